@@ -0,0 +1,402 @@
+#include "benchmark.h"
+
+#include <jet/cg.h>
+#include <jet/fdm_amgpcg_solver3.h>
+#include <jet/fdm_cg_solver3.h>
+#include <jet/fdm_iccg_solver3.h>
+#include <jet/fdm_matrix_free_linear_system3.h>
+#include <jet/fdm_mgpcg_solver3.h>
+#include <jet/matrix_sell.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace jet;
+
+namespace bench {
+
+namespace {
+
+// Fills A with the 7-point Poisson matrix on a grid with spacing h and
+// Dirichlet boundaries, like the pressure system of a closed fluid box.
+void buildPoissonMatrix(double h, FdmMatrix3* A) {
+  const Size3 size = A->size();
+  const double invH2 = 1.0 / (h * h);
+  A->parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+    FdmMatrixRow3& row = (*A)(i, j, k);
+    row.center = 6.0 * invH2;
+    row.right = (i + 1 < size.x) ? -invH2 : 0.0;
+    row.up = (j + 1 < size.y) ? -invH2 : 0.0;
+    row.front = (k + 1 < size.z) ? -invH2 : 0.0;
+  });
+}
+
+// Marks a fluid box surrounded by one layer of air cells.
+void buildLaplacianMatrix(double h, FdmLaplacianMatrix3* A) {
+  const Size3 size = A->size();
+  A->invHSqr = Vector3D(1, 1, 1) / (h * h);
+  A->markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+    const bool isInside = i > 0 && j > 0 && k > 0 && i + 1 < size.x && j + 1 < size.y &&
+                          k + 1 < size.z;
+    A->markers(i, j, k) = isInside ? FdmLaplacianMatrix3::kFluid : FdmLaplacianMatrix3::kAir;
+  });
+}
+
+void buildRhs(FdmVector3* b) {
+  std::mt19937 rng(kSeed);
+  std::uniform_real_distribution<double> d(-1.0, 1.0);
+  b->forEachIndex([&](size_t i, size_t j, size_t k) { (*b)(i, j, k) = d(rng); });
+}
+
+void addMgpcg(BenchmarkRegistry* registry, size_t resolution) {
+  const size_t maxLevels = 5;
+  auto system = std::make_shared<FdmMgLinearSystem3>();
+  system->resizeWithFinest(Size3(resolution, resolution, resolution), maxLevels);
+
+  double h = 1.0 / resolution;
+  for (FdmMatrix3& level : system->A.levels) {
+    buildPoissonMatrix(h, &level);
+    h *= 2.0;
+  }
+  buildRhs(&system->b.levels.front());
+
+  auto solver = std::make_shared<FdmMgpcgSolver3>(100, maxLevels, 5, 5, 20, 20, 1e-6);
+  registry->add(
+      "FdmMgpcgSolver3/" + std::to_string(resolution), resolution * resolution * resolution,
+      [solver, system]() { solver->solve(system.get()); },
+      [system]() {
+        for (FdmVector3& x : system->x.levels) {
+          x.set(0.0);
+        }
+      });
+
+  // Single precision V-cycles inside double precision PCG. The natural
+  // ordering smoother is latency bound, the red-black one bandwidth bound.
+  for (bool useRedBlackOrdering : {false, true}) {
+    for (bool useMixedPrecision : {false, true}) {
+      if (!useRedBlackOrdering && !useMixedPrecision) {
+        continue;  // Same as above
+      }
+
+      auto variant = std::make_shared<FdmMgpcgSolver3>(100, maxLevels, 5, 5, 20, 20, 1e-6, 1.5,
+                                                       useRedBlackOrdering);
+      variant->setUseMixedPrecision(useMixedPrecision);
+      registry->add(
+          std::string("FdmMgpcgSolver3/") + (useRedBlackOrdering ? "RedBlack/" : "") +
+              (useMixedPrecision ? "MixedPrecision/" : "") + std::to_string(resolution),
+          resolution * resolution * resolution,
+          [variant, system]() { variant->solve(system.get()); },
+          [system]() {
+            for (FdmVector3& x : system->x.levels) {
+              x.set(0.0);
+            }
+          });
+    }
+  }
+}
+
+void addIccg(BenchmarkRegistry* registry, size_t resolution) {
+  auto system = std::make_shared<FdmLinearSystem3>();
+  system->resize(Size3(resolution, resolution, resolution));
+  buildPoissonMatrix(1.0 / resolution, &system->A);
+  buildRhs(&system->b);
+
+  auto solver = std::make_shared<FdmIccgSolver3>(1000, 1e-6);
+  registry->add(
+      "FdmIccgSolver3/" + std::to_string(resolution), resolution * resolution * resolution,
+      [solver, system]() { solver->solve(system.get()); }, [system]() { system->x.set(0.0); });
+
+  // Parallel triangular solves. Wavefront gives the same iterations as the
+  // natural ordering above, multicolor (red-black) needs more of them.
+  using Ordering = FdmIccgSolver3::Ordering;
+  for (Ordering ordering : {Ordering::kWavefront, Ordering::kMulticolor}) {
+    auto variant = std::make_shared<FdmIccgSolver3>(1000, 1e-6, ordering);
+    registry->add(
+        std::string("FdmIccgSolver3/") +
+            (ordering == Ordering::kWavefront ? "Wavefront/" : "Multicolor/") +
+            std::to_string(resolution),
+        resolution * resolution * resolution,
+        [variant, system]() { variant->solve(system.get()); },
+        [system]() { system->x.set(0.0); });
+  }
+}
+
+void addCg(BenchmarkRegistry* registry, size_t resolution) {
+  auto system = std::make_shared<FdmLinearSystem3>();
+  system->resize(Size3(resolution, resolution, resolution));
+  buildPoissonMatrix(1.0 / resolution, &system->A);
+  buildRhs(&system->b);
+
+  // Pipelined CG with fused kernels
+  auto solver = std::make_shared<FdmCgSolver3>(200, 1e-6);
+  registry->add(
+      "FdmCgSolver3/" + std::to_string(resolution), resolution * resolution * resolution,
+      [solver, system]() { solver->solve(system.get()); }, [system]() { system->x.set(0.0); });
+
+  // Baseline: textbook CG with one pass per BLAS operation
+  auto vectors = std::make_shared<std::array<FdmVector3, 4>>();
+  for (FdmVector3& v : *vectors) {
+    v.resize(system->A.size());
+  }
+  registry->add(
+      "cg<FdmBlas3>/" + std::to_string(resolution), resolution * resolution * resolution,
+      [vectors, system]() {
+        unsigned int iterations = 0;
+        double residual = 0.0;
+        auto& v = *vectors;
+        cg<FdmBlas3>(system->A, system->b, 200, 1e-6, &system->x, &v[0], &v[1], &v[2], &v[3],
+                     &iterations, &residual);
+      },
+      [system]() { system->x.set(0.0); });
+}
+
+// Same systems solved with the matrix-free and the assembled matrix
+void addMatrixFree(BenchmarkRegistry* registry, size_t resolution) {
+  const Size3 size(resolution, resolution, resolution);
+  const size_t maxLevels = 5;
+
+  auto system = std::make_shared<FdmMatrixFreeLinearSystem3>();
+  system->resize(size);
+  buildLaplacianMatrix(1.0 / resolution, &system->A);
+  buildRhs(&system->b);
+
+  auto assembled = std::make_shared<FdmLinearSystem3>();
+  assembled->resize(size);
+  system->A.assemble(&assembled->A);
+  assembled->b.set(system->b);
+
+  auto cgSolver = std::make_shared<FdmCgSolver3>(200, 1e-6);
+  registry->add(
+      "FdmCgSolver3/MatrixFree/" + std::to_string(resolution), resolution * resolution * resolution,
+      [cgSolver, system]() { cgSolver->solveMatrixFree(system.get()); },
+      [system]() { system->x.set(0.0); });
+  registry->add(
+      "FdmCgSolver3/Assembled/" + std::to_string(resolution), resolution * resolution * resolution,
+      [cgSolver, assembled]() { cgSolver->solve(assembled.get()); },
+      [assembled]() { assembled->x.set(0.0); });
+
+  auto mgSystem = std::make_shared<FdmMgMatrixFreeLinearSystem3>();
+  mgSystem->resizeWithFinest(size, maxLevels);
+  auto mgAssembled = std::make_shared<FdmMgLinearSystem3>();
+  mgAssembled->resizeWithFinest(size, maxLevels);
+
+  double h = 1.0 / resolution;
+  for (size_t l = 0; l < mgSystem->numberOfLevels(); ++l) {
+    buildLaplacianMatrix(h, &mgSystem->A.levels[l]);
+    mgSystem->A.levels[l].assemble(&mgAssembled->A.levels[l]);
+    h *= 2.0;
+  }
+  buildRhs(&mgSystem->b.levels.front());
+  mgAssembled->b.levels.front().set(mgSystem->b.levels.front());
+
+  auto mgpcgSolver = std::make_shared<FdmMgpcgSolver3>(100, maxLevels, 5, 5, 20, 20, 1e-6);
+  registry->add(
+      "FdmMgpcgSolver3/MatrixFree/" + std::to_string(resolution),
+      resolution * resolution * resolution,
+      [mgpcgSolver, mgSystem]() { mgpcgSolver->solve(mgSystem.get()); },
+      [mgSystem]() {
+        for (FdmVector3& x : mgSystem->x.levels) {
+          x.set(0.0);
+        }
+      });
+  registry->add(
+      "FdmMgpcgSolver3/Assembled/" + std::to_string(resolution),
+      resolution * resolution * resolution,
+      [mgpcgSolver, mgAssembled]() { mgpcgSolver->solve(mgAssembled.get()); },
+      [mgAssembled]() {
+        for (FdmVector3& x : mgAssembled->x.levels) {
+          x.set(0.0);
+        }
+      });
+}
+
+// Compressed pressure system of a tank filled to 70% around a solid sphere,
+// with the rows ordered like GridSinglePhasePressureSolver3 orders them.
+void buildCompressedMatrix(size_t resolution, MatrixCsrD* A) {
+  FdmLaplacianMatrix3 laplacian;
+  laplacian.resize(Size3(resolution, resolution, resolution));
+  laplacian.invHSqr = Vector3D(1, 1, 1) * static_cast<double>(resolution * resolution);
+  laplacian.markers.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+    const Vector3D x = Vector3D(i + 0.5, j + 0.5, k + 0.5) / static_cast<double>(resolution);
+    char marker = (x.y < 0.7) ? FdmLaplacianMatrix3::kFluid : FdmLaplacianMatrix3::kAir;
+    if (x.distanceTo(Vector3D(0.5, 0.3, 0.5)) < 0.15) {
+      marker = FdmLaplacianMatrix3::kBoundary;
+    }
+    laplacian.markers(i, j, k) = marker;
+  });
+
+  const Array3<char>& markers = laplacian.markers;
+  Array3<size_t> rowIndices(markers.size());
+  size_t numberOfRows = 0;
+  markers.forEachIndex([&](size_t i, size_t j, size_t k) {
+    if (markers(i, j, k) == FdmLaplacianMatrix3::kFluid) {
+      rowIndices(i, j, k) = numberOfRows++;
+    }
+  });
+
+  A->clear();
+  std::vector<double> values;
+  std::vector<size_t> columns;
+  markers.forEachIndex([&](size_t i, size_t j, size_t k) {
+    if (markers(i, j, k) != FdmLaplacianMatrix3::kFluid) {
+      return;
+    }
+
+    values.clear();
+    columns.clear();
+    auto addNeighbor = [&](size_t ii, size_t jj, size_t kk, double w) {
+      if (markers(ii, jj, kk) == FdmLaplacianMatrix3::kFluid) {
+        values.push_back(-w);
+        columns.push_back(rowIndices(ii, jj, kk));
+      }
+    };
+    const Vector3D& w = laplacian.invHSqr;
+    if (k > 0) addNeighbor(i, j, k - 1, w.z);
+    if (j > 0) addNeighbor(i, j - 1, k, w.y);
+    if (i > 0) addNeighbor(i - 1, j, k, w.x);
+    values.push_back(laplacian.diagonal(i, j, k));
+    columns.push_back(rowIndices(i, j, k));
+    if (i + 1 < resolution) addNeighbor(i + 1, j, k, w.x);
+    if (j + 1 < resolution) addNeighbor(i, j + 1, k, w.y);
+    if (k + 1 < resolution) addNeighbor(i, j, k + 1, w.z);
+    A->addRow(values, columns);
+  });
+}
+
+// SpMV of the compressed pressure system in CSR and SELL format. The systems
+// are built by the first setup call, so unselected cases cost nothing.
+void addCompressed(BenchmarkRegistry* registry, size_t resolution) {
+  struct Data {
+    MatrixCsrD csr;
+    MatrixSellD sell;
+    VectorND x;
+    VectorND y;
+  };
+  auto data = std::make_shared<Data>();
+  auto prepare = [data, resolution]() {
+    if (data->csr.rows() > 0) {
+      return;
+    }
+    buildCompressedMatrix(resolution, &data->csr);
+    data->sell.set(data->csr);
+    data->x.resize(data->csr.rows());
+    data->y.resize(data->csr.rows());
+    std::mt19937 rng(kSeed);
+    std::uniform_real_distribution<double> d(-1.0, 1.0);
+    for (size_t i = 0; i < data->x.size(); ++i) {
+      data->x[i] = d(rng);
+    }
+  };
+
+  // The number of fluid cells is not known before the build; report cells
+  const size_t cells = resolution * resolution * resolution;
+  registry->add(
+      "FdmCompressedBlas3::mvm/" + std::to_string(resolution), cells,
+      [data]() { FdmCompressedBlas3::mvm(data->csr, data->x, &data->y); }, prepare);
+  registry->add(
+      "FdmCompressedSellBlas3::mvm/" + std::to_string(resolution), cells,
+      [data]() { FdmCompressedSellBlas3::mvm(data->sell, data->x, &data->y); }, prepare);
+  registry->add(
+      "MatrixSellD::set/" + std::to_string(resolution), cells,
+      [data]() { data->sell.set(data->csr); }, prepare);
+}
+
+// ICCG and algebraic multigrid PCG on the compressed pressure system, the
+// only multigrid option for it. Built lazily like addCompressed.
+void addCompressedSolvers(BenchmarkRegistry* registry, size_t resolution) {
+  auto system = std::make_shared<FdmCompressedLinearSystem3>();
+  auto prepare = [system, resolution]() {
+    if (system->A.rows() == 0) {
+      buildCompressedMatrix(resolution, &system->A);
+      system->b.resize(system->A.rows());
+      std::mt19937 rng(kSeed);
+      std::uniform_real_distribution<double> d(-1.0, 1.0);
+      for (size_t i = 0; i < system->b.size(); ++i) {
+        system->b[i] = d(rng);
+      }
+    }
+    system->x.resize(system->A.rows());
+    system->x.set(0.0);
+  };
+
+  const size_t cells = resolution * resolution * resolution;
+  auto iccg = std::make_shared<FdmIccgSolver3>(1000, 1e-6);
+  registry->add(
+      "FdmIccgSolver3/Compressed/" + std::to_string(resolution), cells,
+      [iccg, system]() { iccg->solveCompressed(system.get()); }, prepare);
+  auto amgpcg = std::make_shared<FdmAmgpcgSolver3>(1000, 1e-6);
+  registry->add(
+      "FdmAmgpcgSolver3/Compressed/" + std::to_string(resolution), cells,
+      [amgpcg, system]() { amgpcg->solveCompressed(system.get()); }, prepare);
+}
+
+// AMGPCG on the dense system, which it converts to CSR. The first setup
+// checks the solution against ICCG, with coefficients left on the domain
+// borders that FdmBlas3 ignores and the conversion has to skip as well.
+void addAmgpcg(BenchmarkRegistry* registry, size_t resolution) {
+  auto system = std::make_shared<FdmLinearSystem3>();
+  system->resize(Size3(resolution, resolution, resolution));
+  buildPoissonMatrix(1.0 / resolution, &system->A);
+  const double invH2 = static_cast<double>(resolution * resolution);
+  system->A.forEachIndex([&](size_t i, size_t j, size_t k) {
+    FdmMatrixRow3& row = system->A(i, j, k);
+    row.right = -invH2;
+    row.up = -invH2;
+    row.front = -invH2;
+  });
+  buildRhs(&system->b);
+
+  auto solver = std::make_shared<FdmAmgpcgSolver3>(1000, 1e-6);
+  auto isChecked = std::make_shared<bool>(false);
+  registry->add(
+      "FdmAmgpcgSolver3/" + std::to_string(resolution), resolution * resolution * resolution,
+      [solver, system]() { solver->solve(system.get()); },
+      [solver, system, isChecked, resolution]() {
+        if (!*isChecked) {
+          FdmLinearSystem3 reference;
+          reference.resize(system->A.size());
+          reference.A.set(system->A);
+          reference.b.set(system->b);
+          FdmIccgSolver3(1000, 1e-9).solve(&reference);
+
+          system->x.set(0.0);
+          solver->solve(system.get());
+          double maxError = 0.0;
+          double maxValue = 0.0;
+          system->x.forEachIndex([&](size_t i, size_t j, size_t k) {
+            maxError = std::max(maxError, std::fabs(system->x(i, j, k) - reference.x(i, j, k)));
+            maxValue = std::max(maxValue, std::fabs(reference.x(i, j, k)));
+          });
+          if (maxError > 1e-4 * maxValue) {
+            fprintf(stderr, "FdmAmgpcgSolver3/%zu differs from ICCG by %g (max %g)\n",
+                    resolution, maxError, maxValue);
+            std::exit(1);
+          }
+          *isChecked = true;
+        }
+        system->x.set(0.0);
+      });
+}
+
+}  // namespace
+
+void registerFdmSolverBenchmarks(BenchmarkRegistry* registry) {
+  for (size_t resolution : {16, 32, 64}) {
+    addMgpcg(registry, resolution);
+    addIccg(registry, resolution);
+    addCg(registry, resolution);
+    addMatrixFree(registry, resolution);
+    addAmgpcg(registry, resolution);
+  }
+  for (size_t resolution : {64, 128}) {
+    addCompressedSolvers(registry, resolution);
+  }
+  for (size_t resolution : {128, 256}) {
+    addCompressed(registry, resolution);
+  }
+}
+
+}  // namespace bench
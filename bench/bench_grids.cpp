@@ -0,0 +1,60 @@
+#include "benchmark.h"
+
+#include <jet/array3.h>
+#include <jet/block_sparse_array3.h>
+#include <jet/parallel.h>
+
+using namespace jet;
+
+namespace bench {
+
+namespace {
+
+// A drop in a large, mostly empty domain, stored as a level set that is
+// clamped to a narrow band like the liquid solvers' signed distance field
+const Vector3D kDropCenter(0.5, 0.3, 0.5);
+const double kDropRadius = 0.15;
+const double kBandWidthInCells = 3.0;
+
+double dropSdf(size_t i, size_t j, size_t k, double h, double band) {
+  const Vector3D x = h * Vector3D(i + 0.5, j + 0.5, k + 0.5);
+  return clamp(x.distanceTo(kDropCenter) - kDropRadius, -band, band);
+}
+
+void addSweeps(BenchmarkRegistry* registry, size_t resolution) {
+  const double h = 1.0 / resolution;
+  const double band = kBandWidthInCells * h;
+  const Size3 size(resolution, resolution, resolution);
+  const std::string suffix = "/" + std::to_string(resolution);
+
+  auto dense = std::make_shared<Array3<double>>(size);
+  dense->parallelForEachIndex(
+      [&](size_t i, size_t j, size_t k) { (*dense)(i, j, k) = dropSdf(i, j, k, h, band); });
+  auto sparse = std::make_shared<BlockSparseArray3<double>>(size, band);
+  sparse->fill([h, band](size_t i, size_t j, size_t k) { return dropSdf(i, j, k, h, band); });
+
+  // Re-clamping the band touches every stored value once, like the sweeps
+  // of the level set and extrapolation passes. Both report the cells of the
+  // whole domain as items.
+  const size_t numberOfCells = size.x * size.y * size.z;
+  registry->add("Array3/sweep" + suffix, numberOfCells, [dense, band]() {
+    Array3<double>& phi = *dense;
+    phi.parallelForEachIndex(
+        [&](size_t i, size_t j, size_t k) { phi(i, j, k) = clamp(phi(i, j, k), -band, band); });
+  });
+  registry->add("BlockSparseArray3/sweep" + suffix, numberOfCells, [sparse, band]() {
+    BlockSparseArray3<double>& phi = *sparse;
+    phi.parallelForEachActiveIndex([&](size_t i, size_t j, size_t k) {
+      phi.activeValue(i, j, k) = clamp(phi(i, j, k), -band, band);
+    });
+  });
+}
+
+}  // namespace
+
+void registerGridBenchmarks(BenchmarkRegistry* registry) {
+  addSweeps(registry, 128);
+  addSweeps(registry, 256);
+}
+
+}  // namespace bench
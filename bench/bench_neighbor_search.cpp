@@ -0,0 +1,81 @@
+#include "benchmark.h"
+
+#include <jet/parallel.h>
+#include <jet/point_hash_grid_searcher3.h>
+#include <jet/point_kdtree_searcher3.h>
+#include <jet/point_parallel_hash_grid_searcher3.h>
+#include <jet/point_simple_list_searcher3.h>
+
+#include <atomic>
+#include <cmath>
+
+using namespace jet;
+
+namespace bench {
+
+namespace {
+
+// About 30 neighbors per query at the given density
+double searchRadius(size_t numberOfPoints) {
+  return std::cbrt(30.0 / (4.0 / 3.0 * kPiD * numberOfPoints));
+}
+
+void addSearcher(BenchmarkRegistry* registry, const std::string& name, size_t numberOfPoints,
+                 const std::function<PointNeighborSearcher3Ptr(double)>& factory) {
+  std::mt19937 rng(kSeed);
+  auto points = std::make_shared<Array1<Vector3D>>(randomPoints(numberOfPoints, &rng));
+  const double radius = searchRadius(numberOfPoints);
+
+  auto searcher = factory(radius);
+  registry->add(name + "/build", numberOfPoints,
+                [searcher, points]() { searcher->build(points->constAccessor()); });
+
+  // Queries every point against a prebuilt searcher; the queries are
+  // independent, so the loop runs in parallel.
+  auto prebuilt = factory(radius);
+  prebuilt->build(points->constAccessor());
+  registry->add(name + "/query", numberOfPoints, [prebuilt, points, radius]() {
+    const auto p = points->constAccessor();
+    size_t numberOfNeighbors = parallelReduce(
+        kZeroSize, p.size(), kZeroSize,
+        [&](size_t begin, size_t end, size_t count) {
+          for (size_t i = begin; i < end; ++i) {
+            prebuilt->forEachNearbyPoint(p[i], radius, [&](size_t, const Vector3D&) { ++count; });
+          }
+          return count;
+        },
+        [](size_t a, size_t b) { return a + b; });
+    doNotOptimize(static_cast<double>(numberOfNeighbors));
+  });
+}
+
+}  // namespace
+
+void registerNeighborSearchBenchmarks(BenchmarkRegistry* registry) {
+  const size_t n = 100000;
+
+  auto hashGrid = [](double radius) -> PointNeighborSearcher3Ptr {
+    size_t resolution = static_cast<size_t>(std::ceil(1.0 / (2.0 * radius)));
+    return std::make_shared<PointHashGridSearcher3>(Size3(resolution, resolution, resolution),
+                                                    2.0 * radius);
+  };
+  auto parallelHashGrid = [](double radius) -> PointNeighborSearcher3Ptr {
+    size_t resolution = static_cast<size_t>(std::ceil(1.0 / (2.0 * radius)));
+    return std::make_shared<PointParallelHashGridSearcher3>(
+        Size3(resolution, resolution, resolution), 2.0 * radius);
+  };
+  auto kdTree = [](double) -> PointNeighborSearcher3Ptr {
+    return std::make_shared<PointKdTreeSearcher3>();
+  };
+  auto simpleList = [](double) -> PointNeighborSearcher3Ptr {
+    return std::make_shared<PointSimpleListSearcher3>();
+  };
+
+  addSearcher(registry, "PointHashGridSearcher3", n, hashGrid);
+  addSearcher(registry, "PointParallelHashGridSearcher3", n, parallelHashGrid);
+  addSearcher(registry, "PointKdTreeSearcher3", n, kdTree);
+  // Queries are brute force, so use fewer points
+  addSearcher(registry, "PointSimpleListSearcher3", n / 20, simpleList);
+}
+
+}  // namespace bench
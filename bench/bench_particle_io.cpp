@@ -0,0 +1,138 @@
+#include "benchmark.h"
+
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/particle_cache3.h>
+#include <jet/sph_system_data3.h>
+
+using namespace jet;
+
+namespace bench {
+
+namespace {
+
+const size_t kNumberOfParticles = 1 << 19;
+const size_t kGridResolution = 128;
+const int kNumberOfFrames = 4;
+const char kCacheFilename[] = "bench_particle_cache.jpc";
+const char kCompressedCacheFilename[] = "bench_particle_cache_compressed.jpc";
+
+std::shared_ptr<SphSystemData3> makeParticles() {
+  std::mt19937 rng(kSeed);
+  auto particles = std::make_shared<SphSystemData3>();
+  Array1<Vector3D> positions = randomPoints(kNumberOfParticles, &rng);
+  particles->addParticles(positions.constAccessor(), positions.constAccessor());
+  return particles;
+}
+
+// Copies the serialized buffer into a shared block like a mapped checkpoint
+std::shared_ptr<const uint8_t> toSharedBuffer(const std::vector<uint8_t>& buffer) {
+  std::shared_ptr<uint8_t> shared(new uint8_t[buffer.size()], std::default_delete<uint8_t[]>());
+  std::copy(buffer.begin(), buffer.end(), shared.get());
+  return shared;
+}
+
+// Writes kNumberOfFrames frames of particles that move a little every frame
+void writeCache(const std::string& filename, bool isCompressed,
+                const std::shared_ptr<SphSystemData3>& particles) {
+  particle_cache::Compression compression;
+  compression.isEnabled = isCompressed;
+  compression.positionTolerance = 1e-4;
+
+  ParticleCacheWriter3 writer;
+  writer.setCompression(compression);
+  writer.open(filename);
+  auto positions = particles->positions();
+  for (int i = 0; i < kNumberOfFrames; ++i) {
+    positions.forEachIndex([&](size_t j) { positions[j].y -= 1e-3; });
+    writer.writeFrame(i, i / 60.0, *particles);
+  }
+  writer.close();
+}
+
+}  // namespace
+
+void registerParticleIoBenchmarks(BenchmarkRegistry* registry) {
+  auto particles = makeParticles();
+
+  // Baseline: one flatbuffer per frame, copied back on load
+  auto buffer = std::make_shared<std::vector<uint8_t>>();
+  registry->add("ParticleSystemData3/serialize", kNumberOfParticles,
+                [particles, buffer]() { particles->serialize(buffer.get()); });
+  registry->add(
+      "ParticleSystemData3/deserialize", kNumberOfParticles,
+      [buffer]() {
+        SphSystemData3 loaded;
+        loaded.deserialize(*buffer);
+        doNotOptimize(loaded.positions()[0].x);
+      },
+      [particles, buffer]() { particles->serialize(buffer.get()); });
+
+  // Zero-copy restore; touching the positions does not promote them
+  auto sharedBuffer = std::make_shared<std::shared_ptr<const uint8_t>>();
+  registry->add(
+      "ParticleSystemData3/deserializeView", kNumberOfParticles,
+      [sharedBuffer]() {
+        SphSystemData3 loaded;
+        loaded.deserializeView(*sharedBuffer);
+        const auto& constLoaded = loaded;
+        doNotOptimize(constLoaded.positions()[0].x);
+      },
+      [particles, buffer, sharedBuffer]() {
+        particles->serialize(buffer.get());
+        *sharedBuffer = toSharedBuffer(*buffer);
+      });
+
+  const size_t numberOfCells = kGridResolution * kGridResolution * kGridResolution;
+  auto gridBuffer = std::make_shared<std::vector<uint8_t>>();
+  auto sharedGridBuffer = std::make_shared<std::shared_ptr<const uint8_t>>();
+  auto setUpGridBuffer = [gridBuffer, sharedGridBuffer]() {
+    CellCenteredScalarGrid3 grid(kGridResolution, kGridResolution, kGridResolution);
+    grid.fill([](const Vector3D& x) { return x.length(); });
+    grid.serialize(gridBuffer.get());
+    *sharedGridBuffer = toSharedBuffer(*gridBuffer);
+  };
+  registry->add(
+      "ScalarGrid3/deserialize", numberOfCells,
+      [gridBuffer]() {
+        CellCenteredScalarGrid3 loaded;
+        loaded.deserialize(*gridBuffer);
+        doNotOptimize(loaded.sample(Vector3D(1, 1, 1)));
+      },
+      setUpGridBuffer);
+  registry->add(
+      "ScalarGrid3/deserializeView", numberOfCells,
+      [sharedGridBuffer]() {
+        CellCenteredScalarGrid3 loaded;
+        loaded.deserializeView(*sharedGridBuffer);
+        doNotOptimize(loaded.sample(Vector3D(1, 1, 1)));
+      },
+      setUpGridBuffer);
+
+  for (bool isCompressed : {false, true}) {
+    const std::string name = isCompressed ? "ParticleCache3/compressed" : "ParticleCache3/raw";
+    const std::string filename = isCompressed ? kCompressedCacheFilename : kCacheFilename;
+
+    registry->add(name + "/writeFrames", kNumberOfFrames * kNumberOfParticles,
+                  [filename, isCompressed, particles]() {
+                    writeCache(filename, isCompressed, particles);
+                  });
+
+    // Reads every frame's positions in order like playback does
+    registry->add(
+        name + "/readPositions", kNumberOfFrames * kNumberOfParticles,
+        [filename]() {
+          ParticleCacheReader3 reader;
+          reader.open(filename);
+          Array1<Vector3D> positions;
+          double sum = 0.0;
+          for (size_t i = 0; i < reader.numberOfFrames(); ++i) {
+            reader.readPositions(i, &positions);
+            sum += positions[0].x;
+          }
+          doNotOptimize(sum);
+        },
+        [filename, isCompressed, particles]() { writeCache(filename, isCompressed, particles); });
+  }
+}
+
+}  // namespace bench
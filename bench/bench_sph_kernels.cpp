@@ -0,0 +1,52 @@
+#include "benchmark.h"
+
+#include <jet/parallel.h>
+#include <jet/sph_kernels3.h>
+
+using namespace jet;
+
+namespace bench {
+
+namespace {
+
+template <typename Kernel>
+void addKernel(BenchmarkRegistry* registry, const std::string& name) {
+  const size_t n = 1 << 22;
+  const double h = 0.1;
+
+  // Distances spread over [0, 1.25 h) so that the cut-off branch is taken too
+  std::mt19937 rng(kSeed);
+  std::uniform_real_distribution<double> d(0.0, 1.25 * h);
+  auto distances = std::make_shared<std::vector<double>>(n);
+  for (double& r : *distances) {
+    r = d(rng);
+  }
+
+  const Kernel kernel(h);
+  auto evaluate = [registry, distances, kernel, n](const std::string& caseName,
+                                                   double (*f)(const Kernel&, double)) {
+    registry->add(caseName, n, [distances, kernel, f]() {
+      const std::vector<double>& r = *distances;
+      double sum = parallelSum(
+          kZeroSize, r.size(), 0.0, [&](size_t i) { return f(kernel, r[i]); });
+      doNotOptimize(sum);
+    });
+  };
+
+  evaluate(name + "/value", [](const Kernel& k, double r) { return k(r); });
+  evaluate(name + "/firstDerivative",
+           [](const Kernel& k, double r) { return k.firstDerivative(r); });
+  evaluate(name + "/gradient",
+           [](const Kernel& k, double r) { return k.gradient(r, Vector3D(1, 0, 0)).x; });
+  evaluate(name + "/secondDerivative",
+           [](const Kernel& k, double r) { return k.secondDerivative(r); });
+}
+
+}  // namespace
+
+void registerSphKernelBenchmarks(BenchmarkRegistry* registry) {
+  addKernel<SphStdKernel3>(registry, "SphStdKernel3");
+  addKernel<SphSpikyKernel3>(registry, "SphSpikyKernel3");
+}
+
+}  // namespace bench
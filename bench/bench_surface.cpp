@@ -0,0 +1,155 @@
+#include "benchmark.h"
+
+#include <jet/anisotropic_points_to_implicit3.h>
+#include <jet/bvh3.h>
+#include <jet/cell_centered_scalar_grid3.h>
+#include <jet/marching_cubes.h>
+#include <jet/parallel.h>
+#include <jet/sph_points_to_implicit3.h>
+#include <jet/spherical_points_to_implicit3.h>
+#include <jet/triangle_mesh3.h>
+#include <jet/triangle_mesh_to_sdf.h>
+#include <jet/vertex_centered_scalar_grid3.h>
+#include <jet/zhu_bridson_points_to_implicit3.h>
+
+#include <cstdio>
+#include <filesystem>
+
+using namespace jet;
+
+namespace bench {
+
+namespace {
+
+const Vector3D kCenter(0.5, 0.5, 0.5);
+const double kRadius = 0.35;
+
+std::shared_ptr<VertexCenteredScalarGrid3> sphereSdf(size_t resolution) {
+  const double h = 1.0 / resolution;
+  auto sdf = std::make_shared<VertexCenteredScalarGrid3>(Size3(resolution, resolution, resolution),
+                                                         Vector3D(h, h, h));
+  sdf->fill([](const Vector3D& x) { return x.distanceTo(kCenter) - kRadius; });
+  return sdf;
+}
+
+std::shared_ptr<TriangleMesh3> sphereMesh(size_t resolution) {
+  auto sdf = sphereSdf(resolution);
+  auto mesh = std::make_shared<TriangleMesh3>();
+  marchingCubes(sdf->constDataAccessor(), sdf->gridSpacing(), sdf->dataOrigin(), mesh.get());
+  return mesh;
+}
+
+void addMarchingCubes(BenchmarkRegistry* registry, size_t resolution) {
+  auto sdf = sphereSdf(resolution);
+  registry->add("marchingCubes/" + std::to_string(resolution),
+                sdf->dataSize().x * sdf->dataSize().y * sdf->dataSize().z, [sdf]() {
+                  TriangleMesh3 mesh;
+                  marchingCubes(sdf->constDataAccessor(), sdf->gridSpacing(), sdf->dataOrigin(),
+                                &mesh);
+                  doNotOptimize(static_cast<double>(mesh.numberOfTriangles()));
+                });
+}
+
+void addConverters(BenchmarkRegistry* registry) {
+  // Same settings as the viewer's surface reconstruction
+  const double spacing = 0.02;
+  const double kernelRadius = 1.8 * spacing;
+  const size_t resolution = 64;
+
+  std::mt19937 rng(kSeed);
+  auto particles = std::make_shared<Array1<Vector3D>>(particlesInSphere(spacing, kRadius, &rng));
+
+  const std::vector<std::pair<std::string, PointsToImplicit3Ptr>> converters = {
+      {"SphericalPointsToImplicit3",
+       std::make_shared<SphericalPointsToImplicit3>(kernelRadius, false)},
+      {"SphPointsToImplicit3", std::make_shared<SphPointsToImplicit3>(kernelRadius, 0.3, false)},
+      {"ZhuBridsonPointsToImplicit3",
+       std::make_shared<ZhuBridsonPointsToImplicit3>(kernelRadius, 0.8, false)},
+      {"AnisotropicPointsToImplicit3",
+       std::make_shared<AnisotropicPointsToImplicit3>(kernelRadius, 0.3, 0.7, 10, false)},
+  };
+
+  for (const auto& converter : converters) {
+    auto sdf = std::make_shared<VertexCenteredScalarGrid3>(
+        Size3(resolution, resolution, resolution),
+        Vector3D(1.0 / resolution, 1.0 / resolution, 1.0 / resolution));
+    PointsToImplicit3Ptr impl = converter.second;
+    registry->add(converter.first + "/convert", particles->size(),
+                  [impl, particles, sdf]() { impl->convert(particles->constAccessor(), sdf.get()); });
+  }
+}
+
+void addBvh(BenchmarkRegistry* registry) {
+  auto mesh = sphereMesh(64);
+  const size_t numberOfTriangles = mesh->numberOfTriangles();
+
+  auto items = std::make_shared<std::vector<size_t>>(numberOfTriangles);
+  auto bounds = std::make_shared<std::vector<BoundingBox3D>>(numberOfTriangles);
+  for (size_t i = 0; i < numberOfTriangles; ++i) {
+    (*items)[i] = i;
+    (*bounds)[i] = mesh->triangle(i).boundingBox();
+  }
+
+  registry->add("Bvh3/build", numberOfTriangles, [items, bounds]() {
+    Bvh3<size_t> bvh;
+    bvh.build(*items, *bounds);
+    doNotOptimize(static_cast<double>(bvh.numberOfNodes()));
+  });
+
+  auto bvh = std::make_shared<Bvh3<size_t>>();
+  bvh->build(*items, *bounds);
+
+  std::mt19937 rng(kSeed);
+  auto queries = std::make_shared<Array1<Vector3D>>(randomPoints(100000, &rng));
+  registry->add("Bvh3/nearest", queries->size(), [bvh, mesh, queries]() {
+    const auto q = queries->constAccessor();
+    double sum = parallelSum(kZeroSize, q.size(), 0.0, [&](size_t i) {
+      auto result = bvh->nearest(q[i], [&](size_t t, const Vector3D& pt) {
+        return mesh->triangle(t).closestDistance(pt);
+      });
+      return result.distance;
+    });
+    doNotOptimize(sum);
+  });
+}
+
+void addTriangleMeshToSdf(BenchmarkRegistry* registry, size_t resolution) {
+  auto mesh = sphereMesh(64);
+  const double h = 1.0 / resolution;
+  auto sdf = std::make_shared<CellCenteredScalarGrid3>(Size3(resolution, resolution, resolution),
+                                                       Vector3D(h, h, h));
+  registry->add("triangleMeshToSdf/" + std::to_string(resolution),
+                resolution * resolution * resolution,
+                [mesh, sdf]() { triangleMeshToSdf(*mesh, sdf.get()); });
+}
+
+// The meshes are written to the temporary directory and removed after timing.
+void addMeshWriters(BenchmarkRegistry* registry, size_t resolution) {
+  auto mesh = sphereMesh(resolution);
+  const std::string suffix = "/" + std::to_string(resolution);
+  const std::filesystem::path tempDir = std::filesystem::temp_directory_path();
+  const std::string objFilename = (tempDir / "jet_bench_mesh.obj").string();
+  const std::string plyFilename = (tempDir / "jet_bench_mesh.ply").string();
+  registry->add(
+      "TriangleMesh3/writeObj" + suffix, mesh->numberOfTriangles(),
+      [mesh, objFilename]() { mesh->writeObj(objFilename); }, nullptr,
+      [objFilename]() { std::remove(objFilename.c_str()); });
+  registry->add(
+      "TriangleMesh3/writePly" + suffix, mesh->numberOfTriangles(),
+      [mesh, plyFilename]() { mesh->writePly(plyFilename); }, nullptr,
+      [plyFilename]() { std::remove(plyFilename.c_str()); });
+}
+
+}  // namespace
+
+void registerSurfaceBenchmarks(BenchmarkRegistry* registry) {
+  addMarchingCubes(registry, 64);
+  addMarchingCubes(registry, 128);
+  addConverters(registry);
+  addBvh(registry);
+  addTriangleMeshToSdf(registry, 32);
+  addTriangleMeshToSdf(registry, 64);
+  addMeshWriters(registry, 256);
+}
+
+}  // namespace bench
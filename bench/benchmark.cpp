@@ -0,0 +1,174 @@
+#include "benchmark.h"
+
+#include <jet/constants.h>
+#include <jet/parallel.h>
+#include <jet/timer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace bench {
+
+void BenchmarkRegistry::add(const std::string& name, size_t items, std::function<void()> run,
+                            std::function<void()> setup, std::function<void()> teardown) {
+  _cases.push_back({name, items, std::move(setup), std::move(run), std::move(teardown)});
+}
+
+const std::vector<BenchmarkCase>& BenchmarkRegistry::cases() const { return _cases; }
+
+namespace {
+
+volatile double sSink = 0.0;
+
+const char* taskingSystemName() {
+#if defined(JET_TASKING_TBB)
+  return "tbb";
+#elif defined(JET_TASKING_CPP11THREADS)
+  return "cpp11threads";
+#elif defined(JET_TASKING_OPENMP)
+  return "openmp";
+#else
+  return "serial";
+#endif
+}
+
+struct Measurement {
+  unsigned int threads = 0;
+  double minSeconds = 0.0;
+  double medianSeconds = 0.0;
+  double meanSeconds = 0.0;
+};
+
+Measurement measure(const BenchmarkCase& benchmarkCase, unsigned int threads,
+                    unsigned int repetitions) {
+  // One untimed warm-up run fills caches and lazily built structures
+  if (benchmarkCase.setup) {
+    benchmarkCase.setup();
+  }
+  benchmarkCase.run();
+
+  std::vector<double> seconds;
+  for (unsigned int r = 0; r < repetitions; ++r) {
+    if (benchmarkCase.setup) {
+      benchmarkCase.setup();
+    }
+    jet::Timer timer;
+    benchmarkCase.run();
+    seconds.push_back(timer.durationInSeconds());
+  }
+  if (benchmarkCase.teardown) {
+    benchmarkCase.teardown();
+  }
+
+  std::sort(seconds.begin(), seconds.end());
+
+  Measurement result;
+  result.threads = threads;
+  result.minSeconds = seconds.front();
+  result.medianSeconds = seconds[seconds.size() / 2];
+  for (double s : seconds) {
+    result.meanSeconds += s / seconds.size();
+  }
+  return result;
+}
+
+void writeEscaped(std::ostream& strm, const std::string& str) {
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      strm << '\\';
+    }
+    strm << c;
+  }
+}
+
+}  // namespace
+
+int runBenchmarks(const BenchmarkRegistry& registry, const BenchmarkOptions& options) {
+  std::ofstream file;
+  if (!options.outputFilename.empty()) {
+    file.open(options.outputFilename.c_str());
+    if (!file) {
+      fprintf(stderr, "Cannot open %s\n", options.outputFilename.c_str());
+      return 1;
+    }
+  }
+  std::ostream& out = options.outputFilename.empty() ? std::cout : file;
+
+  const unsigned int defaultThreads = jet::maxNumberOfThreads();
+
+  out << "{\n  \"tasking\": \"" << taskingSystemName() << "\",\n"
+      << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n"
+      << "  \"repetitions\": " << options.repetitions << ",\n"
+      << "  \"seed\": " << kSeed << ",\n"
+      << "  \"benchmarks\": [";
+
+  bool isFirst = true;
+  for (const BenchmarkCase& benchmarkCase : registry.cases()) {
+    if (benchmarkCase.name.find(options.filter) == std::string::npos) {
+      continue;
+    }
+
+    std::vector<Measurement> scaling;
+    for (unsigned int threads : options.threadCounts) {
+      jet::setMaxNumberOfThreads(threads);
+      scaling.push_back(measure(benchmarkCase, threads, options.repetitions));
+      fprintf(stderr, "%-48s %3u threads %12.6f s\n", benchmarkCase.name.c_str(), threads,
+              scaling.back().medianSeconds);
+    }
+
+    out << (isFirst ? "" : ",") << "\n    {\n      \"name\": \"";
+    writeEscaped(out, benchmarkCase.name);
+    out << "\",\n      \"items\": " << benchmarkCase.items << ",\n      \"scaling\": [";
+    isFirst = false;
+
+    for (size_t i = 0; i < scaling.size(); ++i) {
+      const Measurement& m = scaling[i];
+      out << (i == 0 ? "" : ",") << "\n        {\"threads\": " << m.threads
+          << ", \"min_seconds\": " << m.minSeconds << ", \"median_seconds\": " << m.medianSeconds
+          << ", \"mean_seconds\": " << m.meanSeconds
+          << ", \"items_per_second\": " << benchmarkCase.items / m.medianSeconds
+          << ", \"speedup\": " << scaling.front().medianSeconds / m.medianSeconds << "}";
+    }
+    out << "\n      ]\n    }";
+  }
+  out << "\n  ]\n}\n";
+
+  jet::setMaxNumberOfThreads(defaultThreads);
+  return 0;
+}
+
+void doNotOptimize(double value) { sSink = sSink + value; }
+
+jet::Array1<jet::Vector3D> randomPoints(size_t count, std::mt19937* rng) {
+  std::uniform_real_distribution<double> d(0.0, 1.0);
+  jet::Array1<jet::Vector3D> points(count);
+  for (size_t i = 0; i < count; ++i) {
+    points[i].x = d(*rng);
+    points[i].y = d(*rng);
+    points[i].z = d(*rng);
+  }
+  return points;
+}
+
+jet::Array1<jet::Vector3D> particlesInSphere(double spacing, double radius, std::mt19937* rng) {
+  std::uniform_real_distribution<double> jitter(-0.1 * spacing, 0.1 * spacing);
+  const jet::Vector3D center(0.5, 0.5, 0.5);
+
+  jet::Array1<jet::Vector3D> points;
+  for (double z = center.z - radius; z <= center.z + radius; z += spacing) {
+    for (double y = center.y - radius; y <= center.y + radius; y += spacing) {
+      for (double x = center.x - radius; x <= center.x + radius; x += spacing) {
+        jet::Vector3D p(x + jitter(*rng), y + jitter(*rng), z + jitter(*rng));
+        if (p.distanceTo(center) < radius) {
+          points.append(p);
+        }
+      }
+    }
+  }
+  return points;
+}
+
+}  // namespace bench
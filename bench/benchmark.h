@@ -0,0 +1,72 @@
+#ifndef BENCH_BENCHMARK_H_
+#define BENCH_BENCHMARK_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <jet/array1.h>
+#include <jet/vector3.h>
+
+namespace bench {
+
+// Fixed seed so every run benchmarks the same inputs
+constexpr unsigned int kSeed = 0;
+
+struct BenchmarkCase {
+  std::string name;
+  // Number of items processed by one call of run, used for the throughput
+  size_t items = 1;
+  // Optional untimed preparation before every repetition
+  std::function<void()> setup;
+  std::function<void()> run;
+  // Optional untimed cleanup after the last repetition
+  std::function<void()> teardown;
+};
+
+class BenchmarkRegistry {
+ public:
+  void add(const std::string& name, size_t items, std::function<void()> run,
+           std::function<void()> setup = nullptr, std::function<void()> teardown = nullptr);
+
+  const std::vector<BenchmarkCase>& cases() const;
+
+ private:
+  std::vector<BenchmarkCase> _cases;
+};
+
+struct BenchmarkOptions {
+  // Cases whose name contains this string are run
+  std::string filter;
+  std::vector<unsigned int> threadCounts;
+  unsigned int repetitions = 5;
+  std::string outputFilename;
+};
+
+// Runs every selected case at every thread count and writes a JSON report
+// with the timings, throughput and speedup relative to the first thread count.
+int runBenchmarks(const BenchmarkRegistry& registry, const BenchmarkOptions& options);
+
+// Keeps the compiler from optimizing away a result
+void doNotOptimize(double value);
+
+// Uniformly distributed points in [0, 1]^3
+jet::Array1<jet::Vector3D> randomPoints(size_t count, std::mt19937* rng);
+
+// Points on a jittered lattice inside a sphere of the given radius centered
+// at (0.5, 0.5, 0.5), which is closer to a fluid than uniform noise
+jet::Array1<jet::Vector3D> particlesInSphere(double spacing, double radius, std::mt19937* rng);
+
+void registerNeighborSearchBenchmarks(BenchmarkRegistry* registry);
+void registerSphKernelBenchmarks(BenchmarkRegistry* registry);
+void registerSurfaceBenchmarks(BenchmarkRegistry* registry);
+void registerFdmSolverBenchmarks(BenchmarkRegistry* registry);
+void registerParticleIoBenchmarks(BenchmarkRegistry* registry);
+void registerGridBenchmarks(BenchmarkRegistry* registry);
+
+}  // namespace bench
+
+#endif  // BENCH_BENCHMARK_H_
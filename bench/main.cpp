@@ -0,0 +1,99 @@
+// Micro-benchmarks for the jet kernels and data structures.
+//
+// Usage: SPH3D_bench [--filter=<substring>] [--threads=1,2,4] [--repetitions=5]
+//                    [--output=<file.json>] [--list]
+//
+// Every case runs at each thread count and the report contains the median
+// time, throughput and speedup over the first thread count. Progress goes to
+// stderr, the JSON report to stdout unless --output is given.
+
+#include "benchmark.h"
+
+#include <jet/logging.h>
+#include <jet/parallel.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+namespace {
+
+bool startsWith(const std::string& str, const std::string& prefix) {
+  return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::vector<unsigned int> defaultThreadCounts() {
+  std::vector<unsigned int> counts;
+  const unsigned int maxThreads = jet::maxNumberOfThreads();
+  for (unsigned int n = 1; n < maxThreads; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(maxThreads);
+  return counts;
+}
+
+std::vector<unsigned int> parseThreadCounts(const std::string& list) {
+  std::vector<unsigned int> counts;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    int n = std::atoi(item.c_str());
+    if (n > 0) {
+      counts.push_back(static_cast<unsigned int>(n));
+    }
+  }
+  return counts;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  // The library logs every step; keep the report readable
+  jet::Logging::mute();
+
+  bench::BenchmarkOptions options;
+  options.threadCounts = defaultThreadCounts();
+  bool isListing = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (startsWith(arg, "--filter=")) {
+      options.filter = arg.substr(9);
+    } else if (startsWith(arg, "--threads=")) {
+      options.threadCounts = parseThreadCounts(arg.substr(10));
+    } else if (startsWith(arg, "--repetitions=")) {
+      options.repetitions = std::max(std::atoi(arg.substr(14).c_str()), 1);
+    } else if (startsWith(arg, "--output=")) {
+      options.outputFilename = arg.substr(9);
+    } else if (arg == "--list") {
+      isListing = true;
+    } else {
+      fprintf(stderr, "Unknown argument %s\n", arg.c_str());
+      return 1;
+    }
+  }
+
+  if (options.threadCounts.empty()) {
+    fprintf(stderr, "No valid thread count given\n");
+    return 1;
+  }
+
+  bench::BenchmarkRegistry registry;
+  bench::registerNeighborSearchBenchmarks(&registry);
+  bench::registerSphKernelBenchmarks(&registry);
+  bench::registerSurfaceBenchmarks(&registry);
+  bench::registerFdmSolverBenchmarks(&registry);
+  bench::registerParticleIoBenchmarks(&registry);
+  bench::registerGridBenchmarks(&registry);
+
+  if (isListing) {
+    for (const bench::BenchmarkCase& benchmarkCase : registry.cases()) {
+      printf("%s\n", benchmarkCase.name.c_str());
+    }
+    return 0;
+  }
+
+  return bench::runBenchmarks(registry, options);
+}
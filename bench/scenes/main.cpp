@@ -0,0 +1,357 @@
+// Headless scene runner for end-to-end performance regression tests.
+//
+// Usage: SPH3D_scenes --scene=<name> [--frames=60] [--fps=60] [--threads=N]
+//                     [--reconstruct-every=1] [--output=<report.json>]
+//                     [--substeps=<substeps.csv>] [--cache=<file>]
+//                     [--cache-tolerance=<meters>] [--checkpoint=<file>]
+//                     [--checkpoint-every=N] [--resume=<file>]
+//                     [--baseline=<report.json>] [--tolerance=0.1]
+//                     [--tolerance=<metric>:<value> ...] [--list]
+//
+// Runs the scene for the given number of frames and writes a JSON report. If
+// a baseline report is given, every metric is compared against it and the
+// exit code is 2 when any metric got worse by more than its tolerance.
+// --substeps additionally writes one CSV row per sub-timestep for plotting.
+// --cache records every frame to a particle cache, compressed with the given
+// position tolerance if it is positive, and reports its size and decode time.
+// --checkpoint writes the solver state to the given file every N frames in the
+// background, and --resume continues a run from such a checkpoint.
+
+#include "report.h"
+#include "scenes.h"
+
+#include <jet/checkpoint.h>
+#include <jet/logging.h>
+#include <jet/parallel.h>
+#include <jet/particle_cache3.h>
+#include <jet/timer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace jet;
+
+namespace {
+
+double peakResidentSetSizeInMegabytes() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+  return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+  return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+const char* taskingSystemName() {
+#if defined(JET_TASKING_TBB)
+  return "tbb";
+#elif defined(JET_TASKING_CPP11THREADS)
+  return "cpp11threads";
+#elif defined(JET_TASKING_OPENMP)
+  return "openmp";
+#else
+  return "serial";
+#endif
+}
+
+bool startsWith(const std::string& str, const std::string& prefix) {
+  return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  std::string sceneName;
+  int numberOfFrames = 60;
+  double fps = 60.0;
+  unsigned int reconstructEvery = 1;
+  std::string outputFilename;
+  std::string baselineFilename;
+  std::string substepsFilename;
+  std::string cacheFilename;
+  double cacheTolerance = 0.0;
+  std::string checkpointFilename;
+  int checkpointEvery = 0;
+  std::string resumeFilename;
+  double defaultTolerance = 0.1;
+  std::map<std::string, double> tolerances;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (startsWith(arg, "--scene=")) {
+      sceneName = arg.substr(8);
+    } else if (startsWith(arg, "--frames=")) {
+      numberOfFrames = std::max(std::atoi(arg.substr(9).c_str()), 1);
+    } else if (startsWith(arg, "--fps=")) {
+      fps = std::atof(arg.substr(6).c_str());
+    } else if (startsWith(arg, "--threads=")) {
+      setMaxNumberOfThreads(static_cast<unsigned int>(std::max(std::atoi(arg.substr(10).c_str()), 1)));
+    } else if (startsWith(arg, "--reconstruct-every=")) {
+      reconstructEvery = static_cast<unsigned int>(std::max(std::atoi(arg.substr(20).c_str()), 0));
+    } else if (startsWith(arg, "--output=")) {
+      outputFilename = arg.substr(9);
+    } else if (startsWith(arg, "--substeps=")) {
+      substepsFilename = arg.substr(11);
+    } else if (startsWith(arg, "--cache=")) {
+      cacheFilename = arg.substr(8);
+    } else if (startsWith(arg, "--cache-tolerance=")) {
+      cacheTolerance = std::atof(arg.substr(18).c_str());
+    } else if (startsWith(arg, "--checkpoint=")) {
+      checkpointFilename = arg.substr(13);
+    } else if (startsWith(arg, "--checkpoint-every=")) {
+      checkpointEvery = std::max(std::atoi(arg.substr(19).c_str()), 0);
+    } else if (startsWith(arg, "--resume=")) {
+      resumeFilename = arg.substr(9);
+    } else if (startsWith(arg, "--baseline=")) {
+      baselineFilename = arg.substr(11);
+    } else if (startsWith(arg, "--tolerance=")) {
+      const std::string value = arg.substr(12);
+      const size_t colon = value.find(':');
+      if (colon == std::string::npos) {
+        defaultTolerance = std::atof(value.c_str());
+      } else {
+        tolerances[value.substr(0, colon)] = std::atof(value.substr(colon + 1).c_str());
+      }
+    } else if (arg == "--list") {
+      for (const std::string& name : scenes::sceneNames()) {
+        printf("%s\n", name.c_str());
+      }
+      return 0;
+    } else {
+      fprintf(stderr, "Unknown argument %s\n", arg.c_str());
+      return 1;
+    }
+  }
+
+  if (fps <= 0.0) {
+    fprintf(stderr, "Invalid fps\n");
+    return 1;
+  }
+
+  Logging::mute();
+
+  scenes::Scene scene;
+  if (!scenes::makeScene(sceneName, &scene)) {
+    fprintf(stderr, "Unknown scene \"%s\", use --list to see the available scenes\n",
+            sceneName.c_str());
+    return 1;
+  }
+  if (outputFilename.empty()) {
+    outputFilename = scene.name + ".json";
+  }
+
+  double simulationSeconds = 0.0;
+  double reconstructionSeconds = 0.0;
+  unsigned int numberOfReconstructions = 0;
+  unsigned int totalSubTimeSteps = 0;
+  unsigned int totalPciIterations = 0;
+  unsigned int maxPciIterations = 0;
+  double maxDensityErrorRatio = 0.0;
+  SubTimeStepMetrics::PhaseTimes phaseSeconds{};
+
+  std::ofstream substepsFile;
+  if (!substepsFilename.empty()) {
+    substepsFile.open(substepsFilename.c_str());
+    substepsFile << "frame,substep,time,dt,wall_seconds,particles,pci_iterations,"
+                    "max_density_error_ratio";
+    for (size_t p = 0; p < phaseSeconds.size(); ++p) {
+      substepsFile << "," << subTimeStepPhaseName(static_cast<SubTimeStepPhase>(p)) << "_seconds";
+    }
+    substepsFile << "\n";
+  }
+
+  scene.solver->setSubTimeStepCallback([&](const SubTimeStepMetrics& metrics) {
+    ++totalSubTimeSteps;
+    totalPciIterations += metrics.numberOfPressureIterations;
+    maxPciIterations = std::max(maxPciIterations, metrics.numberOfPressureIterations);
+    maxDensityErrorRatio = std::max(maxDensityErrorRatio, metrics.maxDensityErrorRatio);
+    for (size_t p = 0; p < phaseSeconds.size(); ++p) {
+      phaseSeconds[p] += metrics.phaseTimesInSeconds[p];
+    }
+
+    if (substepsFile) {
+      substepsFile << metrics.frameIndex << "," << metrics.subTimeStepIndex << ","
+                   << metrics.timeInSeconds << "," << metrics.timeIntervalInSeconds << ","
+                   << metrics.wallTimeInSeconds << "," << metrics.numberOfParticles << ","
+                   << metrics.numberOfPressureIterations << "," << metrics.maxDensityErrorRatio;
+      for (double seconds : metrics.phaseTimesInSeconds) {
+        substepsFile << "," << seconds;
+      }
+      substepsFile << "\n";
+    }
+  });
+
+  ParticleCacheWriter3 cacheWriter;
+  if (!cacheFilename.empty()) {
+    particle_cache::Compression compression;
+    compression.isEnabled = cacheTolerance > 0.0;
+    compression.origin = scene.domain.lowerCorner;
+    compression.positionTolerance = cacheTolerance;
+    cacheWriter.setCompression(compression);
+    if (!cacheWriter.open(cacheFilename)) {
+      fprintf(stderr, "Cannot write %s\n", cacheFilename.c_str());
+      return 1;
+    }
+  }
+
+  Frame frame(0, 1.0 / fps);
+  if (!resumeFilename.empty()) {
+    if (!loadCheckpoint(resumeFilename, scene.solver.get())) {
+      fprintf(stderr, "Cannot resume from %s\n", resumeFilename.c_str());
+      return 1;
+    }
+    frame.index = scene.solver->currentFrame().index + 1;
+  }
+  // Frames this run simulates, which is fewer than numberOfFrames on resume
+  const int numberOfSimulatedFrames = std::max(numberOfFrames - frame.index, 0);
+  auto perFrame = [](double value, size_t frames) { return frames > 0 ? value / frames : 0.0; };
+
+  CheckpointWriter checkpointWriter;
+  if (checkpointEvery > 0 && checkpointFilename.empty()) {
+    checkpointFilename = scene.name + ".jck";
+  }
+  double checkpointSnapshotSeconds = 0.0;
+  unsigned int numberOfCheckpoints = 0;
+
+  for (; frame.index < numberOfFrames; ++frame) {
+    Timer timer;
+    scene.solver->update(frame);
+    simulationSeconds += timer.durationInSeconds();
+
+    if (checkpointEvery > 0 && (frame.index + 1) % checkpointEvery == 0) {
+      if (!checkpointWriter.save(*scene.solver, checkpointFilename)) {
+        fprintf(stderr, "Cannot write %s\n", checkpointFilename.c_str());
+        return 1;
+      }
+      checkpointSnapshotSeconds += checkpointWriter.lastSnapshotTimeInSeconds();
+      ++numberOfCheckpoints;
+    }
+
+    if (cacheWriter.isOpen()) {
+      cacheWriter.writeFrame(frame.index, frame.timeInSeconds(),
+                             *scene.solver->particleSystemData());
+    }
+
+    if (reconstructEvery > 0 && frame.index % reconstructEvery == 0) {
+      timer.reset();
+      scenes::reconstructSurface(scene);
+      reconstructionSeconds += timer.durationInSeconds();
+      ++numberOfReconstructions;
+    }
+
+    fprintf(stderr, "\r%s: frame %d/%d", scene.name.c_str(), frame.index + 1, numberOfFrames);
+  }
+  fprintf(stderr, "\n");
+
+  if (!checkpointWriter.flush()) {
+    fprintf(stderr, "Cannot write %s\n", checkpointFilename.c_str());
+    return 1;
+  }
+
+  scenes::Report report;
+  report.info = {
+      {"scene", scene.name},
+      {"description", scene.description},
+      {"tasking", taskingSystemName()},
+      {"threads", std::to_string(maxNumberOfThreads())},
+      {"frames", std::to_string(numberOfFrames)},
+      {"simulated_frames", std::to_string(numberOfSimulatedFrames)},
+      {"fps", std::to_string(fps)},
+      {"seed", std::to_string(scenes::kSeed)},
+      {"number_of_particles",
+       std::to_string(scene.solver->particleSystemData()->numberOfParticles())},
+  };
+
+  const double simulatedSeconds = numberOfSimulatedFrames / fps;
+  report.metrics = {
+      {"wall_seconds_per_simulated_second",
+       simulatedSeconds > 0.0 ? simulationSeconds / simulatedSeconds : 0.0},
+      {"mean_substeps_per_frame",
+       perFrame(static_cast<double>(totalSubTimeSteps), numberOfSimulatedFrames)},
+      {"mean_pci_iterations",
+       totalSubTimeSteps > 0 ? static_cast<double>(totalPciIterations) / totalSubTimeSteps : 0.0},
+      {"max_pci_iterations", static_cast<double>(maxPciIterations)},
+      {"max_density_error_ratio", maxDensityErrorRatio},
+      {"mean_reconstruction_seconds",
+       numberOfReconstructions > 0 ? reconstructionSeconds / numberOfReconstructions : 0.0},
+      {"peak_rss_mb", peakResidentSetSizeInMegabytes()},
+  };
+  if (cacheWriter.isOpen()) {
+    if (!cacheWriter.close()) {
+      fprintf(stderr, "Cannot write %s\n", cacheFilename.c_str());
+      return 1;
+    }
+
+    // Decode every frame in order like playback does
+    ParticleCacheReader3 reader;
+    if (!reader.open(cacheFilename)) {
+      fprintf(stderr, "Cannot read %s\n", cacheFilename.c_str());
+      return 1;
+    }
+    Array1<Vector3D> positions;
+    Timer timer;
+    for (size_t i = 0; i < reader.numberOfFrames(); ++i) {
+      reader.readPositions(i, &positions);
+    }
+    report.metrics.emplace_back("cache_compression_ratio", cacheWriter.compressionRatio());
+    report.metrics.emplace_back("cache_decode_seconds_per_frame",
+                                perFrame(timer.durationInSeconds(), reader.numberOfFrames()));
+  }
+  if (numberOfCheckpoints > 0) {
+    report.metrics.emplace_back("checkpoint_snapshot_seconds",
+                                checkpointSnapshotSeconds / numberOfCheckpoints);
+    report.metrics.emplace_back("checkpoint_compression_ratio",
+                                checkpointWriter.lastCompressionRatio());
+  }
+  for (size_t p = 0; p < phaseSeconds.size(); ++p) {
+    const std::string phase = subTimeStepPhaseName(static_cast<SubTimeStepPhase>(p));
+    report.metrics.emplace_back(phase + "_seconds_per_frame",
+                                perFrame(phaseSeconds[p], numberOfSimulatedFrames));
+  }
+
+  if (!scenes::writeReport(report, outputFilename)) {
+    fprintf(stderr, "Cannot write %s\n", outputFilename.c_str());
+    return 1;
+  }
+  for (const auto& metric : report.metrics) {
+    printf("%-36s %14.6f\n", metric.first.c_str(), metric.second);
+  }
+
+  if (baselineFilename.empty()) {
+    return 0;
+  }
+
+  std::map<std::string, double> baseline;
+  if (!scenes::readMetrics(baselineFilename, &baseline)) {
+    fprintf(stderr, "Cannot read baseline %s\n", baselineFilename.c_str());
+    return 1;
+  }
+
+  bool hasRegression = false;
+  printf("\n%-36s %14s %14s %8s\n", "metric", "baseline", "current", "change");
+  for (const scenes::Comparison& c : scenes::compare(baseline, report, defaultTolerance, tolerances)) {
+    double change = (c.baseline != 0.0) ? (c.current / c.baseline - 1.0) * 100.0 : 0.0;
+    printf("%-36s %14.6f %14.6f %+7.1f%%%s\n", c.metric.c_str(), c.baseline, c.current, change,
+           c.isRegression ? "  REGRESSION" : "");
+    hasRegression = hasRegression || c.isRegression;
+  }
+
+  return hasRegression ? 2 : 0;
+}
@@ -0,0 +1,115 @@
+#include "report.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace scenes {
+
+namespace {
+
+void writeString(std::ostream& strm, const std::string& str) {
+  strm << '"';
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      strm << '\\';
+    }
+    strm << c;
+  }
+  strm << '"';
+}
+
+}  // namespace
+
+bool writeReport(const Report& report, const std::string& filename) {
+  std::ofstream file(filename.c_str());
+  if (!file) {
+    return false;
+  }
+
+  file << "{\n";
+  for (const auto& field : report.info) {
+    file << "  ";
+    writeString(file, field.first);
+    file << ": ";
+    writeString(file, field.second);
+    file << ",\n";
+  }
+
+  file << "  \"metrics\": {";
+  file << std::setprecision(10);
+  for (size_t i = 0; i < report.metrics.size(); ++i) {
+    file << (i == 0 ? "\n    " : ",\n    ");
+    writeString(file, report.metrics[i].first);
+    file << ": " << report.metrics[i].second;
+  }
+  file << "\n  }\n}\n";
+
+  return static_cast<bool>(file);
+}
+
+bool readMetrics(const std::string& filename, std::map<std::string, double>* metrics) {
+  std::ifstream file(filename.c_str());
+  if (!file) {
+    return false;
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  const std::string json = buffer.str();
+
+  // The metrics object is flat: "name": number pairs until the closing brace
+  size_t pos = json.find("\"metrics\"");
+  if (pos == std::string::npos || (pos = json.find('{', pos)) == std::string::npos) {
+    return false;
+  }
+  const size_t end = json.find('}', pos);
+  if (end == std::string::npos) {
+    return false;
+  }
+
+  while ((pos = json.find('"', pos)) < end) {
+    size_t nameEnd = json.find('"', pos + 1);
+    size_t colon = json.find(':', nameEnd);
+    if (nameEnd == std::string::npos || colon == std::string::npos || colon > end) {
+      return false;
+    }
+
+    const char* valueBegin = json.c_str() + colon + 1;
+    char* valueEnd = nullptr;
+    double value = std::strtod(valueBegin, &valueEnd);
+    if (valueEnd == valueBegin) {
+      return false;
+    }
+
+    (*metrics)[json.substr(pos + 1, nameEnd - pos - 1)] = value;
+    pos = static_cast<size_t>(valueEnd - json.c_str());
+  }
+
+  return true;
+}
+
+std::vector<Comparison> compare(const std::map<std::string, double>& baseline, const Report& report,
+                                double defaultTolerance,
+                                const std::map<std::string, double>& tolerances) {
+  std::vector<Comparison> result;
+  for (const auto& metric : report.metrics) {
+    auto base = baseline.find(metric.first);
+    if (base == baseline.end()) {
+      continue;
+    }
+
+    Comparison comparison;
+    comparison.metric = metric.first;
+    comparison.baseline = base->second;
+    comparison.current = metric.second;
+    auto tolerance = tolerances.find(metric.first);
+    comparison.tolerance = (tolerance != tolerances.end()) ? tolerance->second : defaultTolerance;
+    comparison.isRegression =
+        comparison.current > comparison.baseline * (1.0 + comparison.tolerance);
+    result.push_back(comparison);
+  }
+  return result;
+}
+
+}  // namespace scenes
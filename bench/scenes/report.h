@@ -0,0 +1,41 @@
+#ifndef BENCH_SCENES_REPORT_H_
+#define BENCH_SCENES_REPORT_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace scenes {
+
+// Result of one scene run. Every metric is "lower is better".
+struct Report {
+  // Descriptive fields that are written but never compared
+  std::vector<std::pair<std::string, std::string>> info;
+  std::vector<std::pair<std::string, double>> metrics;
+};
+
+// Writes the report as JSON; returns false if the file cannot be written.
+bool writeReport(const Report& report, const std::string& filename);
+
+// Reads the "metrics" object of a report written by writeReport.
+bool readMetrics(const std::string& filename, std::map<std::string, double>* metrics);
+
+struct Comparison {
+  std::string metric;
+  double baseline = 0.0;
+  double current = 0.0;
+  double tolerance = 0.0;
+  bool isRegression = false;
+};
+
+// Compares each metric present in both reports. A metric regresses when it
+// exceeds the baseline by more than its relative tolerance; metrics without an
+// entry in tolerances use defaultTolerance.
+std::vector<Comparison> compare(const std::map<std::string, double>& baseline, const Report& report,
+                                double defaultTolerance,
+                                const std::map<std::string, double>& tolerances);
+
+}  // namespace scenes
+
+#endif  // BENCH_SCENES_REPORT_H_
@@ -0,0 +1,94 @@
+#include "scenes.h"
+
+#include "mfd.hpp"
+
+using namespace jet;
+
+namespace scenes {
+
+namespace {
+
+// Closed box collider around the domain
+Collider3Ptr makeContainer(const BoundingBox3D& domain) {
+  auto box = Box3::builder().withIsNormalFlipped(true).withBoundingBox(domain).makeShared();
+  return RigidBodyCollider3::builder().withSurface(box).makeShared();
+}
+
+PciSphSolver3Ptr makeBlockOfWater(const BoundingBox3D& domain, const BoundingBox3D& water,
+                                  double targetSpacing) {
+  auto solver = PciSphSolver3::builder()
+                    .withTargetDensity(kWaterDensity)
+                    .withTargetSpacing(targetSpacing)
+                    .withRelativeKernelRadius(1.8)
+                    .makeShared();
+  solver->setPseudoViscosityCoefficient(0);
+
+  BoundingBox3D sourceBound(domain);
+  sourceBound.expand(-targetSpacing);
+
+  auto box = Box3::builder().withBoundingBox(water).makeShared();
+  auto emitter = VolumeParticleEmitter3::builder()
+                     .withSurface(box)
+                     .withSpacing(targetSpacing)
+                     .withMaxRegion(sourceBound)
+                     .withIsOneShot(true)
+                     .withRandomSeed(kSeed)
+                     .makeShared();
+  solver->setEmitter(emitter);
+  solver->setCollider(makeContainer(domain));
+  return solver;
+}
+
+}  // namespace
+
+std::vector<std::string> sceneNames() { return {"sphere_drop", "dam_break", "tank_1m"}; }
+
+bool makeScene(const std::string& name, Scene* scene) {
+  scene->name = name;
+
+  if (name == "sphere_drop") {
+    // The viewer's scene: a sphere of water dropped next to a thin wall
+    scene->description = "Viewer scene (mfd.hpp) with the domain2 wall obstacle";
+    init(scene->solver, 0.08, 0, 60.0);
+    scene->domain = domain;
+    scene->reconstructionKernelRadius = 0.07;
+    scene->reconstructionGridSpacing = 0.04;
+  } else if (name == "dam_break") {
+    scene->description = "Water column collapsing in a 3 x 2 x 1 box";
+    scene->domain = BoundingBox3D(Vector3D(0, 0, 0), Vector3D(3, 2, 1));
+    scene->solver = makeBlockOfWater(scene->domain,
+                                     BoundingBox3D(Vector3D(0, 0, 0), Vector3D(1, 1.5, 1)), 0.04);
+    scene->reconstructionKernelRadius = 0.07;
+    scene->reconstructionGridSpacing = 0.04;
+  } else if (name == "tank_1m") {
+    scene->description = "Resting tank of about one million particles";
+    scene->domain = BoundingBox3D(Vector3D(0, 0, 0), Vector3D(2, 1, 1));
+    scene->solver = makeBlockOfWater(
+        scene->domain, BoundingBox3D(Vector3D(0, 0, 0), Vector3D(2, 0.5, 1)), 0.01);
+    scene->reconstructionKernelRadius = 0.018;
+    scene->reconstructionGridSpacing = 0.01;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+size_t reconstructSurface(const Scene& scene) {
+  const double h = scene.reconstructionGridSpacing;
+  Size3 resolution(static_cast<size_t>(scene.domain.width() / h),
+                   static_cast<size_t>(scene.domain.height() / h),
+                   static_cast<size_t>(scene.domain.depth() / h));
+
+  VertexCenteredScalarGrid3 sdf(resolution, Vector3D(h, h, h), scene.domain.lowerCorner);
+  ZhuBridsonPointsToImplicit3 converter(scene.reconstructionKernelRadius,
+                                        sZhuBridsonCutOffThreshold, false);
+  converter.convert(scene.solver->particleSystemData()->positions(), &sdf);
+
+  TriangleMesh3 mesh;
+  marchingCubes(sdf.dataAccessor(), sdf.gridSpacing(), sdf.dataOrigin(), &mesh, 0.0,
+                kDirectionAll);
+  return mesh.numberOfTriangles();
+}
+
+}  // namespace scenes
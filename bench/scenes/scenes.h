@@ -0,0 +1,37 @@
+#ifndef BENCH_SCENES_SCENES_H_
+#define BENCH_SCENES_SCENES_H_
+
+#include <jet/bounding_box3.h>
+#include <jet/pci_sph_solver3.h>
+
+#include <string>
+#include <vector>
+
+namespace scenes {
+
+// Seed for every random choice a scene makes (emitter jitter, ...)
+constexpr uint32_t kSeed = 0;
+
+struct Scene {
+  std::string name;
+  std::string description;
+  jet::PciSphSolver3Ptr solver;
+  // Domain used for the surface reconstruction
+  jet::BoundingBox3D domain;
+  double reconstructionKernelRadius = 0.0;
+  double reconstructionGridSpacing = 0.0;
+};
+
+// Names of the standard scenes
+std::vector<std::string> sceneNames();
+
+// Builds the named scene; returns false if there is no such scene
+bool makeScene(const std::string& name, Scene* scene);
+
+// Reconstructs the surface of the scene's particles with the viewer's
+// Zhu-Bridson settings and returns the number of triangles.
+size_t reconstructSurface(const Scene& scene);
+
+}  // namespace scenes
+
+#endif  // BENCH_SCENES_SCENES_H_
@@ -0,0 +1,89 @@
+#ifndef FRAME_GRAPH_H
+#define FRAME_GRAPH_H
+
+#include <jet/array1.h>
+#include <jet/async.h>
+#include <jet/triangle_mesh3.h>
+#include <jet/vector3.h>
+
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Everything the side lane knows about one simulated frame. The positions are a
+// copy taken when the frame ended, so the solver can advance the next frame
+// while the stages read them.
+struct FrameData {
+  unsigned int index = 0;
+  jet::Array1<jet::Vector3D> positions;
+  jet::TriangleMesh3 mesh;
+  // Wall time of each stage in seconds, indexed by stage id. Every stage only
+  // writes its own slot, so stages of the same frame may run concurrently.
+  std::vector<double> stageSeconds;
+  // Exception thrown by each stage, or null, indexed by stage id like
+  // stageSeconds. A failed stage is logged and the pipeline keeps running.
+  std::vector<std::exception_ptr> stageErrors;
+};
+
+// A small per-frame task graph that runs post-processing (surface
+// reconstruction, export, statistics, ...) off the simulation thread.
+//
+// Stages are registered once and instantiated for every submitted frame. A
+// stage starts when the stages it depends on have finished for the same frame
+// and the same stage has finished for the previous frame, so e.g. exports are
+// written in frame order. At most maxFramesInFlight frames are processed at a
+// time; Submit blocks when the limit is reached, which caps the memory used by
+// snapshots and lets the simulation run at most that many frames ahead.
+class FrameGraph {
+ public:
+  using StageFunction = std::function<void(FrameData &)>;
+
+  explicit FrameGraph(size_t maxFramesInFlight = 2);
+  // Waits for all frames in flight
+  ~FrameGraph();
+
+  FrameGraph(const FrameGraph &) = delete;
+  FrameGraph &operator=(const FrameGraph &) = delete;
+
+  // Registers a stage that runs after the given stages and returns its id.
+  // Dependencies must have been added before, so the graph is always acyclic.
+  size_t AddStage(const std::string &name, StageFunction function,
+                  const std::vector<size_t> &dependsOn = {});
+
+  // Copies the positions of the finished frame and schedules all stages for it
+  void Submit(unsigned int frameIndex, const jet::ConstArrayAccessor1<jet::Vector3D> &positions);
+
+  // Returns the newest frame that completed since the last call, or nullptr
+  std::shared_ptr<const FrameData> PopLatestCompleted();
+
+  // Blocks until every submitted frame has completed
+  void Flush();
+
+  size_t NumberOfStages() const;
+  const std::string &StageName(size_t stageId) const;
+
+ private:
+  struct Stage {
+    std::string name;
+    StageFunction function;
+    std::vector<size_t> dependsOn;
+  };
+
+  struct FrameInFlight {
+    std::shared_ptr<FrameData> data;
+    jet::TaskHandle<void> completion;
+  };
+
+  size_t maxFramesInFlight;
+  std::vector<Stage> stages;
+  std::vector<jet::TaskHandle<void>> lastStageTasks;
+  std::deque<FrameInFlight> framesInFlight;
+  std::shared_ptr<const FrameData> latestCompleted;
+
+  void retireOldestFrame();
+};
+
+#endif
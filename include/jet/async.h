@@ -0,0 +1,254 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_ASYNC_H_
+#define INCLUDE_JET_ASYNC_H_
+
+#include <jet/macros.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace jet {
+
+//! Exception thrown by TaskHandle::get() when the task was canceled.
+class TaskCanceledError : public std::runtime_error {
+ public:
+    TaskCanceledError() : std::runtime_error("Task was canceled") {}
+};
+
+namespace internal {
+
+//!
+//! \brief Type-independent part of the shared state behind a TaskHandle.
+//!
+//! A task goes through the following states:
+//!
+//!     kWaiting --(all dependencies done)--> kPending --(claimed)--> kRunning
+//!     kRunning --> kDone | kFailed
+//!     kWaiting | kPending --(cancel or failed dependency)--> kCanceled
+//!
+//! Whoever claims a pending task runs it: either the backend worker it was
+//! scheduled on, or a thread that calls wait() before the worker gets to it.
+//!
+class TaskStateBase : public std::enable_shared_from_this<TaskStateBase> {
+ public:
+    explicit TaskStateBase(size_t numberOfDependencies);
+
+    virtual ~TaskStateBase();
+
+    JET_NON_COPYABLE(TaskStateBase)
+
+    //! Runs the task on the calling thread if nobody has claimed it yet.
+    void tryRun();
+
+    //! Cancels the task if it has not started yet.
+    bool cancel();
+
+    //! Blocks until the task is done, failed or canceled.
+    void wait();
+
+    //! Returns true if the task is done, failed or canceled.
+    bool isReady() const;
+
+    //! Returns true if the task was canceled.
+    bool isCanceled() const;
+
+    //! Rethrows the task's exception, or throws TaskCanceledError.
+    void rethrowIfNotSucceeded() const;
+
+    //! Calls \p continuation once the task is finished, with true if the task
+    //! succeeded. Calls it immediately if the task is already finished.
+    void addContinuation(const std::function<void(bool)>& continuation);
+
+    //! Notifies that one of the dependencies finished.
+    void onDependencyFinished(bool succeeded);
+
+    //! Moves the task to the pending state and hands it to the backend.
+    void schedule();
+
+ protected:
+    //! Runs the user function and stores its result.
+    virtual void invoke() = 0;
+
+ private:
+    enum Status : int { kWaiting, kPending, kRunning, kDone, kFailed, kCanceled };
+
+    std::atomic<int> _status;
+    std::atomic<size_t> _numberOfPendingDependencies;
+    std::atomic<bool> _hasFailedDependency{false};
+    std::exception_ptr _exception;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _finished;
+    std::vector<std::function<void(bool)>> _continuations;
+
+    void finish(int status);
+};
+
+template <typename T>
+class TaskState final : public TaskStateBase {
+ public:
+    template <typename Function>
+    TaskState(Function&& func, size_t numberOfDependencies)
+        : TaskStateBase(numberOfDependencies),
+          _func(std::forward<Function>(func)) {}
+
+    T& value() { return *_value; }
+
+ protected:
+    void invoke() override {
+        _value.emplace(_func());
+        _func = nullptr;
+    }
+
+ private:
+    std::function<T()> _func;
+    std::optional<T> _value;
+};
+
+template <>
+class TaskState<void> final : public TaskStateBase {
+ public:
+    template <typename Function>
+    TaskState(Function&& func, size_t numberOfDependencies)
+        : TaskStateBase(numberOfDependencies),
+          _func(std::forward<Function>(func)) {}
+
+ protected:
+    void invoke() override {
+        _func();
+        _func = nullptr;
+    }
+
+ private:
+    std::function<void()> _func;
+};
+
+}  // namespace internal
+
+//!
+//! \brief Handle to an asynchronously running task.
+//!
+//! Handles are cheap to copy; all copies refer to the same task. Destroying
+//! the last handle does not cancel or wait for the task.
+//!
+//! \tparam T Return type of the task.
+//!
+template <typename T>
+class TaskHandle {
+ public:
+    //! Constructs an empty handle that refers to no task.
+    TaskHandle() = default;
+
+    //! Returns true if the handle refers to a task.
+    bool isValid() const;
+
+    //! Returns true if the task is finished, failed or canceled.
+    bool isReady() const;
+
+    //! Returns true if the task was canceled.
+    bool isCanceled() const;
+
+    //!
+    //! \brief Blocks until the task is finished, failed or canceled.
+    //!
+    //! If the task has not been picked up by a worker yet, it runs on the
+    //! calling thread instead, so waiting never deadlocks on a busy backend.
+    //!
+    void wait() const;
+
+    //!
+    //! \brief Waits for the task and returns its result.
+    //!
+    //! Rethrows the exception thrown by the task, or throws TaskCanceledError
+    //! if the task was canceled.
+    //!
+    decltype(auto) get() const;
+
+    //!
+    //! \brief Cancels the task if it has not started yet.
+    //!
+    //! Tasks that depend on a canceled task are canceled too. A task that is
+    //! already running is not interrupted.
+    //!
+    //! \return True if the task will not run.
+    //!
+    bool cancel() const;
+
+    //!
+    //! \brief Schedules \p func to run after this task succeeds.
+    //!
+    //! If this task fails or is canceled, the returned task is canceled.
+    //!
+    template <typename Function>
+    TaskHandle<std::invoke_result_t<std::decay_t<Function>>> then(
+        Function&& func) const;
+
+ private:
+    std::shared_ptr<internal::TaskState<T>> _state;
+
+    explicit TaskHandle(const std::shared_ptr<internal::TaskState<T>>& state);
+
+    template <typename U>
+    friend class TaskHandle;
+
+    template <typename Function, typename... Dependencies>
+    friend TaskHandle<std::invoke_result_t<std::decay_t<Function>>> async(
+        Function&& func, const TaskHandle<Dependencies>&... dependencies);
+
+    template <typename Function, typename Dependency>
+    friend TaskHandle<std::invoke_result_t<std::decay_t<Function>>> async(
+        Function&& func,
+        const std::vector<TaskHandle<Dependency>>& dependencies);
+};
+
+//!
+//! \brief Runs \p func asynchronously and returns a handle to wait on.
+//!
+//! With the TBB backend the task is enqueued to the task arena used by the
+//! parallel algorithms; with the C++11 thread backend it is queued to the
+//! persistent worker pool; otherwise it runs synchronously. The function object is copied, so
+//! captured references must outlive the task.
+//!
+//! \code{.cpp}
+//! auto mesh = jet::async([=]() { return reconstruct(positions); });
+//! auto saved = mesh.then([=]() { writeObj(mesh.get()); });
+//! saved.wait();
+//! \endcode
+//!
+//! \param[in]  func         The function to run.
+//! \param[in]  dependencies Tasks that must succeed before \p func starts. If
+//!                          any of them fails or is canceled, the returned
+//!                          task is canceled.
+//!
+template <typename Function, typename... Dependencies>
+TaskHandle<std::invoke_result_t<std::decay_t<Function>>> async(
+    Function&& func, const TaskHandle<Dependencies>&... dependencies);
+
+//!
+//! \brief Runs \p func asynchronously after a run-time list of tasks.
+//!
+//! Same as the variadic overload, but takes the dependencies as a vector.
+//! Empty handles in the list are ignored.
+//!
+template <typename Function, typename Dependency>
+TaskHandle<std::invoke_result_t<std::decay_t<Function>>> async(
+    Function&& func, const std::vector<TaskHandle<Dependency>>& dependencies);
+
+}  // namespace jet
+
+#include "detail/async-inl.h"
+
+#endif  // INCLUDE_JET_ASYNC_H_
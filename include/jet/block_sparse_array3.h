@@ -0,0 +1,178 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_BLOCK_SPARSE_ARRAY3_H_
+#define INCLUDE_JET_BLOCK_SPARSE_ARRAY3_H_
+
+#include <jet/parallel.h>
+#include <jet/size3.h>
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief 3-D block-sparse array class.
+//!
+//! This class stores a 3-D array as tiles of kTileSize^3 elements that are
+//! allocated on demand. A flat top-level table maps each tile coordinate to
+//! its storage; elements of unallocated tiles read as the background value.
+//! Reading with operator() never allocates, while writing through
+//! activeValue() allocates the tile, filled with the background. The memory
+//! and the cost of the active-index loops thus scale with the number of
+//! allocated tiles rather than with the array size. Within a tile the
+//! elements are stored i-first, as in Array3.
+//!
+//! Allocating tiles is not thread-safe. Parallel writes must either stay
+//! within the active tiles, e.g. in parallelForEachActiveIndex, or activate
+//! the tiles beforehand.
+//!
+//! \tparam T - Type to store in the array.
+//!
+template <typename T>
+class BlockSparseArray3 final {
+ public:
+    static_assert(
+        std::is_floating_point<T>::value,
+        "BlockSparseArray3 only can be instantiated with floating point types");
+
+    //! Number of elements along each edge of a tile.
+    static constexpr size_t kTileSize = 8;
+
+    //! Number of elements in a tile.
+    static constexpr size_t kTileVolume = kTileSize * kTileSize * kTileSize;
+
+    //! Constructs zero-sized array.
+    BlockSparseArray3();
+
+    //! Constructs an array of given \p size without any allocated tile.
+    explicit BlockSparseArray3(const Size3& size, T background = T());
+
+    //! Copy constructor.
+    BlockSparseArray3(const BlockSparseArray3& other);
+
+    //! Move constructor.
+    BlockSparseArray3(BlockSparseArray3&& other);
+
+    //! Copies given array \p other to this array.
+    void set(const BlockSparseArray3& other);
+
+    //! Clears the array and resizes to zero.
+    void clear();
+
+    //!
+    //! \brief Resizes the array with \p size and \p background.
+    //!
+    //! Unlike Array3::resize, this function releases all the tiles.
+    //!
+    void resize(const Size3& size, T background = T());
+
+    //! Returns the size of the array.
+    Size3 size() const;
+
+    //! Returns the number of tiles along each axis.
+    Size3 tileResolution() const;
+
+    //! Returns the value of the elements in unallocated tiles.
+    T background() const;
+
+    //! Returns the number of allocated tiles.
+    size_t numberOfActiveTiles() const;
+
+    //! Returns true if the tile containing (i, j, k) is allocated.
+    bool isActive(size_t i, size_t j, size_t k) const;
+
+    //! Allocates the tile containing (i, j, k) if not allocated yet.
+    void activate(size_t i, size_t j, size_t k);
+
+    //! Returns the element at (i, j, k), or the background if its tile is
+    //! not allocated.
+    const T& operator()(size_t i, size_t j, size_t k) const;
+
+    //! Returns the reference to the element at (i, j, k), allocating its
+    //! tile if needed.
+    T& activeValue(size_t i, size_t j, size_t k);
+
+    //! Releases all the tiles and sets the background to \p value.
+    void fill(T value);
+
+    //!
+    //! \brief Sets every element to func(i, j, k).
+    //!
+    //! The function is evaluated for all the elements, tile by tile, and only
+    //! the tiles holding a value other than the background stay allocated.
+    //!
+    void fill(const std::function<T(size_t, size_t, size_t)>& func,
+              ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+    //! Releases the tiles whose elements all differ from the background by
+    //! at most \p tolerance.
+    void prune(T tolerance = T());
+
+    //!
+    //! \brief Iterates the elements of the allocated tiles.
+    //!
+    //! This function invokes \p func with the (i, j, k) indices of each
+    //! element in the allocated tiles, except for the elements outside the
+    //! array size in the tiles at the upper boundaries. The tiles are visited
+    //! in allocation order and the elements within a tile i-first.
+    //!
+    void forEachActiveIndex(
+        const std::function<void(size_t, size_t, size_t)>& func) const;
+
+    //!
+    //! \brief Iterates the elements of the allocated tiles in parallel.
+    //!
+    //! Same as forEachActiveIndex, except that the tiles are processed in
+    //! parallel in arbitrary order. Since the visited tiles are allocated,
+    //! \p func may write to the visited elements through activeValue().
+    //!
+    void parallelForEachActiveIndex(
+        const std::function<void(size_t, size_t, size_t)>& func) const;
+
+    //! Swaps the content of the array with \p other array.
+    void swap(BlockSparseArray3& other);
+
+    //! Copies given array \p other to this array.
+    BlockSparseArray3& operator=(const BlockSparseArray3& other);
+
+    //! Moves given array \p other to this array.
+    BlockSparseArray3& operator=(BlockSparseArray3&& other);
+
+ private:
+    Size3 _size;
+    Size3 _tileResolution;
+    T _background = T();
+
+    // Top-level index from the tile coordinate to the tile storage, or
+    // nullptr for the tiles that are not allocated.
+    std::vector<T*> _table;
+    std::vector<std::unique_ptr<T[]>> _tiles;
+    std::vector<size_t> _tileIds;
+
+    size_t tileId(size_t i, size_t j, size_t k) const;
+
+    T* allocateTile(size_t tileId);
+
+    void forEachIndexInTile(
+        size_t tileId,
+        const std::function<void(size_t, size_t, size_t)>& func) const;
+};
+
+//! Float-type 3-D block-sparse array.
+typedef BlockSparseArray3<float> BlockSparseArray3F;
+
+//! Double-type 3-D block-sparse array.
+typedef BlockSparseArray3<double> BlockSparseArray3D;
+
+}  // namespace jet
+
+#include "detail/block_sparse_array3-inl.h"
+
+#endif  // INCLUDE_JET_BLOCK_SPARSE_ARRAY3_H_
@@ -65,6 +65,32 @@ void pcg(
     unsigned int* lastNumberOfIterations,
     double* lastResidualNorm);
 
+//!
+//! \brief Solves conjugate gradient in the pipelined form.
+//!
+//! This is the pipelined CG method by Ghysels and Vanroose, which is
+//! mathematically equivalent to cg but rearranged so that each iteration
+//! consists of one matrix-vector multiplication and a single fused pass that
+//! updates all vectors and computes both dot products. In addition to the
+//! regular BLAS operators, \p BlasType must provide mvmDot and
+//! pipelinedCgUpdate, as FdmBlas3 does.
+//!
+template <typename BlasType>
+void pipelinedCg(
+    const typename BlasType::MatrixType& A,
+    const typename BlasType::VectorType& b,
+    unsigned int maxNumberOfIterations,
+    double tolerance,
+    typename BlasType::VectorType* x,
+    typename BlasType::VectorType* r,
+    typename BlasType::VectorType* w,
+    typename BlasType::VectorType* p,
+    typename BlasType::VectorType* s,
+    typename BlasType::VectorType* q,
+    typename BlasType::VectorType* z,
+    unsigned int* lastNumberOfIterations,
+    double* lastResidualNorm);
+
 }  // namespace jet
 
 #include "detail/cg-inl.h"
@@ -0,0 +1,148 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_CHECKPOINT_H_
+#define INCLUDE_JET_CHECKPOINT_H_
+
+#include <jet/physics_animation.h>
+#include <jet/state_archive.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief      On-disk layout of a checkpoint file.
+//!
+//! A checkpoint file is a header followed by the PhysicsAnimation state
+//! archive, either as is or losslessly compressed. The compressed encoding
+//! XORs every 8-byte word with the previous one, splits the words into byte
+//! planes, and run-length encodes zero bytes, which works well for the
+//! slowly varying doubles that make up most of a particle state. Values are
+//! stored in the byte order of the writing machine.
+//!
+namespace checkpoint {
+
+//! Current version of the file format.
+constexpr uint32_t kVersion = 1;
+
+//! Encoding of the state archive.
+enum Encoding : uint32_t {
+    //! The archive bytes as is.
+    kRaw = 0,
+
+    //! XOR-delta, byte-plane shuffled, zero run-length encoded archive.
+    kShuffledRle = 1,
+};
+
+//! File header.
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t encoding;
+    uint64_t stateSize;
+    uint64_t payloadSize;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(FileHeader) == 40, "Unexpected checkpoint header size");
+
+}  // namespace checkpoint
+
+//!
+//! \brief      Writes checkpoints of a PhysicsAnimation in the background.
+//!
+//! save() captures the animation state on the calling thread, which only
+//! copies the particle layers into a recycled buffer, and hands it over to a
+//! worker thread that compresses it and writes it to disk. The file is
+//! written under a temporary name and renamed when complete, so an existing
+//! checkpoint is never left half-written. One checkpoint can be pending at a
+//! time; save() waits for the previous one only after taking its snapshot.
+//!
+//! \see loadCheckpoint
+//!
+class CheckpointWriter {
+ public:
+    //! Constructs the writer and starts its worker thread.
+    CheckpointWriter();
+
+    //! Waits for the pending checkpoint and stops the worker thread.
+    ~CheckpointWriter();
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    //! Returns true if the checkpoints are compressed. Default is true.
+    bool isCompressionEnabled() const;
+
+    //! Enables or disables the lossless compression.
+    void setIsCompressionEnabled(bool isEnabled);
+
+    //!
+    //! \brief      Snapshots \p animation and writes it to \p filename in the
+    //!             background.
+    //!
+    //! \return     False if the previous checkpoint could not be written.
+    //!
+    bool save(const PhysicsAnimation& animation, const std::string& filename);
+
+    //! Waits until the pending checkpoint is on disk. Returns false if any
+    //! checkpoint failed since the last flush.
+    bool flush();
+
+    //! Returns the time the last save() spent on the snapshot in seconds.
+    double lastSnapshotTimeInSeconds() const;
+
+    //! Returns the size of the last written file over the state size.
+    double lastCompressionRatio() const;
+
+ private:
+    bool _isCompressionEnabled = true;
+    double _lastSnapshotTimeInSeconds = 0.0;
+    double _lastCompressionRatio = 1.0;
+
+    StateArchive _snapshot;
+    StateArchive _pending;
+    std::string _pendingFilename;
+    bool _hasPending = false;
+    bool _isPendingCompressed = true;
+    bool _hasFailed = false;
+    bool _isStopping = false;
+
+    std::vector<uint8_t> _encoded;
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+    std::thread _worker;
+
+    void run();
+};
+
+//! Writes a checkpoint of \p animation synchronously.
+bool saveCheckpoint(const PhysicsAnimation& animation,
+                    const std::string& filename, bool isCompressed = true);
+
+//!
+//! \brief      Loads a checkpoint into \p animation.
+//!
+//! The animation must be set up the same way as the one that was saved, i.e.
+//! built by the same scene setup code with the same solver type, emitters,
+//! and colliders. Calling update() with the frames after the checkpointed one
+//! then continues the simulation bit-identically.
+//!
+//! \return     False if the file is missing, corrupted, or does not match the
+//!             animation; the animation state is undefined in that case.
+//!
+bool loadCheckpoint(const std::string& filename, PhysicsAnimation* animation);
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_CHECKPOINT_H_
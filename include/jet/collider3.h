@@ -7,6 +7,7 @@
 #ifndef INCLUDE_JET_COLLIDER3_H_
 #define INCLUDE_JET_COLLIDER3_H_
 
+#include <jet/state_archive.h>
 #include <jet/surface3.h>
 #include <functional>
 
@@ -84,6 +85,17 @@ class Collider3 {
     //!
     void setOnBeginUpdateCallback(const OnBeginUpdateCallback& callback);
 
+    //!
+    //! \brief      Saves the run-time state of the collider for checkpointing.
+    //!
+    //! This includes the friction coefficient and the transform of the
+    //! surface, since update callbacks commonly move the collider.
+    //!
+    void saveState(StateArchive* archive) const;
+
+    //! Loads the run-time state saved by Collider3::saveState.
+    void loadState(StateArchive* archive);
+
  protected:
     //! Internal query result structure.
     struct ColliderQueryResult final {
@@ -96,6 +108,12 @@ class Collider3 {
     //! Assigns the surface instance from the subclass.
     void setSurface(const Surface3Ptr& newSurface);
 
+    //! Called when Collider3::saveState is executed.
+    virtual void onSaveState(StateArchive* archive) const;
+
+    //! Called when Collider3::loadState is executed.
+    virtual void onLoadState(StateArchive* archive);
+
     //! Outputs closest point's information.
     void getClosestPoint(
         const Surface3Ptr& surface,
@@ -41,6 +41,10 @@ class ColliderSet3 final : public Collider3 {
 
  private:
     std::vector<Collider3Ptr> _colliders;
+
+    void onSaveState(StateArchive* archive) const override;
+
+    void onLoadState(StateArchive* archive) override;
 };
 
 //! Shared pointer for the ColliderSet3 type.
@@ -7,7 +7,9 @@
 #ifndef INCLUDE_JET_CONSTANTS_H_
 #define INCLUDE_JET_CONSTANTS_H_
 
-#ifndef JET_TASKING_TBB
+// TBB is the default tasking backend unless another one is selected.
+#if !defined(JET_TASKING_TBB) && !defined(JET_TASKING_CPP11THREADS) && \
+    !defined(JET_TASKING_OPENMP) && !defined(JET_TASKING_SERIAL)
 #define JET_TASKING_TBB
 #endif
 
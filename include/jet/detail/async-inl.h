@@ -0,0 +1,115 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_DETAIL_ASYNC_INL_H_
+#define INCLUDE_JET_DETAIL_ASYNC_INL_H_
+
+#include <utility>
+
+namespace jet {
+
+template <typename T>
+TaskHandle<T>::TaskHandle(const std::shared_ptr<internal::TaskState<T>>& state) : _state(state) {}
+
+template <typename T>
+bool TaskHandle<T>::isValid() const {
+  return _state != nullptr;
+}
+
+template <typename T>
+bool TaskHandle<T>::isReady() const {
+  JET_ASSERT(isValid());
+  return _state->isReady();
+}
+
+template <typename T>
+bool TaskHandle<T>::isCanceled() const {
+  JET_ASSERT(isValid());
+  return _state->isCanceled();
+}
+
+template <typename T>
+void TaskHandle<T>::wait() const {
+  JET_ASSERT(isValid());
+  _state->wait();
+}
+
+template <typename T>
+decltype(auto) TaskHandle<T>::get() const {
+  JET_ASSERT(isValid());
+  _state->wait();
+  _state->rethrowIfNotSucceeded();
+  if constexpr (!std::is_void<T>::value) {
+    return static_cast<T&>(_state->value());
+  }
+}
+
+template <typename T>
+bool TaskHandle<T>::cancel() const {
+  JET_ASSERT(isValid());
+  return _state->cancel();
+}
+
+template <typename T>
+template <typename Function>
+TaskHandle<std::invoke_result_t<std::decay_t<Function>>> TaskHandle<T>::then(
+    Function&& func) const {
+  return async(std::forward<Function>(func), *this);
+}
+
+template <typename Function, typename... Dependencies>
+TaskHandle<std::invoke_result_t<std::decay_t<Function>>> async(
+    Function&& func, const TaskHandle<Dependencies>&... dependencies) {
+  using Result = std::invoke_result_t<std::decay_t<Function>>;
+
+  auto state = std::make_shared<internal::TaskState<Result>>(std::forward<Function>(func),
+                                                             sizeof...(Dependencies));
+
+  if constexpr (sizeof...(Dependencies) == 0) {
+    state->schedule();
+  } else {
+    // The continuation keeps the dependent task alive until it is released.
+    std::function<void(bool)> onFinished = [state](bool succeeded) {
+      state->onDependencyFinished(succeeded);
+    };
+    (dependencies._state->addContinuation(onFinished), ...);
+  }
+
+  return TaskHandle<Result>(state);
+}
+
+template <typename Function, typename Dependency>
+TaskHandle<std::invoke_result_t<std::decay_t<Function>>> async(
+    Function&& func, const std::vector<TaskHandle<Dependency>>& dependencies) {
+  using Result = std::invoke_result_t<std::decay_t<Function>>;
+
+  size_t numberOfDependencies = 0;
+  for (const auto& dependency : dependencies) {
+    numberOfDependencies += dependency.isValid() ? 1 : 0;
+  }
+
+  auto state =
+      std::make_shared<internal::TaskState<Result>>(std::forward<Function>(func), numberOfDependencies);
+
+  if (numberOfDependencies == 0) {
+    state->schedule();
+  } else {
+    std::function<void(bool)> onFinished = [state](bool succeeded) {
+      state->onDependencyFinished(succeeded);
+    };
+    for (const auto& dependency : dependencies) {
+      if (dependency.isValid()) {
+        dependency._state->addContinuation(onFinished);
+      }
+    }
+  }
+
+  return TaskHandle<Result>(state);
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_ASYNC_INL_H_
@@ -0,0 +1,278 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_DETAIL_BLOCK_SPARSE_ARRAY3_INL_H_
+#define INCLUDE_JET_DETAIL_BLOCK_SPARSE_ARRAY3_INL_H_
+
+#include <jet/block_sparse_array3.h>
+#include <jet/macros.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace jet {
+
+template <typename T>
+BlockSparseArray3<T>::BlockSparseArray3() {}
+
+template <typename T>
+BlockSparseArray3<T>::BlockSparseArray3(const Size3& size, T background) {
+    resize(size, background);
+}
+
+template <typename T>
+BlockSparseArray3<T>::BlockSparseArray3(const BlockSparseArray3& other) {
+    set(other);
+}
+
+template <typename T>
+BlockSparseArray3<T>::BlockSparseArray3(BlockSparseArray3&& other) {
+    swap(other);
+}
+
+template <typename T>
+void BlockSparseArray3<T>::set(const BlockSparseArray3& other) {
+    if (this == &other) {
+        return;
+    }
+
+    resize(other._size, other._background);
+
+    _tiles.resize(other._tiles.size());
+    _tileIds = other._tileIds;
+    for (size_t t = 0; t < _tiles.size(); ++t) {
+        _tiles[t].reset(new T[kTileVolume]);
+        std::copy(other._tiles[t].get(), other._tiles[t].get() + kTileVolume,
+                  _tiles[t].get());
+        _table[_tileIds[t]] = _tiles[t].get();
+    }
+}
+
+template <typename T>
+void BlockSparseArray3<T>::clear() {
+    resize(Size3(), T());
+}
+
+template <typename T>
+void BlockSparseArray3<T>::resize(const Size3& size, T background) {
+    _size = size;
+    _tileResolution = Size3((size.x + kTileSize - 1) / kTileSize,
+                            (size.y + kTileSize - 1) / kTileSize,
+                            (size.z + kTileSize - 1) / kTileSize);
+    _background = background;
+
+    _table.assign(
+        _tileResolution.x * _tileResolution.y * _tileResolution.z, nullptr);
+    _tiles.clear();
+    _tileIds.clear();
+}
+
+template <typename T>
+Size3 BlockSparseArray3<T>::size() const {
+    return _size;
+}
+
+template <typename T>
+Size3 BlockSparseArray3<T>::tileResolution() const {
+    return _tileResolution;
+}
+
+template <typename T>
+T BlockSparseArray3<T>::background() const {
+    return _background;
+}
+
+template <typename T>
+size_t BlockSparseArray3<T>::numberOfActiveTiles() const {
+    return _tiles.size();
+}
+
+template <typename T>
+bool BlockSparseArray3<T>::isActive(size_t i, size_t j, size_t k) const {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+    return _table[tileId(i, j, k)] != nullptr;
+}
+
+template <typename T>
+void BlockSparseArray3<T>::activate(size_t i, size_t j, size_t k) {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+    const size_t id = tileId(i, j, k);
+    if (_table[id] == nullptr) {
+        allocateTile(id);
+    }
+}
+
+template <typename T>
+const T& BlockSparseArray3<T>::operator()(size_t i, size_t j, size_t k) const {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+    const T* tile = _table[tileId(i, j, k)];
+    if (tile == nullptr) {
+        return _background;
+    }
+    return tile[(i % kTileSize) +
+                kTileSize * ((j % kTileSize) + kTileSize * (k % kTileSize))];
+}
+
+template <typename T>
+T& BlockSparseArray3<T>::activeValue(size_t i, size_t j, size_t k) {
+    JET_ASSERT(i < _size.x && j < _size.y && k < _size.z);
+    const size_t id = tileId(i, j, k);
+    T* tile = _table[id];
+    if (tile == nullptr) {
+        tile = allocateTile(id);
+    }
+    return tile[(i % kTileSize) +
+                kTileSize * ((j % kTileSize) + kTileSize * (k % kTileSize))];
+}
+
+template <typename T>
+void BlockSparseArray3<T>::fill(T value) {
+    resize(_size, value);
+}
+
+template <typename T>
+void BlockSparseArray3<T>::fill(
+    const std::function<T(size_t, size_t, size_t)>& func,
+    ExecutionPolicy policy) {
+    // Evaluate each tile into its own buffer and keep the buffers holding
+    // anything but the background, so the peak memory stays proportional to
+    // the active tiles
+    std::vector<std::unique_ptr<T[]>> candidates(_table.size());
+    parallelFor(kZeroSize, _table.size(), [&](size_t id) {
+        std::unique_ptr<T[]> tile(new T[kTileVolume]);
+        std::fill(tile.get(), tile.get() + kTileVolume, _background);
+
+        bool isActive = false;
+        forEachIndexInTile(id, [&](size_t i, size_t j, size_t k) {
+            T& value = tile[(i % kTileSize) +
+                            kTileSize * ((j % kTileSize) +
+                                         kTileSize * (k % kTileSize))];
+            value = func(i, j, k);
+            isActive |= (value != _background);
+        });
+        if (isActive) {
+            candidates[id] = std::move(tile);
+        }
+    }, policy);
+
+    resize(_size, _background);
+    for (size_t id = 0; id < candidates.size(); ++id) {
+        if (candidates[id] != nullptr) {
+            _table[id] = candidates[id].get();
+            _tiles.push_back(std::move(candidates[id]));
+            _tileIds.push_back(id);
+        }
+    }
+}
+
+template <typename T>
+void BlockSparseArray3<T>::prune(T tolerance) {
+    std::vector<char> isBackground(_tiles.size());
+    parallelFor(kZeroSize, _tiles.size(), [&](size_t t) {
+        const T* tile = _tiles[t].get();
+        isBackground[t] = std::all_of(tile, tile + kTileVolume, [&](T value) {
+            return std::abs(value - _background) <= tolerance;
+        });
+    });
+
+    size_t numberOfKeptTiles = 0;
+    for (size_t t = 0; t < _tiles.size(); ++t) {
+        if (isBackground[t]) {
+            _table[_tileIds[t]] = nullptr;
+        } else {
+            _tiles[numberOfKeptTiles] = std::move(_tiles[t]);
+            _tileIds[numberOfKeptTiles] = _tileIds[t];
+            ++numberOfKeptTiles;
+        }
+    }
+    _tiles.resize(numberOfKeptTiles);
+    _tileIds.resize(numberOfKeptTiles);
+}
+
+template <typename T>
+void BlockSparseArray3<T>::forEachActiveIndex(
+    const std::function<void(size_t, size_t, size_t)>& func) const {
+    for (size_t id : _tileIds) {
+        forEachIndexInTile(id, func);
+    }
+}
+
+template <typename T>
+void BlockSparseArray3<T>::parallelForEachActiveIndex(
+    const std::function<void(size_t, size_t, size_t)>& func) const {
+    parallelFor(kZeroSize, _tileIds.size(),
+                [&](size_t t) { forEachIndexInTile(_tileIds[t], func); });
+}
+
+template <typename T>
+void BlockSparseArray3<T>::swap(BlockSparseArray3& other) {
+    std::swap(_size, other._size);
+    std::swap(_tileResolution, other._tileResolution);
+    std::swap(_background, other._background);
+    _table.swap(other._table);
+    _tiles.swap(other._tiles);
+    _tileIds.swap(other._tileIds);
+}
+
+template <typename T>
+BlockSparseArray3<T>& BlockSparseArray3<T>::operator=(
+    const BlockSparseArray3& other) {
+    set(other);
+    return *this;
+}
+
+template <typename T>
+BlockSparseArray3<T>& BlockSparseArray3<T>::operator=(
+    BlockSparseArray3&& other) {
+    swap(other);
+    return *this;
+}
+
+template <typename T>
+size_t BlockSparseArray3<T>::tileId(size_t i, size_t j, size_t k) const {
+    return i / kTileSize +
+           _tileResolution.x *
+               (j / kTileSize + _tileResolution.y * (k / kTileSize));
+}
+
+template <typename T>
+T* BlockSparseArray3<T>::allocateTile(size_t tileId) {
+    JET_ASSERT(_table[tileId] == nullptr);
+
+    std::unique_ptr<T[]> tile(new T[kTileVolume]);
+    std::fill(tile.get(), tile.get() + kTileVolume, _background);
+
+    _table[tileId] = tile.get();
+    _tiles.push_back(std::move(tile));
+    _tileIds.push_back(tileId);
+    return _table[tileId];
+}
+
+template <typename T>
+void BlockSparseArray3<T>::forEachIndexInTile(
+    size_t tileId,
+    const std::function<void(size_t, size_t, size_t)>& func) const {
+    const size_t ti = tileId % _tileResolution.x;
+    const size_t tj = (tileId / _tileResolution.x) % _tileResolution.y;
+    const size_t tk = tileId / (_tileResolution.x * _tileResolution.y);
+
+    const size_t iEnd = std::min(_size.x, (ti + 1) * kTileSize);
+    const size_t jEnd = std::min(_size.y, (tj + 1) * kTileSize);
+    const size_t kEnd = std::min(_size.z, (tk + 1) * kTileSize);
+    for (size_t k = tk * kTileSize; k < kEnd; ++k) {
+        for (size_t j = tj * kTileSize; j < jEnd; ++j) {
+            for (size_t i = ti * kTileSize; i < iEnd; ++i) {
+                func(i, j, k);
+            }
+        }
+    }
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_BLOCK_SPARSE_ARRAY3_INL_H_
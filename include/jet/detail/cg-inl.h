@@ -123,6 +123,78 @@ void cg(
         lastResidualNorm);
 }
 
+template <typename BlasType>
+void pipelinedCg(
+    const typename BlasType::MatrixType& A,
+    const typename BlasType::VectorType& b,
+    unsigned int maxNumberOfIterations,
+    double tolerance,
+    typename BlasType::VectorType* x,
+    typename BlasType::VectorType* r,
+    typename BlasType::VectorType* w,
+    typename BlasType::VectorType* p,
+    typename BlasType::VectorType* s,
+    typename BlasType::VectorType* q,
+    typename BlasType::VectorType* z,
+    unsigned int* lastNumberOfIterations,
+    double* lastResidualNorm) {
+    // Clear
+    BlasType::set(0, p);
+    BlasType::set(0, s);
+    BlasType::set(0, z);
+
+    // r = b - Ax
+    BlasType::residual(A, *x, b, r);
+
+    // w = Ar, delta = w.r
+    double delta = BlasType::mvmDot(A, *r, w);
+
+    // gamma = r.r
+    double gamma = BlasType::dot(*r, *r);
+
+    double gammaOld = 0.0;
+    double alphaOld = 0.0;
+    unsigned int iter = 0;
+    while (gamma > square(tolerance) && iter < maxNumberOfIterations) {
+        // q = Aw
+        BlasType::mvm(A, *w, q);
+
+        double beta = 0.0;
+        double alpha = 0.0;
+        if (iter > 0) {
+            beta = gamma / gammaOld;
+            alpha = gamma / (delta - beta * gamma / alphaOld);
+        } else {
+            alpha = gamma / delta;
+        }
+
+        // z = q + beta*z, s = w + beta*s, p = r + beta*p, x = x + alpha*p,
+        // r = r - alpha*s, w = w - alpha*z, and the next gamma and delta
+        gammaOld = gamma;
+        alphaOld = alpha;
+        BlasType::pipelinedCgUpdate(alpha, beta, *q, z, s, p, x, r, w, &gamma,
+                                    &delta);
+
+        ++iter;
+
+        // The recurrences drift apart from the true residual faster than in
+        // regular CG, so replace them every 50 iterations
+        if (iter % 50 == 0 && gamma > square(tolerance)) {
+            // r = b - Ax, w = Ar, s = Ap, z = As
+            BlasType::residual(A, *x, b, r);
+            delta = BlasType::mvmDot(A, *r, w);
+            BlasType::mvm(A, *p, s);
+            BlasType::mvm(A, *s, z);
+            gamma = BlasType::dot(*r, *r);
+        }
+    }
+
+    *lastNumberOfIterations = iter;
+
+    // std::fabs(gamma) - Workaround for negative zero
+    *lastResidualNorm = std::sqrt(std::fabs(gamma));
+}
+
 }  // namespace jet
 
 #endif  // INCLUDE_JET_DETAIL_CG_INL_H_
@@ -0,0 +1,227 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_DETAIL_MATRIX_SELL_INL_H_
+#define INCLUDE_JET_DETAIL_MATRIX_SELL_INL_H_
+
+#include <jet/macros.h>
+#include <jet/matrix_sell.h>
+#include <jet/parallel.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace jet {
+
+namespace internal {
+
+// Computes the products of the kChunkSize rows of one chunk that has
+// `length` stored elements per row.
+template <typename T, size_t C>
+inline void sellChunkProduct(const T* values, const uint32_t* columnIndices,
+                             size_t length, const T* x, T* result) {
+    for (size_t lane = 0; lane < C; ++lane) {
+        result[lane] = 0;
+    }
+    for (size_t s = 0; s < length; ++s) {
+        const T* v = values + s * C;
+        const uint32_t* c = columnIndices + s * C;
+        for (size_t lane = 0; lane < C; ++lane) {
+            result[lane] += v[lane] * x[c[lane]];
+        }
+    }
+}
+
+#if defined(__AVX2__)
+// Multiply and add are kept separate, as in the scalar CSR product, so the
+// results do not depend on whether FMA is available.
+template <>
+inline void sellChunkProduct<double, 4>(const double* values,
+                                        const uint32_t* columnIndices,
+                                        size_t length, const double* x,
+                                        double* result) {
+    __m256d sum = _mm256_setzero_pd();
+    for (size_t s = 0; s < length; ++s) {
+        const __m128i c = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(columnIndices + 4 * s));
+        const __m256d xs = _mm256_i32gather_pd(x, c, 8);
+        const __m256d v = _mm256_loadu_pd(values + 4 * s);
+        sum = _mm256_add_pd(sum, _mm256_mul_pd(v, xs));
+    }
+    _mm256_storeu_pd(result, sum);
+}
+#endif
+
+}  // namespace internal
+
+template <typename T>
+MatrixSell<T>::MatrixSell() {}
+
+template <typename T>
+MatrixSell<T>::MatrixSell(const MatrixCsr<T>& other, size_t sortingScope) {
+    set(other, sortingScope);
+}
+
+template <typename T>
+void MatrixSell<T>::clear() {
+    _size = Size2();
+    _numberOfNonZeros = 0;
+    _chunkPointers.clear();
+    _values.clear();
+    _columnIndices.clear();
+    _rowOrder.clear();
+}
+
+template <typename T>
+void MatrixSell<T>::set(const MatrixCsr<T>& other, size_t sortingScope) {
+    JET_THROW_INVALID_ARG_WITH_MESSAGE_IF(
+        other.cols() > std::numeric_limits<uint32_t>::max(),
+        "MatrixSell stores 32-bit column indices.");
+
+    clear();
+    _size = other.size();
+    _numberOfNonZeros = other.numberOfNonZeros();
+
+    const size_t n = other.rows();
+    const auto rp = other.rowPointersBegin();
+    const auto ci = other.columnIndicesBegin();
+    const auto nnz = other.nonZeroBegin();
+    auto rowLength = [&](size_t row) { return rp[row + 1] - rp[row]; };
+
+    // Sort the rows by descending length within each window, keeping the
+    // original order among rows of the same length
+    if (sortingScope > 1) {
+        _rowOrder.resize(n);
+        std::iota(_rowOrder.begin(), _rowOrder.end(), kZeroSize);
+        for (size_t begin = 0; begin < n; begin += sortingScope) {
+            const size_t end = std::min(n, begin + sortingScope);
+            std::stable_sort(_rowOrder.begin() + begin,
+                             _rowOrder.begin() + end, [&](size_t a, size_t b) {
+                                 return rowLength(a) > rowLength(b);
+                             });
+        }
+    }
+    auto sourceRow = [&](size_t row) {
+        return _rowOrder.empty() ? row : _rowOrder[row];
+    };
+
+    const size_t numberOfChunks = (n + kChunkSize - 1) / kChunkSize;
+    _chunkPointers.resize(numberOfChunks + 1);
+    _chunkPointers[0] = 0;
+    for (size_t chunk = 0; chunk < numberOfChunks; ++chunk) {
+        size_t length = 0;
+        for (size_t row = chunk * kChunkSize;
+             row < std::min(n, (chunk + 1) * kChunkSize); ++row) {
+            length = std::max(length, rowLength(sourceRow(row)));
+        }
+        _chunkPointers[chunk + 1] =
+            _chunkPointers[chunk] + length * kChunkSize;
+    }
+
+    // Padding elements are zeros that read the first column
+    _values.assign(_chunkPointers.back(), 0);
+    _columnIndices.assign(_chunkPointers.back(), 0);
+    parallelFor(kZeroSize, numberOfChunks, [&](size_t chunk) {
+        for (size_t lane = 0; lane < kChunkSize; ++lane) {
+            const size_t row = chunk * kChunkSize + lane;
+            if (row >= n) {
+                break;
+            }
+
+            const size_t src = sourceRow(row);
+            size_t dst = _chunkPointers[chunk] + lane;
+            for (size_t jj = rp[src]; jj < rp[src + 1]; ++jj) {
+                _values[dst] = nnz[jj];
+                _columnIndices[dst] = static_cast<uint32_t>(ci[jj]);
+                dst += kChunkSize;
+            }
+        }
+    });
+}
+
+template <typename T>
+Size2 MatrixSell<T>::size() const {
+    return _size;
+}
+
+template <typename T>
+size_t MatrixSell<T>::rows() const {
+    return _size.x;
+}
+
+template <typename T>
+size_t MatrixSell<T>::cols() const {
+    return _size.y;
+}
+
+template <typename T>
+size_t MatrixSell<T>::numberOfNonZeros() const {
+    return _numberOfNonZeros;
+}
+
+template <typename T>
+size_t MatrixSell<T>::numberOfStoredElements() const {
+    return _values.size();
+}
+
+template <typename T>
+void MatrixSell<T>::mul(const VectorN<T>& v, VectorN<T>* result) const {
+    JET_THROW_INVALID_ARG_IF(v.size() != cols());
+    JET_THROW_INVALID_ARG_IF(result->size() != rows());
+
+    forEachRowProduct(v, [&](size_t row, T av) { (*result)[row] = av; });
+}
+
+template <typename T>
+void MatrixSell<T>::residual(const VectorN<T>& x, const VectorN<T>& b,
+                             VectorN<T>* result) const {
+    JET_THROW_INVALID_ARG_IF(x.size() != cols());
+    JET_THROW_INVALID_ARG_IF(b.size() != rows());
+    JET_THROW_INVALID_ARG_IF(result->size() != rows());
+
+    forEachRowProduct(
+        x, [&](size_t row, T ax) { (*result)[row] = b[row] - ax; });
+}
+
+template <typename T>
+template <typename Callback>
+void MatrixSell<T>::forEachRowProduct(const VectorN<T>& x,
+                                      const Callback& func) const {
+    const size_t n = rows();
+    if (n == 0) {
+        return;
+    }
+    const size_t numberOfChunks = _chunkPointers.size() - 1;
+
+    const T* xData = x.data();
+    parallelRangeFor(kZeroSize, numberOfChunks, [&](size_t begin, size_t end) {
+        T products[kChunkSize];
+        for (size_t chunk = begin; chunk < end; ++chunk) {
+            const size_t offset = _chunkPointers[chunk];
+            const size_t length =
+                (_chunkPointers[chunk + 1] - offset) / kChunkSize;
+            internal::sellChunkProduct<T, kChunkSize>(
+                _values.data() + offset, _columnIndices.data() + offset,
+                length, xData, products);
+
+            const size_t rowBegin = chunk * kChunkSize;
+            const size_t rowEnd = std::min(n, rowBegin + kChunkSize);
+            for (size_t row = rowBegin; row < rowEnd; ++row) {
+                const size_t dst = _rowOrder.empty() ? row : _rowOrder[row];
+                func(dst, products[row - rowBegin]);
+            }
+        }
+    });
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_MATRIX_SELL_INL_H_
@@ -8,6 +8,9 @@
 #define INCLUDE_JET_DETAIL_MG_INL_H_
 
 #include <jet/mg.h>
+#include <jet/timer.h>
+
+#include <utility>
 
 namespace jet {
 
@@ -17,6 +20,10 @@ template <typename BlasType>
 MgResult mgVCycle(const MgMatrix<BlasType>& A, MgParameters<BlasType> params,
                   unsigned int currentLevel, MgVector<BlasType>* x,
                   MgVector<BlasType>* b, MgVector<BlasType>* buffer) {
+    MgResult result;
+    Timer timer;
+    double levelTime = 0.0;
+
     // 1) Relax a few times on Ax = b, with arbitrary x
     params.relaxFunc(A[currentLevel], (*b)[currentLevel],
                      params.numberOfRestrictionIter, params.maxTolerance,
@@ -33,7 +40,12 @@ MgResult mgVCycle(const MgMatrix<BlasType>& A, MgParameters<BlasType> params,
 
         params.maxTolerance *= 0.5;
         // Solve Ae = r
-        mgVCycle(A, params, currentLevel + 1, x, b, buffer);
+        levelTime += timer.durationInSeconds();
+        MgResult coarserResult =
+            mgVCycle(A, params, currentLevel + 1, x, b, buffer);
+        result.levelTimesInSeconds =
+            std::move(coarserResult.levelTimesInSeconds);
+        timer.reset();
         params.maxTolerance *= 2.0;
 
         // 3) correct
@@ -57,13 +69,16 @@ MgResult mgVCycle(const MgMatrix<BlasType>& A, MgParameters<BlasType> params,
 
         BlasType::residual(A[currentLevel], (*x)[currentLevel],
                            (*b)[currentLevel], &(*buffer)[currentLevel]);
+
+        result.levelTimesInSeconds.assign(A.levels.size(), 0.0);
     }
 
     BlasType::residual(A[currentLevel], (*x)[currentLevel], (*b)[currentLevel],
                        &(*buffer)[currentLevel]);
 
-    MgResult result;
     result.lastResidualNorm = BlasType::l2Norm((*buffer)[currentLevel]);
+    result.levelTimesInSeconds[currentLevel] =
+        levelTime + timer.durationInSeconds();
     return result;
 }
 
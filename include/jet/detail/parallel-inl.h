@@ -9,45 +9,153 @@
 
 #include <jet/constants.h>
 #include <jet/macros.h>
+#include <jet/profiler.h>
 
 #include <algorithm>
 #include <functional>
 #include <future>
+#include <utility>
 #include <vector>
 
 #ifdef JET_TASKING_TBB
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_reduce.h>
 #include <tbb/parallel_sort.h>
-#include <tbb/task.h>
-#elif defined(JET_TASKING_CPP11THREADS)
-#include <thread>
+#include <tbb/task_arena.h>
 #endif
 
 namespace jet {
 
 namespace internal {
 
+// Number of indices per block used by parallelDeterministicReduce.
+constexpr size_t kDeterministicReduceBlockSize = 4096;
+
+#ifdef JET_TASKING_TBB
+// Returns the arena created by setMaxNumberOfThreads, or nullptr if the
+// default arena should be used.
+tbb::task_arena* taskArena();
+
+// Runs the function inside the configured task arena.
+template <typename Function>
+void executeInArena(const Function& func) {
+  tbb::task_arena* arena = taskArena();
+  if (arena != nullptr) {
+    arena->execute(func);
+  } else {
+    func();
+  }
+}
+
+template <typename Range, typename Body>
+void tbbParallelFor(const Range& range, const Body& body, const ExecutionPolicy& policy) {
+  executeInArena([&]() {
+    switch (policy.partitioner()) {
+      case Partitioner::kStatic:
+        tbb::parallel_for(range, body, tbb::static_partitioner());
+        break;
+      case Partitioner::kAffinity:
+        if (policy.affinityPartitioner() != nullptr) {
+          tbb::parallel_for(range, body, policy.affinityPartitioner()->tbbPartitioner());
+          break;
+        }
+        tbb::parallel_for(range, body, tbb::auto_partitioner());
+        break;
+      default:
+        tbb::parallel_for(range, body, tbb::auto_partitioner());
+        break;
+    }
+  });
+}
+
+template <typename Range, typename Value, typename Body, typename Reduce>
+Value tbbParallelReduce(const Range& range, const Value& identity, const Body& body,
+                        const Reduce& reduce, const ExecutionPolicy& policy) {
+  Value result = identity;
+  executeInArena([&]() {
+    switch (policy.partitioner()) {
+      case Partitioner::kStatic:
+        result = tbb::parallel_reduce(range, identity, body, reduce, tbb::static_partitioner());
+        break;
+      case Partitioner::kAffinity:
+        if (policy.affinityPartitioner() != nullptr) {
+          result = tbb::parallel_reduce(range, identity, body, reduce,
+                                        policy.affinityPartitioner()->tbbPartitioner());
+          break;
+        }
+        result = tbb::parallel_reduce(range, identity, body, reduce, tbb::auto_partitioner());
+        break;
+      default:
+        result = tbb::parallel_reduce(range, identity, body, reduce, tbb::auto_partitioner());
+        break;
+    }
+  });
+  return result;
+}
+#endif
+
+#ifdef JET_TASKING_CPP11THREADS
+// Number of slices per thread handed to the pool. More slices than threads
+// lets idle workers pick up the remainder of an unbalanced loop.
+constexpr unsigned int kSlicesPerThread = 4;
+
+// Calls body(c) for every c in [0, numberOfChunks) using the persistent
+// thread pool. The calling thread processes chunks as well, so nested calls
+// from a worker thread cannot deadlock.
+void runChunks(size_t numberOfChunks, const std::function<void(size_t)>& body);
+
+// Pushes a fire-and-forget task to the persistent thread pool.
+void enqueueTask(std::function<void()> task);
+#endif
+
+// Returns the number of indices per slice when [start, end) is split evenly
+// into numThreads slices, but never less than the policy's grain size.
+template <typename IndexType>
+IndexType sliceSize(IndexType start, IndexType end, unsigned int numThreads,
+                    const ExecutionPolicy& policy) {
+  IndexType n = end - start + 1;
+  IndexType slice = (IndexType)std::round(n / static_cast<double>(numThreads));
+  return std::max(slice, static_cast<IndexType>(policy.grainSize()));
+}
+
+#ifdef JET_TASKING_CPP11THREADS
+// Returns the number of slices runSlices will use for [start, end).
+template <typename IndexType>
+size_t numberOfSlices(IndexType start, IndexType end, const ExecutionPolicy& policy) {
+  const IndexType slice = sliceSize(start, end, maxNumberOfThreads() * kSlicesPerThread, policy);
+  return static_cast<size_t>((end - start + slice - 1) / slice);
+}
+
+// Splits [start, end) into slices and calls func(sliceBegin, sliceEnd, slice)
+// for each of them on the persistent thread pool.
+template <typename IndexType, typename Function>
+void runSlices(IndexType start, IndexType end, const ExecutionPolicy& policy,
+               const Function& func) {
+  const IndexType slice = sliceSize(start, end, maxNumberOfThreads() * kSlicesPerThread, policy);
+  const size_t numSlices = numberOfSlices(start, end, policy);
+
+  runChunks(numSlices, [&](size_t c) {
+    IndexType k1 = start + static_cast<IndexType>(c) * slice;
+    IndexType k2 = std::min(k1 + slice, end);
+    func(k1, k2, c);
+  });
+}
+#endif
+
 // NOTE - This abstraction takes a lambda which should take captured
 //        variables by *value* to ensure no captured references race
 //        with the task itself.
 template <typename TASK_T>
 inline void schedule(TASK_T&& fcn) {
 #ifdef JET_TASKING_TBB
-  struct LocalTBBTask : public tbb::task {
-    TASK_T func;
-    tbb::task* execute() override {
-      func();
-      return nullptr;
-    }
-    LocalTBBTask(TASK_T&& f) : func(std::forward<TASK_T>(f)) {}
-  };
-
-  auto* tbb_node = new (tbb::task::allocate_root()) LocalTBBTask(std::forward<TASK_T>(fcn));
-  tbb::task::enqueue(*tbb_node);
+  tbb::task_arena* arena = taskArena();
+  if (arena != nullptr) {
+    arena->enqueue(std::forward<TASK_T>(fcn));
+  } else {
+    tbb::this_task_arena::enqueue(std::forward<TASK_T>(fcn));
+  }
 #elif defined(JET_TASKING_CPP11THREADS)
-  std::thread thread(fcn);
-  thread.detach();
+  enqueueTask(std::forward<TASK_T>(fcn));
 #else  // OpenMP or Serial --> synchronous!
   fcn();
 #endif
@@ -117,14 +225,23 @@ void parallelMergeSort(RandomIterator a, size_t size, RandomIterator2 temp, unsi
   if (numThreads == 1) {
     std::sort(a, a + size, compareFunction);
   } else if (numThreads > 1) {
-    std::vector<std::future<void>> pool;
-    pool.reserve(2);
-
     auto launchRange = [compareFunction](RandomIterator begin, size_t k2, RandomIterator2 temp,
                                          unsigned int numThreads) {
       parallelMergeSort(begin, k2, temp, numThreads, compareFunction);
     };
 
+#ifdef JET_TASKING_CPP11THREADS
+    runChunks(2, [&](size_t c) {
+      if (c == 0) {
+        launchRange(a, size / 2, temp, numThreads / 2);
+      } else {
+        launchRange(a + size / 2, size - size / 2, temp + size / 2, numThreads - numThreads / 2);
+      }
+    });
+#else
+    std::vector<std::future<void>> pool;
+    pool.reserve(2);
+
     pool.emplace_back(internal::async([=]() { launchRange(a, size / 2, temp, numThreads / 2); }));
 
     pool.emplace_back(internal::async([=]() {
@@ -137,6 +254,7 @@ void parallelMergeSort(RandomIterator a, size_t size, RandomIterator2 temp, unsi
         f.wait();
       }
     }
+#endif
 
     merge(a, size, temp, compareFunction);
   }
@@ -164,57 +282,43 @@ void parallelFor(IndexType start, IndexType end, const Function& func, Execution
     return;
   }
 
+  JET_PROFILE_SCOPE("parallelFor");
+
 #ifdef JET_TASKING_TBB
-  if (policy == ExecutionPolicy::kParallel) {
-    tbb::parallel_for(start, end, func);
+  if (policy.isParallel()) {
+    internal::tbbParallelFor(
+        tbb::blocked_range<IndexType>(start, end, policy.grainSize()),
+        [&func](const tbb::blocked_range<IndexType>& range) {
+          JET_PROFILE_SCOPE("parallelFor chunk");
+          for (IndexType i = range.begin(); i != range.end(); ++i) {
+            func(i);
+          }
+        },
+        policy);
   } else {
     for (auto i = start; i < end; ++i) {
       func(i);
     }
   }
 
-#elif JET_TASKING_CPP11THREADS
-  // Estimate number of threads in the pool
-  unsigned int numThreadsHint = maxNumberOfThreads();
-  const unsigned int numThreads =
-      (policy == ExecutionPolicy::kParallel) ? (numThreadsHint == 0u ? 8u : numThreadsHint) : 1;
-
-  // Size of a slice for the range functions
-  IndexType n = end - start + 1;
-  IndexType slice = (IndexType)std::round(n / static_cast<double>(numThreads));
-  slice = std::max(slice, IndexType(1));
-
-  // [Helper] Inner loop
-  auto launchRange = [&func](IndexType k1, IndexType k2) {
-    for (IndexType k = k1; k < k2; k++) {
-      func(k);
+#elif defined(JET_TASKING_CPP11THREADS)
+  if (policy.isParallel()) {
+    internal::runSlices(start, end, policy, [&func](IndexType k1, IndexType k2, size_t) {
+      JET_PROFILE_SCOPE("parallelFor chunk");
+      for (IndexType k = k1; k < k2; ++k) {
+        func(k);
+      }
+    });
+  } else {
+    for (auto i = start; i < end; ++i) {
+      func(i);
     }
-  };
-
-  // Create pool and launch jobs
-  std::vector<std::thread> pool;
-  pool.reserve(numThreads);
-  IndexType i1 = start;
-  IndexType i2 = std::min(start + slice, end);
-  for (unsigned int i = 0; i + 1 < numThreads && i1 < end; ++i) {
-    pool.emplace_back(launchRange, i1, i2);
-    i1 = i2;
-    i2 = std::min(i2 + slice, end);
-  }
-  if (i1 < end) {
-    pool.emplace_back(launchRange, i1, end);
   }
 
-  // Wait for jobs to finish
-  for (std::thread& t : pool) {
-    if (t.joinable()) {
-      t.join();
-    }
-  }
 #else
 
 #ifdef JET_TASKING_OPENMP
-  if (policy == ExecutionPolicy::kParallel) {
+  if (policy.isParallel()) {
 #pragma omp parallel for
 #if defined(_MSC_VER) && !defined(__INTEL_COMPILER)
     for (ssize_t i = start; i < ssize_t(end); ++i) {
@@ -244,11 +348,27 @@ void parallelRangeFor(IndexType start, IndexType end, const Function& func,
     return;
   }
 
+  JET_PROFILE_SCOPE("parallelRangeFor");
+
 #ifdef JET_TASKING_TBB
-  if (policy == ExecutionPolicy::kParallel) {
-    tbb::parallel_for(
-        tbb::blocked_range<IndexType>(start, end),
-        [&func](const tbb::blocked_range<IndexType>& range) { func(range.begin(), range.end()); });
+  if (policy.isParallel()) {
+    internal::tbbParallelFor(
+        tbb::blocked_range<IndexType>(start, end, policy.grainSize()),
+        [&func](const tbb::blocked_range<IndexType>& range) {
+          JET_PROFILE_SCOPE("parallelRangeFor chunk");
+          func(range.begin(), range.end());
+        },
+        policy);
+  } else {
+    func(start, end);
+  }
+
+#elif defined(JET_TASKING_CPP11THREADS)
+  if (policy.isParallel()) {
+    internal::runSlices(start, end, policy, [&func](IndexType k1, IndexType k2, size_t) {
+      JET_PROFILE_SCOPE("parallelRangeFor chunk");
+      func(k1, k2);
+    });
   } else {
     func(start, end);
   }
@@ -257,12 +377,10 @@ void parallelRangeFor(IndexType start, IndexType end, const Function& func,
   // Estimate number of threads in the pool
   unsigned int numThreadsHint = maxNumberOfThreads();
   const unsigned int numThreads =
-      (policy == ExecutionPolicy::kParallel) ? (numThreadsHint == 0u ? 8u : numThreadsHint) : 1;
+      policy.isParallel() ? (numThreadsHint == 0u ? 8u : numThreadsHint) : 1;
 
   // Size of a slice for the range functions
-  IndexType n = end - start + 1;
-  IndexType slice = (IndexType)std::round(n / static_cast<double>(numThreads));
-  slice = std::max(slice, IndexType(1));
+  IndexType slice = internal::sliceSize(start, end, numThreads, policy);
 
   // Create pool and launch jobs
   std::vector<std::future<void>> pool;
@@ -344,29 +462,50 @@ Value parallelReduce(IndexType start, IndexType end, const Value& identity, cons
     return identity;
   }
 
+  JET_PROFILE_SCOPE("parallelReduce");
+
 #ifdef JET_TASKING_TBB
-  if (policy == ExecutionPolicy::kParallel) {
-    return tbb::parallel_reduce(
-        tbb::blocked_range<IndexType>(start, end), identity,
+  if (policy.isParallel()) {
+    return internal::tbbParallelReduce(
+        tbb::blocked_range<IndexType>(start, end, policy.grainSize()), identity,
         [&func](const tbb::blocked_range<IndexType>& range, const Value& init) {
+          JET_PROFILE_SCOPE("parallelReduce chunk");
           return func(range.begin(), range.end(), init);
         },
-        reduce);
+        reduce, policy);
   } else {
     (void)reduce;
     return func(start, end, identity);
   }
 
+#elif defined(JET_TASKING_CPP11THREADS)
+  if (!policy.isParallel()) {
+    (void)reduce;
+    return func(start, end, identity);
+  }
+
+  // One partial result per slice, gathered in slice order
+  std::vector<Value> results(internal::numberOfSlices(start, end, policy), identity);
+  internal::runSlices(start, end, policy, [&](IndexType k1, IndexType k2, size_t c) {
+    JET_PROFILE_SCOPE("parallelReduce chunk");
+    results[c] = func(k1, k2, identity);
+  });
+
+  Value finalResult = identity;
+  for (const Value& val : results) {
+    finalResult = reduce(finalResult, val);
+  }
+
+  return finalResult;
+
 #else
   // Estimate number of threads in the pool
   unsigned int numThreadsHint = maxNumberOfThreads();
   const unsigned int numThreads =
-      (policy == ExecutionPolicy::kParallel) ? (numThreadsHint == 0u ? 8u : numThreadsHint) : 1;
+      policy.isParallel() ? (numThreadsHint == 0u ? 8u : numThreadsHint) : 1;
 
   // Size of a slice for the range functions
-  IndexType n = end - start + 1;
-  IndexType slice = (IndexType)std::round(n / static_cast<double>(numThreads));
-  slice = std::max(slice, IndexType(1));
+  IndexType slice = internal::sliceSize(start, end, numThreads, policy);
 
   // Results
   std::vector<Value> results(numThreads, identity);
@@ -408,6 +547,116 @@ Value parallelReduce(IndexType start, IndexType end, const Value& identity, cons
 #endif
 }
 
+template <typename IndexType, typename Value, typename Function, typename Reduce>
+Value parallelDeterministicReduce(IndexType start, IndexType end, const Value& identity,
+                                  const Function& func, const Reduce& reduce,
+                                  ExecutionPolicy policy) {
+  if (start >= end) {
+    return identity;
+  }
+
+  // Fixed-size blocks make the partial results independent of the scheduler,
+  // and combining them in block order keeps the final result reproducible.
+  const size_t n = static_cast<size_t>(end - start);
+  const size_t blockSize = internal::kDeterministicReduceBlockSize;
+  const size_t numBlocks = (n + blockSize - 1) / blockSize;
+
+  std::vector<Value> blockResults(numBlocks, identity);
+  parallelFor(
+      kZeroSize, numBlocks,
+      [&](size_t b) {
+        IndexType blockBegin = start + static_cast<IndexType>(b * blockSize);
+        IndexType blockEnd =
+            (b + 1 == numBlocks) ? end : start + static_cast<IndexType>((b + 1) * blockSize);
+        blockResults[b] = func(blockBegin, blockEnd, identity);
+      },
+      ExecutionPolicy(policy.mode()));
+
+  Value finalResult = identity;
+  for (const Value& val : blockResults) {
+    finalResult = reduce(finalResult, val);
+  }
+
+  return finalResult;
+}
+
+template <typename IndexType, typename Value, typename Function>
+Value parallelSum(IndexType start, IndexType end, const Value& identity, const Function& function,
+                  ExecutionPolicy policy) {
+  return parallelDeterministicReduce(
+      start, end, identity,
+      [&function](IndexType k1, IndexType k2, Value result) {
+        for (IndexType k = k1; k < k2; ++k) {
+          result += function(k);
+        }
+        return result;
+      },
+      [](const Value& a, const Value& b) { return a + b; }, policy);
+}
+
+template <typename IndexType, typename Value, typename Function>
+Value parallelMin(IndexType start, IndexType end, const Value& identity, const Function& function,
+                  ExecutionPolicy policy) {
+  return parallelDeterministicReduce(
+      start, end, identity,
+      [&function](IndexType k1, IndexType k2, Value result) {
+        for (IndexType k = k1; k < k2; ++k) {
+          result = std::min(result, static_cast<Value>(function(k)));
+        }
+        return result;
+      },
+      [](const Value& a, const Value& b) { return std::min(a, b); }, policy);
+}
+
+template <typename IndexType, typename Value, typename Function>
+Value parallelMax(IndexType start, IndexType end, const Value& identity, const Function& function,
+                  ExecutionPolicy policy) {
+  return parallelDeterministicReduce(
+      start, end, identity,
+      [&function](IndexType k1, IndexType k2, Value result) {
+        for (IndexType k = k1; k < k2; ++k) {
+          result = std::max(result, static_cast<Value>(function(k)));
+        }
+        return result;
+      },
+      [](const Value& a, const Value& b) { return std::max(a, b); }, policy);
+}
+
+template <typename IndexType, typename Function>
+IndexType parallelArgMax(IndexType start, IndexType end, const Function& function,
+                         ExecutionPolicy policy) {
+  using Value = typename std::decay<decltype(function(start))>::type;
+  using Candidate = std::pair<IndexType, Value>;
+
+  if (start >= end) {
+    return end;
+  }
+
+  // Blocks are combined in ascending order, so keeping the left operand on
+  // ties always yields the smallest maximizing index.
+  const Candidate identity(end, Value());
+  Candidate best = parallelDeterministicReduce(
+      start, end, identity,
+      [&function, end](IndexType k1, IndexType k2, Candidate result) {
+        for (IndexType k = k1; k < k2; ++k) {
+          Value value = function(k);
+          if (result.first == end || result.second < value) {
+            result = Candidate(k, value);
+          }
+        }
+        return result;
+      },
+      [end](const Candidate& a, const Candidate& b) {
+        if (a.first == end || (b.first != end && a.second < b.second)) {
+          return b;
+        }
+        return a;
+      },
+      policy);
+
+  return best.first;
+}
+
 template <typename RandomIterator, typename CompareFunction>
 void parallelSort(RandomIterator begin, RandomIterator end, CompareFunction compareFunction,
                   ExecutionPolicy policy) {
@@ -416,8 +665,8 @@ void parallelSort(RandomIterator begin, RandomIterator end, CompareFunction comp
   }
 
 #ifdef JET_TASKING_TBB
-  if (policy == ExecutionPolicy::kParallel) {
-    tbb::parallel_sort(begin, end, compareFunction);
+  if (policy.isParallel()) {
+    internal::executeInArena([&]() { tbb::parallel_sort(begin, end, compareFunction); });
   } else {
     std::sort(begin, end, compareFunction);
   }
@@ -431,7 +680,7 @@ void parallelSort(RandomIterator begin, RandomIterator end, CompareFunction comp
   // Estimate number of threads in the pool
   unsigned int numThreadsHint = maxNumberOfThreads();
   const unsigned int numThreads =
-      (policy == ExecutionPolicy::kParallel) ? (numThreadsHint == 0u ? 8u : numThreadsHint) : 1;
+      policy.isParallel() ? (numThreadsHint == 0u ? 8u : numThreadsHint) : 1;
 
   internal::parallelMergeSort(begin, size, temp.begin(), numThreads, compareFunction);
 #endif
@@ -0,0 +1,38 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_DETAIL_PIC_SOLVER3_INL_H_
+#define INCLUDE_JET_DETAIL_PIC_SOLVER3_INL_H_
+
+#include <jet/parallel.h>
+
+namespace jet {
+
+template <typename Callback>
+void PicSolver3::forEachParticleInColoredBlocks(const Callback& func) {
+    bucketParticlesByBlock();
+
+    const Size3 n = _numberOfParticleBlocks;
+    for (size_t color = 0; color < 8; ++color) {
+        const Size3 first(color & 1, (color >> 1) & 1, (color >> 2) & 1);
+        parallelFor(
+            kZeroSize, (n.x + 1 - first.x) / 2, kZeroSize,
+            (n.y + 1 - first.y) / 2, kZeroSize, (n.z + 1 - first.z) / 2,
+            [&](size_t i, size_t j, size_t k) {
+                const size_t block =
+                    (2 * i + first.x) +
+                    n.x * ((2 * j + first.y) + n.y * (2 * k + first.z));
+                for (size_t p = _blockPointers[block];
+                     p < _blockPointers[block + 1]; ++p) {
+                    func(_particlesByBlock[p]);
+                }
+            });
+    }
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_DETAIL_PIC_SOLVER3_INL_H_
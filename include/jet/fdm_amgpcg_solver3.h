@@ -0,0 +1,133 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_FDM_AMGPCG_SOLVER3_H_
+#define INCLUDE_JET_FDM_AMGPCG_SOLVER3_H_
+
+#include <jet/fdm_linear_system_solver3.h>
+
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief 3-D finite difference-type linear system solver using algebraic
+//!        multigrid preconditioned conjugate gradient (AMGPCG).
+//!
+//! FdmMgpcgSolver3 needs the grid hierarchy of FdmMgLinearSystem3, which the
+//! compressed system does not have. This solver builds the hierarchy from
+//! the matrix instead, using unsmoothed aggregation: the rows are grouped
+//! into aggregates of strongly connected neighbors, the interpolation from
+//! the aggregates is piecewise constant, and the coarse matrices are the
+//! Galerkin products P^T A P, which keep about the sparsity of the fine
+//! matrix. The preconditioner is one V-cycle with damped Jacobi smoothing, a
+//! scaled-up coarse grid correction to make up for the crude interpolation,
+//! and symmetric Gauss-Seidel iterations on the coarsest level. The
+//! hierarchy is rebuilt at every solve.
+//!
+//! Uncompressed systems are converted to the compressed form, with one row
+//! per grid point, and solved the same way.
+//!
+//! \see Vanek, Petr, Jan Mandel, and Marian Brezina. "Algebraic multigrid by
+//!      smoothed aggregation for second and fourth order elliptic problems."
+//!      Computing 56.3 (1996): 179-196.
+//! \see Braess, Dietrich. "Towards algebraic multigrid for elliptic problems
+//!      of second order." Computing 55.4 (1995): 379-393.
+//!
+class FdmAmgpcgSolver3 final : public FdmLinearSystemSolver3 {
+ public:
+    //!
+    //! Constructs the solver with given parameters.
+    //!
+    //! \param maxNumberOfIterations - Number of max PCG iterations.
+    //! \param tolerance - Max residual tolerance.
+    //! \param maxNumberOfLevels - Number of maximum AMG levels.
+    //! \param numberOfSmoothingIter - Number of Jacobi iterations before and
+    //!     after the coarse grid correction.
+    //! \param numberOfCoarsestIter - Number of symmetric Gauss-Seidel
+    //!     iterations at the coarsest level.
+    //!
+    FdmAmgpcgSolver3(unsigned int maxNumberOfIterations, double tolerance,
+                     size_t maxNumberOfLevels = 10,
+                     unsigned int numberOfSmoothingIter = 1,
+                     unsigned int numberOfCoarsestIter = 20);
+
+    //! Solves the given linear system.
+    bool solve(FdmLinearSystem3* system) override;
+
+    //! Solves the given compressed linear system.
+    bool solveCompressed(FdmCompressedLinearSystem3* system) override;
+
+    //! Returns the max number of PCG iterations.
+    unsigned int maxNumberOfIterations() const;
+
+    //! Returns the last number of PCG iterations the solver made.
+    unsigned int lastNumberOfIterations() const override;
+
+    //! Returns the max residual tolerance for the PCG method.
+    double tolerance() const;
+
+    //! Returns the last residual after the PCG iterations.
+    double lastResidual() const;
+
+    //! Returns the max number of AMG levels.
+    size_t maxNumberOfLevels() const;
+
+    //! Returns the number of AMG levels built by the last solve.
+    size_t numberOfLevels() const;
+
+ private:
+    struct Level final {
+        MatrixCsrD A;
+        MatrixCsrD R;
+        std::vector<size_t> aggregates;
+        VectorND invDiagonal;
+        double omega = 0.0;
+        VectorND x;
+        VectorND b;
+        VectorND r;
+    };
+
+    struct Preconditioner final {
+        const MatrixCsrD* fineMatrix = nullptr;
+        std::vector<Level> levels;
+        size_t maxNumberOfLevels;
+        unsigned int numberOfSmoothingIter;
+        unsigned int numberOfCoarsestIter;
+
+        void build(const MatrixCsrD& matrix);
+
+        void solve(const VectorND& b, VectorND* x);
+
+        const MatrixCsrD& matrix(size_t level) const;
+
+        void vCycle(size_t level, const VectorND& b, VectorND* x);
+
+        void relax(size_t level, const VectorND& b, VectorND* x);
+
+        void relaxCoarsest(const MatrixCsrD& A, const VectorND& b,
+                           VectorND* x);
+    };
+
+    unsigned int _maxNumberOfIterations;
+    unsigned int _lastNumberOfIterations;
+    double _tolerance;
+    double _lastResidualNorm;
+
+    VectorND _r;
+    VectorND _d;
+    VectorND _q;
+    VectorND _s;
+    Preconditioner _precond;
+    FdmCompressedLinearSystem3 _convertedSystem;
+};
+
+//! Shared pointer type for the FdmAmgpcgSolver3.
+typedef std::shared_ptr<FdmAmgpcgSolver3> FdmAmgpcgSolver3Ptr;
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_AMGPCG_SOLVER3_H_
@@ -31,7 +31,7 @@ class FdmGaussSeidelSolver3 final : public FdmLinearSystemSolver3 {
     unsigned int maxNumberOfIterations() const;
 
     //! Returns the last number of Gauss-Seidel iterations the solver made.
-    unsigned int lastNumberOfIterations() const;
+    unsigned int lastNumberOfIterations() const override;
 
     //! Returns the max residual tolerance for the Gauss-Seidel method.
     double tolerance() const;
@@ -58,6 +58,27 @@ class FdmGaussSeidelSolver3 final : public FdmLinearSystemSolver3 {
     static void relaxRedBlack(const FdmMatrix3& A, const FdmVector3& b,
                               double sorFactor, FdmVector3* x);
 
+    //! \brief Performs single natural Gauss-Seidel relaxation step for
+    //!        single precision sys.
+    static void relax(const FdmMatrix3F& A, const FdmVector3F& b,
+                      double sorFactor, FdmVector3F* x);
+
+    //! \brief Performs single Red-Black Gauss-Seidel relaxation step for
+    //!        single precision sys.
+    static void relaxRedBlack(const FdmMatrix3F& A, const FdmVector3F& b,
+                              double sorFactor, FdmVector3F* x);
+
+    //! \brief Performs single natural Gauss-Seidel relaxation step for
+    //!        matrix-free sys.
+    static void relax(const FdmLaplacianMatrix3& A, const FdmVector3& b,
+                      double sorFactor, FdmVector3* x);
+
+    //! \brief Performs single Red-Black Gauss-Seidel relaxation step for
+    //!        matrix-free sys.
+    static void relaxRedBlack(const FdmLaplacianMatrix3& A,
+                              const FdmVector3& b, double sorFactor,
+                              FdmVector3* x);
+
  private:
     unsigned int _maxNumberOfIterations;
     unsigned int _lastNumberOfIterations;
@@ -8,6 +8,7 @@
 #define INCLUDE_JET_FDM_LINEAR_SYSTEM_SOLVER3_H_
 
 #include <jet/fdm_linear_system3.h>
+#include <jet/fdm_matrix_free_linear_system3.h>
 
 #include <memory>
 
@@ -25,6 +26,36 @@ class FdmLinearSystemSolver3 {
 
     //! Solves the given compressed linear system.
     virtual bool solveCompressed(FdmCompressedLinearSystem3*) { return false; }
+
+    //!
+    //! \brief Solves the given matrix-free linear system.
+    //!
+    //! Solvers that can work with FdmLaplacianMatrix3 directly override this
+    //! function. The default implementation assembles the explicit matrix
+    //! and calls solve(FdmLinearSystem3*).
+    //!
+    virtual bool solveMatrixFree(FdmMatrixFreeLinearSystem3* system);
+
+    //! Returns the number of iterations the last solve made, or zero if the
+    //! solver does not count them.
+    virtual unsigned int lastNumberOfIterations() const { return 0; }
+
+    //! Returns true if the solve starts from the given solution vector.
+    bool useInitialGuess() const;
+
+    //!
+    //! \brief Sets whether the solve starts from the given solution vector.
+    //!
+    //! By default, the Krylov solvers (CG, ICCG, and MGPCG) reset the
+    //! solution to zero before iterating. With an initial guess close to the
+    //! solution, such as the pressure of the previous frame, they start from
+    //! a smaller residual and need fewer iterations. The relaxation and
+    //! multigrid solvers always start from the given solution vector.
+    //!
+    void setUseInitialGuess(bool useInitialGuess);
+
+ private:
+    bool _useInitialGuess = false;
 };
 
 //! Shared pointer type for the FdmLinearSystemSolver3.
@@ -0,0 +1,142 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_FDM_MATRIX_FREE_LINEAR_SYSTEM3_H_
+#define INCLUDE_JET_FDM_MATRIX_FREE_LINEAR_SYSTEM3_H_
+
+#include <jet/fdm_linear_system3.h>
+#include <jet/vector3.h>
+
+namespace jet {
+
+//!
+//! \brief Matrix-free 7-point Laplacian for 3-D finite differencing.
+//!
+//! This matrix stores only a cell type per grid point and the inverse squared
+//! grid spacing, i.e. 1 byte per cell instead of the 32 bytes of an
+//! FdmMatrixRow3, and generates the stencil on the fly. It represents the same
+//! operator as the single-phase pressure system: a fluid cell gets
+//! invHSqr.axis on the diagonal for every neighbor that is not a boundary
+//! (the domain border counts as a boundary), and -invHSqr.axis for every fluid
+//! neighbor. Rows of air and boundary cells are identity rows.
+//!
+struct FdmLaplacianMatrix3 {
+    //! Marker of a fluid cell.
+    static constexpr char kFluid = 0;
+
+    //! Marker of an air cell, i.e. a zero pressure (Dirichlet) cell.
+    static constexpr char kAir = 1;
+
+    //! Marker of a solid boundary cell, i.e. a zero flux (Neumann) cell.
+    static constexpr char kBoundary = 2;
+
+    //! Cell type of each grid point.
+    Array3<char> markers;
+
+    //! Inverse squared grid spacing along each axis.
+    Vector3D invHSqr = Vector3D(1, 1, 1);
+
+    //! Returns the size of the grid.
+    Size3 size() const;
+
+    //! Resizes the grid; new cells are marked as air.
+    void resize(const Size3& size);
+
+    //! Clears the matrix.
+    void clear();
+
+    //! Returns the diagonal element of row (i, j, k).
+    double diagonal(size_t i, size_t j, size_t k) const;
+
+    //! Returns the off-diagonal part of row (i, j, k) times \p v.
+    double offDiagonalProduct(const FdmVector3& v, size_t i, size_t j,
+                              size_t k) const;
+
+    //! Returns row (i, j, k) in the explicit FdmMatrix3 form.
+    FdmMatrixRow3 row(size_t i, size_t j, size_t k) const;
+
+    //! Builds the explicit FdmMatrix3 form of this matrix.
+    void assemble(FdmMatrix3* result) const;
+};
+
+//! Matrix-free linear system (Ax=b) for 3-D finite differencing.
+struct FdmMatrixFreeLinearSystem3 {
+    //! System matrix.
+    FdmLaplacianMatrix3 A;
+
+    //! Solution vector.
+    FdmVector3 x;
+
+    //! RHS vector.
+    FdmVector3 b;
+
+    //! Clears all the data.
+    void clear();
+
+    //! Resizes the arrays with given grid size.
+    void resize(const Size3& size);
+};
+
+//!
+//! \brief BLAS operator wrapper for matrix-free 3-D finite differencing.
+//!
+//! Vector operations are the same as FdmBlas3. The matrix operations sweep
+//! the grid along x-rows with branch-free inner loops that the compiler can
+//! vectorize, reading the neighbors' cell types instead of stored stencil
+//! coefficients.
+//!
+struct FdmMatrixFreeBlas3 {
+    typedef double ScalarType;
+    typedef FdmVector3 VectorType;
+    typedef FdmLaplacianMatrix3 MatrixType;
+
+    //! Sets entire element of given vector \p result with scalar \p s.
+    static void set(ScalarType s, VectorType* result);
+
+    //! Copies entire element of given vector \p result with other vector \p v.
+    static void set(const VectorType& v, VectorType* result);
+
+    //! Copies entire element of given matrix \p result with other matrix \p v.
+    static void set(const MatrixType& m, MatrixType* result);
+
+    //! Performs dot product with vector \p a and \p b.
+    static double dot(const VectorType& a, const VectorType& b);
+
+    //! Performs ax + y operation where \p a is a matrix and \p x and \p y are
+    //! vectors.
+    static void axpy(double a, const VectorType& x, const VectorType& y,
+                     VectorType* result);
+
+    //! Performs matrix-vector multiplication.
+    static void mvm(const MatrixType& m, const VectorType& v,
+                    VectorType* result);
+
+    //! Computes residual vector (b - ax).
+    static void residual(const MatrixType& a, const VectorType& x,
+                         const VectorType& b, VectorType* result);
+
+    //! Returns L2-norm of the given vector \p v.
+    static ScalarType l2Norm(const VectorType& v);
+
+    //! Returns Linf-norm of the given vector \p v.
+    static ScalarType lInfNorm(const VectorType& v);
+
+    //! Performs matrix-vector multiplication and returns the dot product of
+    //! \p v and the result, reading the grid only once.
+    static double mvmDot(const MatrixType& m, const VectorType& v,
+                         VectorType* result);
+
+    //! Same as FdmBlas3::pipelinedCgUpdate.
+    static void pipelinedCgUpdate(double alpha, double beta,
+                                  const VectorType& q, VectorType* z,
+                                  VectorType* s, VectorType* p, VectorType* x,
+                                  VectorType* r, VectorType* w, double* rDotR,
+                                  double* wDotR);
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_FDM_MATRIX_FREE_LINEAR_SYSTEM3_H_
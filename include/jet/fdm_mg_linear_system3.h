@@ -9,6 +9,7 @@
 
 #include <jet/face_centered_grid3.h>
 #include <jet/fdm_linear_system3.h>
+#include <jet/fdm_matrix_free_linear_system3.h>
 #include <jet/mg.h>
 
 namespace jet {
@@ -54,15 +55,67 @@ struct FdmMgLinearSystem3 {
                           size_t maxNumberOfLevels);
 };
 
+//! Single precision multigrid-style 3-D FDM matrix.
+typedef MgMatrix<FdmBlas3F> FdmMgMatrix3F;
+
+//! Single precision multigrid-style 3-D FDM vector.
+typedef MgVector<FdmBlas3F> FdmMgVector3F;
+
+//! Multigrid-style 3-D matrix-free FDM matrix.
+typedef MgMatrix<FdmMatrixFreeBlas3> FdmMgLaplacianMatrix3;
+
+//! Multigrid-style 3-D matrix-free FDM vector.
+typedef MgVector<FdmMatrixFreeBlas3> FdmMgMatrixFreeVector3;
+
+//!
+//! \brief Multigrid-style 3-D matrix-free linear system.
+//!
+//! Every level only stores the cell types and grid spacing of its
+//! FdmLaplacianMatrix3, so the hierarchy takes a fraction of the memory of
+//! FdmMgLinearSystem3.
+//!
+struct FdmMgMatrixFreeLinearSystem3 {
+    //! The system matrix.
+    FdmMgLaplacianMatrix3 A;
+
+    //! The solution vector.
+    FdmMgMatrixFreeVector3 x;
+
+    //! The RHS vector.
+    FdmMgMatrixFreeVector3 b;
+
+    //! Clears the linear system.
+    void clear();
+
+    //! Returns the number of multigrid levels.
+    size_t numberOfLevels() const;
+
+    //!
+    //! \brief Resizes the system with the finest resolution and max number of
+    //! levels.
+    //!
+    //! \param finestResolution - The finest grid resolution.
+    //! \param maxNumberOfLevels - Maximum number of multigrid levels.
+    //!
+    void resizeWithFinest(const Size3 &finestResolution,
+                          size_t maxNumberOfLevels);
+};
+
 //! Multigrid utilities for 2-D FDM system.
 class FdmMgUtils3 {
  public:
     //! Restricts given finer grid to the coarser grid.
     static void restrict(const FdmVector3 &finer, FdmVector3 *coarser);
 
+    //! Restricts given single precision finer grid to the coarser grid.
+    static void restrict(const FdmVector3F &finer, FdmVector3F *coarser);
+
     //! Corrects given coarser grid to the finer grid.
     static void correct(const FdmVector3 &coarser, FdmVector3 *finer);
 
+    //! Corrects given single precision coarser grid to the finer grid.
+    static void correct(const FdmVector3F &coarser, FdmVector3F *finer);
+
     //! Resizes the array with the coarsest resolution and number of levels.
     template <typename T>
     static void resizeArrayWithCoarsest(const Size3 &coarsestResolution,
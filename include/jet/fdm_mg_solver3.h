@@ -32,6 +32,12 @@ class FdmMgSolver3 : public FdmLinearSystemSolver3 {
     //! Returns the Multigrid parameters.
     const MgParameters<FdmBlas3>& params() const;
 
+    //! Returns the Multigrid parameters for matrix-free systems.
+    const MgParameters<FdmMatrixFreeBlas3>& matrixFreeParams() const;
+
+    //! Returns the Multigrid parameters for single precision levels.
+    const MgParameters<FdmBlas3F>& singlePrecisionParams() const;
+
     //! Returns the SOR (Successive Over Relaxation) factor.
     double sorFactor() const;
 
@@ -44,8 +50,13 @@ class FdmMgSolver3 : public FdmLinearSystemSolver3 {
     //! Solves Multigrid linear system.
     virtual bool solve(FdmMgLinearSystem3* system);
 
+    //! Solves matrix-free Multigrid linear system.
+    virtual bool solve(FdmMgMatrixFreeLinearSystem3* system);
+
  private:
     MgParameters<FdmBlas3> _mgParams;
+    MgParameters<FdmMatrixFreeBlas3> _mgMatrixFreeParams;
+    MgParameters<FdmBlas3F> _mgSinglePrecisionParams;
     double _sorFactor;
     bool _useRedBlackOrdering;
 };
@@ -9,6 +9,8 @@
 
 #include <jet/fdm_mg_solver3.h>
 
+#include <vector>
+
 namespace jet {
 
 //!
@@ -43,11 +45,14 @@ class FdmMgpcgSolver3 final : public FdmMgSolver3 {
     //! Solves the given linear system.
     bool solve(FdmMgLinearSystem3* system) override;
 
+    //! Solves the given matrix-free linear system.
+    bool solve(FdmMgMatrixFreeLinearSystem3* system) override;
+
     //! Returns the max number of Jacobi iterations.
     unsigned int maxNumberOfIterations() const;
 
     //! Returns the last number of Jacobi iterations the solver made.
-    unsigned int lastNumberOfIterations() const;
+    unsigned int lastNumberOfIterations() const override;
 
     //! Returns the max residual tolerance for the Jacobi method.
     double tolerance() const;
@@ -55,12 +60,46 @@ class FdmMgpcgSolver3 final : public FdmMgSolver3 {
     //! Returns the last residual after the Jacobi iterations.
     double lastResidual() const;
 
+    //! Returns true if the preconditioner runs in single precision.
+    bool useMixedPrecision() const;
+
+    //!
+    //! \brief Enables or disables the mixed-precision mode.
+    //!
+    //! In mixed-precision mode, the multigrid preconditioner (smoothing,
+    //! restriction, and correction) runs on single precision copies of the
+    //! levels while the outer PCG iterations stay in double precision, so the
+    //! final tolerance is unchanged. It applies to FdmMgLinearSystem3 only;
+    //! matrix-free systems are always solved in double precision.
+    //!
+    void setUseMixedPrecision(bool useMixedPrecision);
+
+    //! Returns the time spent on each multigrid level by the preconditioner
+    //! during the last solve, in seconds.
+    const std::vector<double>& lastLevelTimesInSeconds() const;
+
  private:
+    template <typename SystemType, typename BlasType>
     struct Preconditioner final {
-        FdmMgLinearSystem3* system;
-        MgParameters<FdmBlas3> mgParams;
+        SystemType* system;
+        MgParameters<BlasType> mgParams;
+        std::vector<double> levelTimesInSeconds;
 
-        void build(FdmMgLinearSystem3* system, MgParameters<FdmBlas3> mgParams);
+        void build(SystemType* system, MgParameters<BlasType> mgParams);
+
+        void solve(const FdmVector3& b, FdmVector3* x);
+    };
+
+    struct MixedPrecisionPreconditioner final {
+        FdmMgMatrix3F A;
+        FdmMgVector3F x;
+        FdmMgVector3F b;
+        FdmMgVector3F buffer;
+        MgParameters<FdmBlas3F> mgParams;
+        std::vector<double> levelTimesInSeconds;
+
+        void build(const FdmMgLinearSystem3& system,
+                   MgParameters<FdmBlas3F> mgParams);
 
         void solve(const FdmVector3& b, FdmVector3* x);
     };
@@ -69,12 +108,19 @@ class FdmMgpcgSolver3 final : public FdmMgSolver3 {
     unsigned int _lastNumberOfIterations;
     double _tolerance;
     double _lastResidualNorm;
+    bool _useMixedPrecision = false;
+    std::vector<double> _lastLevelTimesInSeconds;
 
     FdmVector3 _r;
     FdmVector3 _d;
     FdmVector3 _q;
     FdmVector3 _s;
-    Preconditioner _precond;
+    Preconditioner<FdmMgLinearSystem3, FdmBlas3> _precond;
+    Preconditioner<FdmMgMatrixFreeLinearSystem3, FdmMatrixFreeBlas3>
+        _matrixFreePrecond;
+    MixedPrecisionPreconditioner _mixedPrecisionPrecond;
+
+    void logLevelTimes() const;
 };
 
 //! Shared pointer type for the FdmMgpcgSolver3.
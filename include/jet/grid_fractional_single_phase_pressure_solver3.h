@@ -13,6 +13,7 @@
 #include <jet/fdm_mg_solver3.h>
 #include <jet/grid_boundary_condition_solver3.h>
 #include <jet/grid_pressure_solver3.h>
+#include <jet/grid_pressure_warm_start3.h>
 #include <jet/vertex_centered_scalar_grid3.h>
 
 #include <memory>
@@ -99,6 +100,39 @@ class GridFractionalSinglePhasePressureSolver3 : public GridPressureSolver3 {
     //! Returns the pressure field.
     const FdmVector3& pressure() const;
 
+    //! Returns true if the solve starts from the previous pressure.
+    bool useWarmStart() const;
+
+    //!
+    //! \brief Sets whether the solve starts from the previous pressure.
+    //!
+    //! The pressure of the last solve, remapped onto the current fluid cells,
+    //! becomes the initial guess of the linear system solver instead of zero.
+    //! The savings show up in lastNumberOfIterations(). Default is false.
+    //!
+    void setUseWarmStart(bool useWarmStart);
+
+    //! Returns the number of iterations of the last linear system solve.
+    unsigned int lastNumberOfIterations() const;
+
+    //! Returns true if the compressed system pattern is cached.
+    bool useCompressedPatternCache() const;
+
+    //!
+    //! \brief Sets whether the compressed system pattern is cached.
+    //!
+    //! If enabled, the compressed (CSR) system is built in parallel: the rows
+    //! are numbered by a prefix sum over the fluid cells of every x-row and
+    //! each row is filled independently. The row pointers and column indices
+    //! are kept and only the values are recomputed as long as the fluid cells
+    //! do not change. The resulting system is identical to the serial build.
+    //! Default is false.
+    //!
+    void setUseCompressedPatternCache(bool useCache);
+
+    //! Returns true if the last compressed system reused the cached pattern.
+    bool isCompressedPatternReused() const;
+
  private:
     FdmLinearSystem3 _system;
     FdmCompressedLinearSystem3 _compSystem;
@@ -107,6 +141,14 @@ class GridFractionalSinglePhasePressureSolver3 : public GridPressureSolver3 {
     FdmMgLinearSystem3 _mgSystem;
     FdmMgSolver3Ptr _mgSystemSolver;
 
+    bool _useWarmStart = false;
+    GridPressureWarmStart3 _warmStart;
+
+    bool _useCompressedPatternCache = false;
+    bool _isCompressedPatternReused = false;
+    Array3<char> _compressedFluidMask;
+    Array3<size_t> _coordToIndex;
+
     std::vector<Array3<float>> _uWeights;
     std::vector<Array3<float>> _vWeights;
     std::vector<Array3<float>> _wWeights;
@@ -121,6 +163,12 @@ class GridFractionalSinglePhasePressureSolver3 : public GridPressureSolver3 {
 
     void decompressSolution();
 
+    void buildInitialGuess(double timeIntervalInSeconds, bool useCompressed);
+
+    void buildCompressedSystem(const FaceCenteredGrid3& input);
+
+    void buildCompressedPattern();
+
     virtual void buildSystem(const FaceCenteredGrid3& input,
                              bool useCompressed);
 
@@ -0,0 +1,87 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_GRID_PRESSURE_WARM_START3_H_
+#define INCLUDE_JET_GRID_PRESSURE_WARM_START3_H_
+
+#include <jet/fdm_linear_system3.h>
+#include <jet/fdm_linear_system_solver3.h>
+#include <jet/macros.h>
+
+#include <functional>
+
+namespace jet {
+
+//!
+//! \brief Initial guess for a pressure solve from the previous frame.
+//!
+//! The pressure changes little between frames, so starting the iterative
+//! solver from the last solution instead of zero saves iterations. This class
+//! stores the pressure of the last solve together with its fluid cells and
+//! remaps it onto the fluid cells of the next solve: cells that stay fluid
+//! keep their pressure, cells that became fluid take the average of their
+//! neighbors that were fluid (zero if there are none), and all other cells
+//! are zero. Since the solved pressure is scaled by the time interval, the
+//! guess is rescaled when the time interval changes.
+//!
+class GridPressureWarmStart3 {
+ public:
+    //! Returns true if the cell (i, j, k) is a fluid cell.
+    typedef std::function<bool(size_t, size_t, size_t)> FluidPredicate;
+
+    //! Clears the stored pressure; the next guess is zero.
+    void clear();
+
+    //! Stores the \p pressure solved with the given time interval.
+    void save(const FdmVector3& pressure, const FluidPredicate& isFluid,
+              double timeIntervalInSeconds);
+
+    //! Writes the remapped pressure to \p result, which must already have
+    //! the size of the grid.
+    void initialGuess(const FluidPredicate& isFluid,
+                      double timeIntervalInSeconds, FdmVector3* result) const;
+
+    //! Writes the remapped pressure of the fluid cells of a grid with the
+    //! given \p size, in the row order of the compressed pressure system, to
+    //! \p result, which must already have one element per fluid cell.
+    void initialGuess(const Size3& size, const FluidPredicate& isFluid,
+                      double timeIntervalInSeconds, VectorND* result) const;
+
+ private:
+    FdmVector3 _pressure;
+    Array3<char> _isFluid;
+    double _timeIntervalInSeconds = 0.0;
+
+    double remap(const FluidPredicate& isFluid, double scale, size_t i,
+                 size_t j, size_t k) const;
+};
+
+//!
+//! \brief Forces the initial guess of a linear system solver for a scope.
+//!
+//! Pressure solvers that warm-start turn on the initial guess of their linear
+//! system solver for the solve. This guard restores the previous setting when
+//! it goes out of scope, also if the solve throws, so the flag the caller set
+//! on the linear system solver is kept.
+//!
+class ScopedInitialGuess3 {
+ public:
+    //! Turns on the initial guess of \p solver if \p isForced is true.
+    ScopedInitialGuess3(FdmLinearSystemSolver3* solver, bool isForced);
+
+    //! Restores the initial guess setting of the solver.
+    ~ScopedInitialGuess3();
+
+    JET_NON_COPYABLE(ScopedInitialGuess3)
+
+ private:
+    FdmLinearSystemSolver3* _solver;
+    bool _previousUseInitialGuess;
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_GRID_PRESSURE_WARM_START3_H_
@@ -12,6 +12,7 @@
 #include <jet/fdm_mg_solver3.h>
 #include <jet/grid_boundary_condition_solver3.h>
 #include <jet/grid_pressure_solver3.h>
+#include <jet/grid_pressure_warm_start3.h>
 
 #include <memory>
 
@@ -90,14 +91,48 @@ class GridSinglePhasePressureSolver3 : public GridPressureSolver3 {
     //! Returns the pressure field.
     const FdmVector3& pressure() const;
 
+    //! Returns true if the matrix-free linear system is used.
+    bool useMatrixFreeLinearSystem() const;
+
+    //!
+    //! \brief Sets whether the matrix-free linear system is used.
+    //!
+    //! The matrix-free system stores the cell types instead of the stencil
+    //! coefficients, 1 byte per cell instead of 32, and multigrid solvers do
+    //! not need the downsampled velocity to build the coarser levels. It is
+    //! ignored if the compressed system is requested in solve().
+    //!
+    void setUseMatrixFreeLinearSystem(bool useMatrixFree);
+
+    //! Returns true if the solve starts from the previous pressure.
+    bool useWarmStart() const;
+
+    //!
+    //! \brief Sets whether the solve starts from the previous pressure.
+    //!
+    //! The pressure of the last solve, remapped onto the current fluid cells,
+    //! becomes the initial guess of the linear system solver instead of zero.
+    //! The savings show up in lastNumberOfIterations(). Default is false.
+    //!
+    void setUseWarmStart(bool useWarmStart);
+
+    //! Returns the number of iterations of the last linear system solve.
+    unsigned int lastNumberOfIterations() const;
+
  private:
     FdmLinearSystem3 _system;
     FdmCompressedLinearSystem3 _compSystem;
+    FdmMatrixFreeLinearSystem3 _matrixFreeSystem;
     FdmLinearSystemSolver3Ptr _systemSolver;
 
     FdmMgLinearSystem3 _mgSystem;
+    FdmMgMatrixFreeLinearSystem3 _mgMatrixFreeSystem;
     FdmMgSolver3Ptr _mgSystemSolver;
 
+    bool _useMatrixFree = false;
+    bool _useWarmStart = false;
+    GridPressureWarmStart3 _warmStart;
+
     std::vector<Array3<char>> _markers;
 
     void buildMarkers(
@@ -107,9 +142,14 @@ class GridSinglePhasePressureSolver3 : public GridPressureSolver3 {
 
     void decompressSolution();
 
+    void buildInitialGuess(double timeIntervalInSeconds, bool useCompressed,
+                           bool useMatrixFree);
+
     virtual void buildSystem(const FaceCenteredGrid3& input,
                              bool useCompressed);
 
+    void buildMatrixFreeSystem(const FaceCenteredGrid3& input);
+
     virtual void applyPressureGradient(const FaceCenteredGrid3& input,
                                        FaceCenteredGrid3* output);
 };
@@ -27,8 +27,10 @@
 #include <jet/array_samplers2.h>
 #include <jet/array_samplers3.h>
 #include <jet/array_utils.h>
+#include <jet/async.h>
 #include <jet/bcc_lattice_point_generator.h>
 #include <jet/blas.h>
+#include <jet/block_sparse_array3.h>
 #include <jet/bounding_box.h>
 #include <jet/bounding_box2.h>
 #include <jet/bounding_box3.h>
@@ -41,6 +43,7 @@
 #include <jet/cell_centered_vector_grid2.h>
 #include <jet/cell_centered_vector_grid3.h>
 #include <jet/cg.h>
+#include <jet/checkpoint.h>
 #include <jet/collider2.h>
 #include <jet/collider3.h>
 #include <jet/collider_set2.h>
@@ -67,6 +70,7 @@
 #include <jet/face_centered_grid2.h>
 #include <jet/face_centered_grid3.h>
 #include <jet/fcc_lattice_point_generator.h>
+#include <jet/fdm_amgpcg_solver3.h>
 #include <jet/fdm_cg_solver2.h>
 #include <jet/fdm_cg_solver3.h>
 #include <jet/fdm_gauss_seidel_solver2.h>
@@ -79,6 +83,7 @@
 #include <jet/fdm_linear_system3.h>
 #include <jet/fdm_linear_system_solver2.h>
 #include <jet/fdm_linear_system_solver3.h>
+#include <jet/fdm_matrix_free_linear_system3.h>
 #include <jet/fdm_mg_linear_system2.h>
 #include <jet/fdm_mg_linear_system3.h>
 #include <jet/fdm_mg_solver2.h>
@@ -119,6 +124,7 @@
 #include <jet/grid_point_generator3.h>
 #include <jet/grid_pressure_solver2.h>
 #include <jet/grid_pressure_solver3.h>
+#include <jet/grid_pressure_warm_start3.h>
 #include <jet/grid_single_phase_pressure_solver2.h>
 #include <jet/grid_single_phase_pressure_solver3.h>
 #include <jet/grid_smoke_solver2.h>
@@ -154,11 +160,14 @@
 #include <jet/matrix_csr.h>
 #include <jet/matrix_expression.h>
 #include <jet/matrix_mxn.h>
+#include <jet/matrix_sell.h>
+#include <jet/mesh_export_queue3.h>
 #include <jet/mg.h>
 #include <jet/nearest_neighbor_query_engine2.h>
 #include <jet/nearest_neighbor_query_engine3.h>
 #include <jet/octree.h>
 #include <jet/parallel.h>
+#include <jet/particle_cache3.h>
 #include <jet/particle_emitter2.h>
 #include <jet/particle_emitter3.h>
 #include <jet/particle_emitter_set2.h>
@@ -194,6 +203,7 @@
 #include <jet/point_simple_list_searcher3.h>
 #include <jet/points_to_implicit2.h>
 #include <jet/points_to_implicit3.h>
+#include <jet/profiler.h>
 #include <jet/quadtree.h>
 #include <jet/quaternion.h>
 #include <jet/ray.h>
@@ -225,6 +235,7 @@
 #include <jet/sphere3.h>
 #include <jet/spherical_points_to_implicit2.h>
 #include <jet/spherical_points_to_implicit3.h>
+#include <jet/state_archive.h>
 #include <jet/surface2.h>
 #include <jet/surface3.h>
 #include <jet/surface_set2.h>
@@ -7,10 +7,18 @@
 #ifndef INCLUDE_JET_LOGGING_H_
 #define INCLUDE_JET_LOGGING_H_
 
+#include <cstdint>
 #include <iostream>
 #include <sstream>
 #include <string>
 
+//! Compile-time logging level. Log statements below this level are compiled
+//! out, e.g. define JET_LOG_LEVEL=3 to keep only warnings and errors.
+//! The values match LoggingLevel.
+#ifndef JET_LOG_LEVEL
+#define JET_LOG_LEVEL 0
+#endif
+
 namespace jet {
 
 //! Level of the logging.
@@ -21,7 +29,9 @@ enum class LoggingLevel : uint8_t { All = 0, Debug = 1, Info = 2, Warn = 3, Erro
 //! \brief Super simple logger implementation.
 //!
 //! This is a super simple logger implementation that has minimal logging
-//! capability. Currently, the class doesn't support multi-thread logging.
+//! capability. Each message is written as a whole when the logger is
+//! destroyed, either directly to the output stream or, in asynchronous mode,
+//! through the background writer (see Logging::setAsync).
 //!
 class Logger final {
  public:
@@ -72,6 +82,29 @@ class Logging {
 
   //! Un-mutes the logger.
   static void unmute();
+
+  //! Returns true if messages of the given level are currently logged.
+  static bool isEnabled(LoggingLevel level);
+
+  //!
+  //! \brief Enables or disables asynchronous logging.
+  //!
+  //! In asynchronous mode a logger only moves its message into a lock-free
+  //! ring buffer owned by the calling thread. A background thread drains all
+  //! the buffers, restores the original order of the messages and writes them
+  //! in batches with a single flush per stream. Disabling the mode writes out
+  //! all pending messages and stops the background thread.
+  //!
+  //! Call this from the main thread while no other thread is logging, and
+  //! disable it before the output streams are destroyed.
+  //!
+  static void setAsync(bool isAsync);
+
+  //! Returns true if asynchronous logging is enabled.
+  static bool isAsync();
+
+  //! Blocks until every message logged so far has been written and flushed.
+  static void flush();
 };
 
 //! Info-level logger.
@@ -86,18 +119,45 @@ extern Logger errorLogger;
 //! Debug-level logger.
 extern Logger debugLogger;
 
-#define JET_INFO                                                                                  \
-  (Logger(LoggingLevel::Info) << Logging::getHeader(LoggingLevel::Info) << "[" << __FILE__ << ":" \
-                              << __LINE__ << " (" << __func__ << ")] ")
-#define JET_WARN                                                                                  \
-  (Logger(LoggingLevel::Warn) << Logging::getHeader(LoggingLevel::Warn) << "[" << __FILE__ << ":" \
-                              << __LINE__ << " (" << __func__ << ")] ")
-#define JET_ERROR                                                                            \
-  (Logger(LoggingLevel::Error) << Logging::getHeader(LoggingLevel::Error) << "[" << __FILE__ \
-                               << ":" << __LINE__ << " (" << __func__ << ")] ")
-#define JET_DEBUG                                                                            \
-  (Logger(LoggingLevel::Debug) << Logging::getHeader(LoggingLevel::Debug) << "[" << __FILE__ \
-                               << ":" << __LINE__ << " (" << __func__ << ")] ")
+#define JET_LOG_STREAM(level)                                                            \
+  (Logger(level) << Logging::getHeader(level) << "[" << __FILE__ << ":" << __LINE__ << " (" \
+                 << __func__ << ")] ")
+
+// The if-else form lets the macros be used as `JET_INFO << ...;` while
+// skipping all the formatting when the level is disabled.
+#define JET_LOG_IF_ENABLED(level) \
+  if (!Logging::isEnabled(level)) { \
+  } else                            \
+    JET_LOG_STREAM(level)
+
+#define JET_LOG_DISABLED(level) \
+  if (true) {                   \
+  } else                        \
+    JET_LOG_STREAM(level)
+
+#if JET_LOG_LEVEL <= 2
+#define JET_INFO JET_LOG_IF_ENABLED(LoggingLevel::Info)
+#else
+#define JET_INFO JET_LOG_DISABLED(LoggingLevel::Info)
+#endif
+
+#if JET_LOG_LEVEL <= 3
+#define JET_WARN JET_LOG_IF_ENABLED(LoggingLevel::Warn)
+#else
+#define JET_WARN JET_LOG_DISABLED(LoggingLevel::Warn)
+#endif
+
+#if JET_LOG_LEVEL <= 4
+#define JET_ERROR JET_LOG_IF_ENABLED(LoggingLevel::Error)
+#else
+#define JET_ERROR JET_LOG_DISABLED(LoggingLevel::Error)
+#endif
+
+#if JET_LOG_LEVEL <= 1
+#define JET_DEBUG JET_LOG_IF_ENABLED(LoggingLevel::Debug)
+#else
+#define JET_DEBUG JET_LOG_DISABLED(LoggingLevel::Debug)
+#endif
 
 }  // namespace jet
 
@@ -0,0 +1,111 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_MATRIX_SELL_H_
+#define INCLUDE_JET_MATRIX_SELL_H_
+
+#include <jet/matrix_csr.h>
+#include <jet/size2.h>
+#include <jet/vector_n.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief Sliced ELLPACK (SELL-C-sigma) sparse matrix class.
+//!
+//! This class stores a sparse matrix in chunks of kChunkSize consecutive
+//! rows. Each chunk is padded to its longest row and stored column-major, so
+//! the k-th non-zeros of all rows of a chunk are adjacent in memory and one
+//! SIMD lane works on one row. To limit the padding, rows are sorted by
+//! their number of non-zeros within windows of sigma rows before they are
+//! cut into chunks; sigma = 1 keeps the original row order. The matrix is
+//! built from a MatrixCsr and is meant for repeated matrix-vector products,
+//! not for element-wise editing.
+//!
+//! The non-zeros of each row are accumulated in the same order as in the
+//! CSR matrix, so the products match the CSR products bit by bit. When the
+//! compiler targets AVX2, the double precision kernel processes one chunk
+//! with 256-bit gathers.
+//!
+//! \tparam T Type of the element.
+//!
+template <typename T>
+class MatrixSell {
+ public:
+    static_assert(
+        std::is_floating_point<T>::value,
+        "MatrixSell only can be instantiated with floating point types");
+
+    //! Number of rows per chunk, i.e. the number of doubles in an AVX2
+    //! register.
+    static constexpr size_t kChunkSize = 4;
+
+    //! Default number of rows sorted by length at a time.
+    static constexpr size_t kDefaultSortingScope = 32;
+
+    //! Constructs an empty matrix.
+    MatrixSell();
+
+    //! Constructs a matrix from a CSR matrix with the given sorting scope.
+    explicit MatrixSell(const MatrixCsr<T>& other,
+                        size_t sortingScope = kDefaultSortingScope);
+
+    //! Clears the matrix and makes it zero-dimensional.
+    void clear();
+
+    //! Copies the CSR matrix \p other, sorting the rows by length within
+    //! windows of \p sortingScope rows.
+    void set(const MatrixCsr<T>& other,
+             size_t sortingScope = kDefaultSortingScope);
+
+    //! Returns the size of this matrix.
+    Size2 size() const;
+
+    //! Returns number of rows of this matrix.
+    size_t rows() const;
+
+    //! Returns number of columns of this matrix.
+    size_t cols() const;
+
+    //! Returns the number of non-zero elements of the source matrix.
+    size_t numberOfNonZeros() const;
+
+    //! Returns the number of stored elements including the padding.
+    size_t numberOfStoredElements() const;
+
+    //! Computes \p result = this * \p v.
+    void mul(const VectorN<T>& v, VectorN<T>* result) const;
+
+    //! Computes \p result = \p b - this * \p x.
+    void residual(const VectorN<T>& x, const VectorN<T>& b,
+                  VectorN<T>* result) const;
+
+ private:
+    Size2 _size;
+    size_t _numberOfNonZeros = 0;
+    std::vector<size_t> _chunkPointers;
+    std::vector<T> _values;
+    std::vector<uint32_t> _columnIndices;
+    std::vector<size_t> _rowOrder;
+
+    template <typename Callback>
+    void forEachRowProduct(const VectorN<T>& x, const Callback& func) const;
+};
+
+//! Float-type SELL matrix.
+typedef MatrixSell<float> MatrixSellF;
+
+//! Double-type SELL matrix.
+typedef MatrixSell<double> MatrixSellD;
+
+}  // namespace jet
+
+#include "detail/matrix_sell-inl.h"
+
+#endif  // INCLUDE_JET_MATRIX_SELL_H_
@@ -0,0 +1,96 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_MESH_EXPORT_QUEUE3_H_
+#define INCLUDE_JET_MESH_EXPORT_QUEUE3_H_
+
+#include <jet/triangle_mesh3.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace jet {
+
+//!
+//! \brief      Writes triangle meshes to disk on a background thread.
+//!
+//! push() hands a finished mesh, typically the output of the surface
+//! reconstruction, over to a worker thread that writes it as binary ply if
+//! the file name ends with ".ply" and as obj otherwise. The memory held by
+//! queued meshes is bounded: once it exceeds the budget, push() blocks until
+//! the worker has written enough meshes, which throttles the producer to the
+//! speed of the disk instead of letting the queue grow without limit. A
+//! single mesh larger than the budget is still accepted when the queue is
+//! empty.
+//!
+class MeshExportQueue3 {
+ public:
+    //! Default memory budget of the queued meshes in bytes.
+    static constexpr size_t kDefaultMaxPendingBytes = 512u << 20;
+
+    //! Constructs the queue and starts its worker thread.
+    explicit MeshExportQueue3(size_t maxPendingBytes = kDefaultMaxPendingBytes);
+
+    //! Writes the remaining meshes and stops the worker thread.
+    ~MeshExportQueue3();
+
+    MeshExportQueue3(const MeshExportQueue3&) = delete;
+
+    MeshExportQueue3& operator=(const MeshExportQueue3&) = delete;
+
+    //!
+    //! \brief      Queues \p mesh to be written to \p filename.
+    //!
+    //! The mesh must not be modified until it has been written; pass a copy
+    //! if the caller keeps using it.
+    //!
+    //! \return     False if a previously queued mesh could not be written.
+    //!
+    bool push(const std::shared_ptr<const TriangleMesh3>& mesh,
+              const std::string& filename);
+
+    //! Waits until all queued meshes are on disk. Returns false if any mesh
+    //! failed since the last flush.
+    bool flush();
+
+    //! Returns the memory budget of the queued meshes in bytes.
+    size_t maxPendingBytes() const;
+
+    //! Returns the memory held by queued meshes in bytes.
+    size_t pendingBytes() const;
+
+    //! Returns the total time push() spent waiting for the budget in seconds.
+    double blockedTimeInSeconds() const;
+
+ private:
+    struct Job {
+        std::shared_ptr<const TriangleMesh3> mesh;
+        std::string filename;
+        size_t bytes;
+    };
+
+    size_t _maxPendingBytes;
+    size_t _pendingBytes = 0;
+    double _blockedTimeInSeconds = 0.0;
+
+    std::deque<Job> _jobs;
+    bool _hasFailed = false;
+    bool _isStopping = false;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+    std::thread _worker;
+
+    void run();
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_MESH_EXPORT_QUEUE3_H_
@@ -89,6 +89,9 @@ struct MgParameters {
 struct MgResult {
     //! Lastly measured norm of residual.
     double lastResidualNorm;
+
+    //! Time spent on each level in seconds, excluding the coarser levels.
+    std::vector<double> levelTimesInSeconds;
 };
 
 //!
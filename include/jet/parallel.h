@@ -7,10 +7,144 @@
 #ifndef INCLUDE_JET_PARALLEL_H_
 #define INCLUDE_JET_PARALLEL_H_
 
+#include <jet/constants.h>
+
+#include <cstddef>
+
+#ifdef JET_TASKING_TBB
+#include <tbb/partitioner.h>
+#endif
+
 namespace jet {
 
-//! Execution policy tag.
-enum class ExecutionPolicy { kSerial, kParallel };
+//! Strategy used to split a parallel loop into chunks.
+enum class Partitioner {
+    //! Adaptive splitting, chosen by the tasking backend (default).
+    kAuto,
+
+    //! Even split across the worker threads with no further stealing.
+    kStatic,
+
+    //! Like kAuto, but replays the previous thread assignment of the
+    //! AffinityPartitioner token passed along with the policy.
+    kAffinity
+};
+
+//!
+//! \brief Reusable token that remembers which thread ran which chunk.
+//!
+//! Passing the same token to successive loops over the same index range (for
+//! example, the per-particle loops of consecutive sub-timesteps) lets the
+//! backend schedule each chunk on the thread that touched it last time, which
+//! keeps the data warm in that core's cache. The token must outlive every loop
+//! that uses it and must not be shared by loops running concurrently.
+//!
+class AffinityPartitioner {
+ public:
+    AffinityPartitioner() = default;
+
+    JET_NON_COPYABLE(AffinityPartitioner)
+
+#ifdef JET_TASKING_TBB
+    //! Returns the underlying TBB partitioner.
+    tbb::affinity_partitioner& tbbPartitioner() { return _partitioner; }
+
+ private:
+    tbb::affinity_partitioner _partitioner;
+#endif
+};
+
+//!
+//! \brief Execution policy.
+//!
+//! The policy tells the parallel algorithms whether to run serially or in
+//! parallel. Parallel policies additionally carry scheduling hints: the minimum
+//! number of indices per chunk (grain size) and the partitioner. Hints are
+//! honored where the tasking backend supports them and ignored otherwise.
+//!
+//! \code{.cpp}
+//! auto policy = ExecutionPolicy::kParallel.withGrainSize(1024);
+//! parallelFor(kZeroSize, n, func, policy);
+//! \endcode
+//!
+class ExecutionPolicy {
+ public:
+    //! Execution mode.
+    enum class Mode { kSerial, kParallel };
+
+    //! Serial execution policy.
+    static const ExecutionPolicy kSerial;
+
+    //! Parallel execution policy with default scheduling.
+    static const ExecutionPolicy kParallel;
+
+    //! Constructs a policy with given mode and scheduling hints.
+    constexpr ExecutionPolicy(Mode mode = Mode::kParallel, size_t grainSize = 1,
+                              Partitioner partitioner = Partitioner::kAuto,
+                              AffinityPartitioner* affinity = nullptr)
+        : _mode(mode),
+          _grainSize(grainSize > 0 ? grainSize : 1),
+          _partitioner(partitioner),
+          _affinity(affinity) {}
+
+    //! Returns the execution mode.
+    constexpr Mode mode() const { return _mode; }
+
+    //! Returns true if the policy runs loops in parallel.
+    constexpr bool isParallel() const { return _mode == Mode::kParallel; }
+
+    //! Returns the minimum number of indices per chunk.
+    constexpr size_t grainSize() const { return _grainSize; }
+
+    //! Returns the partitioner.
+    constexpr Partitioner partitioner() const { return _partitioner; }
+
+    //! Returns the affinity token, or nullptr if none is attached.
+    constexpr AffinityPartitioner* affinityPartitioner() const {
+        return _affinity;
+    }
+
+    //! Returns a copy of this policy with given grain size.
+    constexpr ExecutionPolicy withGrainSize(size_t grainSize) const {
+        return ExecutionPolicy(_mode, grainSize, _partitioner, _affinity);
+    }
+
+    //! Returns a copy of this policy with given partitioner.
+    constexpr ExecutionPolicy withPartitioner(Partitioner partitioner) const {
+        return ExecutionPolicy(_mode, _grainSize, partitioner, _affinity);
+    }
+
+    //! Returns a copy of this policy that replays the given affinity token.
+    constexpr ExecutionPolicy withAffinity(
+        AffinityPartitioner& affinity) const {
+        return ExecutionPolicy(_mode, _grainSize, Partitioner::kAffinity,
+                               &affinity);
+    }
+
+    //! Returns true if both policies are identical.
+    constexpr bool operator==(const ExecutionPolicy& other) const {
+        return _mode == other._mode && _grainSize == other._grainSize &&
+               _partitioner == other._partitioner &&
+               _affinity == other._affinity;
+    }
+
+    //! Returns true if the policies differ.
+    constexpr bool operator!=(const ExecutionPolicy& other) const {
+        return !(*this == other);
+    }
+
+ private:
+    Mode _mode;
+    size_t _grainSize;
+    Partitioner _partitioner;
+    AffinityPartitioner* _affinity;
+};
+
+inline constexpr ExecutionPolicy ExecutionPolicy::kSerial{
+    ExecutionPolicy::Mode::kSerial};
+
+inline constexpr ExecutionPolicy ExecutionPolicy::kParallel{
+    ExecutionPolicy::Mode::kParallel};
 
 //!
 //! \brief      Fills from \p begin to \p end with \p value in parallel.
@@ -202,6 +336,110 @@ Value parallelReduce(IndexType beginIndex, IndexType endIndex,
                      const Reduce& reduce,
                      ExecutionPolicy policy = ExecutionPolicy::kParallel);
 
+//!
+//! \brief      Performs reduce operation in parallel with deterministic order.
+//!
+//! This function works like parallelReduce, but the index range is always
+//! split into the same fixed-size blocks and the partial results are combined
+//! in ascending block order. The result is therefore identical from run to run
+//! regardless of the number of threads, which matters for non-associative
+//! operations such as floating-point sums.
+//!
+//! \param[in]  beginIndex The begin index.
+//! \param[in]  endIndex   The end index.
+//! \param[in]  identity   Identity value for the reduce operation.
+//! \param[in]  function   The function for reducing subrange.
+//! \param[in]  reduce     The reduce operator.
+//! \param[in]  policy     The execution policy (parallel or serial).
+//!
+//! \tparam     IndexType  Index type.
+//! \tparam     Value      Value type.
+//! \tparam     Function   Reduce function type.
+//!
+template <typename IndexType, typename Value, typename Function,
+          typename Reduce>
+Value parallelDeterministicReduce(
+    IndexType beginIndex, IndexType endIndex, const Value& identity,
+    const Function& func, const Reduce& reduce,
+    ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+//!
+//! \brief      Returns the sum of \p function(i) for all indices in parallel.
+//!
+//! \param[in]  beginIndex The begin index.
+//! \param[in]  endIndex   The end index.
+//! \param[in]  identity   The zero value returned for an empty range.
+//! \param[in]  function   The function that maps an index to a value.
+//! \param[in]  policy     The execution policy (parallel or serial).
+//!
+//! \tparam     IndexType  Index type.
+//! \tparam     Value      Value type.
+//! \tparam     Function   Function type.
+//!
+template <typename IndexType, typename Value, typename Function>
+Value parallelSum(IndexType beginIndex, IndexType endIndex,
+                  const Value& identity, const Function& function,
+                  ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+//!
+//! \brief      Returns the minimum of \p function(i) for all indices in
+//!             parallel.
+//!
+//! \param[in]  beginIndex The begin index.
+//! \param[in]  endIndex   The end index.
+//! \param[in]  identity   The initial value (e.g. the largest representable
+//!                        value), also returned for an empty range.
+//! \param[in]  function   The function that maps an index to a value.
+//! \param[in]  policy     The execution policy (parallel or serial).
+//!
+//! \tparam     IndexType  Index type.
+//! \tparam     Value      Value type.
+//! \tparam     Function   Function type.
+//!
+template <typename IndexType, typename Value, typename Function>
+Value parallelMin(IndexType beginIndex, IndexType endIndex,
+                  const Value& identity, const Function& function,
+                  ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+//!
+//! \brief      Returns the maximum of \p function(i) for all indices in
+//!             parallel.
+//!
+//! \param[in]  beginIndex The begin index.
+//! \param[in]  endIndex   The end index.
+//! \param[in]  identity   The initial value (e.g. the lowest representable
+//!                        value), also returned for an empty range.
+//! \param[in]  function   The function that maps an index to a value.
+//! \param[in]  policy     The execution policy (parallel or serial).
+//!
+//! \tparam     IndexType  Index type.
+//! \tparam     Value      Value type.
+//! \tparam     Function   Function type.
+//!
+template <typename IndexType, typename Value, typename Function>
+Value parallelMax(IndexType beginIndex, IndexType endIndex,
+                  const Value& identity, const Function& function,
+                  ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
+//!
+//! \brief      Returns the index that maximizes \p function(i) in parallel.
+//!
+//! If several indices share the maximum value, the smallest one is returned.
+//! If the range is empty, \p endIndex is returned.
+//!
+//! \param[in]  beginIndex The begin index.
+//! \param[in]  endIndex   The end index.
+//! \param[in]  function   The function that maps an index to a value.
+//! \param[in]  policy     The execution policy (parallel or serial).
+//!
+//! \tparam     IndexType  Index type.
+//! \tparam     Function   Function type.
+//!
+template <typename IndexType, typename Function>
+IndexType parallelArgMax(IndexType beginIndex, IndexType endIndex,
+                         const Function& function,
+                         ExecutionPolicy policy = ExecutionPolicy::kParallel);
+
 //!
 //! \brief      Sorts a container in parallel.
 //!
@@ -237,7 +475,14 @@ void parallelSort(RandomIterator begin, RandomIterator end,
                   CompareFunction compare,
                   ExecutionPolicy policy = ExecutionPolicy::kParallel);
 
-//! Sets maximum number of threads to use.
+//!
+//! \brief      Sets maximum number of threads to use.
+//!
+//! With the TBB backend, the parallel algorithms run inside a task arena of
+//! this size. With the C++11 thread backend, the persistent worker pool is
+//! rebuilt with this many threads (the calling thread counts as one). Call this
+//! from the main thread between parallel loops, not while one is running.
+//!
 void setMaxNumberOfThreads(unsigned int numThreads);
 
 //! Returns maximum number of threads to use.
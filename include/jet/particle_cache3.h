@@ -0,0 +1,451 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_PARTICLE_CACHE3_H_
+#define INCLUDE_JET_PARTICLE_CACHE3_H_
+
+#include <jet/array1.h>
+#include <jet/array_accessor1.h>
+#include <jet/constants.h>
+#include <jet/macros.h>
+#include <jet/particle_system_data3.h>
+#include <jet/vector3.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief      On-disk layout of a particle cache file.
+//!
+//! A cache file is a header followed by one block per frame and, once the
+//! writer has been closed, a frame index. Each block starts with a frame
+//! header and a column table, followed by one column per particle attribute
+//! (scalar layers, then vector layers, in ParticleSystemData3 order). Blocks
+//! and columns start at 64-byte aligned offsets, so a memory-mapped column
+//! can be read in place as an array of double or Vector3D. All values are
+//! stored in the byte order of the writing machine.
+//!
+//! Optionally, columns are stored in a lossy compressed encoding instead (see
+//! Compression). Such columns cannot be viewed in place and are decoded with
+//! the ParticleCacheReader3::read* functions.
+//!
+namespace particle_cache {
+
+//! Alignment of frame blocks and columns in bytes.
+constexpr uint64_t kAlignment = 64;
+
+//! Current version of the file format.
+constexpr uint32_t kVersion = 2;
+
+//! Encoding of a column.
+enum ColumnEncoding : uint32_t {
+    //! Array of double or Vector3D that can be viewed in place.
+    kRaw = 0,
+
+    //! Positions on a fixed-point grid, see QuantizedColumnHeader.
+    kQuantized = 1,
+
+    //! Vectors as three IEEE 754 half floats.
+    kHalf = 2,
+
+    //! Scalars as single-precision floats.
+    kFloat = 3
+};
+
+//!
+//! \brief      Options of the lossy compressed encoding.
+//!
+//! Positions are rounded to a grid with a spacing of twice the tolerance
+//! around the origin, and every grid coordinate is stored as a
+//! variable-length integer. Between key frames, the difference to the same
+//! particle's coordinate in the previous frame is stored instead, which
+//! takes one or two bytes for a particle that moved a few grid cells. Other
+//! vector layers such as velocities are stored as half floats and scalar
+//! layers as floats.
+//!
+struct Compression {
+    //! Enables the compressed encoding.
+    bool isEnabled = false;
+
+    //! Origin of the position grid, e.g. the lower corner of the domain.
+    Vector3D origin;
+
+    //! Max absolute error of a decoded position component.
+    double positionTolerance = 1e-4;
+
+    //!
+    //! Number of frames between two key frames. Decoding frame i takes the
+    //! decoding of every frame since the previous key frame, unless frames
+    //! are read in order.
+    //!
+    unsigned int keyFrameInterval = 30;
+};
+
+//! File header at offset zero.
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t numberOfFrames;
+    //! Offset of the frame index, or zero if the writer was not closed.
+    uint64_t indexOffset;
+    uint64_t reserved[4];
+};
+
+//! Header at the start of every frame block.
+struct FrameHeader {
+    char magic[4];
+    uint32_t numberOfColumns;
+    //! Size of the whole block including padding.
+    uint64_t blockSize;
+    int64_t frameIndex;
+    double timeInSeconds;
+    uint64_t numberOfParticles;
+    double radius;
+    double mass;
+    uint32_t numberOfScalarColumns;
+    uint32_t positionColumn;
+    uint32_t velocityColumn;
+    uint32_t forceColumn;
+};
+
+//! Entry of the column table that follows the frame header.
+struct ColumnEntry {
+    //! Offset of the column relative to the start of the block.
+    uint64_t offset;
+    //! Size of the column in bytes.
+    uint64_t size;
+    //! One of ColumnEncoding.
+    uint32_t encoding;
+    uint32_t reserved;
+};
+
+//!
+//! \brief      Header of a kQuantized column.
+//!
+//! The header is followed by numberOfChunks + 1 offsets relative to the
+//! column start, which delimit the byte streams of the chunks. Each chunk
+//! holds particlesPerChunk particles (the last one fewer), so chunks can be
+//! encoded and decoded in parallel. A particle is stored as three zigzag
+//! encoded LEB128 integers: grid coordinates in key frames, otherwise the
+//! difference to the previous frame's coordinates.
+//!
+struct QuantizedColumnHeader {
+    double origin[3];
+    double gridSpacing;
+    uint64_t particlesPerChunk;
+    uint32_t numberOfChunks;
+    //! Non-zero if the coordinates are relative to the previous frame.
+    uint32_t isDelta;
+};
+
+//! Entry of the frame index at the end of the file.
+struct FrameIndexEntry {
+    uint64_t offset;
+    uint64_t blockSize;
+    int64_t frameIndex;
+    double timeInSeconds;
+};
+
+}  // namespace particle_cache
+
+//!
+//! \brief      Writes particle frames to a cache file on a background thread.
+//!
+//! writeFrame copies the attribute columns of the particles into a frame
+//! block and returns; a dedicated thread appends the blocks to the file, so
+//! the solver can continue with the next frame while the previous one is
+//! written. Block buffers are recycled, so steady-state writing does not
+//! allocate. At most maxPendingFrames blocks are queued at a time; writeFrame
+//! blocks when the limit is reached, which caps the memory used by snapshots.
+//!
+class ParticleCacheWriter3 {
+ public:
+    //! Default constructor.
+    ParticleCacheWriter3();
+
+    //! Closes the file if it is still open.
+    ~ParticleCacheWriter3();
+
+    //! Sets the compression for files opened afterwards. Off by default.
+    void setCompression(const particle_cache::Compression& compression);
+
+    //! Returns the compression options.
+    const particle_cache::Compression& compression() const;
+
+    ParticleCacheWriter3(const ParticleCacheWriter3&) = delete;
+
+    ParticleCacheWriter3& operator=(const ParticleCacheWriter3&) = delete;
+
+    //!
+    //! \brief      Creates the cache file and starts the writer thread.
+    //!
+    //! \param[in]  filename            Name of the file to create.
+    //! \param[in]  maxPendingFrames    Max number of frames queued for writing.
+    //!
+    //! \return     False if the file cannot be created.
+    //!
+    bool open(const std::string& filename, size_t maxPendingFrames = 2);
+
+    //! Returns true if the cache file is open.
+    bool isOpen() const;
+
+    //!
+    //! \brief      Snapshots the particles and queues the frame for writing.
+    //!
+    //! \return     False if the cache is not open or a previous write failed.
+    //!
+    bool writeFrame(int frameIndex, double timeInSeconds,
+                    const ParticleSystemData3& particles);
+
+    //! Blocks until every queued frame has been written.
+    void flush();
+
+    //!
+    //! \brief      Writes the pending frames and the frame index, then closes
+    //!             the file.
+    //!
+    //! \return     False if any write failed.
+    //!
+    bool close();
+
+    //! Returns the number of frames queued so far.
+    size_t numberOfFrames() const;
+
+    //!
+    //! \brief      Returns the size of the written frames divided by the size
+    //!             they would have without compression.
+    //!
+    double compressionRatio() const;
+
+ private:
+    struct PendingFrame {
+        std::vector<uint8_t> block;
+        particle_cache::FrameIndexEntry entry;
+    };
+
+    std::FILE* _file = nullptr;
+    uint64_t _fileSize = 0;
+    size_t _maxPendingFrames = 2;
+    size_t _numberOfFrames = 0;
+    bool _hasFailed = false;
+    bool _isStopping = false;
+
+    std::vector<particle_cache::FrameIndexEntry> _index;
+    std::deque<PendingFrame> _pendingFrames;
+    std::vector<std::vector<uint8_t>> _freeBlocks;
+    size_t _numberOfFramesBeingWritten = 0;
+    uint64_t _rawFrameBytes = 0;
+    uint64_t _writtenFrameBytes = 0;
+
+    particle_cache::Compression _compression;
+
+    // Encoder state, only used by the writer thread
+    particle_cache::Compression _activeCompression;
+    std::vector<uint8_t> _encodedBlock;
+    std::vector<std::vector<uint8_t>> _encodedChunks;
+    std::vector<int64_t> _previousCoordinates;
+    unsigned int _framesSinceKeyFrame = 0;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _queueChanged;
+    std::thread _thread;
+
+    void run();
+
+    void encodeBlock(const std::vector<uint8_t>& block);
+};
+
+//!
+//! \brief      View of a single frame stored in a particle cache.
+//!
+//! The accessors point straight into the memory-mapped file, so they stay
+//! valid only while the ParticleCacheReader3 that returned the frame is open.
+//! Columns of compressed frames cannot be viewed; use the read functions of
+//! the reader for them.
+//!
+class ParticleCacheFrame3 {
+ public:
+    //! Constructs an empty frame.
+    ParticleCacheFrame3() = default;
+
+    //! Returns the index of the frame as passed to the writer.
+    int index() const;
+
+    //! Returns the simulation time of the frame.
+    double timeInSeconds() const;
+
+    //! Returns the number of particles.
+    size_t numberOfParticles() const;
+
+    //! Returns the radius of the particles.
+    double radius() const;
+
+    //! Returns the mass of the particles.
+    double mass() const;
+
+    //! Returns true if any column is stored in a compressed encoding.
+    bool isCompressed() const;
+
+    //! Returns the position array.
+    ConstArrayAccessor1<Vector3D> positions() const;
+
+    //! Returns the velocity array.
+    ConstArrayAccessor1<Vector3D> velocities() const;
+
+    //! Returns the force array.
+    ConstArrayAccessor1<Vector3D> forces() const;
+
+    //! Returns the number of scalar data layers.
+    size_t numberOfScalarData() const;
+
+    //! Returns the number of vector data layers.
+    size_t numberOfVectorData() const;
+
+    //! Returns custom scalar data layer at given index.
+    ConstArrayAccessor1<double> scalarDataAt(size_t idx) const;
+
+    //! Returns custom vector data layer at given index.
+    ConstArrayAccessor1<Vector3D> vectorDataAt(size_t idx) const;
+
+    //! Returns the encoding of the given column.
+    particle_cache::ColumnEncoding columnEncoding(size_t column) const;
+
+    //!
+    //! \brief      Copies the frame into the particle system data.
+    //!
+    //! The particles are resized to the frame's particle count and the data
+    //! layers that exist in both are copied. Extra layers of \p particles are
+    //! only resized.
+    //!
+    void copyTo(ParticleSystemData3* particles) const;
+
+ private:
+    friend class ParticleCacheReader3;
+
+    const uint8_t* _block = nullptr;
+
+    explicit ParticleCacheFrame3(const uint8_t* block);
+
+    const particle_cache::FrameHeader& header() const;
+
+    const particle_cache::ColumnEntry& columnEntry(size_t idx) const;
+
+    const uint8_t* column(size_t idx) const;
+};
+
+//!
+//! \brief      Memory-maps a particle cache file for random frame access.
+//!
+//! Opening the cache only maps the file and reads the frame index; frame data
+//! is paged in by the OS when it is first touched. If the writer was not
+//! closed, e.g. because the simulation crashed, the frames that were fully
+//! written are recovered by scanning the blocks.
+//!
+class ParticleCacheReader3 {
+ public:
+    //! Default constructor.
+    ParticleCacheReader3();
+
+    //! Unmaps the file.
+    ~ParticleCacheReader3();
+
+    ParticleCacheReader3(const ParticleCacheReader3&) = delete;
+
+    ParticleCacheReader3& operator=(const ParticleCacheReader3&) = delete;
+
+    //!
+    //! \brief      Maps the cache file.
+    //!
+    //! \return     False if the file cannot be mapped or is not a valid cache.
+    //!
+    bool open(const std::string& filename);
+
+    //! Unmaps the file; frames returned before become invalid.
+    void close();
+
+    //! Returns true if a cache file is mapped.
+    bool isOpen() const;
+
+    //! Returns the number of frames in the cache.
+    size_t numberOfFrames() const;
+
+    //! Returns the i-th frame in the order it was written.
+    ParticleCacheFrame3 frame(size_t i) const;
+
+    //!
+    //! \brief      Finds the frame that was written with the given index.
+    //!
+    //! \return     False if there is no such frame.
+    //!
+    bool findFrame(int frameIndex, ParticleCacheFrame3* frame) const;
+
+    //! Asks the OS to start paging in the i-th frame, e.g. ahead of playback.
+    void prefetch(size_t i) const;
+
+    //!
+    //! \brief      Reads the positions of the i-th frame, decoding them if
+    //!             they are compressed.
+    //!
+    //! The last decoded frame is remembered, so reading delta-encoded frames
+    //! in order costs one decode per frame. Because of that state, read
+    //! functions must not be called concurrently on the same reader.
+    //!
+    void readPositions(size_t i, Array1<Vector3D>* positions) const;
+
+    //! Reads a scalar data layer of the i-th frame, decoding it if needed.
+    void readScalarDataAt(size_t i, size_t idx, Array1<double>* data) const;
+
+    //! Reads a vector data layer of the i-th frame, decoding it if needed.
+    void readVectorDataAt(size_t i, size_t idx, Array1<Vector3D>* data) const;
+
+    //!
+    //! \brief      Reads the i-th frame into the particle system data.
+    //!
+    //! Works like ParticleCacheFrame3::copyTo, but also for compressed frames.
+    //!
+    void readFrame(size_t i, ParticleSystemData3* particles) const;
+
+ private:
+    const uint8_t* _data = nullptr;
+    uint64_t _size = 0;
+    std::vector<particle_cache::FrameIndexEntry> _index;
+
+    // Grid coordinates of the last decoded delta-encoded position column
+    mutable std::vector<int64_t> _decodedCoordinates;
+    mutable size_t _decodedFrame = kMaxSize;
+
+#ifdef JET_WINDOWS
+    void* _fileHandle = nullptr;
+    void* _mappingHandle = nullptr;
+#endif
+
+    bool readIndex();
+
+    bool isValidBlock(uint64_t offset, uint64_t blockSize) const;
+
+    bool isValidColumn(const particle_cache::ColumnEntry& column,
+                       const uint8_t* data, uint64_t numberOfParticles,
+                       bool isPosition, bool isScalar) const;
+
+    void decodeCoordinates(size_t i) const;
+
+    void readScalarColumn(size_t i, size_t column, double* data) const;
+
+    void readVectorColumn(size_t i, size_t column, Vector3D* data) const;
+};
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_PARTICLE_CACHE3_H_
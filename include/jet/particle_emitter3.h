@@ -9,6 +9,7 @@
 
 #include <jet/animation.h>
 #include <jet/particle_system_data3.h>
+#include <jet/state_archive.h>
 
 namespace jet {
 
@@ -60,10 +61,22 @@ class ParticleEmitter3 {
     //!
     void setOnBeginUpdateCallback(const OnBeginUpdateCallback& callback);
 
+    //! Saves the run-time state of the emitter for checkpointing.
+    void saveState(StateArchive* archive) const;
+
+    //! Loads the run-time state saved by ParticleEmitter3::saveState.
+    void loadState(StateArchive* archive);
+
  protected:
     //! Called when ParticleEmitter3::setTarget is executed.
     virtual void onSetTarget(const ParticleSystemData3Ptr& particles);
 
+    //! Called when ParticleEmitter3::saveState is executed.
+    virtual void onSaveState(StateArchive* archive) const;
+
+    //! Called when ParticleEmitter3::loadState is executed.
+    virtual void onLoadState(StateArchive* archive);
+
     //! Called when ParticleEmitter3::update is executed.
     virtual void onUpdate(
         double currentTimeInSeconds,
@@ -44,6 +44,10 @@ class ParticleEmitterSet3 final : public ParticleEmitter3 {
     void onUpdate(
         double currentTimeInSeconds,
         double timeIntervalInSecond) override;
+
+    void onSaveState(StateArchive* archive) const override;
+
+    void onLoadState(StateArchive* archive) override;
 };
 
 //! Shared pointer type for the ParticleEmitterSet3.
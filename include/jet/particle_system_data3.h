@@ -9,6 +9,7 @@
 
 #include <jet/array1.h>
 #include <jet/serialization.h>
+#include <jet/state_archive.h>
 #include <jet/point_neighbor_searcher3.h>
 
 #include <memory>
@@ -128,6 +129,17 @@ class ParticleSystemData3 : public Serializable {
     //! Returns the force array (mutable).
     ArrayAccessor1<Vector3D> forces();
 
+    //! Returns the number of scalar data layers.
+    size_t numberOfScalarData() const;
+
+    //!
+    //! \brief      Returns the number of vector data layers.
+    //!
+    //! Positions, velocities, and forces are vector data layers as well, so
+    //! this is at least three.
+    //!
+    size_t numberOfVectorData() const;
+
     //! Returns custom scalar data layer at given index (immutable).
     ConstArrayAccessor1<double> scalarDataAt(size_t idx) const;
 
@@ -216,6 +228,43 @@ class ParticleSystemData3 : public Serializable {
     //! Deserializes this particle system data from the buffer.
     void deserialize(const std::vector<uint8_t>& buffer) override;
 
+    //!
+    //! \brief      Deserializes from the buffer without copying the data
+    //!             layers.
+    //!
+    //! The scalar and vector data layers keep pointing into \p buffer, which
+    //! must not change, and are copied to owned storage (copy-on-write) when
+    //! they are first accessed through a mutable accessor or resized. The
+    //! buffer is released once every layer has been copied. This makes
+    //! restoring a large state, e.g. from a memory-mapped file, cheap and
+    //! avoids holding two copies of layers that are only read. The neighbor
+    //! searcher and lists are copied as in deserialize().
+    //!
+    //! \param[in]  buffer  Serialized data; it can alias any owner, such as a
+    //!                     memory mapping, through the shared_ptr aliasing
+    //!                     constructor.
+    //!
+    virtual void deserializeView(const std::shared_ptr<const uint8_t>& buffer);
+
+    //! Returns true if any data layer still points into a deserialized view.
+    bool isView() const;
+
+    //!
+    //! \brief      Saves the particle layers for checkpointing.
+    //!
+    //! Each layer is copied with a single memcpy. The neighbor searcher and
+    //! lists are not saved since the solvers rebuild them every sub-timestep.
+    //!
+    void saveState(StateArchive* archive) const;
+
+    //!
+    //! \brief      Loads the particle layers saved by saveState.
+    //!
+    //! The data must have the same layers as the saved one, e.g. be set up by
+    //! the same solver type.
+    //!
+    void loadState(StateArchive* archive);
+
     //! Copies from other particle system data.
     void set(const ParticleSystemData3& other);
 
@@ -229,7 +278,8 @@ class ParticleSystemData3 : public Serializable {
         const;
 
     void deserializeParticleSystemData(
-        const fbs::ParticleSystemData3* fbsParticleSystemData);
+        const fbs::ParticleSystemData3* fbsParticleSystemData,
+        const std::shared_ptr<const uint8_t>& viewBuffer = nullptr);
 
  private:
     double _radius = 1e-3;
@@ -244,6 +294,25 @@ class ParticleSystemData3 : public Serializable {
 
     PointNeighborSearcher3Ptr _neighborSearcher;
     std::vector<std::vector<size_t>> _neighborLists;
+
+    // Layers restored by deserializeView point into _viewBuffer until they
+    // are first written. Empty unless such a view is active; an entry with a
+    // null data pointer means the layer is owned by the lists above.
+    std::shared_ptr<const uint8_t> _viewBuffer;
+    std::vector<ConstArrayAccessor1<double>> _scalarDataViews;
+    std::vector<ConstArrayAccessor1<Vector3D>> _vectorDataViews;
+
+    bool isScalarDataView(size_t idx) const;
+
+    bool isVectorDataView(size_t idx) const;
+
+    void promoteScalarData(size_t idx);
+
+    void promoteVectorData(size_t idx);
+
+    void promoteAllData();
+
+    void releaseViewBufferIfUnused();
 };
 
 //! Shared pointer type of ParticleSystemData3.
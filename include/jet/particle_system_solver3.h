@@ -142,6 +142,13 @@ class ParticleSystemSolver3 : public PhysicsAnimation {
     //! Assign a new particle system data.
     void setParticleSystemData(const ParticleSystemData3Ptr& newParticles);
 
+    //! Saves the solver parameters, particles, emitter, and collider state.
+    //! The wind field is assumed to be constant.
+    void onSaveState(StateArchive* archive) const override;
+
+    //! Loads the state saved by ParticleSystemSolver3::onSaveState.
+    void onLoadState(StateArchive* archive) override;
+
  private:
     double _dragCoefficient = 1e-4;
     double _restitutionCoefficient = 0.0;
@@ -7,6 +7,7 @@
 #ifndef INCLUDE_JET_PCI_SPH_SOLVER3_H_
 #define INCLUDE_JET_PCI_SPH_SOLVER3_H_
 
+#include <jet/parallel.h>
 #include <jet/sph_solver3.h>
 
 namespace jet {
@@ -57,6 +58,9 @@ class PciSphSolver3 : public SphSolver3 {
     //!
     void setMaxNumberOfIterations(unsigned int n);
 
+    //! Returns the number of PCISPH iterations of the last sub-timestep.
+    unsigned int lastNumberOfIterations() const;
+
     //! Returns builder fox PciSphSolver3.
     static Builder builder();
 
@@ -68,15 +72,31 @@ class PciSphSolver3 : public SphSolver3 {
     //! Performs pre-processing step before the simulation.
     void onBeginAdvanceTimeStep(double timeStepInSeconds) override;
 
+    //! Saves the PCISPH parameters on top of the SPH solver state.
+    void onSaveState(StateArchive* archive) const override;
+
+    //! Loads the state saved by PciSphSolver3::onSaveState.
+    void onLoadState(StateArchive* archive) override;
+
  private:
     double _maxDensityErrorRatio = 0.01;
     unsigned int _maxNumberOfIterations = 5;
+    unsigned int _lastNumberOfIterations = 0;
 
     ParticleSystemData3::VectorData _tempPositions;
     ParticleSystemData3::VectorData _tempVelocities;
     ParticleSystemData3::VectorData _pressureForces;
     ParticleSystemData3::ScalarData _densityErrors;
 
+    // One token per per-particle loop, so that each particle chunk of a loop
+    // stays on the same worker thread across PCI iterations and
+    // sub-timesteps. Loops with other grain sizes split the range into other
+    // chunks and must not share a token.
+    AffinityPartitioner _initializationAffinity;
+    AffinityPartitioner _predictionAffinity;
+    AffinityPartitioner _densityAffinity;
+    AffinityPartitioner _forceAccumulationAffinity;
+
     double computeDelta(double timeStepInSeconds);
     double computeBeta(double timeStepInSeconds);
 };
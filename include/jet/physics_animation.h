@@ -8,9 +8,82 @@
 #define INCLUDE_JET_PHYSICS_ANIMATION_H_
 
 #include <jet/animation.h>
+#include <jet/state_archive.h>
+
+#include <array>
+#include <deque>
+#include <functional>
+#include <vector>
 
 namespace jet {
 
+//!
+//! \brief      Phases of a sub-timestep whose wall time solvers report.
+//!
+//! kPressure is measured inside kAccumulateForces, so the two overlap.
+//!
+enum class SubTimeStepPhase {
+    kUpdateCollider,
+    kUpdateEmitter,
+    kNeighborSearch,
+    kDensity,
+    kAccumulateForces,
+    kPressure,
+    kTimeIntegration,
+    kResolveCollision,
+    kCount
+};
+
+//! Returns a short name of the phase, e.g. "neighbor_search".
+const char* subTimeStepPhaseName(SubTimeStepPhase phase);
+
+//!
+//! \brief      Diagnostics of a single sub-timestep.
+//!
+//! Fields that do not apply to a solver keep their default value, e.g.
+//! numberOfPressureIterations is only set by iterative pressure solvers.
+//!
+struct SubTimeStepMetrics {
+    //! Wall time per phase, indexed by SubTimeStepPhase.
+    typedef std::array<double, static_cast<size_t>(SubTimeStepPhase::kCount)>
+        PhaseTimes;
+
+    //! Index of the frame the sub-timestep belongs to.
+    int frameIndex = 0;
+
+    //! Index of the sub-timestep within the frame.
+    unsigned int subTimeStepIndex = 0;
+
+    //! Simulation time at the beginning of the sub-timestep.
+    double timeInSeconds = 0.0;
+
+    //! Length of the sub-timestep.
+    double timeIntervalInSeconds = 0.0;
+
+    //! Wall time of the whole sub-timestep.
+    double wallTimeInSeconds = 0.0;
+
+    //! Wall time of each phase.
+    PhaseTimes phaseTimesInSeconds{};
+
+    //! Number of particles at the end of the sub-timestep.
+    size_t numberOfParticles = 0;
+
+    //! Number of pressure solver iterations.
+    unsigned int numberOfPressureIterations = 0;
+
+    //! Max density error ratio left after the pressure solve.
+    double maxDensityErrorRatio = 0.0;
+
+    //! Returns the wall time of the given phase in seconds.
+    double phaseTimeInSeconds(SubTimeStepPhase phase) const {
+        return phaseTimesInSeconds[static_cast<size_t>(phase)];
+    }
+};
+
+//! Callback type invoked after every sub-timestep.
+typedef std::function<void(const SubTimeStepMetrics&)> SubTimeStepCallback;
+
 //!
 //! \brief      Abstract base class for physics-based animation.
 //!
@@ -94,7 +167,63 @@ class PhysicsAnimation : public Animation {
     //!
     double currentTimeInSeconds() const;
 
+    //!
+    //! \brief      Returns the number of sub-timesteps taken for the last
+    //!             frame.
+    //!
+    unsigned int lastNumberOfSubTimeSteps() const;
+
+    //!
+    //! \brief      Sets the function called after every sub-timestep.
+    //!
+    //! The callback runs on the simulation thread right after the
+    //! sub-timestep, so it should return quickly. Pass nullptr to remove it.
+    //!
+    void setSubTimeStepCallback(const SubTimeStepCallback& callback);
+
+    //!
+    //! \brief      Returns the metrics of the most recent sub-timesteps,
+    //!             oldest first.
+    //!
+    std::vector<SubTimeStepMetrics> metricsHistory() const;
+
+    //! Returns the max number of sub-timesteps kept in metricsHistory().
+    size_t metricsHistorySize() const;
+
+    //!
+    //! \brief      Sets the max number of sub-timesteps kept in
+    //!             metricsHistory(). Default is 256; zero disables the history.
+    //!
+    void setMetricsHistorySize(size_t size);
+
+    //!
+    //! \brief      Saves the simulation state for checkpointing.
+    //!
+    //! The state covers the current frame and time, the sub-timestep settings,
+    //! and whatever the subclasses add in onSaveState. Loading it into an
+    //! animation that was set up the same way continues the simulation
+    //! bit-identically.
+    //!
+    //! \see CheckpointWriter
+    //!
+    void saveState(StateArchive* archive) const;
+
+    //! Loads the simulation state saved by PhysicsAnimation::saveState.
+    void loadState(StateArchive* archive);
+
  protected:
+    //!
+    //! \brief      Returns the metrics of the sub-timestep in progress.
+    //!
+    //! Subclasses fill in the fields they know about while advancing a
+    //! sub-timestep; the base class sets the time and wall time fields.
+    //!
+    SubTimeStepMetrics& currentSubTimeStepMetrics();
+
+    //! Adds \p seconds to the wall time of \p phase of the current
+    //! sub-timestep.
+    void recordPhaseTime(SubTimeStepPhase phase, double seconds);
+
     //!
     //! \brief      Called when a single time-step should be advanced.
     //!
@@ -132,17 +261,34 @@ class PhysicsAnimation : public Animation {
     //!
     virtual void onInitialize();
 
+    //! Called when PhysicsAnimation::saveState is executed. Inheriting classes
+    //! with simulation state should override this function and call the
+    //! parent's.
+    virtual void onSaveState(StateArchive* archive) const;
+
+    //! Called when PhysicsAnimation::loadState is executed.
+    virtual void onLoadState(StateArchive* archive);
+
  private:
     Frame _currentFrame;
     bool _isUsingFixedSubTimeSteps = true;
     unsigned int _numberOfFixedSubTimeSteps = 1;
     double _currentTime = 0.0;
+    unsigned int _lastNumberOfSubTimeSteps = 0;
+    int _frameIndexInProgress = 0;
+
+    SubTimeStepMetrics _currentSubTimeStepMetrics;
+    SubTimeStepCallback _subTimeStepCallback;
+    std::deque<SubTimeStepMetrics> _metricsHistory;
+    size_t _metricsHistorySize = 256;
 
     void onUpdate(const Frame& frame) final;
 
     void advanceTimeStep(double timeIntervalInSeconds);
 
     void initialize();
+
+    void advanceSubTimeStep(double timeIntervalInSeconds);
 };
 
 typedef std::shared_ptr<PhysicsAnimation> PhysicsAnimationPtr;
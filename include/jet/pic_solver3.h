@@ -11,6 +11,8 @@
 #include <jet/particle_emitter3.h>
 #include <jet/particle_system_data3.h>
 
+#include <vector>
+
 namespace jet {
 
 //!
@@ -74,6 +76,22 @@ class PicSolver3 : public GridFluidSolver3 {
     //! Transfers velocity field from particles to grids.
     virtual void transferFromParticlesToGrids();
 
+    //!
+    //! \brief Calls \p func for every particle, in parallel, such that
+    //!        concurrent calls never scatter to the same grid point.
+    //!
+    //! Particle-to-grid transfers write to the grid points within one cell of
+    //! the particle's cell. The particles are bucketed by blocks of cells and
+    //! the blocks are processed in eight colors by the parity of their block
+    //! coordinates, so the footprints of blocks of the same color, which run
+    //! in parallel, never overlap. Within a block the particles are visited
+    //! in index order, so the result does not depend on the number of
+    //! threads; it differs from a serial loop over the particles only in the
+    //! order of the floating point additions.
+    //!
+    template <typename Callback>
+    void forEachParticleInColoredBlocks(const Callback& func);
+
     //! Transfers velocity field from grids to particles.
     virtual void transferFromGridsToParticles();
 
@@ -83,8 +101,14 @@ class PicSolver3 : public GridFluidSolver3 {
  private:
     size_t _signedDistanceFieldId;
     ParticleSystemData3Ptr _particles;
+    std::vector<size_t> _particleBlocks;
+    std::vector<size_t> _blockPointers;
+    std::vector<size_t> _particlesByBlock;
+    Size3 _numberOfParticleBlocks;
     ParticleEmitter3Ptr _particleEmitter;
 
+    void bucketParticlesByBlock();
+
     void extrapolateVelocityToAir();
 
     void buildSignedDistanceField();
@@ -111,4 +135,6 @@ class PicSolver3::Builder final
 
 }  // namespace jet
 
+#include "detail/pic_solver3-inl.h"
+
 #endif  // INCLUDE_JET_PIC_SOLVER3_H_
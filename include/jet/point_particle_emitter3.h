@@ -86,6 +86,10 @@ class PointParticleEmitter3 final : public ParticleEmitter3 {
         double currentTimeInSeconds,
         double timeIntervalInSeconds) override;
 
+    void onSaveState(StateArchive* archive) const override;
+
+    void onLoadState(StateArchive* archive) override;
+
     void emit(
         Array1<Vector3D>* newPositions,
         Array1<Vector3D>* newVelocities,
@@ -0,0 +1,123 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_PROFILER_H_
+#define INCLUDE_JET_PROFILER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+//! Define JET_PROFILING=0 to compile all profiling macros out.
+#ifndef JET_PROFILING
+#define JET_PROFILING 1
+#endif
+
+namespace jet {
+
+namespace internal {
+
+extern std::atomic<bool> sIsProfilingEnabled;
+
+}  // namespace internal
+
+//!
+//! \brief Collects timed zones and counters and exports them as a trace.
+//!
+//! Zones and counters are recorded per thread while profiling is enabled and
+//! written in the Chrome trace event format, which can be opened in
+//! chrome://tracing or https://ui.perfetto.dev. Zones nest naturally: a zone
+//! opened inside another one on the same thread shows up as its child.
+//!
+//! \code{.cpp}
+//! Profiler::setEnabled(true);
+//! for (Frame frame; frame.index < 100; ++frame) {
+//!     Profiler::beginFrame(frame.index);
+//!     solver->update(frame);
+//!     Profiler::writeChromeTrace("frame_" + std::to_string(frame.index) + ".json");
+//! }
+//! \endcode
+//!
+class Profiler {
+ public:
+    //! Enables or disables recording. Disabled zones cost a single check.
+    static void setEnabled(bool isEnabled);
+
+    //! Returns true if recording is enabled.
+    static bool isEnabled() {
+        return internal::sIsProfilingEnabled.load(std::memory_order_relaxed);
+    }
+
+    //! Marks the beginning of a frame; the index is stored in the trace.
+    static void beginFrame(unsigned int frameIndex);
+
+    //!
+    //! \brief Writes everything recorded since the last write or clear.
+    //!
+    //! The recorded events are discarded afterwards, so calling this at the
+    //! end of every frame produces one trace file per frame. Zones that are
+    //! still open are written with the next trace.
+    //!
+    static void writeChromeTrace(const std::string& filename);
+
+    //! Discards all recorded events.
+    static void clear();
+
+    //! Returns the time since the start of the program in nanoseconds.
+    static int64_t now();
+
+    //! Records a zone on the calling thread. \p name must outlive the
+    //! profiler, e.g. a string literal.
+    static void recordZone(const char* name, int64_t begin, int64_t end);
+
+    //! Records the value of a counter. \p name must outlive the profiler.
+    static void recordCounter(const char* name, double value);
+};
+
+//! Records the lifetime of the object as a profiler zone.
+class ProfileScope {
+ public:
+    explicit ProfileScope(const char* name)
+        : _name(name), _begin(Profiler::isEnabled() ? Profiler::now() : -1) {}
+
+    ~ProfileScope() {
+        if (_begin >= 0) {
+            Profiler::recordZone(_name, _begin, Profiler::now());
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+    const char* _name;
+    int64_t _begin;
+};
+
+}  // namespace jet
+
+#define JET_PROFILE_CONCAT_IMPL(a, b) a##b
+#define JET_PROFILE_CONCAT(a, b) JET_PROFILE_CONCAT_IMPL(a, b)
+
+#if JET_PROFILING
+//! Profiles the enclosing scope under the given name (a string literal).
+#define JET_PROFILE_SCOPE(name) \
+    ::jet::ProfileScope JET_PROFILE_CONCAT(_jetProfileScope, __LINE__)(name)
+
+//! Records the current value of a counter (the name must be a literal).
+#define JET_PROFILE_COUNTER(name, value)                               \
+    do {                                                               \
+        if (::jet::Profiler::isEnabled()) {                            \
+            ::jet::Profiler::recordCounter(name,                       \
+                                           static_cast<double>(value)); \
+        }                                                              \
+    } while (false)
+#else
+#define JET_PROFILE_SCOPE(name) ((void)0)
+#define JET_PROFILE_COUNTER(name, value) ((void)0)
+#endif
+
+#endif  // INCLUDE_JET_PROFILER_H_
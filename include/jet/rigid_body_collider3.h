@@ -42,6 +42,11 @@ class RigidBodyCollider3 final : public Collider3 {
 
     //! Returns builder fox RigidBodyCollider3.
     static Builder builder();
+
+ private:
+    void onSaveState(StateArchive* archive) const override;
+
+    void onLoadState(StateArchive* archive) override;
 };
 
 //! Shared pointer for the RigidBodyCollider3 type.
@@ -90,7 +90,14 @@ class ScalarGrid3 : public ScalarField3, public Grid3 {
     //! Returns the grid data at given data point.
     const double& operator()(size_t i, size_t j, size_t k) const;
 
-    //! Returns the grid data at given data point.
+    //!
+    //! \brief Returns the grid data at given data point.
+    //!
+    //! A deserialized view is copied to owned storage on the first call.
+    //! The copy is not thread-safe, so parallel writes should go through the
+    //! non-const for-each functions or dataAccessor(), which copy the view
+    //! before the loop starts.
+    //!
     double& operator()(size_t i, size_t j, size_t k);
 
     //! Returns the gradient vector at given data point.
@@ -138,6 +145,27 @@ class ScalarGrid3 : public ScalarField3, public Grid3 {
     void parallelForEachDataPointIndex(
         const std::function<void(size_t, size_t, size_t)>& func) const;
 
+    //!
+    //! \brief Invokes the given function \p func for each data point.
+    //!
+    //! Same as the const version, except that the data of a deserialized
+    //! view is copied to owned storage before the loop, so \p func can write
+    //! to the grid through operator().
+    //!
+    void forEachDataPointIndex(
+        const std::function<void(size_t, size_t, size_t)>& func);
+
+    //!
+    //! \brief Invokes the given function \p func for each data point
+    //! parallelly.
+    //!
+    //! Same as the const version, except that the data of a deserialized
+    //! view is copied to owned storage before the loop, so \p func can write
+    //! to the grid through operator().
+    //!
+    void parallelForEachDataPointIndex(
+        const std::function<void(size_t, size_t, size_t)>& func);
+
     // ScalarField3 implementations
 
     //!
@@ -168,6 +196,21 @@ class ScalarGrid3 : public ScalarField3, public Grid3 {
     //! Deserializes the input buffer to the grid instance.
     void deserialize(const std::vector<uint8_t>& buffer) override;
 
+    //!
+    //! \brief      Deserializes the input buffer without copying the grid
+    //!             data.
+    //!
+    //! The grid data keeps pointing into \p buffer, which must not change,
+    //! until the non-const operator(), dataAccessor(), a non-const for-each
+    //! function, fill, or resize is called. At that point the data is copied
+    //! to owned storage and the buffer is released. The buffer can alias a
+    //! memory mapping through the shared_ptr aliasing constructor.
+    //!
+    void deserializeView(const std::shared_ptr<const uint8_t>& buffer);
+
+    //! Returns true if the grid data still points into a deserialized view.
+    bool isView() const;
+
  protected:
     //! Swaps the data storage and predefined samplers with given grid.
     void swapScalarGrid(ScalarGrid3* other);
@@ -186,7 +229,16 @@ class ScalarGrid3 : public ScalarField3, public Grid3 {
     LinearArraySampler3<double, double> _linearSampler;
     std::function<double(const Vector3D&)> _sampler;
 
+    // Read-only data borrowed from _viewBuffer by deserializeView until
+    // promoteData copies it to _data.
+    ConstArrayAccessor3<double> _view;
+    std::shared_ptr<const uint8_t> _viewBuffer;
+
     void resetSampler();
+
+    ConstArrayAccessor3<double> dataView() const;
+
+    void promoteData();
 };
 
 //! Shared pointer for the ScalarGrid3 type.
@@ -154,6 +154,12 @@ class SphSolver3 : public ParticleSystemSolver3 {
   //! Computes pseudo viscosity.
   void computePseudoViscosity(double timeStepInSeconds);
 
+  //! Saves the SPH parameters on top of the particle solver state.
+  void onSaveState(StateArchive* archive) const override;
+
+  //! Loads the state saved by SphSolver3::onSaveState.
+  void onLoadState(StateArchive* archive) override;
+
  private:
   //! Exponent component of equation-of-state (or Tait's equation).
   double _eosExponent = 7.0;
@@ -163,6 +163,14 @@ class SphSystemData3 : public ParticleSystemData3 {
     //! Deserializes this SPH system data from the buffer.
     void deserialize(const std::vector<uint8_t>& buffer) override;
 
+    //!
+    //! \brief      Deserializes this SPH system data from the buffer without
+    //!             copying the data layers.
+    //!
+    //! \see ParticleSystemData3::deserializeView
+    //!
+    void deserializeView(const std::shared_ptr<const uint8_t>& buffer) override;
+
     //! Copies from other SPH system data.
     void set(const SphSystemData3& other);
 
@@ -189,6 +197,12 @@ class SphSystemData3 : public ParticleSystemData3 {
 
     //! Computes the mass based on the target density and spacing.
     void computeMass();
+
+    //! Deserializes from the buffer, borrowing the data layers from
+    //! \p viewBuffer if it is not null.
+    void deserializeSphSystemData(
+        const uint8_t* buffer,
+        const std::shared_ptr<const uint8_t>& viewBuffer);
 };
 
 //! Shared pointer for the SphSystemData3 type.
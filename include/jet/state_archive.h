@@ -0,0 +1,146 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#ifndef INCLUDE_JET_STATE_ARCHIVE_H_
+#define INCLUDE_JET_STATE_ARCHIVE_H_
+
+#include <jet/array1.h>
+#include <jet/array_accessor1.h>
+#include <jet/vector3.h>
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace jet {
+
+//!
+//! \brief      Binary archive for the run-time state of simulation objects.
+//!
+//! Unlike Serializable, which describes an object completely, an archive only
+//! captures the state that changes while a simulation runs, such as particle
+//! layers, emitter random number generators, and the current frame. It is
+//! meant for checkpoint/restart: the state is loaded back into objects that
+//! were set up the same way as the ones that were saved, and values are read
+//! in the order they were written. Everything is stored bit-exact in the byte
+//! order of the writing machine.
+//!
+//! Reading past the end marks the archive as invalid instead of throwing, so
+//! a loader can read everything and check isValid() once.
+//!
+class StateArchive {
+ public:
+    //! Constructs an empty archive for writing.
+    StateArchive();
+
+    //! Constructs an archive that reads from \p buffer.
+    explicit StateArchive(std::vector<uint8_t> buffer);
+
+    //! Clears the archive and rewinds it.
+    void clear();
+
+    //! Returns the archived bytes.
+    const std::vector<uint8_t>& buffer() const;
+
+    //! Replaces the archived bytes and rewinds the archive for reading.
+    void setBuffer(std::vector<uint8_t> buffer);
+
+    //! Returns the number of archived bytes.
+    size_t size() const;
+
+    //! Returns false if a read went past the end or a value did not match.
+    bool isValid() const;
+
+    //! Marks the archive as invalid, e.g. when a loaded value is out of range.
+    void invalidate();
+
+    //! Returns true if everything has been read.
+    bool isAtEnd() const;
+
+    //! Appends \p size raw bytes.
+    void write(const void* data, size_t size);
+
+    //! Reads \p size raw bytes, or zeros if the archive is too short.
+    void read(void* data, size_t size);
+
+    //! Appends an arithmetic or enum value.
+    template <typename T>
+    void write(const T& value);
+
+    //! Reads an arithmetic or enum value.
+    template <typename T>
+    void read(T* value);
+
+    //! Appends a vector.
+    void write(const Vector3D& value);
+
+    //! Reads a vector.
+    void read(Vector3D* value);
+
+    //! Appends a string.
+    void write(const std::string& value);
+
+    //! Reads a string.
+    void read(std::string* value);
+
+    //! Appends the state of a random number generator.
+    void write(const std::mt19937& rng);
+
+    //! Reads the state of a random number generator.
+    void read(std::mt19937* rng);
+
+    //! Appends the size and contents of an array with a single memcpy.
+    template <typename T>
+    void writeArray(const ConstArrayAccessor1<T>& array);
+
+    //! Reads an array written by writeArray, resizing \p array to fit.
+    template <typename T>
+    void readArray(Array1<T>* array);
+
+ private:
+    std::vector<uint8_t> _buffer;
+    size_t _readPosition = 0;
+    bool _isValid = true;
+};
+
+template <typename T>
+void StateArchive::write(const T& value) {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                  "Only arithmetic and enum values can be archived directly");
+    write(&value, sizeof(T));
+}
+
+template <typename T>
+void StateArchive::read(T* value) {
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+                  "Only arithmetic and enum values can be archived directly");
+    read(value, sizeof(T));
+}
+
+template <typename T>
+void StateArchive::writeArray(const ConstArrayAccessor1<T>& array) {
+    write(static_cast<uint64_t>(array.size()));
+    write(array.data(), array.size() * sizeof(T));
+}
+
+template <typename T>
+void StateArchive::readArray(Array1<T>* array) {
+    uint64_t size = 0;
+    read(&size);
+    if (!isValid() || size > (_buffer.size() - _readPosition) / sizeof(T)) {
+        invalidate();
+        return;
+    }
+
+    array->resize(static_cast<size_t>(size));
+    read(array->data(), array->size() * sizeof(T));
+}
+
+}  // namespace jet
+
+#endif  // INCLUDE_JET_STATE_ARCHIVE_H_
@@ -184,6 +184,19 @@ class TriangleMesh3 final : public Surface3 {
     //! Writes the mesh in obj format to the file.
     bool writeObj(const std::string& filename) const;
 
+    //!
+    //! \brief      Writes the mesh in binary ply format to the output stream.
+    //!
+    //! Points are written as float vertices in the byte order of the machine.
+    //! Normals and uvs are added as vertex properties if every triangle uses
+    //! the same indices for them as for the points, as in meshes from
+    //! marchingCubes; otherwise they are omitted.
+    //!
+    void writePly(std::ostream* strm) const;
+
+    //! Writes the mesh in binary ply format to the file.
+    bool writePly(const std::string& filename) const;
+
     //! Reads the mesh in obj format from the input stream.
     bool readObj(std::istream* strm);
 
@@ -175,6 +175,10 @@ class VolumeParticleEmitter3 final : public ParticleEmitter3 {
         double currentTimeInSeconds,
         double timeIntervalInSeconds) override;
 
+    void onSaveState(StateArchive* archive) const override;
+
+    void onLoadState(StateArchive* archive) override;
+
     void emit(
         const ParticleSystemData3Ptr& particles,
         Array1<Vector3D>* newPositions,
@@ -3,6 +3,7 @@
 #include "point_renderer.h"
 #include "triangle_renderer.h"
 #include "skybox_renderer.h"
+#include "frame_graph.h"
 
 #include "mfd.hpp"
 #include "camera.hpp"
@@ -10,6 +11,7 @@
 PointRenderer* pointRenderer;
 TriangleRenderer* triangleRenderer;
 SkyboxRenderer* skyboxRenderer;
+FrameGraph* frameGraph;
 
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
 std::ofstream logFile;
@@ -26,12 +28,46 @@ std::string method = "zhu_bridson";
 double kernelRadius = 0.07;
 Vector3D gridSpacing(0.04, 0.04, 0.04);
 
+// 后处理流水线参数
+// 模拟最多领先重建的帧数
+size_t maxFramesInFlight = 2;
+// 非空时把每帧网格导出到该目录，由后台线程落盘
+std::string meshExportDirectory = "";
+// 导出格式，"ply" 为二进制 ply，否则为 obj
+std::string meshExportFormat = "ply";
+// 等待落盘的网格最多占用的内存，超出时阻塞导出阶段，从而限制模拟速度
+size_t maxPendingExportBytes = MeshExportQueue3::kDefaultMaxPendingBytes;
+// 非空时开启性能分析，每帧写出一个 Chrome trace 文件
+std::string traceDirectory = "";
+// 非空时把每帧粒子写入缓存文件，由后台线程落盘
+std::string particleCacheFilename = "";
+// 非空时不做模拟，直接从缓存文件回放粒子并重建网格
+std::string playbackCacheFilename = "";
+
+ParticleCacheWriter3 particleCacheWriter;
+ParticleCacheReader3 particleCacheReader;
+MeshExportQueue3* meshExportQueue = nullptr;
+
+// 最近一帧重建完成的网格
+std::vector<glm::vec3> meshPoints, meshNormals;
+std::vector<glm::ivec3> meshPointIndices, meshNormalIndices;
+
 unsigned int loadCubemap(std::vector<std::string> faces);
 
 Controller::Controller(GLuint width, GLuint height)
     : State(CONTROLLER_ACTIVE), Keys(), Width(width), Height(height) {}
 
 Controller::~Controller() {
+  delete frameGraph;
+  // 写出队列中剩余的网格
+  if (meshExportQueue != nullptr && !meshExportQueue->flush()) {
+    JET_ERROR << "Some meshes could not be exported";
+  }
+  delete meshExportQueue;
+  // 写出缓存中剩余的帧和帧索引
+  particleCacheWriter.close();
+  // 写出剩余日志并停止后台线程
+  Logging::setAsync(false);
   delete pointRenderer;
   delete triangleRenderer;
   delete skyboxRenderer;
@@ -85,14 +121,76 @@ void Controller::Init() {
   if (logFile) {
     Logging::setAllStream(&logFile);
   }
-  init(solver, targetSpacing, numberOfFrames, fps);
+  // 日志由后台线程批量写入，避免每条日志都加锁并刷新文件
+  Logging::setAsync(true);
+  Profiler::setEnabled(!traceDirectory.empty());
+  if (!playbackCacheFilename.empty() && particleCacheReader.open(playbackCacheFilename)) {
+    numberOfFrames = static_cast<int>(particleCacheReader.numberOfFrames());
+  } else {
+    init(solver, targetSpacing, numberOfFrames, fps);
+    if (!particleCacheFilename.empty()) {
+      particleCacheWriter.open(particleCacheFilename);
+    }
+  }
+
+  // 重建、导出和统计在副线程上进行，与下一帧的模拟重叠
+  frameGraph = new FrameGraph(maxFramesInFlight);
+  size_t reconstruction = frameGraph->AddStage("reconstruction", [](FrameData& data) {
+    particlesToTriangles(data.positions.accessor(), gridSpacing, kernelRadius, method, data.mesh);
+  });
+  if (!meshExportDirectory.empty()) {
+    meshExportQueue = new MeshExportQueue3(maxPendingExportBytes);
+    frameGraph->AddStage(
+        "export",
+        [](FrameData& data) {
+          char basename[256];
+          snprintf(basename, sizeof(basename), "frame_%06u.%s", data.index,
+                   meshExportFormat == "ply" ? "ply" : "obj");
+          // 网格还要用于渲染，拷贝一份交给导出线程
+          // push 返回 false 表示之前排队的网格写入失败，出错的文件名已由导出线程记录
+          if (!meshExportQueue->push(std::make_shared<const TriangleMesh3>(data.mesh),
+                                     meshExportDirectory + "/" + basename)) {
+            JET_ERROR << "Frame " << data.index << ": an earlier mesh export failed";
+          }
+        },
+        {reconstruction});
+  }
+  frameGraph->AddStage(
+      "stats",
+      [reconstruction](FrameData& data) {
+        JET_INFO << "Frame " << data.index << ": " << data.positions.size() << " particles, "
+                 << data.mesh.numberOfTriangles() << " triangles, reconstruction took "
+                 << data.stageSeconds[reconstruction] << " seconds";
+      },
+      {reconstruction});
 }
 
 void Controller::Update(GLfloat dt) {
   if (frame.index == numberOfFrames) {
     return;
   }
-  solver->update(frame);
+  Profiler::beginFrame(frame.index);
+  {
+    JET_PROFILE_SCOPE("Frame");
+    if (particleCacheReader.isOpen()) {
+      // 回放时直接读取映射的缓存，不拷贝粒子数据
+      particleCacheReader.prefetch(frame.index + 1);
+      frameGraph->Submit(frame.index, particleCacheReader.frame(frame.index).positions());
+    } else {
+      solver->update(frame);
+      if (particleCacheWriter.isOpen()) {
+        particleCacheWriter.writeFrame(frame.index, frame.timeInSeconds(),
+                                       *solver->particleSystemData());
+      }
+      frameGraph->Submit(frame.index,
+                         ConstArrayAccessor1<Vector3D>(solver->particleSystemData()->positions()));
+    }
+  }
+  if (Profiler::isEnabled()) {
+    char basename[256];
+    snprintf(basename, sizeof(basename), "frame_%06u.json", frame.index);
+    Profiler::writeChromeTrace(traceDirectory + "/" + basename);
+  }
   frame++;
 }
 
@@ -150,36 +248,34 @@ void Controller::ProcessInput(GLfloat dt) {
 }
 
 void Controller::Render() {
-  auto tmp = solver->particleSystemData();
-  std::vector<glm::vec3> particles;
-  // tmp->positions().forEach([&](const auto& p) { particles.push_back({p.x, p.y, p.z}); });
-  // pointRenderer->draw(particles, 3.0, {0.0, 1.0, 0.0});
-
-  TriangleMesh3 mesh;
-  particlesToTriangles(tmp->positions(), gridSpacing, kernelRadius, method, mesh);
-  particles.clear();
-  for (int i = 0; i < mesh.numberOfPoints(); i++) {
-    auto _point = mesh.point(i);
-    particles.push_back({_point.x, _point.y, _point.z});
-  }
+  // 有新的帧重建完成时才更新网格，否则继续绘制上一帧
+  auto completed = frameGraph->PopLatestCompleted();
+  if (completed) {
+    const TriangleMesh3& mesh = completed->mesh;
+
+    meshPoints.clear();
+    for (size_t i = 0; i < mesh.numberOfPoints(); i++) {
+      auto _point = mesh.point(i);
+      meshPoints.push_back({_point.x, _point.y, _point.z});
+    }
 
-  std::vector<glm::vec3> normal;
-  for (int i = 0; i < mesh.numberOfNormals(); i++) {
-    auto _normal = mesh.normal(i);
-    normal.push_back({_normal.x, _normal.y, _normal.z});
-  }
+    meshNormals.clear();
+    for (size_t i = 0; i < mesh.numberOfNormals(); i++) {
+      auto _normal = mesh.normal(i);
+      meshNormals.push_back({_normal.x, _normal.y, _normal.z});
+    }
 
-  std::vector<glm::ivec3> positionIndex, normalIndex;
-  for (int i = 0; i < mesh.numberOfTriangles(); i++) {
-    auto _positionIndex = mesh.pointIndex(i);
-    auto _normalIndex = mesh.normalIndex(i);
-    positionIndex.push_back({_positionIndex.x, _positionIndex.y, _positionIndex.z});
-    normalIndex.push_back({_normalIndex.x, _normalIndex.y, _normalIndex.z});
+    meshPointIndices.clear();
+    meshNormalIndices.clear();
+    for (size_t i = 0; i < mesh.numberOfTriangles(); i++) {
+      auto _positionIndex = mesh.pointIndex(i);
+      auto _normalIndex = mesh.normalIndex(i);
+      meshPointIndices.push_back({_positionIndex.x, _positionIndex.y, _positionIndex.z});
+      meshNormalIndices.push_back({_normalIndex.x, _normalIndex.y, _normalIndex.z});
+    }
   }
 
-  // printf("tris: %d\n", mesh.numberOfTriangles());
-
-  triangleRenderer->draw(particles, positionIndex, normal, normalIndex);
+  triangleRenderer->draw(meshPoints, meshPointIndices, meshNormals, meshNormalIndices);
 
   skyboxRenderer->draw();
 }
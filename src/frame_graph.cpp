@@ -0,0 +1,106 @@
+#include "frame_graph.h"
+
+#include <jet/logging.h>
+#include <jet/parallel.h>
+#include <jet/profiler.h>
+#include <jet/timer.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace jet;
+
+FrameGraph::FrameGraph(size_t maxFramesInFlight)
+    : maxFramesInFlight(std::max(maxFramesInFlight, static_cast<size_t>(1))) {}
+
+FrameGraph::~FrameGraph() { Flush(); }
+
+size_t FrameGraph::AddStage(const std::string &name, StageFunction function,
+                            const std::vector<size_t> &dependsOn) {
+  for (size_t dependency : dependsOn) {
+    if (dependency >= stages.size()) {
+      throw std::invalid_argument("Stage " + name + " depends on an unknown stage");
+    }
+  }
+
+  stages.push_back({name, std::move(function), dependsOn});
+  lastStageTasks.emplace_back();
+  return stages.size() - 1;
+}
+
+void FrameGraph::Submit(unsigned int frameIndex, const ConstArrayAccessor1<Vector3D> &positions) {
+  // Back-pressure: keep the simulation at most maxFramesInFlight frames ahead
+  while (framesInFlight.size() >= maxFramesInFlight) {
+    retireOldestFrame();
+  }
+
+  auto data = std::make_shared<FrameData>();
+  data->index = frameIndex;
+  data->stageSeconds.assign(stages.size(), 0.0);
+  data->stageErrors.assign(stages.size(), nullptr);
+  data->positions.resize(positions.size());
+  auto snapshot = data->positions.accessor();
+  parallelFor(kZeroSize, positions.size(), [&](size_t i) { snapshot[i] = positions[i]; });
+
+  std::vector<TaskHandle<void>> frameTasks(stages.size());
+  for (size_t stageId = 0; stageId < stages.size(); ++stageId) {
+    const Stage &stage = stages[stageId];
+
+    std::vector<TaskHandle<void>> dependencies;
+    dependencies.push_back(lastStageTasks[stageId]);
+    for (size_t dependency : stage.dependsOn) {
+      dependencies.push_back(frameTasks[dependency]);
+    }
+
+    StageFunction function = stage.function;
+    std::string name = stage.name;
+    frameTasks[stageId] = jet::async(
+        [data, function, name, stageId]() {
+          JET_PROFILE_SCOPE("FrameGraph stage");
+          Timer timer;
+          // A failing stage must not cancel the rest of the pipeline
+          try {
+            function(*data);
+          } catch (const std::exception &e) {
+            JET_ERROR << "Frame " << data->index << ": stage " << name << " failed: " << e.what();
+            data->stageErrors[stageId] = std::current_exception();
+          } catch (...) {
+            JET_ERROR << "Frame " << data->index << ": stage " << name
+                      << " failed with an unknown exception";
+            data->stageErrors[stageId] = std::current_exception();
+          }
+          data->stageSeconds[stageId] = timer.durationInSeconds();
+        },
+        dependencies);
+    lastStageTasks[stageId] = frameTasks[stageId];
+  }
+
+  framesInFlight.push_back({data, jet::async([]() {}, frameTasks)});
+}
+
+std::shared_ptr<const FrameData> FrameGraph::PopLatestCompleted() {
+  while (!framesInFlight.empty() && framesInFlight.front().completion.isReady()) {
+    retireOldestFrame();
+  }
+
+  std::shared_ptr<const FrameData> result;
+  result.swap(latestCompleted);
+  return result;
+}
+
+void FrameGraph::Flush() {
+  while (!framesInFlight.empty()) {
+    retireOldestFrame();
+  }
+}
+
+size_t FrameGraph::NumberOfStages() const { return stages.size(); }
+
+const std::string &FrameGraph::StageName(size_t stageId) const { return stages[stageId].name; }
+
+void FrameGraph::retireOldestFrame() {
+  FrameInFlight &oldest = framesInFlight.front();
+  oldest.completion.wait();
+  latestCompleted = oldest.data;
+  framesInFlight.pop_front();
+}
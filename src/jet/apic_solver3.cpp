@@ -69,7 +69,7 @@ void ApicSolver3::transferFromParticlesToGrids() {
         flow->gridSpacing(),
         flow->wOrigin());
 
-    for (size_t i = 0; i < numberOfParticles; ++i) {
+    forEachParticleInColoredBlocks([&](size_t i) {
         std::array<Point3UI, 8> indices;
         std::array<double, 8> weights;
 
@@ -126,7 +126,7 @@ void ApicSolver3::transferFromParticlesToGrids() {
             wWeight(indices[j]) += weights[j];
             _wMarkers(indices[j]) = 1;
         }
-    }
+    });
 
     uWeight.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
         if (uWeight(i, j, k) > 0.0) {
@@ -0,0 +1,122 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#include <pch.h>
+
+#include <jet/async.h>
+#include <jet/parallel.h>
+
+using namespace jet;
+using namespace jet::internal;
+
+TaskStateBase::TaskStateBase(size_t numberOfDependencies)
+    : _status(kWaiting), _numberOfPendingDependencies(numberOfDependencies) {}
+
+TaskStateBase::~TaskStateBase() {}
+
+void TaskStateBase::tryRun() {
+  int expected = kPending;
+  if (!_status.compare_exchange_strong(expected, kRunning)) {
+    // Already claimed by another thread, or canceled.
+    return;
+  }
+
+  try {
+    invoke();
+  } catch (...) {
+    _exception = std::current_exception();
+    finish(kFailed);
+    return;
+  }
+
+  finish(kDone);
+}
+
+bool TaskStateBase::cancel() {
+  int status = _status.load();
+  while (status == kWaiting || status == kPending) {
+    if (_status.compare_exchange_weak(status, kRunning)) {
+      finish(kCanceled);
+      return true;
+    }
+  }
+
+  return status == kCanceled;
+}
+
+void TaskStateBase::wait() {
+  // Help out instead of blocking if no worker has picked the task up yet.
+  tryRun();
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  _finished.wait(lock, [this]() { return isReady(); });
+}
+
+bool TaskStateBase::isReady() const {
+  int status = _status.load();
+  return status == kDone || status == kFailed || status == kCanceled;
+}
+
+bool TaskStateBase::isCanceled() const { return _status.load() == kCanceled; }
+
+void TaskStateBase::rethrowIfNotSucceeded() const {
+  int status = _status.load();
+  if (status == kFailed) {
+    std::rethrow_exception(_exception);
+  } else if (status == kCanceled) {
+    throw TaskCanceledError();
+  }
+}
+
+void TaskStateBase::addContinuation(const std::function<void(bool)>& continuation) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!isReady()) {
+      _continuations.push_back(continuation);
+      return;
+    }
+  }
+
+  continuation(_status.load() == kDone);
+}
+
+void TaskStateBase::onDependencyFinished(bool succeeded) {
+  if (!succeeded) {
+    _hasFailedDependency = true;
+  }
+
+  if (_numberOfPendingDependencies.fetch_sub(1) == 1) {
+    if (_hasFailedDependency) {
+      cancel();
+    } else {
+      schedule();
+    }
+  }
+}
+
+void TaskStateBase::schedule() {
+  int expected = kWaiting;
+  if (!_status.compare_exchange_strong(expected, kPending)) {
+    return;
+  }
+
+  auto self = shared_from_this();
+  internal::schedule([self]() { self->tryRun(); });
+}
+
+void TaskStateBase::finish(int status) {
+  std::vector<std::function<void(bool)>> continuations;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _status = status;
+    continuations.swap(_continuations);
+  }
+  _finished.notify_all();
+
+  for (const auto& continuation : continuations) {
+    continuation(status == kDone);
+  }
+}
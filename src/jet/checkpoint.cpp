@@ -0,0 +1,381 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#include <pch.h>
+
+#include <jet/checkpoint.h>
+#include <jet/logging.h>
+#include <jet/profiler.h>
+#include <jet/timer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+using namespace jet;
+using namespace jet::checkpoint;
+
+namespace {
+
+const char kFileMagic[8] = {'J', 'E', 'T', 'C', 'K', 'P', 'T', '1'};
+
+// Control bytes below this value start a literal run of (control + 1) bytes;
+// kZeroRun is followed by the LEB128 length of a run of zero bytes.
+const uint8_t kMaxLiteralControl = 0x7f;
+const uint8_t kZeroRun = 0x80;
+
+// Shortest zero run that is cheaper as a run than as literals
+const size_t kMinZeroRun = 3;
+
+uint64_t fnv1a(const std::vector<uint8_t>& data) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (uint8_t byte : data) {
+    hash = (hash ^ byte) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+void writeVarint(uint64_t value, std::vector<uint8_t>* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+bool readVarint(const uint8_t** pos, const uint8_t* end, uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64 && *pos < end; shift += 7) {
+    const uint8_t byte = *(*pos)++;
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void appendRunLength(const uint8_t* data, size_t size, std::vector<uint8_t>* out) {
+  size_t literalBegin = 0;
+  size_t i = 0;
+
+  auto flushLiterals = [&](size_t literalEnd) {
+    while (literalBegin < literalEnd) {
+      const size_t count = std::min<size_t>(literalEnd - literalBegin, kMaxLiteralControl + 1);
+      out->push_back(static_cast<uint8_t>(count - 1));
+      out->insert(out->end(), data + literalBegin, data + literalBegin + count);
+      literalBegin += count;
+    }
+  };
+
+  while (i < size) {
+    if (data[i] != 0) {
+      ++i;
+      continue;
+    }
+
+    size_t runEnd = i;
+    while (runEnd < size && data[runEnd] == 0) {
+      ++runEnd;
+    }
+
+    if (runEnd - i >= kMinZeroRun) {
+      flushLiterals(i);
+      out->push_back(kZeroRun);
+      writeVarint(runEnd - i, out);
+      literalBegin = runEnd;
+    }
+    i = runEnd;
+  }
+  flushLiterals(size);
+}
+
+// XOR-delta, byte-plane shuffle, and zero run-length encoding
+void encode(const std::vector<uint8_t>& state, std::vector<uint8_t>* encoded) {
+  JET_PROFILE_SCOPE("encodeCheckpoint");
+
+  const size_t numberOfWords = state.size() / 8;
+  std::vector<uint8_t> planes(numberOfWords * 8);
+
+  uint64_t previous = 0;
+  for (size_t i = 0; i < numberOfWords; ++i) {
+    uint64_t word;
+    std::memcpy(&word, state.data() + 8 * i, sizeof(word));
+    const uint64_t delta = word ^ previous;
+    previous = word;
+    for (size_t b = 0; b < 8; ++b) {
+      planes[b * numberOfWords + i] = static_cast<uint8_t>(delta >> (8 * b));
+    }
+  }
+
+  encoded->clear();
+  appendRunLength(planes.data(), planes.size(), encoded);
+  encoded->insert(encoded->end(), state.begin() + numberOfWords * 8, state.end());
+}
+
+// Returns the number of bytes from the current position to the end of the
+// file, or a negative value if the file cannot be seeked.
+int64_t remainingFileSize(FILE* file) {
+#ifdef JET_WINDOWS
+  const int64_t position = _ftelli64(file);
+  if (position < 0 || _fseeki64(file, 0, SEEK_END) != 0) {
+    return -1;
+  }
+  const int64_t end = _ftelli64(file);
+  if (_fseeki64(file, position, SEEK_SET) != 0) {
+    return -1;
+  }
+#else
+  const int64_t position = ftello(file);
+  if (position < 0 || fseeko(file, 0, SEEK_END) != 0) {
+    return -1;
+  }
+  const int64_t end = ftello(file);
+  if (fseeko(file, static_cast<off_t>(position), SEEK_SET) != 0) {
+    return -1;
+  }
+#endif
+  return end - position;
+}
+
+bool decode(const std::vector<uint8_t>& encoded, size_t stateSize, std::vector<uint8_t>* state) {
+  const size_t numberOfWords = stateSize / 8;
+  const size_t tailSize = stateSize - numberOfWords * 8;
+  if (encoded.size() < tailSize) {
+    return false;
+  }
+
+  std::vector<uint8_t> planes(numberOfWords * 8);
+  const uint8_t* pos = encoded.data();
+  const uint8_t* end = encoded.data() + encoded.size() - tailSize;
+  size_t filled = 0;
+  while (pos < end) {
+    const uint8_t control = *pos++;
+    if (control <= kMaxLiteralControl) {
+      const size_t count = control + 1u;
+      if (count > static_cast<size_t>(end - pos) || count > planes.size() - filled) {
+        return false;
+      }
+      std::memcpy(planes.data() + filled, pos, count);
+      pos += count;
+      filled += count;
+    } else if (control == kZeroRun) {
+      uint64_t count = 0;
+      if (!readVarint(&pos, end, &count) || count > planes.size() - filled) {
+        return false;
+      }
+      filled += static_cast<size_t>(count);  // Already zero
+    } else {
+      return false;
+    }
+  }
+  if (filled != planes.size()) {
+    return false;
+  }
+
+  state->resize(stateSize);
+  uint64_t previous = 0;
+  for (size_t i = 0; i < numberOfWords; ++i) {
+    uint64_t delta = 0;
+    for (size_t b = 0; b < 8; ++b) {
+      delta |= static_cast<uint64_t>(planes[b * numberOfWords + i]) << (8 * b);
+    }
+    previous ^= delta;
+    std::memcpy(state->data() + 8 * i, &previous, sizeof(previous));
+  }
+  std::memcpy(state->data() + numberOfWords * 8, end, tailSize);
+  return true;
+}
+
+// Writes the file under a temporary name and renames it when complete
+bool writeFile(const std::string& filename, const std::vector<uint8_t>& state, bool isCompressed,
+               std::vector<uint8_t>* encoded, double* compressionRatio) {
+  FileHeader header;
+  std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+  header.version = kVersion;
+  header.encoding = isCompressed ? kShuffledRle : kRaw;
+  header.stateSize = state.size();
+  header.checksum = fnv1a(state);
+
+  const std::vector<uint8_t>* payload = &state;
+  if (isCompressed) {
+    encode(state, encoded);
+    payload = encoded;
+  }
+  header.payloadSize = payload->size();
+
+  JET_PROFILE_SCOPE("writeCheckpoint");
+  const std::string tempFilename = filename + ".tmp";
+  FILE* file = std::fopen(tempFilename.c_str(), "wb");
+  if (file == nullptr) {
+    JET_ERROR << "Cannot create checkpoint " << tempFilename;
+    return false;
+  }
+
+  bool isWritten = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(payload->data(), 1, payload->size(), file) == payload->size();
+  isWritten = (std::fclose(file) == 0) && isWritten;
+
+#ifdef JET_WINDOWS
+  // rename() does not replace existing files on Windows
+  if (isWritten) {
+    std::remove(filename.c_str());
+  }
+#endif
+  if (!isWritten || std::rename(tempFilename.c_str(), filename.c_str()) != 0) {
+    JET_ERROR << "Cannot write checkpoint " << filename;
+    std::remove(tempFilename.c_str());
+    return false;
+  }
+
+  *compressionRatio = state.empty() ? 1.0
+                                    : static_cast<double>(sizeof(header) + payload->size()) /
+                                          static_cast<double>(state.size());
+  return true;
+}
+
+}  // namespace
+
+CheckpointWriter::CheckpointWriter() { _worker = std::thread(&CheckpointWriter::run, this); }
+
+CheckpointWriter::~CheckpointWriter() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _isStopping = true;
+  }
+  _condition.notify_all();
+  _worker.join();
+}
+
+bool CheckpointWriter::isCompressionEnabled() const { return _isCompressionEnabled; }
+
+void CheckpointWriter::setIsCompressionEnabled(bool isEnabled) { _isCompressionEnabled = isEnabled; }
+
+bool CheckpointWriter::save(const PhysicsAnimation& animation, const std::string& filename) {
+  JET_PROFILE_SCOPE("CheckpointWriter::save");
+
+  // Snapshot on the calling thread while the previous checkpoint may still be
+  // written from the other buffer
+  Timer timer;
+  _snapshot.clear();
+  animation.saveState(&_snapshot);
+  _lastSnapshotTimeInSeconds = timer.durationInSeconds();
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  _condition.wait(lock, [this] { return !_hasPending; });
+
+  const bool hasFailed = _hasFailed;
+  _hasFailed = false;
+
+  std::swap(_snapshot, _pending);
+  _pendingFilename = filename;
+  _isPendingCompressed = _isCompressionEnabled;
+  _hasPending = true;
+  lock.unlock();
+  _condition.notify_all();
+
+  return !hasFailed;
+}
+
+bool CheckpointWriter::flush() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _condition.wait(lock, [this] { return !_hasPending; });
+
+  const bool hasFailed = _hasFailed;
+  _hasFailed = false;
+  return !hasFailed;
+}
+
+double CheckpointWriter::lastSnapshotTimeInSeconds() const { return _lastSnapshotTimeInSeconds; }
+
+double CheckpointWriter::lastCompressionRatio() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _lastCompressionRatio;
+}
+
+void CheckpointWriter::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _condition.wait(lock, [this] { return _hasPending || _isStopping; });
+    if (!_hasPending) {
+      return;
+    }
+
+    // The worker owns _pending until _hasPending is cleared
+    lock.unlock();
+    double compressionRatio = 1.0;
+    const bool isWritten = writeFile(_pendingFilename, _pending.buffer(), _isPendingCompressed,
+                                     &_encoded, &compressionRatio);
+    lock.lock();
+
+    _hasFailed = _hasFailed || !isWritten;
+    if (isWritten) {
+      _lastCompressionRatio = compressionRatio;
+    }
+    _hasPending = false;
+    _condition.notify_all();
+  }
+}
+
+bool jet::saveCheckpoint(const PhysicsAnimation& animation, const std::string& filename,
+                         bool isCompressed) {
+  StateArchive archive;
+  animation.saveState(&archive);
+
+  std::vector<uint8_t> encoded;
+  double compressionRatio = 1.0;
+  return writeFile(filename, archive.buffer(), isCompressed, &encoded, &compressionRatio);
+}
+
+bool jet::loadCheckpoint(const std::string& filename, PhysicsAnimation* animation) {
+  JET_PROFILE_SCOPE("loadCheckpoint");
+
+  FILE* file = std::fopen(filename.c_str(), "rb");
+  if (file == nullptr) {
+    JET_ERROR << "Cannot open checkpoint " << filename;
+    return false;
+  }
+
+  FileHeader header;
+  std::vector<uint8_t> payload;
+  bool isRead = std::fread(&header, sizeof(header), 1, file) == 1 &&
+                std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) == 0 &&
+                header.version == kVersion &&
+                (header.encoding == kRaw || header.encoding == kShuffledRle);
+  if (isRead) {
+    // Check the size from the header against the file before allocating,
+    // so a truncated or corrupt file is rejected instead of throwing
+    const int64_t remainingSize = remainingFileSize(file);
+    isRead = remainingSize >= 0 && header.payloadSize <= static_cast<uint64_t>(remainingSize);
+  }
+  if (isRead) {
+    payload.resize(static_cast<size_t>(header.payloadSize));
+    isRead = std::fread(payload.data(), 1, payload.size(), file) == payload.size();
+  }
+  std::fclose(file);
+
+  std::vector<uint8_t> state;
+  if (isRead) {
+    if (header.encoding == kShuffledRle) {
+      isRead = decode(payload, static_cast<size_t>(header.stateSize), &state);
+    } else {
+      state = std::move(payload);
+    }
+  }
+  if (!isRead || state.size() != header.stateSize || fnv1a(state) != header.checksum) {
+    JET_ERROR << "Invalid checkpoint " << filename;
+    return false;
+  }
+
+  StateArchive archive(std::move(state));
+  animation->loadState(&archive);
+  if (!archive.isValid() || !archive.isAtEnd()) {
+    JET_ERROR << "Checkpoint " << filename << " does not match the simulation setup";
+    return false;
+  }
+  return true;
+}
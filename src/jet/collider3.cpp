@@ -121,3 +121,51 @@ void Collider3::setOnBeginUpdateCallback(
     const OnBeginUpdateCallback& callback) {
     _onUpdateCallback = callback;
 }
+
+void Collider3::saveState(StateArchive* archive) const {
+    archive->write(_frictionCoeffient);
+
+    archive->write(_surface != nullptr);
+    if (_surface != nullptr) {
+        const QuaternionD& orientation = _surface->transform.orientation();
+        archive->write(_surface->transform.translation());
+        archive->write(orientation.w);
+        archive->write(orientation.x);
+        archive->write(orientation.y);
+        archive->write(orientation.z);
+    }
+
+    onSaveState(archive);
+}
+
+void Collider3::loadState(StateArchive* archive) {
+    archive->read(&_frictionCoeffient);
+
+    bool hasSurface = false;
+    archive->read(&hasSurface);
+    if (hasSurface != (_surface != nullptr)) {
+        archive->invalidate();
+        return;
+    }
+
+    if (_surface != nullptr) {
+        Vector3D translation;
+        QuaternionD orientation;
+        archive->read(&translation);
+        archive->read(&orientation.w);
+        archive->read(&orientation.x);
+        archive->read(&orientation.y);
+        archive->read(&orientation.z);
+        _surface->transform = Transform3(translation, orientation);
+    }
+
+    onLoadState(archive);
+}
+
+void Collider3::onSaveState(StateArchive* archive) const {
+    UNUSED_VARIABLE(archive);
+}
+
+void Collider3::onLoadState(StateArchive* archive) {
+    UNUSED_VARIABLE(archive);
+}
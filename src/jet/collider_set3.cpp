@@ -51,6 +51,26 @@ Collider3Ptr ColliderSet3::collider(size_t i) const {
     return _colliders[i];
 }
 
+void ColliderSet3::onSaveState(StateArchive* archive) const {
+    archive->write(static_cast<uint64_t>(_colliders.size()));
+    for (const auto& collider : _colliders) {
+        collider->saveState(archive);
+    }
+}
+
+void ColliderSet3::onLoadState(StateArchive* archive) {
+    uint64_t numberOfColliders = 0;
+    archive->read(&numberOfColliders);
+    if (numberOfColliders != _colliders.size()) {
+        archive->invalidate();
+        return;
+    }
+
+    for (const auto& collider : _colliders) {
+        collider->loadState(archive);
+    }
+}
+
 ColliderSet3::Builder ColliderSet3::builder() {
     return Builder();
 }
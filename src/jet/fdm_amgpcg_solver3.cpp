@@ -0,0 +1,559 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#include <pch.h>
+
+#include <jet/cg.h>
+#include <jet/constants.h>
+#include <jet/fdm_amgpcg_solver3.h>
+#include <jet/parallel.h>
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+using namespace jet;
+
+namespace {
+
+// Connections with |a_ij| >= theta * sqrt(a_ii * a_jj) are strong
+const double kStrengthThreshold = 0.08;
+
+// Levels with fewer rows are not coarsened further
+const size_t kMinNumberOfCoarseRows = 64;
+
+// Piecewise constant interpolation underestimates the smooth error, so the
+// coarse grid correction is scaled up. Values below 2 keep the V-cycle
+// positive definite.
+const double kCoarseCorrectionScale = 1.8;
+
+const size_t kNoAggregate = std::numeric_limits<size_t>::max();
+
+typedef std::vector<std::pair<size_t, double>> SparseRow;
+
+double inverseOrZero(double value) {
+    return (value != 0.0) ? 1.0 / value : 0.0;
+}
+
+void diagonal(const MatrixCsrD& A, VectorND* result) {
+    const auto rp = A.rowPointersBegin();
+    const auto ci = A.columnIndicesBegin();
+    const auto nnz = A.nonZeroBegin();
+
+    result->resize(A.rows());
+    result->parallelForEachIndex([&](size_t i) {
+        double value = 0.0;
+        for (size_t jj = rp[i]; jj < rp[i + 1]; ++jj) {
+            if (ci[jj] == i) {
+                value = nnz[jj];
+            }
+        }
+        (*result)[i] = value;
+    });
+}
+
+// Computes result = a * v. Unlike FdmCompressedBlas3::mvm, the matrix does
+// not need to be square.
+void mvm(const MatrixCsrD& a, const VectorND& v, VectorND* result) {
+    const auto rp = a.rowPointersBegin();
+    const auto ci = a.columnIndicesBegin();
+    const auto nnz = a.nonZeroBegin();
+
+    result->parallelForEachIndex([&](size_t i) {
+        double sum = 0.0;
+        for (size_t jj = rp[i]; jj < rp[i + 1]; ++jj) {
+            sum += nnz[jj] * v[ci[jj]];
+        }
+        (*result)[i] = sum;
+    });
+}
+
+// Sorts the entries by column and sums up the duplicates
+void mergeRow(SparseRow* row) {
+    std::sort(row->begin(), row->end(),
+              [](const std::pair<size_t, double>& lhs,
+                 const std::pair<size_t, double>& rhs) {
+                  return lhs.first < rhs.first;
+              });
+
+    size_t last = 0;
+    for (size_t kk = 1; kk < row->size(); ++kk) {
+        if ((*row)[kk].first == (*row)[last].first) {
+            (*row)[last].second += (*row)[kk].second;
+        } else {
+            (*row)[++last] = (*row)[kk];
+        }
+    }
+    row->resize(row->empty() ? 0 : last + 1);
+}
+
+// Builds a rows x cols matrix whose i-th row computeRow(i, &row) returns.
+// The rows are computed twice, to count and to fill the non-zeros, so the
+// result does not depend on the number of threads.
+template <typename RowFunction>
+void buildRows(size_t rows, size_t cols, const RowFunction& computeRow,
+               MatrixCsrD* result) {
+    std::vector<size_t> rowPointers(rows + 1, 0);
+    parallelRangeFor(kZeroSize, rows, [&](size_t begin, size_t end) {
+        SparseRow row;
+        for (size_t i = begin; i < end; ++i) {
+            computeRow(i, &row);
+            rowPointers[i + 1] = row.size();
+        }
+    });
+    std::partial_sum(rowPointers.begin(), rowPointers.end(),
+                     rowPointers.begin());
+
+    result->reserve(rows, cols, rowPointers[rows]);
+    std::copy(rowPointers.begin(), rowPointers.end(),
+              result->rowPointersBegin());
+    auto ci = result->columnIndicesBegin();
+    auto nnz = result->nonZeroBegin();
+    parallelRangeFor(kZeroSize, rows, [&](size_t begin, size_t end) {
+        SparseRow row;
+        for (size_t i = begin; i < end; ++i) {
+            computeRow(i, &row);
+            for (size_t kk = 0; kk < row.size(); ++kk) {
+                ci[rowPointers[i] + kk] = row[kk].first;
+                nnz[rowPointers[i] + kk] = row[kk].second;
+            }
+        }
+    });
+}
+
+// Groups the rows into aggregates of strongly connected neighbors and
+// returns the number of aggregates. Rows without strong connections are
+// left out (kNoAggregate); the smoother alone handles them.
+size_t aggregate(const MatrixCsrD& A, const VectorND& diag,
+                 std::vector<size_t>* aggregates) {
+    const size_t n = A.rows();
+    const auto rp = A.rowPointersBegin();
+    const auto ci = A.columnIndicesBegin();
+    const auto nnz = A.nonZeroBegin();
+
+    auto forEachStrongNeighbor = [&](size_t i, const auto& func) {
+        for (size_t jj = rp[i]; jj < rp[i + 1]; ++jj) {
+            const size_t j = ci[jj];
+            const double threshold =
+                kStrengthThreshold * std::sqrt(std::fabs(diag[i] * diag[j]));
+            if (j != i && std::fabs(nnz[jj]) >= threshold) {
+                func(j);
+            }
+        }
+    };
+
+    std::vector<char> hasStrongNeighbor(n, 0);
+    parallelFor(kZeroSize, n, [&](size_t i) {
+        forEachStrongNeighbor(i, [&](size_t) { hasStrongNeighbor[i] = 1; });
+    });
+
+    aggregates->assign(n, kNoAggregate);
+    auto& agg = *aggregates;
+    size_t numberOfAggregates = 0;
+
+    // Pass 1: rows whose strong neighbors are all free form the aggregates
+    for (size_t i = 0; i < n; ++i) {
+        if (!hasStrongNeighbor[i] || agg[i] != kNoAggregate) {
+            continue;
+        }
+
+        bool isFree = true;
+        forEachStrongNeighbor(i, [&](size_t j) {
+            isFree = isFree && agg[j] == kNoAggregate;
+        });
+        if (isFree) {
+            agg[i] = numberOfAggregates;
+            forEachStrongNeighbor(
+                i, [&](size_t j) { agg[j] = numberOfAggregates; });
+            ++numberOfAggregates;
+        }
+    }
+
+    // Pass 2: the remaining rows join a neighboring aggregate of pass 1
+    const std::vector<size_t> firstPass = agg;
+    for (size_t i = 0; i < n; ++i) {
+        if (!hasStrongNeighbor[i] || agg[i] != kNoAggregate) {
+            continue;
+        }
+
+        forEachStrongNeighbor(i, [&](size_t j) {
+            if (agg[i] == kNoAggregate && firstPass[j] != kNoAggregate) {
+                agg[i] = firstPass[j];
+            }
+        });
+    }
+
+    // Pass 3: whatever is left forms aggregates with its free neighbors
+    for (size_t i = 0; i < n; ++i) {
+        if (!hasStrongNeighbor[i] || agg[i] != kNoAggregate) {
+            continue;
+        }
+
+        agg[i] = numberOfAggregates;
+        forEachStrongNeighbor(i, [&](size_t j) {
+            if (agg[j] == kNoAggregate) {
+                agg[j] = numberOfAggregates;
+            }
+        });
+        ++numberOfAggregates;
+    }
+
+    return numberOfAggregates;
+}
+
+// Builds the restriction R = P^T, i.e. the rows of each aggregate, where P
+// interpolates piecewise constantly from the aggregates.
+void buildRestriction(const std::vector<size_t>& aggregates,
+                      size_t numberOfAggregates, MatrixCsrD* R) {
+    const size_t n = aggregates.size();
+    size_t numberOfAggregatedRows = 0;
+    for (size_t i = 0; i < n; ++i) {
+        numberOfAggregatedRows += (aggregates[i] != kNoAggregate);
+    }
+
+    R->reserve(numberOfAggregates, n, numberOfAggregatedRows);
+    auto rp = R->rowPointersBegin();
+    auto ci = R->columnIndicesBegin();
+    auto nnz = R->nonZeroBegin();
+
+    std::fill(rp, rp + numberOfAggregates + 1, kZeroSize);
+    for (size_t i = 0; i < n; ++i) {
+        if (aggregates[i] != kNoAggregate) {
+            ++rp[aggregates[i] + 1];
+        }
+    }
+    std::partial_sum(rp, rp + numberOfAggregates + 1, rp);
+
+    std::vector<size_t> next(rp, rp + numberOfAggregates);
+    for (size_t i = 0; i < n; ++i) {
+        if (aggregates[i] != kNoAggregate) {
+            const size_t dst = next[aggregates[i]]++;
+            ci[dst] = i;
+            nnz[dst] = 1.0;
+        }
+    }
+}
+
+// Builds the Galerkin product R * A * P: entry (I, J) is the sum of the
+// entries of A between the rows of aggregate I and the rows of aggregate J.
+void buildCoarseMatrix(const MatrixCsrD& A, const MatrixCsrD& R,
+                       const std::vector<size_t>& aggregates,
+                       MatrixCsrD* result) {
+    const auto arp = A.rowPointersBegin();
+    const auto aci = A.columnIndicesBegin();
+    const auto annz = A.nonZeroBegin();
+    const auto rrp = R.rowPointersBegin();
+    const auto rci = R.columnIndicesBegin();
+
+    buildRows(R.rows(), R.rows(),
+              [&](size_t coarseRow, SparseRow* row) {
+                  row->clear();
+                  for (size_t ii = rrp[coarseRow]; ii < rrp[coarseRow + 1];
+                       ++ii) {
+                      const size_t i = rci[ii];
+                      for (size_t jj = arp[i]; jj < arp[i + 1]; ++jj) {
+                          const size_t coarseCol = aggregates[aci[jj]];
+                          if (coarseCol != kNoAggregate) {
+                              row->emplace_back(coarseCol, annz[jj]);
+                          }
+                      }
+                  }
+                  mergeRow(row);
+              },
+              result);
+}
+
+// Returns 4 / (3 * rho), where rho is the Gershgorin bound of the spectral
+// radius of D^-1 * A.
+double jacobiWeight(const MatrixCsrD& A, const VectorND& invDiagonal) {
+    const auto rp = A.rowPointersBegin();
+    const auto nnz = A.nonZeroBegin();
+
+    const double rho = parallelMax(kZeroSize, A.rows(), 0.0, [&](size_t i) {
+        double sum = 0.0;
+        for (size_t jj = rp[i]; jj < rp[i + 1]; ++jj) {
+            sum += std::fabs(nnz[jj]);
+        }
+        return sum * std::fabs(invDiagonal[i]);
+    });
+    return (rho > 0.0) ? 4.0 / (3.0 * rho) : 0.0;
+}
+
+void convertToCompressed(const FdmLinearSystem3& system,
+                         FdmCompressedLinearSystem3* result) {
+    const Size3 size = system.A.size();
+    const size_t numberOfRows = size.x * size.y * size.z;
+    const auto& A = system.A;
+    const size_t sliceSize = size.x * size.y;
+
+    // Columns in ascending order: back, down, left, center, right, up, front
+    // Coefficients pointing out of the grid are skipped, like FdmBlas3::mvm
+    std::vector<size_t> rowPointers(numberOfRows + 1, 0);
+    A.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        size_t count = 1;
+        count += (k > 0 && A(i, j, k - 1).front != 0.0);
+        count += (j > 0 && A(i, j - 1, k).up != 0.0);
+        count += (i > 0 && A(i - 1, j, k).right != 0.0);
+        count += (i + 1 < size.x && A(i, j, k).right != 0.0);
+        count += (j + 1 < size.y && A(i, j, k).up != 0.0);
+        count += (k + 1 < size.z && A(i, j, k).front != 0.0);
+        rowPointers[i + size.x * (j + size.y * k) + 1] = count;
+    });
+    std::partial_sum(rowPointers.begin(), rowPointers.end(),
+                     rowPointers.begin());
+
+    MatrixCsrD& matrix = result->A;
+    matrix.reserve(numberOfRows, numberOfRows, rowPointers[numberOfRows]);
+    std::copy(rowPointers.begin(), rowPointers.end(),
+              matrix.rowPointersBegin());
+    auto ci = matrix.columnIndicesBegin();
+    auto nnz = matrix.nonZeroBegin();
+    A.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        const size_t row = i + size.x * (j + size.y * k);
+        size_t dst = rowPointers[row];
+        auto add = [&](size_t col, double value) {
+            ci[dst] = col;
+            nnz[dst] = value;
+            ++dst;
+        };
+        if (k > 0 && A(i, j, k - 1).front != 0.0) {
+            add(row - sliceSize, A(i, j, k - 1).front);
+        }
+        if (j > 0 && A(i, j - 1, k).up != 0.0) {
+            add(row - size.x, A(i, j - 1, k).up);
+        }
+        if (i > 0 && A(i - 1, j, k).right != 0.0) {
+            add(row - 1, A(i - 1, j, k).right);
+        }
+        add(row, A(i, j, k).center);
+        if (i + 1 < size.x && A(i, j, k).right != 0.0) {
+            add(row + 1, A(i, j, k).right);
+        }
+        if (j + 1 < size.y && A(i, j, k).up != 0.0) {
+            add(row + size.x, A(i, j, k).up);
+        }
+        if (k + 1 < size.z && A(i, j, k).front != 0.0) {
+            add(row + sliceSize, A(i, j, k).front);
+        }
+    });
+
+    result->x.resize(numberOfRows);
+    result->b.resize(numberOfRows);
+    std::copy(system.x.data(), system.x.data() + numberOfRows,
+              result->x.data());
+    std::copy(system.b.data(), system.b.data() + numberOfRows,
+              result->b.data());
+}
+
+}  // namespace
+
+void FdmAmgpcgSolver3::Preconditioner::build(const MatrixCsrD& matrix) {
+    fineMatrix = &matrix;
+    levels.clear();
+    levels.reserve(maxNumberOfLevels);
+    levels.emplace_back();
+
+    VectorND diag;
+    for (size_t l = 0;; ++l) {
+        const MatrixCsrD& A = this->matrix(l);
+        Level& level = levels[l];
+        diagonal(A, &diag);
+        level.invDiagonal.resize(A.rows());
+        level.invDiagonal.parallelForEachIndex(
+            [&](size_t i) { level.invDiagonal[i] = inverseOrZero(diag[i]); });
+        level.omega = jacobiWeight(A, level.invDiagonal);
+        level.r.resize(A.rows());
+
+        if (levels.size() >= maxNumberOfLevels ||
+            A.rows() <= kMinNumberOfCoarseRows) {
+            break;
+        }
+
+        const size_t numberOfAggregates =
+            aggregate(A, diag, &level.aggregates);
+        if (numberOfAggregates == 0 || numberOfAggregates >= A.rows()) {
+            level.aggregates.clear();
+            break;
+        }
+
+        buildRestriction(level.aggregates, numberOfAggregates, &level.R);
+
+        levels.emplace_back();
+        Level& coarse = levels.back();
+        buildCoarseMatrix(A, levels[l].R, levels[l].aggregates, &coarse.A);
+        coarse.x.resize(numberOfAggregates);
+        coarse.b.resize(numberOfAggregates);
+    }
+}
+
+const MatrixCsrD& FdmAmgpcgSolver3::Preconditioner::matrix(
+    size_t level) const {
+    return (level == 0) ? *fineMatrix : levels[level].A;
+}
+
+void FdmAmgpcgSolver3::Preconditioner::solve(const VectorND& b,
+                                              VectorND* x) {
+    vCycle(0, b, x);
+}
+
+void FdmAmgpcgSolver3::Preconditioner::vCycle(size_t l, const VectorND& b,
+                                               VectorND* x) {
+    const MatrixCsrD& A = matrix(l);
+    Level& level = levels[l];
+
+    if (l + 1 == levels.size()) {
+        relaxCoarsest(A, b, x);
+        return;
+    }
+
+    // Pre-smoothing from zero
+    x->parallelForEachIndex([&](size_t i) {
+        (*x)[i] = level.omega * level.invDiagonal[i] * b[i];
+    });
+    for (unsigned int iter = 1; iter < numberOfSmoothingIter; ++iter) {
+        relax(l, b, x);
+    }
+
+    // Coarse grid correction
+    Level& coarse = levels[l + 1];
+    FdmCompressedBlas3::residual(A, *x, b, &level.r);
+    mvm(level.R, level.r, &coarse.b);
+    vCycle(l + 1, coarse.b, &coarse.x);
+    x->parallelForEachIndex([&](size_t i) {
+        const size_t coarseRow = level.aggregates[i];
+        if (coarseRow != kNoAggregate) {
+            (*x)[i] += kCoarseCorrectionScale * coarse.x[coarseRow];
+        }
+    });
+
+    // Post-smoothing, the adjoint of the pre-smoothing
+    for (unsigned int iter = 0; iter < numberOfSmoothingIter; ++iter) {
+        relax(l, b, x);
+    }
+}
+
+void FdmAmgpcgSolver3::Preconditioner::relax(size_t l, const VectorND& b,
+                                              VectorND* x) {
+    Level& level = levels[l];
+    FdmCompressedBlas3::residual(matrix(l), *x, b, &level.r);
+    x->parallelForEachIndex([&](size_t i) {
+        (*x)[i] += level.omega * level.invDiagonal[i] * level.r[i];
+    });
+}
+
+void FdmAmgpcgSolver3::Preconditioner::relaxCoarsest(const MatrixCsrD& A,
+                                                      const VectorND& b,
+                                                      VectorND* x) {
+    const auto rp = A.rowPointersBegin();
+    const auto ci = A.columnIndicesBegin();
+    const auto nnz = A.nonZeroBegin();
+    const VectorND& invDiagonal = levels.back().invDiagonal;
+
+    auto relaxRow = [&](size_t i) {
+        double sum = b[i];
+        for (size_t jj = rp[i]; jj < rp[i + 1]; ++jj) {
+            if (ci[jj] != i) {
+                sum -= nnz[jj] * (*x)[ci[jj]];
+            }
+        }
+        (*x)[i] = invDiagonal[i] * sum;
+    };
+
+    // Symmetric Gauss-Seidel keeps the preconditioner symmetric
+    const size_t n = A.rows();
+    x->set(0.0);
+    for (unsigned int iter = 0; iter < numberOfCoarsestIter; ++iter) {
+        for (size_t i = 0; i < n; ++i) {
+            relaxRow(i);
+        }
+        for (size_t i = n; i > 0; --i) {
+            relaxRow(i - 1);
+        }
+    }
+}
+
+FdmAmgpcgSolver3::FdmAmgpcgSolver3(unsigned int maxNumberOfIterations,
+                                   double tolerance, size_t maxNumberOfLevels,
+                                   unsigned int numberOfSmoothingIter,
+                                   unsigned int numberOfCoarsestIter)
+    : _maxNumberOfIterations(maxNumberOfIterations),
+      _lastNumberOfIterations(0),
+      _tolerance(tolerance),
+      _lastResidualNorm(kMaxD) {
+    JET_THROW_INVALID_ARG_IF(maxNumberOfLevels == 0);
+    JET_THROW_INVALID_ARG_IF(numberOfSmoothingIter == 0);
+
+    _precond.maxNumberOfLevels = maxNumberOfLevels;
+    _precond.numberOfSmoothingIter = numberOfSmoothingIter;
+    _precond.numberOfCoarsestIter = numberOfCoarsestIter;
+}
+
+bool FdmAmgpcgSolver3::solve(FdmLinearSystem3* system) {
+    JET_ASSERT(system->A.size() == system->b.size());
+    JET_ASSERT(system->A.size() == system->x.size());
+
+    convertToCompressed(*system, &_convertedSystem);
+    const bool result = solveCompressed(&_convertedSystem);
+
+    const VectorND& x = _convertedSystem.x;
+    std::copy(x.data(), x.data() + x.size(), system->x.data());
+    _convertedSystem.clear();
+    return result;
+}
+
+bool FdmAmgpcgSolver3::solveCompressed(FdmCompressedLinearSystem3* system) {
+    MatrixCsrD& matrix = system->A;
+    VectorND& solution = system->x;
+    VectorND& rhs = system->b;
+
+    size_t size = solution.size();
+    _r.resize(size);
+    _d.resize(size);
+    _q.resize(size);
+    _s.resize(size);
+
+    if (!useInitialGuess()) {
+        system->x.set(0.0);
+    }
+    _r.set(0.0);
+    _d.set(0.0);
+    _q.set(0.0);
+    _s.set(0.0);
+
+    _precond.build(matrix);
+
+    pcg<FdmCompressedBlas3, Preconditioner>(
+        matrix, rhs, _maxNumberOfIterations, _tolerance, &_precond, &solution,
+        &_r, &_d, &_q, &_s, &_lastNumberOfIterations, &_lastResidualNorm);
+
+    JET_INFO << "Residual after solving AMGPCG: " << _lastResidualNorm
+             << " Number of AMGPCG iterations: " << _lastNumberOfIterations
+             << " Number of AMG levels: " << _precond.levels.size();
+
+    return _lastResidualNorm <= _tolerance ||
+           _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+unsigned int FdmAmgpcgSolver3::maxNumberOfIterations() const {
+    return _maxNumberOfIterations;
+}
+
+unsigned int FdmAmgpcgSolver3::lastNumberOfIterations() const {
+    return _lastNumberOfIterations;
+}
+
+double FdmAmgpcgSolver3::tolerance() const { return _tolerance; }
+
+double FdmAmgpcgSolver3::lastResidual() const { return _lastResidualNorm; }
+
+size_t FdmAmgpcgSolver3::maxNumberOfLevels() const {
+    return _precond.maxNumberOfLevels;
+}
+
+size_t FdmAmgpcgSolver3::numberOfLevels() const {
+    return _precond.levels.size();
+}
@@ -32,15 +32,47 @@ bool FdmCgSolver3::solve(FdmLinearSystem3* system) {
     _d.resize(size);
     _q.resize(size);
     _s.resize(size);
+    _w.resize(size);
+    _z.resize(size);
 
-    system->x.set(0.0);
-    _r.set(0.0);
-    _d.set(0.0);
-    _q.set(0.0);
-    _s.set(0.0);
+    if (!useInitialGuess()) {
+        system->x.set(0.0);
+    }
 
-    cg<FdmBlas3>(matrix, rhs, _maxNumberOfIterations, _tolerance, &solution,
-                 &_r, &_d, &_q, &_s, &_lastNumberOfIterations, &_lastResidual);
+    pipelinedCg<FdmBlas3>(matrix, rhs, _maxNumberOfIterations, _tolerance,
+                          &solution, &_r, &_w, &_d, &_s, &_q, &_z,
+                          &_lastNumberOfIterations, &_lastResidual);
+
+    return _lastResidual <= _tolerance ||
+           _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+bool FdmCgSolver3::solveMatrixFree(FdmMatrixFreeLinearSystem3* system) {
+    FdmLaplacianMatrix3& matrix = system->A;
+    FdmVector3& solution = system->x;
+    FdmVector3& rhs = system->b;
+
+    JET_ASSERT(matrix.size() == rhs.size());
+    JET_ASSERT(matrix.size() == solution.size());
+
+    clearCompressedVectors();
+
+    Size3 size = matrix.size();
+    _r.resize(size);
+    _d.resize(size);
+    _q.resize(size);
+    _s.resize(size);
+    _w.resize(size);
+    _z.resize(size);
+
+    if (!useInitialGuess()) {
+        system->x.set(0.0);
+    }
+
+    pipelinedCg<FdmMatrixFreeBlas3>(matrix, rhs, _maxNumberOfIterations,
+                                    _tolerance, &solution, &_r, &_w, &_d, &_s,
+                                    &_q, &_z, &_lastNumberOfIterations,
+                                    &_lastResidual);
 
     return _lastResidual <= _tolerance ||
            _lastNumberOfIterations < _maxNumberOfIterations;
@@ -59,15 +91,26 @@ bool FdmCgSolver3::solveCompressed(FdmCompressedLinearSystem3* system) {
     _qComp.resize(size);
     _sComp.resize(size);
 
-    system->x.set(0.0);
+    if (!useInitialGuess()) {
+        system->x.set(0.0);
+    }
     _rComp.set(0.0);
     _dComp.set(0.0);
     _qComp.set(0.0);
     _sComp.set(0.0);
 
-    cg<FdmCompressedBlas3>(matrix, rhs, _maxNumberOfIterations, _tolerance,
-                           &solution, &_rComp, &_dComp, &_qComp, &_sComp,
-                           &_lastNumberOfIterations, &_lastResidual);
+    if (_useSellMatrix) {
+        _sellMatrix.set(matrix);
+        cg<FdmCompressedSellBlas3>(_sellMatrix, rhs, _maxNumberOfIterations,
+                                   _tolerance, &solution, &_rComp, &_dComp,
+                                   &_qComp, &_sComp, &_lastNumberOfIterations,
+                                   &_lastResidual);
+    } else {
+        cg<FdmCompressedBlas3>(matrix, rhs, _maxNumberOfIterations,
+                               _tolerance, &solution, &_rComp, &_dComp,
+                               &_qComp, &_sComp, &_lastNumberOfIterations,
+                               &_lastResidual);
+    }
 
     return _lastResidual <= _tolerance ||
            _lastNumberOfIterations < _maxNumberOfIterations;
@@ -85,11 +128,22 @@ double FdmCgSolver3::tolerance() const { return _tolerance; }
 
 double FdmCgSolver3::lastResidual() const { return _lastResidual; }
 
+bool FdmCgSolver3::useSellMatrix() const { return _useSellMatrix; }
+
+void FdmCgSolver3::setUseSellMatrix(bool useSellMatrix) {
+    _useSellMatrix = useSellMatrix;
+    if (!_useSellMatrix) {
+        _sellMatrix.clear();
+    }
+}
+
 void FdmCgSolver3::clearUncompressedVectors() {
     _r.clear();
     _d.clear();
     _q.clear();
     _s.clear();
+    _w.clear();
+    _z.clear();
 }
 
 void FdmCgSolver3::clearCompressedVectors() {
@@ -97,4 +151,5 @@ void FdmCgSolver3::clearCompressedVectors() {
     _dComp.clear();
     _qComp.clear();
     _sComp.clear();
+    _sellMatrix.clear();
 }
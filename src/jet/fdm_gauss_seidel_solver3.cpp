@@ -11,6 +11,168 @@
 
 using namespace jet;
 
+namespace {
+
+// Relaxes the cells i = iBegin, iBegin + step, ... of x-row (j, k). Rows away
+// from the y and z borders read the stencil directly from the markers without
+// bounds checks; only the cells next to a border take the generic path.
+void relaxLaplacianRow(const FdmLaplacianMatrix3& A, const FdmVector3& b,
+                       double sorFactor, size_t iBegin, size_t step, size_t j,
+                       size_t k, FdmVector3* x) {
+    const Size3 size = A.size();
+    auto relaxGeneric = [&](size_t i) {
+        double r = A.offDiagonalProduct(*x, i, j, k);
+        (*x)(i, j, k) = (1.0 - sorFactor) * (*x)(i, j, k) +
+                        sorFactor * (b(i, j, k) - r) / A.diagonal(i, j, k);
+    };
+
+    if (j == 0 || k == 0 || j + 1 >= size.y || k + 1 >= size.z) {
+        for (size_t i = iBegin; i < size.x; i += step) {
+            relaxGeneric(i);
+        }
+        return;
+    }
+
+    const char kFluid = FdmLaplacianMatrix3::kFluid;
+    const char kBoundary = FdmLaplacianMatrix3::kBoundary;
+    const size_t nx = size.x;
+    const size_t slice = size.x * size.y;
+    const size_t rowStart = nx * (j + size.y * k);
+    const char* m = A.markers.data() + rowStart;
+    const double* rhs = b.data() + rowStart;
+    double* v = x->data() + rowStart;
+    const double wx = A.invHSqr.x;
+    const double wy = A.invHSqr.y;
+    const double wz = A.invHSqr.z;
+
+    size_t i = iBegin;
+    if (i == 0) {
+        relaxGeneric(0);
+        i += step;
+    }
+    for (; i + 1 < nx; i += step) {
+        if (m[i] != kFluid) {
+            // Identity row
+            v[i] = (1.0 - sorFactor) * v[i] + sorFactor * rhs[i];
+            continue;
+        }
+
+        const char left = m[i - 1];
+        const char right = m[i + 1];
+        const char down = m[i - nx];
+        const char up = m[i + nx];
+        const char back = m[i - slice];
+        const char front = m[i + slice];
+        const double diagonal =
+            wx * ((left != kBoundary) + (right != kBoundary)) +
+            wy * ((down != kBoundary) + (up != kBoundary)) +
+            wz * ((back != kBoundary) + (front != kBoundary));
+        const double neighbors =
+            wx * ((left == kFluid ? v[i - 1] : 0.0) +
+                  (right == kFluid ? v[i + 1] : 0.0)) +
+            wy * ((down == kFluid ? v[i - nx] : 0.0) +
+                  (up == kFluid ? v[i + nx] : 0.0)) +
+            wz * ((back == kFluid ? v[i - slice] : 0.0) +
+                  (front == kFluid ? v[i + slice] : 0.0));
+        v[i] = (1.0 - sorFactor) * v[i] +
+               sorFactor * (rhs[i] + neighbors) / diagonal;
+    }
+    if (i == nx - 1) {
+        relaxGeneric(i);
+    }
+}
+
+// Relaxes the cells i = iBegin, iBegin + step, ... of x-row (j, k) of an
+// FdmMatrix3 or FdmMatrix3F system. Like relaxLaplacianRow, rows away from the
+// y and z borders read the neighbors through row pointers without bounds
+// checks.
+template <typename RowType, typename T>
+void relaxStencilRow(const Array3<RowType>& A, const Array3<T>& b,
+                     double sorFactor, size_t iBegin, size_t step, size_t j,
+                     size_t k, Array3<T>* x) {
+    const Size3 size = A.size();
+    const T zero = 0;
+    const T sor = static_cast<T>(sorFactor);
+    auto relaxGeneric = [&](size_t i) {
+        T r = ((i > 0) ? A(i - 1, j, k).right * (*x)(i - 1, j, k) : zero) +
+              ((i + 1 < size.x) ? A(i, j, k).right * (*x)(i + 1, j, k)
+                                : zero) +
+              ((j > 0) ? A(i, j - 1, k).up * (*x)(i, j - 1, k) : zero) +
+              ((j + 1 < size.y) ? A(i, j, k).up * (*x)(i, j + 1, k) : zero) +
+              ((k > 0) ? A(i, j, k - 1).front * (*x)(i, j, k - 1) : zero) +
+              ((k + 1 < size.z) ? A(i, j, k).front * (*x)(i, j, k + 1)
+                                : zero);
+
+        (*x)(i, j, k) = (1 - sor) * (*x)(i, j, k) +
+                        sor * (b(i, j, k) - r) / A(i, j, k).center;
+    };
+
+    if (j == 0 || k == 0 || j + 1 >= size.y || k + 1 >= size.z) {
+        for (size_t i = iBegin; i < size.x; i += step) {
+            relaxGeneric(i);
+        }
+        return;
+    }
+
+    const size_t nx = size.x;
+    const size_t slice = size.x * size.y;
+    const size_t rowStart = nx * (j + size.y * k);
+    const RowType* m = A.data() + rowStart;
+    const T* rhs = b.data() + rowStart;
+    T* v = x->data() + rowStart;
+
+    size_t i = iBegin;
+    if (i == 0) {
+        relaxGeneric(0);
+        i += step;
+    }
+    for (; i + 1 < nx; i += step) {
+        const RowType& row = m[i];
+        const T r = m[i - 1].right * v[i - 1] + row.right * v[i + 1] +
+                    m[i - nx].up * v[i - nx] + row.up * v[i + nx] +
+                    m[i - slice].front * v[i - slice] +
+                    row.front * v[i + slice];
+        v[i] = (1 - sor) * v[i] + sor * (rhs[i] - r) / row.center;
+    }
+    if (i == nx - 1) {
+        relaxGeneric(i);
+    }
+}
+
+template <typename RowType, typename T>
+void relaxStencil(const Array3<RowType>& A, const Array3<T>& b,
+                  double sorFactor, Array3<T>* x) {
+    Size3 size = A.size();
+
+    for (size_t k = 0; k < size.z; ++k) {
+        for (size_t j = 0; j < size.y; ++j) {
+            relaxStencilRow(A, b, sorFactor, 0, 1, j, k, x);
+        }
+    }
+}
+
+template <typename RowType, typename T>
+void relaxStencilRedBlack(const Array3<RowType>& A, const Array3<T>& b,
+                          double sorFactor, Array3<T>* x) {
+    Size3 size = A.size();
+
+    // Red update, then black update; whole x-rows are split by color
+    for (size_t color = 0; color < 2; ++color) {
+        parallelRangeFor(
+            kZeroSize, size.y, kZeroSize, size.z,
+            [&](size_t jBegin, size_t jEnd, size_t kBegin, size_t kEnd) {
+                for (size_t k = kBegin; k < kEnd; ++k) {
+                    for (size_t j = jBegin; j < jEnd; ++j) {
+                        relaxStencilRow(A, b, sorFactor, (j + k + color) % 2,
+                                        2, j, k, x);
+                    }
+                }
+            });
+    }
+}
+
+}  // namespace
+
 FdmGaussSeidelSolver3::FdmGaussSeidelSolver3(unsigned int maxNumberOfIterations,
                                              unsigned int residualCheckInterval,
                                              double tolerance, double sorFactor,
@@ -101,22 +263,8 @@ bool FdmGaussSeidelSolver3::useRedBlackOrdering() const {
 }
 
 void FdmGaussSeidelSolver3::relax(const FdmMatrix3& A, const FdmVector3& b,
-                                  double sorFactor, FdmVector3* x_) {
-    Size3 size = A.size();
-    FdmVector3& x = *x_;
-
-    A.forEachIndex([&](size_t i, size_t j, size_t k) {
-        double r =
-            ((i > 0) ? A(i - 1, j, k).right * x(i - 1, j, k) : 0.0) +
-            ((i + 1 < size.x) ? A(i, j, k).right * x(i + 1, j, k) : 0.0) +
-            ((j > 0) ? A(i, j - 1, k).up * x(i, j - 1, k) : 0.0) +
-            ((j + 1 < size.y) ? A(i, j, k).up * x(i, j + 1, k) : 0.0) +
-            ((k > 0) ? A(i, j, k - 1).front * x(i, j, k - 1) : 0.0) +
-            ((k + 1 < size.z) ? A(i, j, k).front * x(i, j, k + 1) : 0.0);
-
-        x(i, j, k) = (1.0 - sorFactor) * x(i, j, k) +
-                     sorFactor * (b(i, j, k) - r) / A(i, j, k).center;
-    });
+                                  double sorFactor, FdmVector3* x) {
+    relaxStencil(A, b, sorFactor, x);
 }
 
 void FdmGaussSeidelSolver3::relax(const MatrixCsrD& A, const VectorND& b,
@@ -148,76 +296,52 @@ void FdmGaussSeidelSolver3::relax(const MatrixCsrD& A, const VectorND& b,
 }
 
 void FdmGaussSeidelSolver3::relaxRedBlack(const FdmMatrix3& A,
+                                          const FdmVector3& b, double sorFactor,
+                                          FdmVector3* x) {
+    relaxStencilRedBlack(A, b, sorFactor, x);
+}
+
+void FdmGaussSeidelSolver3::relax(const FdmMatrix3F& A, const FdmVector3F& b,
+                                  double sorFactor, FdmVector3F* x) {
+    relaxStencil(A, b, sorFactor, x);
+}
+
+void FdmGaussSeidelSolver3::relaxRedBlack(const FdmMatrix3F& A,
+                                          const FdmVector3F& b,
+                                          double sorFactor, FdmVector3F* x) {
+    relaxStencilRedBlack(A, b, sorFactor, x);
+}
+
+void FdmGaussSeidelSolver3::relax(const FdmLaplacianMatrix3& A,
+                                  const FdmVector3& b, double sorFactor,
+                                  FdmVector3* x_) {
+    Size3 size = A.size();
+
+    for (size_t k = 0; k < size.z; ++k) {
+        for (size_t j = 0; j < size.y; ++j) {
+            relaxLaplacianRow(A, b, sorFactor, 0, 1, j, k, x_);
+        }
+    }
+}
+
+void FdmGaussSeidelSolver3::relaxRedBlack(const FdmLaplacianMatrix3& A,
                                           const FdmVector3& b, double sorFactor,
                                           FdmVector3* x_) {
     Size3 size = A.size();
-    FdmVector3& x = *x_;
-
-    // Red update
-    parallelRangeFor(
-        kZeroSize, size.x, kZeroSize, size.y, kZeroSize, size.z,
-        [&](size_t iBegin, size_t iEnd, size_t jBegin, size_t jEnd,
-            size_t kBegin, size_t kEnd) {
-            for (size_t k = kBegin; k < kEnd; ++k) {
-                for (size_t j = jBegin; j < jEnd; ++j) {
-                    size_t i = (j + k) % 2 + iBegin;  // i.e. (0, 0, 0)
-                    for (; i < iEnd; i += 2) {
-                        double r =
-                            ((i > 0) ? A(i - 1, j, k).right * x(i - 1, j, k)
-                                     : 0.0) +
-                            ((i + 1 < size.x)
-                                 ? A(i, j, k).right * x(i + 1, j, k)
-                                 : 0.0) +
-                            ((j > 0) ? A(i, j - 1, k).up * x(i, j - 1, k)
-                                     : 0.0) +
-                            ((j + 1 < size.y) ? A(i, j, k).up * x(i, j + 1, k)
-                                              : 0.0) +
-                            ((k > 0) ? A(i, j, k - 1).front * x(i, j, k - 1)
-                                     : 0.0) +
-                            ((k + 1 < size.z)
-                                 ? A(i, j, k).front * x(i, j, k + 1)
-                                 : 0.0);
-
-                        x(i, j, k) =
-                            (1.0 - sorFactor) * x(i, j, k) +
-                            sorFactor * (b(i, j, k) - r) / A(i, j, k).center;
-                    }
-                }
-            }
-        });
-
-    // Black update
-    parallelRangeFor(
-        kZeroSize, size.x, kZeroSize, size.y, kZeroSize, size.z,
-        [&](size_t iBegin, size_t iEnd, size_t jBegin, size_t jEnd,
-            size_t kBegin, size_t kEnd) {
-            for (size_t k = kBegin; k < kEnd; ++k) {
-                for (size_t j = jBegin; j < jEnd; ++j) {
-                    size_t i = 1 - (j + k) % 2 + iBegin;  // i.e. (1, 1, 1)
-                    for (; i < iEnd; i += 2) {
-                        double r =
-                            ((i > 0) ? A(i - 1, j, k).right * x(i - 1, j, k)
-                                     : 0.0) +
-                            ((i + 1 < size.x)
-                                 ? A(i, j, k).right * x(i + 1, j, k)
-                                 : 0.0) +
-                            ((j > 0) ? A(i, j - 1, k).up * x(i, j - 1, k)
-                                     : 0.0) +
-                            ((j + 1 < size.y) ? A(i, j, k).up * x(i, j + 1, k)
-                                              : 0.0) +
-                            ((k > 0) ? A(i, j, k - 1).front * x(i, j, k - 1)
-                                     : 0.0) +
-                            ((k + 1 < size.z)
-                                 ? A(i, j, k).front * x(i, j, k + 1)
-                                 : 0.0);
-
-                        x(i, j, k) =
-                            (1.0 - sorFactor) * x(i, j, k) +
-                            sorFactor * (b(i, j, k) - r) / A(i, j, k).center;
+
+    // Red update, then black update; whole x-rows are split by color
+    for (size_t color = 0; color < 2; ++color) {
+        parallelRangeFor(
+            kZeroSize, size.y, kZeroSize, size.z,
+            [&](size_t jBegin, size_t jEnd, size_t kBegin, size_t kEnd) {
+                for (size_t k = kBegin; k < kEnd; ++k) {
+                    for (size_t j = jBegin; j < jEnd; ++j) {
+                        relaxLaplacianRow(A, b, sorFactor, (j + k + color) % 2,
+                                          2, j, k, x_);
                     }
                 }
-            }
-        });
+            });
+    }
 }
 
 void FdmGaussSeidelSolver3::clearUncompressedVectors() { _residual.clear(); }
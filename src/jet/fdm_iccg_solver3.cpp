@@ -7,149 +7,385 @@
 #include <jet/cg.h>
 #include <jet/constants.h>
 #include <jet/fdm_iccg_solver3.h>
+#include <jet/parallel.h>
 #include <pch.h>
 
+#include <algorithm>
+
 using namespace jet;
 
-void FdmIccgSolver3::Preconditioner::build(const FdmMatrix3& matrix) {
+namespace {
+
+typedef FdmIccgSolver3::Ordering Ordering;
+
+// Calls func(j, k) for every x-row of the grid in the natural order, or in
+// anti-diagonal fronts j + k = const whose rows run in parallel.
+template <typename Callback>
+void forEachRow(const Size3& size, Ordering ordering, bool isReversed,
+                const Callback& func) {
+    if (size.x == 0 || size.y == 0 || size.z == 0) {
+        return;
+    }
+
+    if (ordering == Ordering::kNatural) {
+        for (size_t kk = 0; kk < size.z; ++kk) {
+            for (size_t jj = 0; jj < size.y; ++jj) {
+                const size_t k = isReversed ? size.z - 1 - kk : kk;
+                const size_t j = isReversed ? size.y - 1 - jj : jj;
+                func(j, k);
+            }
+        }
+        return;
+    }
+
+    // Row (j, k) depends on rows (j - 1, k) and (j, k - 1) in the forward
+    // sweep, which are both on the previous front
+    const size_t numberOfFronts = size.y + size.z - 1;
+    for (size_t f = 0; f < numberOfFronts; ++f) {
+        const size_t front = isReversed ? numberOfFronts - 1 - f : f;
+        const size_t kBegin = (front + 1 > size.y) ? front + 1 - size.y : 0;
+        const size_t kEnd = std::min(front + 1, size.z);
+        parallelFor(kBegin, kEnd, [&](size_t k) { func(front - k, k); });
+    }
+}
+
+// Calls func(i, j, k) in parallel for every cell of the given red-black color
+template <typename Callback>
+void forEachCellOfColor(const Size3& size, size_t color,
+                        const Callback& func) {
+    parallelFor(kZeroSize, size.y, kZeroSize, size.z,
+                [&](size_t j, size_t k) {
+                    for (size_t i = (j + k + color) % 2; i < size.x; i += 2) {
+                        func(i, j, k);
+                    }
+                });
+}
+
+// Returns the sum of a_ij * v_j over the six neighbors of cell (i, j, k)
+double offDiagonalSum(const ConstArrayAccessor3<FdmMatrixRow3>& A,
+                      const FdmVector3& v, size_t i, size_t j, size_t k) {
+    const Size3 size = A.size();
+    double sum = 0.0;
+    if (i > 0) {
+        sum += A(i - 1, j, k).right * v(i - 1, j, k);
+    }
+    if (i + 1 < size.x) {
+        sum += A(i, j, k).right * v(i + 1, j, k);
+    }
+    if (j > 0) {
+        sum += A(i, j - 1, k).up * v(i, j - 1, k);
+    }
+    if (j + 1 < size.y) {
+        sum += A(i, j, k).up * v(i, j + 1, k);
+    }
+    if (k > 0) {
+        sum += A(i, j, k - 1).front * v(i, j, k - 1);
+    }
+    if (k + 1 < size.z) {
+        sum += A(i, j, k).front * v(i, j, k + 1);
+    }
+    return sum;
+}
+
+// Returns the sum of a_ij^2 * d_j over the six neighbors of cell (i, j, k)
+double offDiagonalSquaredSum(const ConstArrayAccessor3<FdmMatrixRow3>& A,
+                             const FdmVector3& d, size_t i, size_t j,
+                             size_t k) {
+    const Size3 size = A.size();
+    double sum = 0.0;
+    if (i > 0) {
+        sum += square(A(i - 1, j, k).right) * d(i - 1, j, k);
+    }
+    if (i + 1 < size.x) {
+        sum += square(A(i, j, k).right) * d(i + 1, j, k);
+    }
+    if (j > 0) {
+        sum += square(A(i, j - 1, k).up) * d(i, j - 1, k);
+    }
+    if (j + 1 < size.y) {
+        sum += square(A(i, j, k).up) * d(i, j + 1, k);
+    }
+    if (k > 0) {
+        sum += square(A(i, j, k - 1).front) * d(i, j, k - 1);
+    }
+    if (k + 1 < size.z) {
+        sum += square(A(i, j, k).front) * d(i, j, k + 1);
+    }
+    return sum;
+}
+
+double inverseOrZero(double denom) {
+    return (std::fabs(denom) > 0.0) ? 1.0 / denom : 0.0;
+}
+
+// IC(0) pivot of CSR row i, using the earlier rows only
+template <typename Predicate>
+double factorizeCompressedRow(const MatrixCsrD& A, const VectorND& d,
+                              size_t i, const Predicate& isEarlier) {
+    const auto rp = A.rowPointersBegin();
+    const auto ci = A.columnIndicesBegin();
+    const auto nnz = A.nonZeroBegin();
+
+    double denom = 0.0;
+    for (size_t jj = rp[i]; jj < rp[i + 1]; ++jj) {
+        const size_t j = ci[jj];
+
+        if (j == i) {
+            denom += nnz[jj];
+        } else if (isEarlier(j, i)) {
+            denom -= square(nnz[jj]) * d[j];
+        }
+    }
+    return inverseOrZero(denom);
+}
+
+// Returns (v_i - sum of a_ij * u_j over the selected rows j) * d_i
+template <typename Predicate>
+double substituteCompressedRow(const MatrixCsrD& A, const VectorND& d,
+                               const VectorND& v, const VectorND& u, size_t i,
+                               const Predicate& isSelected) {
+    const auto rp = A.rowPointersBegin();
+    const auto ci = A.columnIndicesBegin();
+    const auto nnz = A.nonZeroBegin();
+
+    double sum = v[i];
+    for (size_t jj = rp[i]; jj < rp[i + 1]; ++jj) {
+        const size_t j = ci[jj];
+
+        if (isSelected(j, i)) {
+            sum -= nnz[jj] * u[j];
+        }
+    }
+    return sum * d[i];
+}
+
+}  // namespace
+
+void FdmIccgSolver3::Preconditioner::build(const FdmMatrix3& matrix,
+                                           Ordering newOrdering) {
     Size3 size = matrix.size();
     A = matrix.constAccessor();
+    ordering = newOrdering;
 
     d.resize(size, 0.0);
     y.resize(size, 0.0);
 
-    matrix.forEachIndex([&](size_t i, size_t j, size_t k) {
-        double denom =
-            matrix(i, j, k).center -
-            ((i > 0) ? square(matrix(i - 1, j, k).right) * d(i - 1, j, k)
-                     : 0.0) -
-            ((j > 0) ? square(matrix(i, j - 1, k).up) * d(i, j - 1, k) : 0.0) -
-            ((k > 0) ? square(matrix(i, j, k - 1).front) * d(i, j, k - 1)
-                     : 0.0);
-
-        if (std::fabs(denom) > 0.0) {
-            d(i, j, k) = 1.0 / denom;
-        } else {
-            d(i, j, k) = 0.0;
-        }
-    });
+    if (ordering == Ordering::kMulticolor) {
+        // Red cells have no earlier neighbors, and all neighbors of a black
+        // cell are red
+        forEachCellOfColor(size, 0, [&](size_t i, size_t j, size_t k) {
+            d(i, j, k) = inverseOrZero(A(i, j, k).center);
+        });
+        forEachCellOfColor(size, 1, [&](size_t i, size_t j, size_t k) {
+            d(i, j, k) = inverseOrZero(A(i, j, k).center -
+                                       offDiagonalSquaredSum(A, d, i, j, k));
+        });
+    } else {
+        forEachRow(size, ordering, false,
+                   [&](size_t j, size_t k) { factorizeRow(j, k); });
+    }
 }
 
 void FdmIccgSolver3::Preconditioner::solve(const FdmVector3& b, FdmVector3* x) {
     Size3 size = b.size();
-    ssize_t sx = static_cast<ssize_t>(size.x);
-    ssize_t sy = static_cast<ssize_t>(size.y);
-    ssize_t sz = static_cast<ssize_t>(size.z);
 
-    b.forEachIndex([&](size_t i, size_t j, size_t k) {
+    if (ordering == Ordering::kMulticolor) {
+        forEachCellOfColor(size, 0, [&](size_t i, size_t j, size_t k) {
+            y(i, j, k) = b(i, j, k) * d(i, j, k);
+        });
+        forEachCellOfColor(size, 1, [&](size_t i, size_t j, size_t k) {
+            y(i, j, k) =
+                (b(i, j, k) - offDiagonalSum(A, y, i, j, k)) * d(i, j, k);
+        });
+
+        forEachCellOfColor(size, 1, [&](size_t i, size_t j, size_t k) {
+            (*x)(i, j, k) = y(i, j, k) * d(i, j, k);
+        });
+        forEachCellOfColor(size, 0, [&](size_t i, size_t j, size_t k) {
+            (*x)(i, j, k) =
+                (y(i, j, k) - offDiagonalSum(A, *x, i, j, k)) * d(i, j, k);
+        });
+    } else {
+        forEachRow(size, ordering, false,
+                   [&](size_t j, size_t k) { forwardRow(b, j, k); });
+        forEachRow(size, ordering, true,
+                   [&](size_t j, size_t k) { backwardRow(x, j, k); });
+    }
+}
+
+void FdmIccgSolver3::Preconditioner::factorizeRow(size_t j, size_t k) {
+    const size_t sx = A.size().x;
+    for (size_t i = 0; i < sx; ++i) {
+        double denom =
+            A(i, j, k).center -
+            ((i > 0) ? square(A(i - 1, j, k).right) * d(i - 1, j, k) : 0.0) -
+            ((j > 0) ? square(A(i, j - 1, k).up) * d(i, j - 1, k) : 0.0) -
+            ((k > 0) ? square(A(i, j, k - 1).front) * d(i, j, k - 1) : 0.0);
+
+        d(i, j, k) = inverseOrZero(denom);
+    }
+}
+
+void FdmIccgSolver3::Preconditioner::forwardRow(const FdmVector3& b, size_t j,
+                                                size_t k) {
+    const size_t sx = A.size().x;
+    for (size_t i = 0; i < sx; ++i) {
         y(i, j, k) = (b(i, j, k) -
                       ((i > 0) ? A(i - 1, j, k).right * y(i - 1, j, k) : 0.0) -
                       ((j > 0) ? A(i, j - 1, k).up * y(i, j - 1, k) : 0.0) -
                       ((k > 0) ? A(i, j, k - 1).front * y(i, j, k - 1) : 0.0)) *
                      d(i, j, k);
-    });
-
-    for (ssize_t k = sz - 1; k >= 0; --k) {
-        for (ssize_t j = sy - 1; j >= 0; --j) {
-            for (ssize_t i = sx - 1; i >= 0; --i) {
-                (*x)(i, j, k) =
-                    (y(i, j, k) -
-                     ((i + 1 < sx) ? A(i, j, k).right * (*x)(i + 1, j, k)
-                                   : 0.0) -
-                     ((j + 1 < sy) ? A(i, j, k).up * (*x)(i, j + 1, k) : 0.0) -
-                     ((k + 1 < sz) ? A(i, j, k).front * (*x)(i, j, k + 1)
-                                   : 0.0)) *
-                    d(i, j, k);
-            }
-        }
+    }
+}
+
+void FdmIccgSolver3::Preconditioner::backwardRow(FdmVector3* x, size_t j,
+                                                 size_t k) {
+    const Size3 size = A.size();
+    for (size_t ii = size.x; ii > 0; --ii) {
+        const size_t i = ii - 1;
+        (*x)(i, j, k) =
+            (y(i, j, k) -
+             ((i + 1 < size.x) ? A(i, j, k).right * (*x)(i + 1, j, k) : 0.0) -
+             ((j + 1 < size.y) ? A(i, j, k).up * (*x)(i, j + 1, k) : 0.0) -
+             ((k + 1 < size.z) ? A(i, j, k).front * (*x)(i, j, k + 1) : 0.0)) *
+            d(i, j, k);
     }
 }
 
 //
 
-void FdmIccgSolver3::PreconditionerCompressed::build(const MatrixCsrD& matrix) {
+void FdmIccgSolver3::PreconditionerCompressed::build(const MatrixCsrD& matrix,
+                                                     Ordering newOrdering) {
     size_t size = matrix.cols();
     A = &matrix;
+    ordering = newOrdering;
 
     d.resize(size, 0.0);
     y.resize(size, 0.0);
 
-    const auto rp = A->rowPointersBegin();
-    const auto ci = A->columnIndicesBegin();
-    const auto nnz = A->nonZeroBegin();
-
-    d.forEachIndex([&](size_t i) {
-        const size_t rowBegin = rp[i];
-        const size_t rowEnd = rp[i + 1];
+    if (ordering == Ordering::kNatural) {
+        const auto isLower = [](size_t col, size_t row) { return col < row; };
 
-        double denom = 0.0;
-        for (size_t jj = rowBegin; jj < rowEnd; ++jj) {
-            size_t j = ci[jj];
+        d.forEachIndex([&](size_t i) {
+            d[i] = factorizeCompressedRow(*A, d, i, isLower);
+        });
+        return;
+    }
 
-            if (j == i) {
-                denom += nnz[jj];
-            } else if (j < i) {
-                denom -= square(nnz[jj]) * d[j];
-            }
-        }
+    buildSchedule();
 
-        if (std::fabs(denom) > 0.0) {
-            d[i] = 1.0 / denom;
-        } else {
-            d[i] = 0.0;
-        }
-    });
+    const auto isEarlier = [&](size_t col, size_t row) {
+        return rank[col] < rank[row];
+    };
+    for (size_t r = 0; r + 1 < rankPointers.size(); ++r) {
+        parallelFor(rankPointers[r], rankPointers[r + 1], [&](size_t p) {
+            const size_t i = rowsByRank[p];
+            d[i] = factorizeCompressedRow(*A, d, i, isEarlier);
+        });
+    }
 }
 
 void FdmIccgSolver3::PreconditionerCompressed::solve(const VectorND& b,
                                                      VectorND* x) {
-    const ssize_t size = static_cast<ssize_t>(b.size());
-
-    const auto rp = A->rowPointersBegin();
-    const auto ci = A->columnIndicesBegin();
-    const auto nnz = A->nonZeroBegin();
+    const size_t size = b.size();
 
-    b.forEachIndex([&](size_t i) {
-        const size_t rowBegin = rp[i];
-        const size_t rowEnd = rp[i + 1];
+    if (ordering == Ordering::kNatural) {
+        const auto isLower = [](size_t col, size_t row) { return col < row; };
+        const auto isUpper = [](size_t col, size_t row) { return col > row; };
 
-        double sum = b[i];
-        for (size_t jj = rowBegin; jj < rowEnd; ++jj) {
-            size_t j = ci[jj];
+        b.forEachIndex([&](size_t i) {
+            y[i] = substituteCompressedRow(*A, d, b, y, i, isLower);
+        });
 
-            if (j < i) {
-                sum -= nnz[jj] * y[j];
-            }
+        for (size_t ii = size; ii > 0; --ii) {
+            const size_t i = ii - 1;
+            (*x)[i] = substituteCompressedRow(*A, d, y, *x, i, isUpper);
         }
+        return;
+    }
 
-        y[i] = sum * d[i];
-    });
+    const auto isEarlier = [&](size_t col, size_t row) {
+        return rank[col] < rank[row];
+    };
+    const auto isLater = [&](size_t col, size_t row) {
+        return rank[col] > rank[row];
+    };
+    const size_t numberOfRanks = rankPointers.size() - 1;
+
+    for (size_t r = 0; r < numberOfRanks; ++r) {
+        parallelFor(rankPointers[r], rankPointers[r + 1], [&](size_t p) {
+            const size_t i = rowsByRank[p];
+            y[i] = substituteCompressedRow(*A, d, b, y, i, isEarlier);
+        });
+    }
 
-    for (ssize_t i = size - 1; i >= 0; --i) {
-        const size_t rowBegin = rp[i];
-        const size_t rowEnd = rp[i + 1];
+    for (size_t r = numberOfRanks; r > 0; --r) {
+        parallelFor(rankPointers[r - 1], rankPointers[r], [&](size_t p) {
+            const size_t i = rowsByRank[p];
+            (*x)[i] = substituteCompressedRow(*A, d, y, *x, i, isLater);
+        });
+    }
+}
 
-        double sum = y[i];
-        for (size_t jj = rowBegin; jj < rowEnd; ++jj) {
-            ssize_t j = static_cast<ssize_t>(ci[jj]);
+void FdmIccgSolver3::PreconditionerCompressed::buildSchedule() {
+    const size_t size = A->rows();
+    const auto rp = A->rowPointersBegin();
+    const auto ci = A->columnIndicesBegin();
 
-            if (j > i) {
-                sum -= nnz[jj] * (*x)[j];
+    // Wavefront: one more than the deepest lower neighbor, so a neighbor has
+    // a lower rank exactly if it has a lower index. Multicolor: the smallest
+    // color no lower neighbor has taken, so neighbors never share a color.
+    rank.assign(size, 0);
+    std::vector<char> isColorTaken;
+    size_t numberOfRanks = (size > 0) ? 1 : 0;
+    for (size_t i = 0; i < size; ++i) {
+        size_t r = 0;
+        if (ordering == Ordering::kWavefront) {
+            for (size_t jj = rp[i]; jj < rp[i + 1]; ++jj) {
+                if (ci[jj] < i) {
+                    r = std::max(r, rank[ci[jj]] + 1);
+                }
+            }
+        } else {
+            isColorTaken.assign(numberOfRanks + 1, 0);
+            for (size_t jj = rp[i]; jj < rp[i + 1]; ++jj) {
+                if (ci[jj] < i) {
+                    isColorTaken[rank[ci[jj]]] = 1;
+                }
+            }
+            while (isColorTaken[r]) {
+                ++r;
             }
         }
+        rank[i] = r;
+        numberOfRanks = std::max(numberOfRanks, r + 1);
+    }
 
-        (*x)[i] = sum * d[i];
+    // Bucket the rows by rank, keeping the index order within a rank
+    rankPointers.assign(numberOfRanks + 1, 0);
+    for (size_t i = 0; i < size; ++i) {
+        ++rankPointers[rank[i] + 1];
+    }
+    for (size_t r = 0; r < numberOfRanks; ++r) {
+        rankPointers[r + 1] += rankPointers[r];
+    }
+
+    std::vector<size_t> next(rankPointers.begin(), rankPointers.end() - 1);
+    rowsByRank.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        rowsByRank[next[rank[i]]++] = i;
     }
 }
 
 //
 
 FdmIccgSolver3::FdmIccgSolver3(unsigned int maxNumberOfIterations,
-                               double tolerance)
+                               double tolerance, Ordering ordering)
     : _maxNumberOfIterations(maxNumberOfIterations),
       _lastNumberOfIterations(0),
       _tolerance(tolerance),
-      _lastResidualNorm(kMaxD) {}
+      _lastResidualNorm(kMaxD),
+      _ordering(ordering) {}
 
 bool FdmIccgSolver3::solve(FdmLinearSystem3* system) {
     FdmMatrix3& matrix = system->A;
@@ -167,13 +403,15 @@ bool FdmIccgSolver3::solve(FdmLinearSystem3* system) {
     _q.resize(size);
     _s.resize(size);
 
-    system->x.set(0.0);
+    if (!useInitialGuess()) {
+        system->x.set(0.0);
+    }
     _r.set(0.0);
     _d.set(0.0);
     _q.set(0.0);
     _s.set(0.0);
 
-    _precond.build(matrix);
+    _precond.build(matrix, _ordering);
 
     pcg<FdmBlas3, Preconditioner>(
         matrix, rhs, _maxNumberOfIterations, _tolerance, &_precond, &solution,
@@ -199,13 +437,15 @@ bool FdmIccgSolver3::solveCompressed(FdmCompressedLinearSystem3* system) {
     _qComp.resize(size);
     _sComp.resize(size);
 
-    system->x.set(0.0);
+    if (!useInitialGuess()) {
+        system->x.set(0.0);
+    }
     _rComp.set(0.0);
     _dComp.set(0.0);
     _qComp.set(0.0);
     _sComp.set(0.0);
 
-    _precondComp.build(matrix);
+    _precondComp.build(matrix, _ordering);
 
     pcg<FdmCompressedBlas3, PreconditionerCompressed>(
         matrix, rhs, _maxNumberOfIterations, _tolerance, &_precondComp,
@@ -231,6 +471,10 @@ double FdmIccgSolver3::tolerance() const { return _tolerance; }
 
 double FdmIccgSolver3::lastResidual() const { return _lastResidualNorm; }
 
+FdmIccgSolver3::Ordering FdmIccgSolver3::ordering() const { return _ordering; }
+
+void FdmIccgSolver3::setOrdering(Ordering ordering) { _ordering = ordering; }
+
 void FdmIccgSolver3::clearUncompressedVectors() {
     _r.clear();
     _d.clear();
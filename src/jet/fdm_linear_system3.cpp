@@ -9,9 +9,61 @@
 #include <jet/fdm_linear_system3.h>
 #include <jet/math_utils.h>
 #include <jet/parallel.h>
+#include <jet/vector2.h>
 
 using namespace jet;
 
+namespace {
+
+// Calls func(i, j, k) for the linear indices [begin, end) of a grid, where i
+// runs fastest. This lets grid reductions use the fixed linear blocks of
+// parallelDeterministicReduce.
+template <typename Callback>
+void forEachIndexInRange(const Size3& size, size_t begin, size_t end,
+                         const Callback& func) {
+    size_t i = begin % size.x;
+    size_t j = (begin / size.x) % size.y;
+    size_t k = begin / (size.x * size.y);
+    for (size_t idx = begin; idx < end; ++idx) {
+        func(i, j, k);
+        if (++i == size.x) {
+            i = 0;
+            if (++j == size.y) {
+                j = 0;
+                ++k;
+            }
+        }
+    }
+}
+
+// Returns the (i, j, k) element of m * v
+template <typename RowType, typename T>
+inline T mvmRow(const Array3<RowType>& m, const Array3<T>& v,
+                const Size3& size, size_t i, size_t j, size_t k) {
+    const T zero = 0;
+    return m(i, j, k).center * v(i, j, k) +
+           ((i > 0) ? m(i - 1, j, k).right * v(i - 1, j, k) : zero) +
+           ((i + 1 < size.x) ? m(i, j, k).right * v(i + 1, j, k) : zero) +
+           ((j > 0) ? m(i, j - 1, k).up * v(i, j - 1, k) : zero) +
+           ((j + 1 < size.y) ? m(i, j, k).up * v(i, j + 1, k) : zero) +
+           ((k > 0) ? m(i, j, k - 1).front * v(i, j, k - 1) : zero) +
+           ((k + 1 < size.z) ? m(i, j, k).front * v(i, j, k + 1) : zero);
+}
+
+// Copies the elements of v into result, converting the value type
+template <typename T, typename U>
+void convert(const Array3<T>& v, Array3<U>* result) {
+    result->resize(v.size());
+
+    const T* in = v.data();
+    U* out = result->data();
+    const Size3 size = v.size();
+    parallelFor(kZeroSize, size.x * size.y * size.z,
+                [&](size_t i) { out[i] = static_cast<U>(in[i]); });
+}
+
+}  // namespace
+
 void FdmLinearSystem3::clear() {
     A.clear();
     x.clear();
@@ -51,17 +103,10 @@ double FdmBlas3::dot(const FdmVector3& a, const FdmVector3& b) {
 
     JET_THROW_INVALID_ARG_IF(size != b.size());
 
-    double result = 0.0;
-
-    for (size_t k = 0; k < size.z; ++k) {
-        for (size_t j = 0; j < size.y; ++j) {
-            for (size_t i = 0; i < size.x; ++i) {
-                result += a(i, j, k) * b(i, j, k);
-            }
-        }
-    }
-
-    return result;
+    const double* aData = a.data();
+    const double* bData = b.data();
+    return parallelSum(kZeroSize, size.x * size.y * size.z, 0.0,
+                       [&](size_t i) { return aData[i] * bData[i]; });
 }
 
 void FdmBlas3::axpy(double a, const FdmVector3& x, const FdmVector3& y,
@@ -84,17 +129,31 @@ void FdmBlas3::mvm(const FdmMatrix3& m, const FdmVector3& v,
     JET_THROW_INVALID_ARG_IF(size != result->size());
 
     m.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
-        (*result)(i, j, k) =
-            m(i, j, k).center * v(i, j, k) +
-            ((i > 0) ? m(i - 1, j, k).right * v(i - 1, j, k) : 0.0) +
-            ((i + 1 < size.x) ? m(i, j, k).right * v(i + 1, j, k) : 0.0) +
-            ((j > 0) ? m(i, j - 1, k).up * v(i, j - 1, k) : 0.0) +
-            ((j + 1 < size.y) ? m(i, j, k).up * v(i, j + 1, k) : 0.0) +
-            ((k > 0) ? m(i, j, k - 1).front * v(i, j, k - 1) : 0.0) +
-            ((k + 1 < size.z) ? m(i, j, k).front * v(i, j, k + 1) : 0.0);
+        (*result)(i, j, k) = mvmRow(m, v, size, i, j, k);
     });
 }
 
+double FdmBlas3::mvmDot(const FdmMatrix3& m, const FdmVector3& v,
+                        FdmVector3* result) {
+    Size3 size = m.size();
+
+    JET_THROW_INVALID_ARG_IF(size != v.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    return parallelDeterministicReduce(
+        kZeroSize, size.x * size.y * size.z, 0.0,
+        [&](size_t begin, size_t end, double sum) {
+            auto rowFunc = [&](size_t i, size_t j, size_t k) {
+                const double mv = mvmRow(m, v, size, i, j, k);
+                (*result)(i, j, k) = mv;
+                sum += v(i, j, k) * mv;
+            };
+            forEachIndexInRange(size, begin, end, rowFunc);
+            return sum;
+        },
+        [](double a, double b) { return a + b; });
+}
+
 void FdmBlas3::residual(const FdmMatrix3& a, const FdmVector3& x,
                         const FdmVector3& b, FdmVector3* result) {
     Size3 size = a.size();
@@ -120,17 +179,160 @@ double FdmBlas3::l2Norm(const FdmVector3& v) { return std::sqrt(dot(v, v)); }
 double FdmBlas3::lInfNorm(const FdmVector3& v) {
     Size3 size = v.size();
 
-    double result = 0.0;
+    const double* data = v.data();
+    return parallelMax(kZeroSize, size.x * size.y * size.z, 0.0,
+                       [&](size_t i) { return std::fabs(data[i]); });
+}
 
-    for (size_t k = 0; k < size.z; ++k) {
-        for (size_t j = 0; j < size.y; ++j) {
-            for (size_t i = 0; i < size.x; ++i) {
-                result = absmax(result, v(i, j, k));
+void FdmBlas3::pipelinedCgUpdate(double alpha, double beta,
+                                 const FdmVector3& q, FdmVector3* z,
+                                 FdmVector3* s, FdmVector3* p, FdmVector3* x,
+                                 FdmVector3* r, FdmVector3* w, double* rDotR,
+                                 double* wDotR) {
+    Size3 size = q.size();
+
+    JET_THROW_INVALID_ARG_IF(size != z->size() || size != s->size() ||
+                             size != p->size() || size != x->size() ||
+                             size != r->size() || size != w->size());
+
+    const double* qData = q.data();
+    double* zData = z->data();
+    double* sData = s->data();
+    double* pData = p->data();
+    double* xData = x->data();
+    double* rData = r->data();
+    double* wData = w->data();
+
+    Vector2D dots = parallelDeterministicReduce(
+        kZeroSize, size.x * size.y * size.z, Vector2D(),
+        [&](size_t begin, size_t end, Vector2D sum) {
+            // Locals keep the compiler from reloading possibly aliased data
+            double rr = sum.x;
+            double wr = sum.y;
+            for (size_t i = begin; i < end; ++i) {
+                const double zi = qData[i] + beta * zData[i];
+                const double si = wData[i] + beta * sData[i];
+                const double pi = rData[i] + beta * pData[i];
+                const double ri = rData[i] - alpha * si;
+                const double wi = wData[i] - alpha * zi;
+                zData[i] = zi;
+                sData[i] = si;
+                pData[i] = pi;
+                xData[i] += alpha * pi;
+                rData[i] = ri;
+                wData[i] = wi;
+                rr += ri * ri;
+                wr += wi * ri;
             }
-        }
-    }
+            return Vector2D(rr, wr);
+        },
+        [](const Vector2D& a, const Vector2D& b) { return a + b; });
 
-    return std::fabs(result);
+    *rDotR = dots.x;
+    *wDotR = dots.y;
+}
+
+//
+
+void FdmBlas3F::set(float s, FdmVector3F* result) { result->set(s); }
+
+void FdmBlas3F::set(const FdmVector3F& v, FdmVector3F* result) {
+    result->set(v);
+}
+
+void FdmBlas3F::set(float s, FdmMatrix3F* result) {
+    FdmMatrixRow3F row;
+    row.center = row.right = row.up = row.front = s;
+    result->set(row);
+}
+
+void FdmBlas3F::set(const FdmMatrix3F& m, FdmMatrix3F* result) {
+    result->set(m);
+}
+
+void FdmBlas3F::set(const FdmVector3& v, FdmVector3F* result) {
+    convert(v, result);
+}
+
+void FdmBlas3F::set(const FdmMatrix3& m, FdmMatrix3F* result) {
+    result->resize(m.size());
+    result->parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        const FdmMatrixRow3& row = m(i, j, k);
+        FdmMatrixRow3F& rowF = (*result)(i, j, k);
+        rowF.center = static_cast<float>(row.center);
+        rowF.right = static_cast<float>(row.right);
+        rowF.up = static_cast<float>(row.up);
+        rowF.front = static_cast<float>(row.front);
+    });
+}
+
+void FdmBlas3F::set(const FdmVector3F& v, FdmVector3* result) {
+    convert(v, result);
+}
+
+double FdmBlas3F::dot(const FdmVector3F& a, const FdmVector3F& b) {
+    Size3 size = a.size();
+
+    JET_THROW_INVALID_ARG_IF(size != b.size());
+
+    const float* aData = a.data();
+    const float* bData = b.data();
+    return parallelSum(kZeroSize, size.x * size.y * size.z, 0.0,
+                       [&](size_t i) {
+                           return static_cast<double>(aData[i]) * bData[i];
+                       });
+}
+
+void FdmBlas3F::axpy(double a, const FdmVector3F& x, const FdmVector3F& y,
+                     FdmVector3F* result) {
+    Size3 size = x.size();
+
+    JET_THROW_INVALID_ARG_IF(size != y.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    const float af = static_cast<float>(a);
+    x.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        (*result)(i, j, k) = af * x(i, j, k) + y(i, j, k);
+    });
+}
+
+void FdmBlas3F::mvm(const FdmMatrix3F& m, const FdmVector3F& v,
+                    FdmVector3F* result) {
+    Size3 size = m.size();
+
+    JET_THROW_INVALID_ARG_IF(size != v.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    m.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        (*result)(i, j, k) = mvmRow(m, v, size, i, j, k);
+    });
+}
+
+void FdmBlas3F::residual(const FdmMatrix3F& a, const FdmVector3F& x,
+                         const FdmVector3F& b, FdmVector3F* result) {
+    Size3 size = a.size();
+
+    JET_THROW_INVALID_ARG_IF(size != x.size());
+    JET_THROW_INVALID_ARG_IF(size != b.size());
+    JET_THROW_INVALID_ARG_IF(size != result->size());
+
+    a.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        (*result)(i, j, k) = b(i, j, k) - mvmRow(a, x, size, i, j, k);
+    });
+}
+
+double FdmBlas3F::l2Norm(const FdmVector3F& v) {
+    return std::sqrt(dot(v, v));
+}
+
+double FdmBlas3F::lInfNorm(const FdmVector3F& v) {
+    Size3 size = v.size();
+
+    const float* data = v.data();
+    return parallelMax(kZeroSize, size.x * size.y * size.z, 0.0,
+                       [&](size_t i) {
+                           return static_cast<double>(std::fabs(data[i]));
+                       });
 }
 
 //
@@ -205,3 +407,44 @@ double FdmCompressedBlas3::l2Norm(const VectorND& v) {
 double FdmCompressedBlas3::lInfNorm(const VectorND& v) {
     return std::fabs(v.absmax());
 }
+
+//
+
+void FdmCompressedSellBlas3::set(double s, VectorND* result) {
+    FdmCompressedBlas3::set(s, result);
+}
+
+void FdmCompressedSellBlas3::set(const VectorND& v, VectorND* result) {
+    FdmCompressedBlas3::set(v, result);
+}
+
+void FdmCompressedSellBlas3::set(const MatrixSellD& m, MatrixSellD* result) {
+    *result = m;
+}
+
+double FdmCompressedSellBlas3::dot(const VectorND& a, const VectorND& b) {
+    return FdmCompressedBlas3::dot(a, b);
+}
+
+void FdmCompressedSellBlas3::axpy(double a, const VectorND& x,
+                                  const VectorND& y, VectorND* result) {
+    FdmCompressedBlas3::axpy(a, x, y, result);
+}
+
+void FdmCompressedSellBlas3::mvm(const MatrixSellD& m, const VectorND& v,
+                                 VectorND* result) {
+    m.mul(v, result);
+}
+
+void FdmCompressedSellBlas3::residual(const MatrixSellD& a, const VectorND& x,
+                                      const VectorND& b, VectorND* result) {
+    a.residual(x, b, result);
+}
+
+double FdmCompressedSellBlas3::l2Norm(const VectorND& v) {
+    return FdmCompressedBlas3::l2Norm(v);
+}
+
+double FdmCompressedSellBlas3::lInfNorm(const VectorND& v) {
+    return FdmCompressedBlas3::lInfNorm(v);
+}
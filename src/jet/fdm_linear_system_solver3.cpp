@@ -0,0 +1,35 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#include <pch.h>
+
+#include <jet/fdm_linear_system_solver3.h>
+
+#include <utility>
+
+using namespace jet;
+
+bool FdmLinearSystemSolver3::solveMatrixFree(
+    FdmMatrixFreeLinearSystem3* system) {
+    FdmLinearSystem3 assembled;
+    system->A.assemble(&assembled.A);
+    assembled.x = std::move(system->x);
+    assembled.b = std::move(system->b);
+
+    const bool result = solve(&assembled);
+
+    system->x = std::move(assembled.x);
+    system->b = std::move(assembled.b);
+    return result;
+}
+
+bool FdmLinearSystemSolver3::useInitialGuess() const {
+    return _useInitialGuess;
+}
+
+void FdmLinearSystemSolver3::setUseInitialGuess(bool useInitialGuess) {
+    _useInitialGuess = useInitialGuess;
+}
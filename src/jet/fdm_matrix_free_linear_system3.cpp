@@ -0,0 +1,316 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#include <pch.h>
+
+#include <jet/fdm_matrix_free_linear_system3.h>
+#include <jet/parallel.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace jet;
+
+namespace {
+
+// Computes (A * v) cell by cell over ranges of linear cell indices. Each
+// range is walked as pieces of x-rows whose inner loop is branch-free: the
+// neighbor rows outside the grid are replaced by a row of boundary markers
+// and a row of zeros, and only the first and last cell of a row, which miss
+// an x-neighbor, take the generic path.
+class LaplacianRowSweeper {
+ public:
+    LaplacianRowSweeper(const FdmLaplacianMatrix3& A, const FdmVector3& v)
+        : _A(A),
+          _v(v),
+          _size(A.size()),
+          _boundaryRow(_size.x, FdmLaplacianMatrix3::kBoundary),
+          _zeroRow(_size.x, 0.0) {}
+
+    size_t numberOfCells() const { return _size.x * _size.y * _size.z; }
+
+    // Calls func(index, (A * v)[index]) for the cells in [begin, end)
+    template <typename Callback>
+    void sweep(size_t begin, size_t end, const Callback& func) const {
+        const size_t nx = _size.x;
+        const size_t slice = _size.x * _size.y;
+        const char* markers = _A.markers.data();
+        const double* values = _v.data();
+
+        const char kFluid = FdmLaplacianMatrix3::kFluid;
+        const char kBoundary = FdmLaplacianMatrix3::kBoundary;
+        const double wx = _A.invHSqr.x;
+        const double wy = _A.invHSqr.y;
+        const double wz = _A.invHSqr.z;
+
+        size_t rowStart = begin - begin % nx;
+        while (rowStart < end) {
+            const size_t j = (rowStart / nx) % _size.y;
+            const size_t k = rowStart / slice;
+            const size_t iBegin = (rowStart < begin) ? begin - rowStart : 0;
+            const size_t iEnd = std::min(nx, end - rowStart);
+
+            const char* m = markers + rowStart;
+            const double* x = values + rowStart;
+            const bool hasDown = j > 0;
+            const bool hasUp = j + 1 < _size.y;
+            const bool hasBack = k > 0;
+            const bool hasFront = k + 1 < _size.z;
+            const char* mDown = hasDown ? m - nx : _boundaryRow.data();
+            const char* mUp = hasUp ? m + nx : _boundaryRow.data();
+            const char* mBack = hasBack ? m - slice : _boundaryRow.data();
+            const char* mFront = hasFront ? m + slice : _boundaryRow.data();
+            const double* xDown = hasDown ? x - nx : _zeroRow.data();
+            const double* xUp = hasUp ? x + nx : _zeroRow.data();
+            const double* xBack = hasBack ? x - slice : _zeroRow.data();
+            const double* xFront = hasFront ? x + slice : _zeroRow.data();
+
+            const size_t iInteriorBegin = std::max<size_t>(iBegin, 1);
+            const size_t iInteriorEnd = std::max(iInteriorBegin,
+                                                 std::min(iEnd, nx - 1));
+
+            if (iBegin == 0 && iEnd > 0) {
+                func(rowStart, generic(0, j, k));
+            }
+
+            for (size_t i = iInteriorBegin; i < iInteriorEnd; ++i) {
+                const double center =
+                    wx * ((m[i - 1] != kBoundary) + (m[i + 1] != kBoundary)) +
+                    wy * ((mDown[i] != kBoundary) + (mUp[i] != kBoundary)) +
+                    wz * ((mBack[i] != kBoundary) + (mFront[i] != kBoundary));
+                const double neighbors =
+                    wx * ((m[i - 1] == kFluid ? x[i - 1] : 0.0) +
+                          (m[i + 1] == kFluid ? x[i + 1] : 0.0)) +
+                    wy * ((mDown[i] == kFluid ? xDown[i] : 0.0) +
+                          (mUp[i] == kFluid ? xUp[i] : 0.0)) +
+                    wz * ((mBack[i] == kFluid ? xBack[i] : 0.0) +
+                          (mFront[i] == kFluid ? xFront[i] : 0.0));
+                func(rowStart + i,
+                     (m[i] == kFluid) ? center * x[i] - neighbors : x[i]);
+            }
+
+            if (nx > 1 && iEnd == nx) {
+                func(rowStart + nx - 1, generic(nx - 1, j, k));
+            }
+
+            rowStart += nx;
+        }
+    }
+
+ private:
+    const FdmLaplacianMatrix3& _A;
+    const FdmVector3& _v;
+    Size3 _size;
+    std::vector<char> _boundaryRow;
+    std::vector<double> _zeroRow;
+
+    double generic(size_t i, size_t j, size_t k) const {
+        return _A.diagonal(i, j, k) * _v(i, j, k) +
+               _A.offDiagonalProduct(_v, i, j, k);
+    }
+};
+
+}  // namespace
+
+Size3 FdmLaplacianMatrix3::size() const { return markers.size(); }
+
+void FdmLaplacianMatrix3::resize(const Size3& size) {
+    markers.resize(size, kAir);
+}
+
+void FdmLaplacianMatrix3::clear() { markers.clear(); }
+
+double FdmLaplacianMatrix3::diagonal(size_t i, size_t j, size_t k) const {
+    if (markers(i, j, k) != kFluid) {
+        return 1.0;
+    }
+
+    const Size3 n = markers.size();
+    double result = 0.0;
+    if (i > 0 && markers(i - 1, j, k) != kBoundary) {
+        result += invHSqr.x;
+    }
+    if (i + 1 < n.x && markers(i + 1, j, k) != kBoundary) {
+        result += invHSqr.x;
+    }
+    if (j > 0 && markers(i, j - 1, k) != kBoundary) {
+        result += invHSqr.y;
+    }
+    if (j + 1 < n.y && markers(i, j + 1, k) != kBoundary) {
+        result += invHSqr.y;
+    }
+    if (k > 0 && markers(i, j, k - 1) != kBoundary) {
+        result += invHSqr.z;
+    }
+    if (k + 1 < n.z && markers(i, j, k + 1) != kBoundary) {
+        result += invHSqr.z;
+    }
+    return result;
+}
+
+double FdmLaplacianMatrix3::offDiagonalProduct(const FdmVector3& v, size_t i,
+                                               size_t j, size_t k) const {
+    if (markers(i, j, k) != kFluid) {
+        return 0.0;
+    }
+
+    const Size3 n = markers.size();
+    double result = 0.0;
+    if (i > 0 && markers(i - 1, j, k) == kFluid) {
+        result -= invHSqr.x * v(i - 1, j, k);
+    }
+    if (i + 1 < n.x && markers(i + 1, j, k) == kFluid) {
+        result -= invHSqr.x * v(i + 1, j, k);
+    }
+    if (j > 0 && markers(i, j - 1, k) == kFluid) {
+        result -= invHSqr.y * v(i, j - 1, k);
+    }
+    if (j + 1 < n.y && markers(i, j + 1, k) == kFluid) {
+        result -= invHSqr.y * v(i, j + 1, k);
+    }
+    if (k > 0 && markers(i, j, k - 1) == kFluid) {
+        result -= invHSqr.z * v(i, j, k - 1);
+    }
+    if (k + 1 < n.z && markers(i, j, k + 1) == kFluid) {
+        result -= invHSqr.z * v(i, j, k + 1);
+    }
+    return result;
+}
+
+FdmMatrixRow3 FdmLaplacianMatrix3::row(size_t i, size_t j, size_t k) const {
+    const Size3 n = markers.size();
+
+    FdmMatrixRow3 result;
+    result.center = diagonal(i, j, k);
+    if (markers(i, j, k) == kFluid) {
+        if (i + 1 < n.x && markers(i + 1, j, k) == kFluid) {
+            result.right = -invHSqr.x;
+        }
+        if (j + 1 < n.y && markers(i, j + 1, k) == kFluid) {
+            result.up = -invHSqr.y;
+        }
+        if (k + 1 < n.z && markers(i, j, k + 1) == kFluid) {
+            result.front = -invHSqr.z;
+        }
+    }
+    return result;
+}
+
+void FdmLaplacianMatrix3::assemble(FdmMatrix3* result) const {
+    result->resize(size());
+    result->parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        (*result)(i, j, k) = row(i, j, k);
+    });
+}
+
+//
+
+void FdmMatrixFreeLinearSystem3::clear() {
+    A.clear();
+    x.clear();
+    b.clear();
+}
+
+void FdmMatrixFreeLinearSystem3::resize(const Size3& size) {
+    A.resize(size);
+    x.resize(size);
+    b.resize(size);
+}
+
+//
+
+void FdmMatrixFreeBlas3::set(double s, FdmVector3* result) {
+    FdmBlas3::set(s, result);
+}
+
+void FdmMatrixFreeBlas3::set(const FdmVector3& v, FdmVector3* result) {
+    FdmBlas3::set(v, result);
+}
+
+void FdmMatrixFreeBlas3::set(const FdmLaplacianMatrix3& m,
+                             FdmLaplacianMatrix3* result) {
+    *result = m;
+}
+
+double FdmMatrixFreeBlas3::dot(const FdmVector3& a, const FdmVector3& b) {
+    return FdmBlas3::dot(a, b);
+}
+
+void FdmMatrixFreeBlas3::axpy(double a, const FdmVector3& x,
+                              const FdmVector3& y, FdmVector3* result) {
+    FdmBlas3::axpy(a, x, y, result);
+}
+
+void FdmMatrixFreeBlas3::mvm(const FdmLaplacianMatrix3& m, const FdmVector3& v,
+                             FdmVector3* result) {
+    JET_THROW_INVALID_ARG_IF(m.size() != v.size());
+    JET_THROW_INVALID_ARG_IF(m.size() != result->size());
+
+    const LaplacianRowSweeper sweeper(m, v);
+    double* out = result->data();
+    parallelRangeFor(kZeroSize, sweeper.numberOfCells(),
+                     [&](size_t begin, size_t end) {
+                         sweeper.sweep(begin, end, [&](size_t i, double av) {
+                             out[i] = av;
+                         });
+                     });
+}
+
+void FdmMatrixFreeBlas3::residual(const FdmLaplacianMatrix3& a,
+                                  const FdmVector3& x, const FdmVector3& b,
+                                  FdmVector3* result) {
+    JET_THROW_INVALID_ARG_IF(a.size() != x.size());
+    JET_THROW_INVALID_ARG_IF(a.size() != b.size());
+    JET_THROW_INVALID_ARG_IF(a.size() != result->size());
+
+    const LaplacianRowSweeper sweeper(a, x);
+    const double* rhs = b.data();
+    double* out = result->data();
+    parallelRangeFor(kZeroSize, sweeper.numberOfCells(),
+                     [&](size_t begin, size_t end) {
+                         sweeper.sweep(begin, end, [&](size_t i, double ax) {
+                             out[i] = rhs[i] - ax;
+                         });
+                     });
+}
+
+double FdmMatrixFreeBlas3::l2Norm(const FdmVector3& v) {
+    return FdmBlas3::l2Norm(v);
+}
+
+double FdmMatrixFreeBlas3::lInfNorm(const FdmVector3& v) {
+    return FdmBlas3::lInfNorm(v);
+}
+
+double FdmMatrixFreeBlas3::mvmDot(const FdmLaplacianMatrix3& m,
+                                  const FdmVector3& v, FdmVector3* result) {
+    JET_THROW_INVALID_ARG_IF(m.size() != v.size());
+    JET_THROW_INVALID_ARG_IF(m.size() != result->size());
+
+    const LaplacianRowSweeper sweeper(m, v);
+    const double* in = v.data();
+    double* out = result->data();
+    return parallelDeterministicReduce(
+        kZeroSize, sweeper.numberOfCells(), 0.0,
+        [&](size_t begin, size_t end, double sum) {
+            sweeper.sweep(begin, end, [&](size_t i, double av) {
+                out[i] = av;
+                sum += in[i] * av;
+            });
+            return sum;
+        },
+        [](double a, double b) { return a + b; });
+}
+
+void FdmMatrixFreeBlas3::pipelinedCgUpdate(double alpha, double beta,
+                                           const FdmVector3& q, FdmVector3* z,
+                                           FdmVector3* s, FdmVector3* p,
+                                           FdmVector3* x, FdmVector3* r,
+                                           FdmVector3* w, double* rDotR,
+                                           double* wDotR) {
+    FdmBlas3::pipelinedCgUpdate(alpha, beta, q, z, s, p, x, r, w, rDotR,
+                                wDotR);
+}
@@ -40,7 +40,36 @@ void FdmMgLinearSystem3::resizeWithFinest(const Size3 &finestResolution,
                                        &b.levels);
 }
 
-void FdmMgUtils3::restrict(const FdmVector3 &finer, FdmVector3 *coarser) {
+//
+
+void FdmMgMatrixFreeLinearSystem3::clear() {
+    A.levels.clear();
+    x.levels.clear();
+    b.levels.clear();
+}
+
+size_t FdmMgMatrixFreeLinearSystem3::numberOfLevels() const {
+    return A.levels.size();
+}
+
+void FdmMgMatrixFreeLinearSystem3::resizeWithFinest(
+    const Size3 &finestResolution, size_t maxNumberOfLevels) {
+    FdmMgUtils3::resizeArrayWithFinest(finestResolution, maxNumberOfLevels,
+                                       &x.levels);
+    FdmMgUtils3::resizeArrayWithFinest(finestResolution, maxNumberOfLevels,
+                                       &b.levels);
+
+    A.levels.resize(x.levels.size());
+    for (size_t l = 0; l < A.levels.size(); ++l) {
+        A.levels[l].resize(x.levels[l].size());
+    }
+}
+
+namespace {
+
+// The kernels are evaluated in double precision for either value type
+template <typename T>
+void restrictLevel(const Array3<T> &finer, Array3<T> *coarser) {
     JET_ASSERT(finer.size().x == 2 * coarser->size().x);
     JET_ASSERT(finer.size().y == 2 * coarser->size().y);
     JET_ASSERT(finer.size().z == 2 * coarser->size().z);
@@ -90,14 +119,15 @@ void FdmMgUtils3::restrict(const FdmVector3 &finer, FdmVector3 *coarser) {
                                 }
                             }
                         }
-                        (*coarser)(i, j, k) = sum;
+                        (*coarser)(i, j, k) = static_cast<T>(sum);
                     }
                 }
             }
         });
 }
 
-void FdmMgUtils3::correct(const FdmVector3 &coarser, FdmVector3 *finer) {
+template <typename T>
+void correctLevel(const Array3<T> &coarser, Array3<T> *finer) {
     JET_ASSERT(finer->size().x == 2 * coarser.size().x);
     JET_ASSERT(finer->size().y == 2 * coarser.size().y);
     JET_ASSERT(finer->size().z == 2 * coarser.size().z);
@@ -168,7 +198,7 @@ void FdmMgUtils3::correct(const FdmVector3 &coarser, FdmVector3 *finer) {
                                                kWeights[z] *
                                                coarser(iIndices[x], jIndices[y],
                                                        kIndices[z]);
-                                    (*finer)(i, j, k) += w;
+                                    (*finer)(i, j, k) += static_cast<T>(w);
                                 }
                             }
                         }
@@ -177,3 +207,21 @@ void FdmMgUtils3::correct(const FdmVector3 &coarser, FdmVector3 *finer) {
             }
         });
 }
+
+}  // namespace
+
+void FdmMgUtils3::restrict(const FdmVector3 &finer, FdmVector3 *coarser) {
+    restrictLevel(finer, coarser);
+}
+
+void FdmMgUtils3::restrict(const FdmVector3F &finer, FdmVector3F *coarser) {
+    restrictLevel(finer, coarser);
+}
+
+void FdmMgUtils3::correct(const FdmVector3 &coarser, FdmVector3 *finer) {
+    correctLevel(coarser, finer);
+}
+
+void FdmMgUtils3::correct(const FdmVector3F &coarser, FdmVector3F *finer) {
+    correctLevel(coarser, finer);
+}
@@ -13,41 +13,66 @@
 
 using namespace jet;
 
+namespace {
+
+// V-cycle parameters with Gauss-Seidel smoothing on the levels of BlasType
+template <typename BlasType>
+MgParameters<BlasType> makeGaussSeidelParams(size_t maxNumberOfLevels,
+                                             unsigned int numberOfRestrictionIter,
+                                             unsigned int numberOfCorrectionIter,
+                                             unsigned int numberOfCoarsestIter,
+                                             unsigned int numberOfFinalIter, double maxTolerance,
+                                             double sorFactor, bool useRedBlackOrdering) {
+  typedef typename BlasType::MatrixType MatrixType;
+  typedef typename BlasType::VectorType VectorType;
+
+  MgParameters<BlasType> params;
+  params.maxNumberOfLevels = maxNumberOfLevels;
+  params.numberOfRestrictionIter = numberOfRestrictionIter;
+  params.numberOfCorrectionIter = numberOfCorrectionIter;
+  params.numberOfCoarsestIter = numberOfCoarsestIter;
+  params.numberOfFinalIter = numberOfFinalIter;
+  params.maxTolerance = maxTolerance;
+  params.relaxFunc = [sorFactor, useRedBlackOrdering](
+                         const MatrixType& A, const VectorType& b, unsigned int numberOfIterations,
+                         double maxTolerance, VectorType* x, VectorType* buffer) {
+    UNUSED_VARIABLE(buffer);
+    UNUSED_VARIABLE(maxTolerance);
+
+    for (unsigned int iter = 0; iter < numberOfIterations; ++iter) {
+      if (useRedBlackOrdering) {
+        FdmGaussSeidelSolver3::relaxRedBlack(A, b, sorFactor, x);
+      } else {
+        FdmGaussSeidelSolver3::relax(A, b, sorFactor, x);
+      }
+    }
+  };
+  params.restrictFunc = [](const VectorType& finer, VectorType* coarser) {
+    FdmMgUtils3::restrict(finer, coarser);
+  };
+  params.correctFunc = [](const VectorType& coarser, VectorType* finer) {
+    FdmMgUtils3::correct(coarser, finer);
+  };
+  return params;
+}
+
+}  // namespace
+
 FdmMgSolver3::FdmMgSolver3(size_t maxNumberOfLevels, unsigned int numberOfRestrictionIter,
                            unsigned int numberOfCorrectionIter, unsigned int numberOfCoarsestIter,
                            unsigned int numberOfFinalIter, double maxTolerance, double sorFactor,
                            bool useRedBlackOrdering) {
-  _mgParams.maxNumberOfLevels = maxNumberOfLevels;
-  _mgParams.numberOfRestrictionIter = numberOfRestrictionIter;
-  _mgParams.numberOfCorrectionIter = numberOfCorrectionIter;
-  _mgParams.numberOfCoarsestIter = numberOfCoarsestIter;
-  _mgParams.numberOfFinalIter = numberOfFinalIter;
-  _mgParams.maxTolerance = maxTolerance;
-  if (useRedBlackOrdering) {
-    _mgParams.relaxFunc = [sorFactor](const FdmMatrix3& A, const FdmVector3& b,
-                                      unsigned int numberOfIterations, double maxTolerance,
-                                      FdmVector3* x, FdmVector3* buffer) {
-      UNUSED_VARIABLE(buffer);
-      UNUSED_VARIABLE(maxTolerance);
-
-      for (unsigned int iter = 0; iter < numberOfIterations; ++iter) {
-        FdmGaussSeidelSolver3::relaxRedBlack(A, b, sorFactor, x);
-      }
-    };
-  } else {
-    _mgParams.relaxFunc = [sorFactor](const FdmMatrix3& A, const FdmVector3& b,
-                                      unsigned int numberOfIterations, double maxTolerance,
-                                      FdmVector3* x, FdmVector3* buffer) {
-      UNUSED_VARIABLE(buffer);
-      UNUSED_VARIABLE(maxTolerance);
-
-      for (unsigned int iter = 0; iter < numberOfIterations; ++iter) {
-        FdmGaussSeidelSolver3::relax(A, b, sorFactor, x);
-      }
-    };
-  }
-  _mgParams.restrictFunc = FdmMgUtils3::restrict;
-  _mgParams.correctFunc = FdmMgUtils3::correct;
+  _mgParams = makeGaussSeidelParams<FdmBlas3>(
+      maxNumberOfLevels, numberOfRestrictionIter, numberOfCorrectionIter, numberOfCoarsestIter,
+      numberOfFinalIter, maxTolerance, sorFactor, useRedBlackOrdering);
+
+  // Same cycle on matrix-free and single precision levels
+  _mgMatrixFreeParams = makeGaussSeidelParams<FdmMatrixFreeBlas3>(
+      maxNumberOfLevels, numberOfRestrictionIter, numberOfCorrectionIter, numberOfCoarsestIter,
+      numberOfFinalIter, maxTolerance, sorFactor, useRedBlackOrdering);
+  _mgSinglePrecisionParams = makeGaussSeidelParams<FdmBlas3F>(
+      maxNumberOfLevels, numberOfRestrictionIter, numberOfCorrectionIter, numberOfCoarsestIter,
+      numberOfFinalIter, maxTolerance, sorFactor, useRedBlackOrdering);
 
   _sorFactor = sorFactor;
   _useRedBlackOrdering = useRedBlackOrdering;
@@ -55,6 +80,14 @@ FdmMgSolver3::FdmMgSolver3(size_t maxNumberOfLevels, unsigned int numberOfRestri
 
 const MgParameters<FdmBlas3>& FdmMgSolver3::params() const { return _mgParams; }
 
+const MgParameters<FdmMatrixFreeBlas3>& FdmMgSolver3::matrixFreeParams() const {
+  return _mgMatrixFreeParams;
+}
+
+const MgParameters<FdmBlas3F>& FdmMgSolver3::singlePrecisionParams() const {
+  return _mgSinglePrecisionParams;
+}
+
 double FdmMgSolver3::sorFactor() const { return _sorFactor; }
 
 bool FdmMgSolver3::useRedBlackOrdering() const { return _useRedBlackOrdering; }
@@ -69,3 +102,9 @@ bool FdmMgSolver3::solve(FdmMgLinearSystem3* system) {
   auto result = mgVCycle(system->A, _mgParams, &system->x, &system->b, &buffer);
   return result.lastResidualNorm < _mgParams.maxTolerance;
 }
+
+bool FdmMgSolver3::solve(FdmMgMatrixFreeLinearSystem3* system) {
+  FdmMgMatrixFreeVector3 buffer = system->x;
+  auto result = mgVCycle(system->A, _mgMatrixFreeParams, &system->x, &system->b, &buffer);
+  return result.lastResidualNorm < _mgMatrixFreeParams.maxTolerance;
+}
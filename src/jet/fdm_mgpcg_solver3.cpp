@@ -10,31 +10,79 @@
 #include <jet/fdm_mgpcg_solver3.h>
 #include <jet/mg.h>
 
+#include <sstream>
+
 using namespace jet;
 
-void FdmMgpcgSolver3::Preconditioner::build(FdmMgLinearSystem3* system_,
-                                            MgParameters<FdmBlas3> mgParams_) {
+namespace {
+
+// Adds the level times of one V-cycle to the totals
+void accumulateLevelTimes(const MgResult& result, std::vector<double>* total) {
+    total->resize(result.levelTimesInSeconds.size(), 0.0);
+    for (size_t l = 0; l < result.levelTimesInSeconds.size(); ++l) {
+        (*total)[l] += result.levelTimesInSeconds[l];
+    }
+}
+
+}  // namespace
+
+template <typename SystemType, typename BlasType>
+void FdmMgpcgSolver3::Preconditioner<SystemType, BlasType>::build(
+    SystemType* system_, MgParameters<BlasType> mgParams_) {
     system = system_;
     mgParams = mgParams_;
+    levelTimesInSeconds.clear();
 }
 
-void FdmMgpcgSolver3::Preconditioner::solve(const FdmVector3& b,
-                                            FdmVector3* x) {
+template <typename SystemType, typename BlasType>
+void FdmMgpcgSolver3::Preconditioner<SystemType, BlasType>::solve(
+    const FdmVector3& b, FdmVector3* x) {
     // Copy dimension
-    FdmMgVector3 mgX = system->x;
-    FdmMgVector3 mgB = system->x;
-    FdmMgVector3 mgBuffer = system->x;
+    MgVector<BlasType> mgX = system->x;
+    MgVector<BlasType> mgB = system->x;
+    MgVector<BlasType> mgBuffer = system->x;
 
     // Copy input to the top
     mgX.levels.front().set(*x);
     mgB.levels.front().set(b);
 
-    mgVCycle(system->A, mgParams, &mgX, &mgB, &mgBuffer);
+    MgResult result = mgVCycle(system->A, mgParams, &mgX, &mgB, &mgBuffer);
+    accumulateLevelTimes(result, &levelTimesInSeconds);
 
     // Copy result to the output
     x->set(mgX.levels.front());
 }
 
+void FdmMgpcgSolver3::MixedPrecisionPreconditioner::build(
+    const FdmMgLinearSystem3& system, MgParameters<FdmBlas3F> mgParams_) {
+    const size_t numberOfLevels = system.numberOfLevels();
+    A.levels.resize(numberOfLevels);
+    x.levels.resize(numberOfLevels);
+    b.levels.resize(numberOfLevels);
+    buffer.levels.resize(numberOfLevels);
+    for (size_t l = 0; l < numberOfLevels; ++l) {
+        const Size3 size = system.A.levels[l].size();
+        FdmBlas3F::set(system.A.levels[l], &A.levels[l]);
+        x.levels[l].resize(size);
+        b.levels[l].resize(size);
+        buffer.levels[l].resize(size);
+    }
+
+    mgParams = mgParams_;
+    levelTimesInSeconds.clear();
+}
+
+void FdmMgpcgSolver3::MixedPrecisionPreconditioner::solve(const FdmVector3& b_,
+                                                          FdmVector3* x_) {
+    FdmBlas3F::set(*x_, &x.levels.front());
+    FdmBlas3F::set(b_, &b.levels.front());
+
+    MgResult result = mgVCycle(A, mgParams, &x, &b, &buffer);
+    accumulateLevelTimes(result, &levelTimesInSeconds);
+
+    FdmBlas3F::set(x.levels.front(), x_);
+}
+
 //
 
 FdmMgpcgSolver3::FdmMgpcgSolver3(
@@ -58,22 +106,76 @@ bool FdmMgpcgSolver3::solve(FdmMgLinearSystem3* system) {
     _q.resize(size);
     _s.resize(size);
 
-    system->x.levels.front().set(0.0);
+    if (!useInitialGuess()) {
+        system->x.levels.front().set(0.0);
+    }
     _r.set(0.0);
     _d.set(0.0);
     _q.set(0.0);
     _s.set(0.0);
 
-    _precond.build(system, params());
+    if (_useMixedPrecision) {
+        _mixedPrecisionPrecond.build(*system, singlePrecisionParams());
+
+        pcg<FdmBlas3, MixedPrecisionPreconditioner>(
+            system->A.levels.front(), system->b.levels.front(),
+            _maxNumberOfIterations, _tolerance, &_mixedPrecisionPrecond,
+            &system->x.levels.front(), &_r, &_d, &_q, &_s,
+            &_lastNumberOfIterations, &_lastResidualNorm);
 
-    pcg<FdmBlas3, Preconditioner>(system->A.levels.front(),
-                                  system->b.levels.front(),
-                                  _maxNumberOfIterations, _tolerance, &_precond,
-                                  &system->x.levels.front(), &_r, &_d, &_q, &_s,
-                                  &_lastNumberOfIterations, &_lastResidualNorm);
+        _lastLevelTimesInSeconds = _mixedPrecisionPrecond.levelTimesInSeconds;
+    } else {
+        _precond.build(system, params());
 
-    JET_INFO << "Residual after solving MGPCG: " << _lastResidualNorm
+        pcg<FdmBlas3, Preconditioner<FdmMgLinearSystem3, FdmBlas3>>(
+            system->A.levels.front(), system->b.levels.front(),
+            _maxNumberOfIterations, _tolerance, &_precond,
+            &system->x.levels.front(), &_r, &_d, &_q, &_s,
+            &_lastNumberOfIterations, &_lastResidualNorm);
+
+        _lastLevelTimesInSeconds = _precond.levelTimesInSeconds;
+    }
+
+    JET_INFO << "Residual after solving "
+             << (_useMixedPrecision ? "mixed-precision " : "")
+             << "MGPCG: " << _lastResidualNorm
              << " Number of MGPCG iterations: " << _lastNumberOfIterations;
+    logLevelTimes();
+
+    return _lastResidualNorm <= _tolerance ||
+           _lastNumberOfIterations < _maxNumberOfIterations;
+}
+
+bool FdmMgpcgSolver3::solve(FdmMgMatrixFreeLinearSystem3* system) {
+    Size3 size = system->A.levels.front().size();
+    _r.resize(size);
+    _d.resize(size);
+    _q.resize(size);
+    _s.resize(size);
+
+    if (!useInitialGuess()) {
+        system->x.levels.front().set(0.0);
+    }
+    _r.set(0.0);
+    _d.set(0.0);
+    _q.set(0.0);
+    _s.set(0.0);
+
+    _matrixFreePrecond.build(system, matrixFreeParams());
+
+    pcg<FdmMatrixFreeBlas3,
+        Preconditioner<FdmMgMatrixFreeLinearSystem3, FdmMatrixFreeBlas3>>(
+        system->A.levels.front(), system->b.levels.front(),
+        _maxNumberOfIterations, _tolerance, &_matrixFreePrecond,
+        &system->x.levels.front(), &_r, &_d, &_q, &_s,
+        &_lastNumberOfIterations, &_lastResidualNorm);
+
+    _lastLevelTimesInSeconds = _matrixFreePrecond.levelTimesInSeconds;
+
+    JET_INFO << "Residual after solving matrix-free MGPCG: "
+             << _lastResidualNorm
+             << " Number of MGPCG iterations: " << _lastNumberOfIterations;
+    logLevelTimes();
 
     return _lastResidualNorm <= _tolerance ||
            _lastNumberOfIterations < _maxNumberOfIterations;
@@ -90,3 +192,21 @@ unsigned int FdmMgpcgSolver3::lastNumberOfIterations() const {
 double FdmMgpcgSolver3::tolerance() const { return _tolerance; }
 
 double FdmMgpcgSolver3::lastResidual() const { return _lastResidualNorm; }
+
+bool FdmMgpcgSolver3::useMixedPrecision() const { return _useMixedPrecision; }
+
+void FdmMgpcgSolver3::setUseMixedPrecision(bool useMixedPrecision) {
+    _useMixedPrecision = useMixedPrecision;
+}
+
+const std::vector<double>& FdmMgpcgSolver3::lastLevelTimesInSeconds() const {
+    return _lastLevelTimesInSeconds;
+}
+
+void FdmMgpcgSolver3::logLevelTimes() const {
+    std::ostringstream stream;
+    for (size_t l = 0; l < _lastLevelTimesInSeconds.size(); ++l) {
+        stream << " L" << l << ": " << _lastLevelTimesInSeconds[l] << "s";
+    }
+    JET_INFO << "MGPCG preconditioner time per level:" << stream.str();
+}
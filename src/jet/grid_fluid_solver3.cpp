@@ -15,6 +15,7 @@
 #include <jet/grid_fluid_solver3.h>
 #include <jet/grid_fractional_single_phase_pressure_solver3.h>
 #include <jet/level_set_utils.h>
+#include <jet/parallel.h>
 #include <jet/surface_to_implicit3.h>
 #include <jet/timer.h>
 
@@ -51,12 +52,16 @@ void GridFluidSolver3::setViscosityCoefficient(double newValue) {
 
 double GridFluidSolver3::cfl(double timeIntervalInSeconds) const {
   auto vel = _grids->velocity();
-  double maxVel = 0.0;
-  vel->forEachCellIndex([&](size_t i, size_t j, size_t k) {
-    Vector3D v = vel->valueAtCellCenter(i, j, k) + timeIntervalInSeconds * _gravity;
-    maxVel = std::max(maxVel, v.x);
-    maxVel = std::max(maxVel, v.y);
-    maxVel = std::max(maxVel, v.z);
+  const Size3 res = vel->resolution();
+  double maxVel = parallelMax(kZeroSize, res.z, 0.0, [&](size_t k) {
+    double result = 0.0;
+    for (size_t j = 0; j < res.y; ++j) {
+      for (size_t i = 0; i < res.x; ++i) {
+        Vector3D v = vel->valueAtCellCenter(i, j, k) + timeIntervalInSeconds * _gravity;
+        result = std::max(result, max3(v.x, v.y, v.z));
+      }
+    }
+    return result;
   });
 
   Vector3D gridSpacing = _grids->gridSpacing();
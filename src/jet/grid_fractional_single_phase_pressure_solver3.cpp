@@ -18,6 +18,10 @@
 #include <jet/grid_fractional_boundary_condition_solver3.h>
 #include <jet/grid_fractional_single_phase_pressure_solver3.h>
 #include <jet/level_set_utils.h>
+#include <jet/parallel.h>
+
+#include <algorithm>
+#include <numeric>
 
 using namespace jet;
 
@@ -443,6 +447,41 @@ void buildSingleSystem(MatrixCsrD* A, VectorND* x, VectorND* b,
     x->resize(b->size(), 0.0);
 }
 
+// Calls func(ii, jj, kk) for the fluid neighbors of (i, j, k) in ascending
+// order of their linear index, which is also the order of their rows in the
+// compressed system
+template <typename Callback>
+void forEachFluidNeighbor(const Array3<char>& isFluid, size_t i, size_t j,
+                          size_t k, const Callback& func) {
+    const Size3 size = isFluid.size();
+    if (k > 0 && isFluid(i, j, k - 1)) {
+        func(i, j, k - 1);
+    }
+    if (j > 0 && isFluid(i, j - 1, k)) {
+        func(i, j - 1, k);
+    }
+    if (i > 0 && isFluid(i - 1, j, k)) {
+        func(i - 1, j, k);
+    }
+    if (i + 1 < size.x && isFluid(i + 1, j, k)) {
+        func(i + 1, j, k);
+    }
+    if (j + 1 < size.y && isFluid(i, j + 1, k)) {
+        func(i, j + 1, k);
+    }
+    if (k + 1 < size.z && isFluid(i, j, k + 1)) {
+        func(i, j, k + 1);
+    }
+}
+
+size_t numberOfFluidNeighbors(const Array3<char>& isFluid, size_t i, size_t j,
+                              size_t k) {
+    size_t count = 0;
+    forEachFluidNeighbor(isFluid, i, j, k,
+                         [&](size_t, size_t, size_t) { ++count; });
+    return count;
+}
+
 }  // namespace
 
 GridFractionalSinglePhasePressureSolver3::
@@ -458,12 +497,18 @@ void GridFractionalSinglePhasePressureSolver3::solve(
     FaceCenteredGrid3* output, const ScalarField3& boundarySdf,
     const VectorField3& boundaryVelocity, const ScalarField3& fluidSdf,
     bool useCompressed) {
-    UNUSED_VARIABLE(timeIntervalInSeconds);
-
     buildWeights(input, boundarySdf, boundaryVelocity, fluidSdf);
     buildSystem(input, useCompressed);
 
     if (_systemSolver != nullptr) {
+        // Only force the initial guess for the warm start. The caller's
+        // setting is restored when the guard goes out of scope, also if the
+        // solve throws.
+        ScopedInitialGuess3 initialGuess(_systemSolver.get(), _useWarmStart);
+        if (_useWarmStart) {
+            buildInitialGuess(timeIntervalInSeconds, useCompressed);
+        }
+
         // Solve the system
         if (_mgSystemSolver == nullptr) {
             if (useCompressed) {
@@ -480,6 +525,15 @@ void GridFractionalSinglePhasePressureSolver3::solve(
 
         // Apply pressure gradient
         applyPressureGradient(input, output);
+
+        if (_useWarmStart) {
+            const auto& phi = _fluidSdf[0];
+            _warmStart.save(pressure(),
+                            [&](size_t i, size_t j, size_t k) {
+                                return isInsideSdf(phi(i, j, k));
+                            },
+                            timeIntervalInSeconds);
+        }
     }
 }
 
@@ -517,6 +571,43 @@ const FdmVector3& GridFractionalSinglePhasePressureSolver3::pressure() const {
     }
 }
 
+bool GridFractionalSinglePhasePressureSolver3::useWarmStart() const {
+    return _useWarmStart;
+}
+
+void GridFractionalSinglePhasePressureSolver3::setUseWarmStart(
+    bool useWarmStart) {
+    _useWarmStart = useWarmStart;
+    if (!_useWarmStart) {
+        _warmStart.clear();
+    }
+}
+
+unsigned int GridFractionalSinglePhasePressureSolver3::lastNumberOfIterations()
+    const {
+    return (_systemSolver != nullptr) ? _systemSolver->lastNumberOfIterations()
+                                      : 0;
+}
+
+bool GridFractionalSinglePhasePressureSolver3::useCompressedPatternCache()
+    const {
+    return _useCompressedPatternCache;
+}
+
+void GridFractionalSinglePhasePressureSolver3::setUseCompressedPatternCache(
+    bool useCache) {
+    _useCompressedPatternCache = useCache;
+    if (!_useCompressedPatternCache) {
+        _compressedFluidMask.clear();
+        _coordToIndex.clear();
+    }
+}
+
+bool GridFractionalSinglePhasePressureSolver3::isCompressedPatternReused()
+    const {
+    return _isCompressedPatternReused;
+}
+
 void GridFractionalSinglePhasePressureSolver3::buildWeights(
     const FaceCenteredGrid3& input, const ScalarField3& boundarySdf,
     const VectorField3& boundaryVelocity, const ScalarField3& fluidSdf) {
@@ -648,6 +739,24 @@ void GridFractionalSinglePhasePressureSolver3::decompressSolution() {
     });
 }
 
+void GridFractionalSinglePhasePressureSolver3::buildInitialGuess(
+    double timeIntervalInSeconds, bool useCompressed) {
+    const auto& phi = _fluidSdf[0];
+    const auto isFluid = [&](size_t i, size_t j, size_t k) {
+        return isInsideSdf(phi(i, j, k));
+    };
+
+    if (_mgSystemSolver != nullptr) {
+        _warmStart.initialGuess(isFluid, timeIntervalInSeconds,
+                                &_mgSystem.x.levels.front());
+    } else if (useCompressed) {
+        _warmStart.initialGuess(phi.size(), isFluid, timeIntervalInSeconds,
+                                &_compSystem.x);
+    } else {
+        _warmStart.initialGuess(isFluid, timeIntervalInSeconds, &_system.x);
+    }
+}
+
 void GridFractionalSinglePhasePressureSolver3::buildSystem(
     const FaceCenteredGrid3& input, bool useCompressed) {
     Size3 size = input.resolution();
@@ -673,7 +782,9 @@ void GridFractionalSinglePhasePressureSolver3::buildSystem(
     // Build top level
     const FaceCenteredGrid3* finer = &input;
     if (_mgSystemSolver == nullptr) {
-        if (useCompressed) {
+        if (useCompressed && _useCompressedPatternCache) {
+            buildCompressedSystem(*finer);
+        } else if (useCompressed) {
             buildSingleSystem(&_compSystem.A, &_compSystem.x, &_compSystem.b,
                               _fluidSdf[0], _uWeights[0], _vWeights[0],
                               _wWeights[0], _boundaryVel, *finer);
@@ -712,6 +823,251 @@ void GridFractionalSinglePhasePressureSolver3::buildSystem(
     }
 }
 
+void GridFractionalSinglePhasePressureSolver3::buildCompressedSystem(
+    const FaceCenteredGrid3& input) {
+    const Array3<float>& fluidSdf = _fluidSdf[0];
+    const Array3<float>& uWeights = _uWeights[0];
+    const Array3<float>& vWeights = _vWeights[0];
+    const Array3<float>& wWeights = _wWeights[0];
+    const Size3 size = fluidSdf.size();
+
+    // The pattern only depends on which cells are fluid
+    Array3<char> isFluid(size);
+    isFluid.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        isFluid(i, j, k) = isInsideSdf(fluidSdf(i, j, k)) ? 1 : 0;
+    });
+
+    _isCompressedPatternReused =
+        _compSystem.A.rows() > 0 && _compressedFluidMask.size() == size &&
+        std::equal(isFluid.data(), isFluid.data() + size.x * size.y * size.z,
+                   _compressedFluidMask.data());
+    if (!_isCompressedPatternReused) {
+        _compressedFluidMask.swap(isFluid);
+        buildCompressedPattern();
+    }
+
+    // Fill the values in the same order as the serial build
+    MatrixCsrD& A = _compSystem.A;
+    VectorND& b = _compSystem.b;
+    const size_t numberOfRows = A.rows();
+    b.resize(numberOfRows);
+    _compSystem.x.resize(numberOfRows, 0.0);
+
+    const auto uPos = input.uPosition();
+    const auto vPos = input.vPosition();
+    const auto wPos = input.wPosition();
+    const Vector3D invH = 1.0 / input.gridSpacing();
+    const Vector3D invHSqr = invH * invH;
+    const auto rp = A.rowPointersBegin();
+    auto nnz = A.nonZeroBegin();
+
+    parallelFor(kZeroSize, size.y * size.z, [&](size_t xRow) {
+        const size_t j = xRow % size.y;
+        const size_t k = xRow / size.y;
+        for (size_t i = 0; i < size.x; ++i) {
+            if (!_compressedFluidMask(i, j, k)) {
+                continue;
+            }
+
+            const double centerPhi = fluidSdf(i, j, k);
+            double center = 0.0;
+            double bijk = 0.0;
+
+            // Off-diagonals of the neighbors, indexed like Array3
+            double right = 0.0, left = 0.0, up = 0.0, down = 0.0;
+            double front = 0.0, back = 0.0;
+
+            // Adds the face between this cell and a neighbor that exists
+            const auto addFace = [&](double term, double neighborPhi,
+                                     double* offDiagonal) {
+                if (isInsideSdf(neighborPhi)) {
+                    center += term;
+                    *offDiagonal = -term;
+                } else {
+                    double theta = fractionInsideSdf(centerPhi, neighborPhi);
+                    theta = std::max(theta, 0.01);
+                    center += term / theta;
+                }
+            };
+
+            if (i + 1 < size.x) {
+                addFace(uWeights(i + 1, j, k) * invHSqr.x,
+                        fluidSdf(i + 1, j, k), &right);
+                bijk += uWeights(i + 1, j, k) * input.u(i + 1, j, k) * invH.x;
+            } else {
+                bijk += input.u(i + 1, j, k) * invH.x;
+            }
+
+            if (i > 0) {
+                addFace(uWeights(i, j, k) * invHSqr.x, fluidSdf(i - 1, j, k),
+                        &left);
+                bijk -= uWeights(i, j, k) * input.u(i, j, k) * invH.x;
+            } else {
+                bijk -= input.u(i, j, k) * invH.x;
+            }
+
+            if (j + 1 < size.y) {
+                addFace(vWeights(i, j + 1, k) * invHSqr.y,
+                        fluidSdf(i, j + 1, k), &up);
+                bijk += vWeights(i, j + 1, k) * input.v(i, j + 1, k) * invH.y;
+            } else {
+                bijk += input.v(i, j + 1, k) * invH.y;
+            }
+
+            if (j > 0) {
+                addFace(vWeights(i, j, k) * invHSqr.y, fluidSdf(i, j - 1, k),
+                        &down);
+                bijk -= vWeights(i, j, k) * input.v(i, j, k) * invH.y;
+            } else {
+                bijk -= input.v(i, j, k) * invH.y;
+            }
+
+            if (k + 1 < size.z) {
+                addFace(wWeights(i, j, k + 1) * invHSqr.z,
+                        fluidSdf(i, j, k + 1), &front);
+                bijk += wWeights(i, j, k + 1) * input.w(i, j, k + 1) * invH.z;
+            } else {
+                bijk += input.w(i, j, k + 1) * invH.z;
+            }
+
+            if (k > 0) {
+                addFace(wWeights(i, j, k) * invHSqr.z, fluidSdf(i, j, k - 1),
+                        &back);
+                bijk -= wWeights(i, j, k) * input.w(i, j, k) * invH.z;
+            } else {
+                bijk -= input.w(i, j, k) * invH.z;
+            }
+
+            // Accumulate contributions from the moving boundary
+            double boundaryContribution =
+                (1.0 - uWeights(i + 1, j, k)) *
+                    _boundaryVel(uPos(i + 1, j, k)).x * invH.x -
+                (1.0 - uWeights(i, j, k)) * _boundaryVel(uPos(i, j, k)).x *
+                    invH.x +
+                (1.0 - vWeights(i, j + 1, k)) *
+                    _boundaryVel(vPos(i, j + 1, k)).y * invH.y -
+                (1.0 - vWeights(i, j, k)) * _boundaryVel(vPos(i, j, k)).y *
+                    invH.y +
+                (1.0 - wWeights(i, j, k + 1)) *
+                    _boundaryVel(wPos(i, j, k + 1)).z * invH.z -
+                (1.0 - wWeights(i, j, k)) * _boundaryVel(wPos(i, j, k)).z *
+                    invH.z;
+            bijk += boundaryContribution;
+
+            // If the center is near-zero, the cell is likely inside a solid
+            // boundary.
+            if (center < kEpsilonD) {
+                center = 1.0;
+                bijk = 0.0;
+            }
+
+            // Same column order as buildCompressedPattern
+            const size_t row = _coordToIndex(i, j, k);
+            size_t p = rp[row];
+            if (k > 0 && _compressedFluidMask(i, j, k - 1)) {
+                nnz[p++] = back;
+            }
+            if (j > 0 && _compressedFluidMask(i, j - 1, k)) {
+                nnz[p++] = down;
+            }
+            if (i > 0 && _compressedFluidMask(i - 1, j, k)) {
+                nnz[p++] = left;
+            }
+            nnz[p++] = center;
+            if (i + 1 < size.x && _compressedFluidMask(i + 1, j, k)) {
+                nnz[p++] = right;
+            }
+            if (j + 1 < size.y && _compressedFluidMask(i, j + 1, k)) {
+                nnz[p++] = up;
+            }
+            if (k + 1 < size.z && _compressedFluidMask(i, j, k + 1)) {
+                nnz[p++] = front;
+            }
+            JET_ASSERT(p == rp[row + 1]);
+            b[row] = bijk;
+        }
+    });
+}
+
+void GridFractionalSinglePhasePressureSolver3::buildCompressedPattern() {
+    const Array3<char>& isFluid = _compressedFluidMask;
+    const Size3 size = isFluid.size();
+    const size_t numberOfXRows = size.y * size.z;
+
+    // Count the fluid cells and non-zeros of every x-row, then number the
+    // rows with an exclusive prefix sum over the x-rows
+    std::vector<size_t> rowOffsets(numberOfXRows + 1, 0);
+    std::vector<size_t> nonZeroOffsets(numberOfXRows + 1, 0);
+    parallelFor(kZeroSize, numberOfXRows, [&](size_t xRow) {
+        const size_t j = xRow % size.y;
+        const size_t k = xRow / size.y;
+        size_t numberOfCells = 0;
+        size_t numberOfNonZeros = 0;
+        for (size_t i = 0; i < size.x; ++i) {
+            if (isFluid(i, j, k)) {
+                ++numberOfCells;
+                numberOfNonZeros +=
+                    1 + numberOfFluidNeighbors(isFluid, i, j, k);
+            }
+        }
+        rowOffsets[xRow + 1] = numberOfCells;
+        nonZeroOffsets[xRow + 1] = numberOfNonZeros;
+    });
+    std::partial_sum(rowOffsets.begin(), rowOffsets.end(), rowOffsets.begin());
+    std::partial_sum(nonZeroOffsets.begin(), nonZeroOffsets.end(),
+                     nonZeroOffsets.begin());
+
+    const size_t numberOfRows = rowOffsets.back();
+    MatrixCsrD& A = _compSystem.A;
+    A.reserve(numberOfRows, numberOfRows, nonZeroOffsets.back());
+    _coordToIndex.resize(size);
+
+    auto rp = A.rowPointersBegin();
+    parallelFor(kZeroSize, numberOfXRows, [&](size_t xRow) {
+        const size_t j = xRow % size.y;
+        const size_t k = xRow / size.y;
+        size_t row = rowOffsets[xRow];
+        size_t pointer = nonZeroOffsets[xRow];
+        for (size_t i = 0; i < size.x; ++i) {
+            if (isFluid(i, j, k)) {
+                _coordToIndex(i, j, k) = row;
+                rp[row] = pointer;
+                pointer += 1 + numberOfFluidNeighbors(isFluid, i, j, k);
+                ++row;
+            }
+        }
+    });
+    rp[numberOfRows] = nonZeroOffsets.back();
+
+    // Columns in ascending order, like MatrixCsr::addRow sorts them
+    auto ci = A.columnIndicesBegin();
+    parallelFor(kZeroSize, numberOfXRows, [&](size_t xRow) {
+        const size_t j = xRow % size.y;
+        const size_t k = xRow / size.y;
+        for (size_t i = 0; i < size.x; ++i) {
+            if (!isFluid(i, j, k)) {
+                continue;
+            }
+
+            const size_t row = _coordToIndex(i, j, k);
+            size_t p = rp[row];
+            bool isDiagonalAdded = false;
+            forEachFluidNeighbor(
+                isFluid, i, j, k, [&](size_t ii, size_t jj, size_t kk) {
+                    const size_t col = _coordToIndex(ii, jj, kk);
+                    if (!isDiagonalAdded && col > row) {
+                        ci[p++] = row;
+                        isDiagonalAdded = true;
+                    }
+                    ci[p++] = col;
+                });
+            if (!isDiagonalAdded) {
+                ci[p++] = row;
+            }
+        }
+    });
+}
+
 void GridFractionalSinglePhasePressureSolver3::applyPressureGradient(
     const FaceCenteredGrid3& input, FaceCenteredGrid3* output) {
     Size3 size = input.resolution();
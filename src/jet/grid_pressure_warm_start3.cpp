@@ -0,0 +1,121 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#include <pch.h>
+
+#include <jet/grid_pressure_warm_start3.h>
+
+using namespace jet;
+
+void GridPressureWarmStart3::clear() {
+    _pressure.clear();
+    _isFluid.clear();
+    _timeIntervalInSeconds = 0.0;
+}
+
+void GridPressureWarmStart3::save(const FdmVector3& pressure,
+                                  const FluidPredicate& isFluid,
+                                  double timeIntervalInSeconds) {
+    _pressure.set(pressure);
+    _isFluid.resize(pressure.size());
+    _isFluid.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        _isFluid(i, j, k) = isFluid(i, j, k) ? 1 : 0;
+    });
+    _timeIntervalInSeconds = timeIntervalInSeconds;
+}
+
+void GridPressureWarmStart3::initialGuess(const FluidPredicate& isFluid,
+                                          double timeIntervalInSeconds,
+                                          FdmVector3* result) const {
+    if (_pressure.size() != result->size()) {
+        result->set(0.0);
+        return;
+    }
+
+    const double scale = (_timeIntervalInSeconds > 0.0)
+                             ? timeIntervalInSeconds / _timeIntervalInSeconds
+                             : 1.0;
+    result->parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+        (*result)(i, j, k) = remap(isFluid, scale, i, j, k);
+    });
+}
+
+void GridPressureWarmStart3::initialGuess(const Size3& size,
+                                          const FluidPredicate& isFluid,
+                                          double timeIntervalInSeconds,
+                                          VectorND* result) const {
+    if (_pressure.size() != size) {
+        result->set(0.0);
+        return;
+    }
+
+    const double scale = (_timeIntervalInSeconds > 0.0)
+                             ? timeIntervalInSeconds / _timeIntervalInSeconds
+                             : 1.0;
+    size_t row = 0;
+    _pressure.forEachIndex([&](size_t i, size_t j, size_t k) {
+        if (isFluid(i, j, k)) {
+            JET_ASSERT(row < result->size());
+            (*result)[row] = remap(isFluid, scale, i, j, k);
+            ++row;
+        }
+    });
+}
+
+double GridPressureWarmStart3::remap(const FluidPredicate& isFluid,
+                                     double scale, size_t i, size_t j,
+                                     size_t k) const {
+    if (!isFluid(i, j, k)) {
+        return 0.0;
+    }
+
+    if (_isFluid(i, j, k)) {
+        return scale * _pressure(i, j, k);
+    }
+
+    // Newly filled cell: extrapolate from the neighbors that were fluid
+    const Size3 size = _pressure.size();
+    double sum = 0.0;
+    int count = 0;
+    auto add = [&](size_t ii, size_t jj, size_t kk) {
+        if (_isFluid(ii, jj, kk)) {
+            sum += _pressure(ii, jj, kk);
+            ++count;
+        }
+    };
+    if (i > 0) {
+        add(i - 1, j, k);
+    }
+    if (i + 1 < size.x) {
+        add(i + 1, j, k);
+    }
+    if (j > 0) {
+        add(i, j - 1, k);
+    }
+    if (j + 1 < size.y) {
+        add(i, j + 1, k);
+    }
+    if (k > 0) {
+        add(i, j, k - 1);
+    }
+    if (k + 1 < size.z) {
+        add(i, j, k + 1);
+    }
+    return (count > 0) ? scale * sum / count : 0.0;
+}
+
+ScopedInitialGuess3::ScopedInitialGuess3(FdmLinearSystemSolver3* solver,
+                                         bool isForced)
+    : _solver(solver),
+      _previousUseInitialGuess(solver->useInitialGuess()) {
+    if (isForced) {
+        _solver->setUseInitialGuess(true);
+    }
+}
+
+ScopedInitialGuess3::~ScopedInitialGuess3() {
+    _solver->setUseInitialGuess(_previousUseInitialGuess);
+}
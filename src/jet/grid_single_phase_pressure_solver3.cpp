@@ -22,6 +22,10 @@ const char kBoundary = 2;
 
 const double kDefaultTolerance = 1e-6;
 
+static_assert(kFluid == FdmLaplacianMatrix3::kFluid && kAir == FdmLaplacianMatrix3::kAir &&
+                  kBoundary == FdmLaplacianMatrix3::kBoundary,
+              "Markers are copied into FdmLaplacianMatrix3 as is");
+
 namespace {
 
 void buildSingleSystem(FdmMatrix3* A, FdmVector3* b, const Array3<char>& markers,
@@ -183,17 +187,35 @@ void GridSinglePhasePressureSolver3::solve(const FaceCenteredGrid3& input,
                                            const ScalarField3& boundarySdf,
                                            const VectorField3& boundaryVelocity,
                                            const ScalarField3& fluidSdf, bool useCompressed) {
-  UNUSED_VARIABLE(timeIntervalInSeconds);
   UNUSED_VARIABLE(boundaryVelocity);
 
+  const bool useMatrixFree = _useMatrixFree && !useCompressed;
+
   auto pos = input.cellCenterPosition();
   buildMarkers(input.resolution(), pos, boundarySdf, fluidSdf);
-  buildSystem(input, useCompressed);
+  if (useMatrixFree) {
+    buildMatrixFreeSystem(input);
+  } else {
+    _matrixFreeSystem.clear();
+    _mgMatrixFreeSystem.clear();
+    buildSystem(input, useCompressed);
+  }
 
   if (_systemSolver != nullptr) {
+    // Only force the initial guess for the warm start. The caller's setting
+    // is restored when the guard goes out of scope, also if the solve throws.
+    ScopedInitialGuess3 initialGuess(_systemSolver.get(), _useWarmStart);
+    if (_useWarmStart) {
+      buildInitialGuess(timeIntervalInSeconds, useCompressed, useMatrixFree);
+    }
+
     // Solve the system
     if (_mgSystemSolver == nullptr) {
-      if (useCompressed) {
+      if (useMatrixFree) {
+        _system.clear();
+        _compSystem.clear();
+        _systemSolver->solveMatrixFree(&_matrixFreeSystem);
+      } else if (useCompressed) {
         _system.clear();
         _systemSolver->solveCompressed(&_compSystem);
         decompressSolution();
@@ -201,12 +223,22 @@ void GridSinglePhasePressureSolver3::solve(const FaceCenteredGrid3& input,
         _compSystem.clear();
         _systemSolver->solve(&_system);
       }
+    } else if (useMatrixFree) {
+      _mgSystem.clear();
+      _mgSystemSolver->solve(&_mgMatrixFreeSystem);
     } else {
       _mgSystemSolver->solve(&_mgSystem);
     }
 
     // Apply pressure gradient
     applyPressureGradient(input, output);
+
+    if (_useWarmStart) {
+      const auto& markers = _markers[0];
+      _warmStart.save(
+          pressure(), [&](size_t i, size_t j, size_t k) { return markers(i, j, k) == kFluid; },
+          timeIntervalInSeconds);
+    }
   }
 }
 
@@ -227,21 +259,45 @@ void GridSinglePhasePressureSolver3::setLinearSystemSolver(
   if (_mgSystemSolver == nullptr) {
     // In case of non-mg system, use flat structure.
     _mgSystem.clear();
+    _mgMatrixFreeSystem.clear();
   } else {
     // In case of mg system, use multi-level structure.
     _system.clear();
     _compSystem.clear();
+    _matrixFreeSystem.clear();
   }
 }
 
 const FdmVector3& GridSinglePhasePressureSolver3::pressure() const {
+  // Only the system used by the last solve is kept
   if (_mgSystemSolver == nullptr) {
-    return _system.x;
+    return _matrixFreeSystem.x.width() > 0 ? _matrixFreeSystem.x : _system.x;
+  } else if (_mgMatrixFreeSystem.numberOfLevels() > 0) {
+    return _mgMatrixFreeSystem.x.levels.front();
   } else {
     return _mgSystem.x.levels.front();
   }
 }
 
+bool GridSinglePhasePressureSolver3::useMatrixFreeLinearSystem() const { return _useMatrixFree; }
+
+void GridSinglePhasePressureSolver3::setUseMatrixFreeLinearSystem(bool useMatrixFree) {
+  _useMatrixFree = useMatrixFree;
+}
+
+bool GridSinglePhasePressureSolver3::useWarmStart() const { return _useWarmStart; }
+
+void GridSinglePhasePressureSolver3::setUseWarmStart(bool useWarmStart) {
+  _useWarmStart = useWarmStart;
+  if (!_useWarmStart) {
+    _warmStart.clear();
+  }
+}
+
+unsigned int GridSinglePhasePressureSolver3::lastNumberOfIterations() const {
+  return (_systemSolver != nullptr) ? _systemSolver->lastNumberOfIterations() : 0;
+}
+
 void GridSinglePhasePressureSolver3::buildMarkers(
     const Size3& size, const std::function<Vector3D(size_t, size_t, size_t)>& pos,
     const ScalarField3& boundarySdf, const ScalarField3& fluidSdf) {
@@ -333,6 +389,27 @@ void GridSinglePhasePressureSolver3::decompressSolution() {
   });
 }
 
+void GridSinglePhasePressureSolver3::buildInitialGuess(double timeIntervalInSeconds,
+                                                       bool useCompressed, bool useMatrixFree) {
+  const auto& markers = _markers[0];
+  const auto isFluid = [&](size_t i, size_t j, size_t k) { return markers(i, j, k) == kFluid; };
+
+  if (_mgSystemSolver == nullptr) {
+    if (useMatrixFree) {
+      _warmStart.initialGuess(isFluid, timeIntervalInSeconds, &_matrixFreeSystem.x);
+    } else if (useCompressed) {
+      _warmStart.initialGuess(markers.size(), isFluid, timeIntervalInSeconds, &_compSystem.x);
+    } else {
+      _warmStart.initialGuess(isFluid, timeIntervalInSeconds, &_system.x);
+    }
+  } else if (useMatrixFree) {
+    _warmStart.initialGuess(isFluid, timeIntervalInSeconds,
+                            &_mgMatrixFreeSystem.x.levels.front());
+  } else {
+    _warmStart.initialGuess(isFluid, timeIntervalInSeconds, &_mgSystem.x.levels.front());
+  }
+}
+
 void GridSinglePhasePressureSolver3::buildSystem(const FaceCenteredGrid3& input,
                                                  bool useCompressed) {
   Size3 size = input.resolution();
@@ -386,6 +463,39 @@ void GridSinglePhasePressureSolver3::buildSystem(const FaceCenteredGrid3& input,
   }
 }
 
+void GridSinglePhasePressureSolver3::buildMatrixFreeSystem(const FaceCenteredGrid3& input) {
+  Size3 size = input.resolution();
+  Vector3D invH = 1.0 / input.gridSpacing();
+  Vector3D invHSqr = invH * invH;
+
+  FdmLaplacianMatrix3* finest;
+  FdmVector3* b;
+  if (_mgSystemSolver == nullptr) {
+    _matrixFreeSystem.resize(size);
+    finest = &_matrixFreeSystem.A;
+    b = &_matrixFreeSystem.b;
+  } else {
+    // Coarser levels only need the cell types; their RHS comes from restriction
+    _mgMatrixFreeSystem.resizeWithFinest(size, _mgSystemSolver->params().maxNumberOfLevels);
+    Vector3D levelInvHSqr = invHSqr;
+    for (size_t l = 1; l < _mgMatrixFreeSystem.numberOfLevels(); ++l) {
+      levelInvHSqr *= 0.25;
+      _mgMatrixFreeSystem.A.levels[l].markers.set(_markers[l]);
+      _mgMatrixFreeSystem.A.levels[l].invHSqr = levelInvHSqr;
+    }
+    finest = &_mgMatrixFreeSystem.A.levels.front();
+    b = &_mgMatrixFreeSystem.b.levels.front();
+  }
+
+  finest->markers.set(_markers[0]);
+  finest->invHSqr = invHSqr;
+
+  const auto& markers = _markers[0];
+  b->parallelForEachIndex([&](size_t i, size_t j, size_t k) {
+    (*b)(i, j, k) = (markers(i, j, k) == kFluid) ? input.divergenceAtCellCenter(i, j, k) : 0.0;
+  });
+}
+
 void GridSinglePhasePressureSolver3::applyPressureGradient(const FaceCenteredGrid3& input,
                                                            FaceCenteredGrid3* output) {
   Size3 size = input.resolution();
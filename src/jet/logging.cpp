@@ -9,13 +9,20 @@
 #include <jet/logging.h>
 #include <jet/macros.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <exception>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 namespace jet {
 
@@ -25,7 +32,8 @@ static std::ostream* infoOutStream = &std::cout;
 static std::ostream* warnOutStream = &std::cout;
 static std::ostream* errorOutStream = &std::cerr;
 static std::ostream* debugOutStream = &std::cout;
-static LoggingLevel sLoggingLevel = LoggingLevel::All;
+static std::atomic<LoggingLevel> sLoggingLevel{LoggingLevel::All};
+static std::atomic<bool> sIsAsync{false};
 
 inline std::ostream* levelToStream(LoggingLevel level) {
   switch (level) {
@@ -59,15 +67,254 @@ inline std::string levelToString(LoggingLevel level) {
 
 inline bool isLeq(LoggingLevel a, LoggingLevel b) { return (uint8_t)a <= (uint8_t)b; }
 
+namespace {
+
+struct LogMessage {
+  uint64_t sequence = 0;
+  LoggingLevel level = LoggingLevel::Info;
+  std::string text;
+};
+
+//!
+//! Single-producer single-consumer ring buffer. The owning thread pushes,
+//! the background writer pops.
+//!
+class LogRingBuffer {
+ public:
+  static constexpr size_t kCapacity = 1024;
+
+  //! Returns false if the buffer is full.
+  bool tryPush(LogMessage& message) {
+    size_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) == kCapacity) {
+      return false;
+    }
+    _slots[head % kCapacity] = std::move(message);
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  //! Returns the number of messages after the last push.
+  size_t size() const {
+    return _head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_relaxed);
+  }
+
+  void popAll(std::vector<LogMessage>* messages) {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+    size_t head = _head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+      messages->push_back(std::move(_slots[tail % kCapacity]));
+    }
+    _tail.store(tail, std::memory_order_release);
+  }
+
+  //! Set when the owning thread exits; the writer then drops the buffer.
+  std::atomic<bool> isAbandoned{false};
+
+ private:
+  LogMessage _slots[kCapacity];
+  alignas(64) std::atomic<size_t> _head{0};
+  alignas(64) std::atomic<size_t> _tail{0};
+};
+
+//!
+//! Background thread that drains the per-thread ring buffers.
+//!
+class AsyncLogWriter {
+ public:
+  ~AsyncLogWriter() {
+    sIsAsync = false;
+    stop();
+  }
+
+  void start() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_thread.joinable()) {
+      return;
+    }
+    _isStopping = false;
+    _thread = std::thread([this]() { run(); });
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!_thread.joinable()) {
+        return;
+      }
+      _isStopping = true;
+    }
+    _wakeUp.notify_one();
+    _thread.join();
+    _thread = std::thread();
+
+    // Messages pushed while the thread was shutting down
+    drain();
+  }
+
+  void push(LoggingLevel level, std::string text) {
+    LogRingBuffer& buffer = localBuffer();
+
+    LogMessage message;
+    message.sequence = _nextSequence.fetch_add(1, std::memory_order_relaxed);
+    message.level = level;
+    message.text = std::move(text);
+
+    while (!buffer.tryPush(message)) {
+      // Full: let the writer catch up
+      _wakeUp.notify_one();
+      std::this_thread::yield();
+    }
+
+    if (buffer.size() == LogRingBuffer::kCapacity / 2) {
+      _wakeUp.notify_one();
+    }
+  }
+
+  void flush() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (!_thread.joinable()) {
+      return;
+    }
+    uint64_t request = ++_numberOfFlushRequests;
+    _wakeUp.notify_one();
+    _flushed.wait(lock, [this, request]() { return _numberOfCompletedFlushes >= request; });
+  }
+
+ private:
+  // Upper bound on how long a message stays in a buffer
+  static constexpr std::chrono::milliseconds kFlushInterval{20};
+
+  struct LocalBufferHolder {
+    std::shared_ptr<LogRingBuffer> buffer;
+    ~LocalBufferHolder() {
+      if (buffer) {
+        buffer->isAbandoned = true;
+      }
+    }
+  };
+
+  std::mutex _mutex;
+  std::condition_variable _wakeUp;
+  std::condition_variable _flushed;
+  std::thread _thread;
+  bool _isStopping = false;
+  uint64_t _numberOfFlushRequests = 0;
+  uint64_t _numberOfCompletedFlushes = 0;
+
+  std::mutex _buffersMutex;
+  std::vector<std::shared_ptr<LogRingBuffer>> _buffers;
+  std::atomic<uint64_t> _nextSequence{0};
+
+  // Only touched by the writer, kept to reuse the allocations
+  std::vector<LogMessage> _batch;
+  std::vector<std::pair<std::ostream*, std::string>> _output;
+
+  LogRingBuffer& localBuffer() {
+    static thread_local LocalBufferHolder holder;
+    if (!holder.buffer) {
+      holder.buffer = std::make_shared<LogRingBuffer>();
+      std::lock_guard<std::mutex> lock(_buffersMutex);
+      _buffers.push_back(holder.buffer);
+    }
+    return *holder.buffer;
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+      _wakeUp.wait_for(lock, kFlushInterval);
+      bool isStopping = _isStopping;
+      uint64_t request = _numberOfFlushRequests;
+
+      lock.unlock();
+      drain();
+      lock.lock();
+
+      _numberOfCompletedFlushes = request;
+      _flushed.notify_all();
+      if (isStopping) {
+        return;
+      }
+    }
+  }
+
+  void drain() {
+    _batch.clear();
+    {
+      std::lock_guard<std::mutex> lock(_buffersMutex);
+      for (const auto& buffer : _buffers) {
+        buffer->popAll(&_batch);
+      }
+      // Drop the buffers of exited threads once they are empty. The flag is
+      // read before draining again so that no late message is lost.
+      _buffers.erase(std::remove_if(_buffers.begin(), _buffers.end(),
+                                    [this](const std::shared_ptr<LogRingBuffer>& buffer) {
+                                      if (!buffer->isAbandoned) {
+                                        return false;
+                                      }
+                                      buffer->popAll(&_batch);
+                                      return true;
+                                    }),
+                     _buffers.end());
+    }
+
+    if (_batch.empty()) {
+      return;
+    }
+
+    std::sort(_batch.begin(), _batch.end(), [](const LogMessage& a, const LogMessage& b) {
+      return a.sequence < b.sequence;
+    });
+
+    std::lock_guard<std::mutex> lock(critical);
+    for (auto& output : _output) {
+      output.second.clear();
+    }
+    for (const LogMessage& message : _batch) {
+      if (!isLeq(sLoggingLevel, message.level)) {
+        continue;
+      }
+      std::ostream* strm = levelToStream(message.level);
+      auto output = std::find_if(_output.begin(), _output.end(),
+                                 [strm](const auto& entry) { return entry.first == strm; });
+      if (output == _output.end()) {
+        _output.emplace_back(strm, std::string());
+        output = _output.end() - 1;
+      }
+      output->second += message.text;
+      output->second += '\n';
+    }
+    for (auto& output : _output) {
+      if (!output.second.empty()) {
+        output.first->write(output.second.data(), output.second.size());
+        output.first->flush();
+      }
+    }
+    _output.clear();
+  }
+};
+
+AsyncLogWriter sAsyncLogWriter;
+
+}  // namespace
+
 Logger::Logger(LoggingLevel level) : _level(level) {}
 
 Logger::~Logger() {
-  std::lock_guard<std::mutex> lock(critical);
-  if (isLeq(sLoggingLevel, _level)) {
-    auto strm = levelToStream(_level);
-    (*strm) << _buffer.str() << std::endl;
-    strm->flush();
+  if (!isLeq(sLoggingLevel, _level)) {
+    return;
   }
+
+  if (sIsAsync.load(std::memory_order_relaxed)) {
+    sAsyncLogWriter.push(_level, _buffer.str());
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(critical);
+  auto strm = levelToStream(_level);
+  (*strm) << _buffer.str() << std::endl;
+  strm->flush();
 }
 
 void Logging::setInfoStream(std::ostream* strm) {
@@ -118,13 +365,32 @@ std::string Logging::getHeader(LoggingLevel level) {
   return header;
 }
 
-void Logging::setLevel(LoggingLevel level) {
-  std::lock_guard<std::mutex> lock(critical);
-  sLoggingLevel = level;
-}
+void Logging::setLevel(LoggingLevel level) { sLoggingLevel = level; }
 
 void Logging::mute() { setLevel(LoggingLevel::Off); }
 
 void Logging::unmute() { setLevel(LoggingLevel::All); }
 
+bool Logging::isEnabled(LoggingLevel level) {
+  return isLeq(sLoggingLevel.load(std::memory_order_relaxed), level);
+}
+
+void Logging::setAsync(bool isAsync) {
+  if (isAsync) {
+    sAsyncLogWriter.start();
+    sIsAsync = true;
+  } else {
+    sIsAsync = false;
+    sAsyncLogWriter.stop();
+  }
+}
+
+bool Logging::isAsync() { return sIsAsync; }
+
+void Logging::flush() {
+  if (sIsAsync) {
+    sAsyncLogWriter.flush();
+  }
+}
+
 }  // namespace jet
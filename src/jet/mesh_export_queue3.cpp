@@ -0,0 +1,119 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#include <pch.h>
+
+#include <jet/logging.h>
+#include <jet/mesh_export_queue3.h>
+#include <jet/profiler.h>
+#include <jet/timer.h>
+
+#include <utility>
+
+using namespace jet;
+
+namespace {
+
+bool hasPlyExtension(const std::string& filename) {
+  const std::string extension = ".ply";
+  return filename.size() >= extension.size() &&
+         filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+size_t meshBytes(const TriangleMesh3& mesh) {
+  return (mesh.numberOfPoints() + mesh.numberOfNormals()) * sizeof(Vector3D) +
+         mesh.numberOfUvs() * sizeof(Vector2D) + mesh.numberOfTriangles() * 3 * sizeof(Point3UI);
+}
+
+}  // namespace
+
+MeshExportQueue3::MeshExportQueue3(size_t maxPendingBytes) : _maxPendingBytes(maxPendingBytes) {
+  _worker = std::thread(&MeshExportQueue3::run, this);
+}
+
+MeshExportQueue3::~MeshExportQueue3() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _isStopping = true;
+  }
+  _condition.notify_all();
+  _worker.join();
+}
+
+bool MeshExportQueue3::push(const std::shared_ptr<const TriangleMesh3>& mesh,
+                            const std::string& filename) {
+  JET_PROFILE_SCOPE("MeshExportQueue3::push");
+
+  const size_t bytes = meshBytes(*mesh);
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (!_jobs.empty() && _pendingBytes + bytes > _maxPendingBytes) {
+    Timer timer;
+    _condition.wait(lock,
+                    [&] { return _jobs.empty() || _pendingBytes + bytes <= _maxPendingBytes; });
+    _blockedTimeInSeconds += timer.durationInSeconds();
+  }
+
+  const bool hasFailed = _hasFailed;
+  _hasFailed = false;
+
+  _jobs.push_back({mesh, filename, bytes});
+  _pendingBytes += bytes;
+  lock.unlock();
+  _condition.notify_all();
+
+  return !hasFailed;
+}
+
+bool MeshExportQueue3::flush() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _condition.wait(lock, [this] { return _jobs.empty(); });
+
+  const bool hasFailed = _hasFailed;
+  _hasFailed = false;
+  return !hasFailed;
+}
+
+size_t MeshExportQueue3::maxPendingBytes() const { return _maxPendingBytes; }
+
+size_t MeshExportQueue3::pendingBytes() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _pendingBytes;
+}
+
+double MeshExportQueue3::blockedTimeInSeconds() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _blockedTimeInSeconds;
+}
+
+void MeshExportQueue3::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    _condition.wait(lock, [this] { return !_jobs.empty() || _isStopping; });
+    if (_jobs.empty()) {
+      return;
+    }
+
+    // The front job stays queued, and counted, until it is on disk
+    const Job& job = _jobs.front();
+    lock.unlock();
+    bool isWritten;
+    {
+      JET_PROFILE_SCOPE("MeshExportQueue3::write");
+      isWritten = hasPlyExtension(job.filename) ? job.mesh->writePly(job.filename)
+                                                : job.mesh->writeObj(job.filename);
+    }
+    if (!isWritten) {
+      JET_ERROR << "Cannot write mesh " << job.filename;
+    }
+    lock.lock();
+
+    _hasFailed = _hasFailed || !isWritten;
+    _pendingBytes -= job.bytes;
+    _jobs.pop_front();
+    _condition.notify_all();
+  }
+}
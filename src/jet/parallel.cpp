@@ -11,27 +11,268 @@
 
 #if defined(JET_TASKING_TBB)
 #include <tbb/task_arena.h>
+#elif defined(JET_TASKING_CPP11THREADS)
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
 #elif defined(JET_TASKING_OPENMP)
 #include <omp.h>
 #endif
 
-static unsigned int sMaxNumberOfThreads = std::thread::hardware_concurrency();
+static unsigned int sMaxNumberOfThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+#if defined(JET_TASKING_TBB)
+static std::unique_ptr<tbb::task_arena> sTaskArena;
+#endif
 
 namespace jet {
 
+namespace internal {
+
+#if defined(JET_TASKING_TBB)
+
+tbb::task_arena* taskArena() { return sTaskArena.get(); }
+
+#elif defined(JET_TASKING_CPP11THREADS)
+
+//!
+//! \brief Persistent work-stealing thread pool.
+//!
+//! Each worker owns a task deque. Workers pop their own deque from the back
+//! and steal from the front of the others' deques when it runs dry. Tasks
+//! submitted from a worker go to that worker's deque; tasks submitted from
+//! other threads are distributed round-robin.
+//!
+class ThreadPool {
+ public:
+  explicit ThreadPool(unsigned int numberOfWorkers) : _queues(numberOfWorkers) {
+    for (auto& queue : _queues) {
+      queue.reset(new WorkQueue());
+    }
+
+    _workers.reserve(numberOfWorkers);
+    for (unsigned int i = 0; i < numberOfWorkers; ++i) {
+      _workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(_sleepMutex);
+      _isStopping = true;
+    }
+    _wakeUp.notify_all();
+
+    for (std::thread& worker : _workers) {
+      worker.join();
+    }
+  }
+
+  JET_NON_COPYABLE(ThreadPool)
+
+  unsigned int numberOfWorkers() const { return static_cast<unsigned int>(_workers.size()); }
+
+  void submit(std::function<void()> task) {
+    size_t queueIndex = (sWorkerPool == this) ? sWorkerIndex : _nextQueue++ % _queues.size();
+    {
+      std::lock_guard<std::mutex> lock(_queues[queueIndex]->mutex);
+      _queues[queueIndex]->tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> lock(_sleepMutex);
+      ++_numberOfQueuedTasks;
+    }
+    _wakeUp.notify_one();
+  }
+
+ private:
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  std::vector<std::unique_ptr<WorkQueue>> _queues;
+  std::vector<std::thread> _workers;
+  std::atomic<size_t> _nextQueue{0};
+
+  std::mutex _sleepMutex;
+  std::condition_variable _wakeUp;
+  size_t _numberOfQueuedTasks = 0;
+  bool _isStopping = false;
+
+  static thread_local ThreadPool* sWorkerPool;
+  static thread_local size_t sWorkerIndex;
+
+  bool tryPop(size_t workerIndex, std::function<void()>* task) {
+    {
+      WorkQueue& own = *_queues[workerIndex];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.tasks.empty()) {
+        *task = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        return true;
+      }
+    }
+
+    for (size_t offset = 1; offset < _queues.size(); ++offset) {
+      WorkQueue& victim = *_queues[(workerIndex + offset) % _queues.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        *task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void workerLoop(size_t workerIndex) {
+    sWorkerPool = this;
+    sWorkerIndex = workerIndex;
+
+    std::function<void()> task;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _wakeUp.wait(lock, [this]() { return _numberOfQueuedTasks > 0 || _isStopping; });
+        if (_numberOfQueuedTasks == 0) {
+          // Stopping and fully drained
+          return;
+        }
+        --_numberOfQueuedTasks;
+      }
+
+      // The counter guarantees a task is queued somewhere; it may take a few
+      // passes to find it while other workers race for the same deques.
+      while (!tryPop(workerIndex, &task)) {
+        std::this_thread::yield();
+      }
+
+      task();
+      task = nullptr;
+    }
+  }
+};
+
+thread_local ThreadPool* ThreadPool::sWorkerPool = nullptr;
+thread_local size_t ThreadPool::sWorkerIndex = 0;
+
+static std::mutex sThreadPoolMutex;
+static std::shared_ptr<ThreadPool> sThreadPool;
+
+static std::shared_ptr<ThreadPool> threadPool() {
+  std::lock_guard<std::mutex> lock(sThreadPoolMutex);
+  if (!sThreadPool) {
+    // The calling thread takes part in every loop, so one worker fewer than
+    // the thread budget saturates it. Keep at least one worker so that
+    // enqueued tasks make progress on their own.
+    sThreadPool = std::make_shared<ThreadPool>(std::max(sMaxNumberOfThreads, 2u) - 1);
+  }
+  return sThreadPool;
+}
+
+namespace {
+
+// Shared state of one runChunks call. Helpers that start after all chunks
+// were claimed find nothing to do and just release their reference.
+struct ChunkJob {
+  ChunkJob(size_t count, const std::function<void(size_t)>* body) : count(count), body(body) {}
+
+  const size_t count;
+  const std::function<void(size_t)>* body;
+  std::atomic<size_t> nextChunk{0};
+  std::atomic<size_t> numberOfFinishedChunks{0};
+
+  std::mutex mutex;
+  std::condition_variable finished;
+  std::exception_ptr exception;
+
+  void work() {
+    size_t chunk;
+    while ((chunk = nextChunk.fetch_add(1)) < count) {
+      try {
+        (*body)(chunk);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!exception) {
+          exception = std::current_exception();
+        }
+      }
+
+      if (numberOfFinishedChunks.fetch_add(1) + 1 == count) {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.notify_all();
+      }
+    }
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return numberOfFinishedChunks.load() == count; });
+  }
+};
+
+}  // namespace
+
+void runChunks(size_t numberOfChunks, const std::function<void(size_t)>& body) {
+  if (numberOfChunks == 0) {
+    return;
+  }
+
+  if (numberOfChunks == 1) {
+    body(0);
+    return;
+  }
+
+  auto pool = threadPool();
+  auto job = std::make_shared<ChunkJob>(numberOfChunks, &body);
+
+  size_t numberOfHelpers = std::min<size_t>(pool->numberOfWorkers(), numberOfChunks - 1);
+  for (size_t i = 0; i < numberOfHelpers; ++i) {
+    pool->submit([job]() { job->work(); });
+  }
+
+  job->work();
+  job->wait();
+
+  if (job->exception) {
+    std::rethrow_exception(job->exception);
+  }
+}
+
+void enqueueTask(std::function<void()> task) { threadPool()->submit(std::move(task)); }
+
+#endif
+
+}  // namespace internal
+
 void setMaxNumberOfThreads(unsigned int numThreads) {
+  numThreads = std::max(numThreads, 1u);
 #if defined(JET_TASKING_TBB)
-  static std::unique_ptr<tbb::task_arena> tbbInit;
-  if (!tbbInit.get())
-    tbbInit.reset(new tbb::task_arena(numThreads));
-  else {
-    tbbInit->terminate();
-    tbbInit->initialize(numThreads);
+  if (!sTaskArena) {
+    sTaskArena.reset(new tbb::task_arena(static_cast<int>(numThreads)));
+  } else {
+    sTaskArena->terminate();
+    sTaskArena->initialize(static_cast<int>(numThreads));
+  }
+#elif defined(JET_TASKING_CPP11THREADS)
+  std::shared_ptr<internal::ThreadPool> oldPool;
+  {
+    std::lock_guard<std::mutex> lock(internal::sThreadPoolMutex);
+    oldPool.swap(internal::sThreadPool);
+    sMaxNumberOfThreads = numThreads;
   }
+  // The next parallel call creates a pool of the new size. The old workers
+  // finish the tasks already queued and exit once the last reference to the
+  // old pool is gone.
+  oldPool.reset();
 #elif defined(JET_TASKING_OPENMP)
   omp_set_num_threads(numThreads);
 #endif
-  sMaxNumberOfThreads = std::max(numThreads, 1u);
+  sMaxNumberOfThreads = numThreads;
 }
 
 unsigned int maxNumberOfThreads() { return sMaxNumberOfThreads; }
@@ -0,0 +1,960 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#include <pch.h>
+
+#include <jet/parallel.h>
+#include <jet/particle_cache3.h>
+#include <jet/profiler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#ifdef JET_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace jet;
+using namespace jet::particle_cache;
+
+static_assert(sizeof(Vector3D) == 3 * sizeof(double),
+              "Vector3D columns are stored as packed doubles");
+static_assert(sizeof(FileHeader) == kAlignment, "File header must fill one aligned slot");
+
+namespace {
+
+const char kFileMagic[8] = {'J', 'E', 'T', 'P', 'C', 'A', 'C', 'H'};
+const char kFrameMagic[4] = {'F', 'R', 'M', '3'};
+const uint32_t kByteOrderMark = 0x01020304;
+
+// Particles per independently coded chunk of a quantized column
+const uint64_t kParticlesPerChunk = 1 << 16;
+
+uint64_t alignUp(uint64_t offset) { return (offset + kAlignment - 1) / kAlignment * kAlignment; }
+
+uint64_t numberOfChunks(uint64_t numberOfParticles, uint64_t particlesPerChunk) {
+  return numberOfParticles / particlesPerChunk + (numberOfParticles % particlesPerChunk != 0);
+}
+
+// IEEE 754 binary16 conversion, rounding to nearest
+uint16_t floatToHalf(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+  const uint32_t mantissa = bits & 0x7fffff;
+  const int exponent = static_cast<int>((bits >> 23) & 0xff) - 127 + 15;
+
+  if (((bits >> 23) & 0xff) == 0xff) {
+    return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);
+  }
+  if (exponent >= 31) {
+    return sign | 0x7c00;
+  }
+  if (exponent <= 0) {
+    if (exponent < -10) {
+      return sign;
+    }
+    const uint32_t m = mantissa | 0x800000;
+    const int shift = 14 - exponent;
+    uint32_t half = m >> shift;
+    half += (m >> (shift - 1)) & 1;
+    return sign | static_cast<uint16_t>(half);
+  }
+
+  // A carry out of the mantissa correctly bumps the exponent
+  uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+  half += (mantissa >> 12) & 1;
+  return sign | static_cast<uint16_t>(half);
+}
+
+float halfToFloat(uint16_t half) {
+  const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  const uint32_t exponent = (half >> 10) & 0x1f;
+  const uint32_t mantissa = half & 0x3ff;
+
+  uint32_t bits;
+  if (exponent == 0) {
+    const float value = mantissa * (1.0f / 16777216.0f);
+    return sign ? -value : value;
+  } else if (exponent == 31) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  }
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void writeVarint(int64_t value, std::vector<uint8_t>* buffer) {
+  // Zigzag mapping keeps small negative values short
+  uint64_t u = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+  while (u >= 0x80) {
+    buffer->push_back(static_cast<uint8_t>(u | 0x80));
+    u >>= 7;
+  }
+  buffer->push_back(static_cast<uint8_t>(u));
+}
+
+int64_t readVarint(const uint8_t** cursor, const uint8_t* end) {
+  uint64_t u = 0;
+  int shift = 0;
+  while (*cursor < end && shift < 64) {
+    const uint8_t byte = *(*cursor)++;
+    u |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+    shift += 7;
+  }
+  return static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+}
+
+template <typename T>
+void appendColumn(const ConstArrayAccessor1<T>& data, uint8_t* block, ColumnEntry* entry) {
+  const uint64_t paddedSize = alignUp(entry->size);
+  if (entry->size > 0) {
+    std::memcpy(block + entry->offset, data.data(), entry->size);
+  }
+  std::memset(block + entry->offset + entry->size, 0, paddedSize - entry->size);
+}
+
+// Returns the layer index of attr in the particles' vector layers
+uint32_t findVectorLayer(const ParticleSystemData3& particles,
+                         const ConstArrayAccessor1<Vector3D>& attr) {
+  for (size_t i = 0; i < particles.numberOfVectorData(); ++i) {
+    if (particles.vectorDataAt(i).data() == attr.data()) {
+      return static_cast<uint32_t>(i);
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+// MARK: ParticleCacheWriter3
+
+ParticleCacheWriter3::ParticleCacheWriter3() {}
+
+ParticleCacheWriter3::~ParticleCacheWriter3() { close(); }
+
+void ParticleCacheWriter3::setCompression(const Compression& compression) {
+  _compression = compression;
+}
+
+const Compression& ParticleCacheWriter3::compression() const { return _compression; }
+
+bool ParticleCacheWriter3::open(const std::string& filename, size_t maxPendingFrames) {
+  close();
+
+  _file = std::fopen(filename.c_str(), "wb");
+  if (_file == nullptr) {
+    JET_ERROR << "Cannot create particle cache " << filename;
+    return false;
+  }
+
+  // Placeholder header; close() fills in the frame index. Until then readers
+  // fall back to scanning the blocks.
+  FileHeader header = {};
+  std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+  header.version = kVersion;
+  header.byteOrderMark = kByteOrderMark;
+  if (std::fwrite(&header, sizeof(header), 1, _file) != 1) {
+    std::fclose(_file);
+    _file = nullptr;
+    return false;
+  }
+
+  _fileSize = sizeof(header);
+  _maxPendingFrames = std::max(maxPendingFrames, size_t(1));
+  _numberOfFrames = 0;
+  _hasFailed = false;
+  _isStopping = false;
+  _index.clear();
+  _rawFrameBytes = 0;
+  _writtenFrameBytes = 0;
+  _activeCompression = _compression;
+  _previousCoordinates.clear();
+  _framesSinceKeyFrame = 0;
+  _thread = std::thread(&ParticleCacheWriter3::run, this);
+  return true;
+}
+
+bool ParticleCacheWriter3::isOpen() const { return _file != nullptr; }
+
+bool ParticleCacheWriter3::writeFrame(int frameIndex, double timeInSeconds,
+                                      const ParticleSystemData3& particles) {
+  if (_file == nullptr) {
+    return false;
+  }
+
+  JET_PROFILE_SCOPE("ParticleCache::writeFrame");
+
+  std::vector<uint8_t> block;
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _queueChanged.wait(lock, [this] {
+      return _pendingFrames.size() + _numberOfFramesBeingWritten < _maxPendingFrames ||
+             _hasFailed;
+    });
+    if (_hasFailed) {
+      return false;
+    }
+    if (!_freeBlocks.empty()) {
+      block = std::move(_freeBlocks.back());
+      _freeBlocks.pop_back();
+    }
+  }
+
+  const size_t n = particles.numberOfParticles();
+  const size_t numberOfScalarColumns = particles.numberOfScalarData();
+  const size_t numberOfColumns = numberOfScalarColumns + particles.numberOfVectorData();
+
+  FrameHeader header = {};
+  std::memcpy(header.magic, kFrameMagic, sizeof(kFrameMagic));
+  header.numberOfColumns = static_cast<uint32_t>(numberOfColumns);
+  header.frameIndex = frameIndex;
+  header.timeInSeconds = timeInSeconds;
+  header.numberOfParticles = n;
+  header.radius = particles.radius();
+  header.mass = particles.mass();
+  header.numberOfScalarColumns = static_cast<uint32_t>(numberOfScalarColumns);
+  const uint32_t firstVectorColumn = static_cast<uint32_t>(numberOfScalarColumns);
+  header.positionColumn = firstVectorColumn + findVectorLayer(particles, particles.positions());
+  header.velocityColumn = firstVectorColumn + findVectorLayer(particles, particles.velocities());
+  header.forceColumn = firstVectorColumn + findVectorLayer(particles, particles.forces());
+
+  // Lay out the columns after the header and the column table
+  std::vector<ColumnEntry> columns(numberOfColumns);
+  uint64_t offset = alignUp(sizeof(FrameHeader) + numberOfColumns * sizeof(ColumnEntry));
+  for (size_t i = 0; i < numberOfColumns; ++i) {
+    columns[i].offset = offset;
+    columns[i].size = n * (i < numberOfScalarColumns ? sizeof(double) : sizeof(Vector3D));
+    columns[i].encoding = kRaw;
+    offset = alignUp(offset + columns[i].size);
+  }
+  header.blockSize = offset;
+
+  // Recycled blocks keep their capacity, so this only allocates while the
+  // particle count grows
+  block.resize(header.blockSize);
+  std::memset(block.data(), 0, columns.empty() ? header.blockSize : columns[0].offset);
+  std::memcpy(block.data(), &header, sizeof(header));
+  if (!columns.empty()) {
+    std::memcpy(block.data() + sizeof(header), columns.data(),
+                numberOfColumns * sizeof(ColumnEntry));
+  }
+  for (size_t i = 0; i < numberOfScalarColumns; ++i) {
+    appendColumn(particles.scalarDataAt(i), block.data(), &columns[i]);
+  }
+  for (size_t i = numberOfScalarColumns; i < numberOfColumns; ++i) {
+    appendColumn(particles.vectorDataAt(i - numberOfScalarColumns), block.data(), &columns[i]);
+  }
+
+  PendingFrame frame;
+  frame.block = std::move(block);
+  frame.entry.offset = 0;
+  frame.entry.blockSize = header.blockSize;
+  frame.entry.frameIndex = frameIndex;
+  frame.entry.timeInSeconds = timeInSeconds;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pendingFrames.push_back(std::move(frame));
+    ++_numberOfFrames;
+  }
+  _queueChanged.notify_all();
+  return true;
+}
+
+void ParticleCacheWriter3::flush() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _queueChanged.wait(lock,
+                     [this] { return _pendingFrames.empty() && _numberOfFramesBeingWritten == 0; });
+}
+
+bool ParticleCacheWriter3::close() {
+  if (_file == nullptr) {
+    return true;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _isStopping = true;
+  }
+  _queueChanged.notify_all();
+  _thread.join();
+
+  // Append the frame index and point the header at it
+  bool isOk = !_hasFailed;
+  if (isOk) {
+    FileHeader header = {};
+    std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+    header.version = kVersion;
+    header.byteOrderMark = kByteOrderMark;
+    header.numberOfFrames = _index.size();
+    header.indexOffset = _fileSize;
+
+    isOk = (_index.empty() ||
+            std::fwrite(_index.data(), sizeof(FrameIndexEntry), _index.size(), _file) ==
+                _index.size()) &&
+           std::fseek(_file, 0, SEEK_SET) == 0 &&
+           std::fwrite(&header, sizeof(header), 1, _file) == 1;
+  }
+  isOk = (std::fclose(_file) == 0) && isOk;
+  _file = nullptr;
+
+  _pendingFrames.clear();
+  _freeBlocks.clear();
+  _index.clear();
+  _encodedBlock.clear();
+  _encodedChunks.clear();
+  _previousCoordinates.clear();
+  return isOk;
+}
+
+size_t ParticleCacheWriter3::numberOfFrames() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _numberOfFrames;
+}
+
+double ParticleCacheWriter3::compressionRatio() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return (_rawFrameBytes > 0) ? static_cast<double>(_writtenFrameBytes) / _rawFrameBytes : 1.0;
+}
+
+void ParticleCacheWriter3::run() {
+  while (true) {
+    PendingFrame frame;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _queueChanged.wait(lock, [this] { return !_pendingFrames.empty() || _isStopping; });
+      if (_pendingFrames.empty()) {
+        return;
+      }
+      frame = std::move(_pendingFrames.front());
+      _pendingFrames.pop_front();
+      ++_numberOfFramesBeingWritten;
+    }
+
+    // Only this thread touches the file and its size while it runs
+    const std::vector<uint8_t>* data = &frame.block;
+    if (_activeCompression.isEnabled && !_hasFailed) {
+      encodeBlock(frame.block);
+      data = &_encodedBlock;
+    }
+    bool isOk = !_hasFailed && std::fwrite(data->data(), 1, data->size(), _file) == data->size();
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (isOk) {
+        frame.entry.offset = _fileSize;
+        frame.entry.blockSize = data->size();
+        _fileSize += data->size();
+        _rawFrameBytes += frame.block.size();
+        _writtenFrameBytes += data->size();
+        _index.push_back(frame.entry);
+      } else {
+        _hasFailed = true;
+      }
+      _freeBlocks.push_back(std::move(frame.block));
+      --_numberOfFramesBeingWritten;
+    }
+    _queueChanged.notify_all();
+  }
+}
+
+void ParticleCacheWriter3::encodeBlock(const std::vector<uint8_t>& block) {
+  JET_PROFILE_SCOPE("ParticleCache::encodeBlock");
+
+  FrameHeader header;
+  std::memcpy(&header, block.data(), sizeof(header));
+  std::vector<ColumnEntry> rawColumns(header.numberOfColumns);
+  if (!rawColumns.empty()) {
+    std::memcpy(rawColumns.data(), block.data() + sizeof(header),
+                rawColumns.size() * sizeof(ColumnEntry));
+  }
+
+  const size_t n = static_cast<size_t>(header.numberOfParticles);
+  const bool isKeyFrame = _framesSinceKeyFrame == 0 ||
+                          _framesSinceKeyFrame >= _activeCompression.keyFrameInterval ||
+                          _previousCoordinates.size() != 3 * n;
+  _framesSinceKeyFrame = isKeyFrame ? 1 : _framesSinceKeyFrame + 1;
+  if (isKeyFrame) {
+    _previousCoordinates.assign(3 * n, 0);
+  }
+
+  // Quantize the positions and code each chunk into its own buffer
+  QuantizedColumnHeader quantized = {};
+  quantized.origin[0] = _activeCompression.origin.x;
+  quantized.origin[1] = _activeCompression.origin.y;
+  quantized.origin[2] = _activeCompression.origin.z;
+  quantized.gridSpacing = 2.0 * _activeCompression.positionTolerance;
+  quantized.particlesPerChunk = kParticlesPerChunk;
+  quantized.numberOfChunks = static_cast<uint32_t>(numberOfChunks(n, kParticlesPerChunk));
+  quantized.isDelta = isKeyFrame ? 0 : 1;
+
+  const Vector3D* positions =
+      reinterpret_cast<const Vector3D*>(block.data() + rawColumns[header.positionColumn].offset);
+  const double invGridSpacing = 1.0 / quantized.gridSpacing;
+  _encodedChunks.resize(quantized.numberOfChunks);
+  parallelFor(kZeroSize, _encodedChunks.size(), [&](size_t chunk) {
+    std::vector<uint8_t>& buffer = _encodedChunks[chunk];
+    buffer.clear();
+    const size_t end = std::min(n, (chunk + 1) * kParticlesPerChunk);
+    for (size_t i = chunk * kParticlesPerChunk; i < end; ++i) {
+      for (size_t c = 0; c < 3; ++c) {
+        const int64_t coordinate = std::llround((positions[i][c] - quantized.origin[c]) *
+                                                invGridSpacing);
+        writeVarint(coordinate - _previousCoordinates[3 * i + c], &buffer);
+        _previousCoordinates[3 * i + c] = coordinate;
+      }
+    }
+  });
+
+  std::vector<uint64_t> chunkOffsets(_encodedChunks.size() + 1);
+  chunkOffsets[0] = sizeof(quantized) + chunkOffsets.size() * sizeof(uint64_t);
+  for (size_t chunk = 0; chunk < _encodedChunks.size(); ++chunk) {
+    chunkOffsets[chunk + 1] = chunkOffsets[chunk] + _encodedChunks[chunk].size();
+  }
+
+  // Lay out the encoded columns like writeFrame does for raw ones
+  std::vector<ColumnEntry> columns = rawColumns;
+  uint64_t offset = alignUp(sizeof(FrameHeader) + columns.size() * sizeof(ColumnEntry));
+  for (size_t i = 0; i < columns.size(); ++i) {
+    if (i == header.positionColumn) {
+      columns[i].encoding = kQuantized;
+      columns[i].size = chunkOffsets.back();
+    } else if (i < header.numberOfScalarColumns) {
+      columns[i].encoding = kFloat;
+      columns[i].size = n * sizeof(float);
+    } else {
+      columns[i].encoding = kHalf;
+      columns[i].size = n * 3 * sizeof(uint16_t);
+    }
+    columns[i].offset = offset;
+    offset = alignUp(offset + columns[i].size);
+  }
+  header.blockSize = offset;
+
+  _encodedBlock.resize(header.blockSize);
+  uint8_t* encoded = _encodedBlock.data();
+  std::memset(encoded, 0, header.blockSize);
+  std::memcpy(encoded, &header, sizeof(header));
+  if (!columns.empty()) {
+    std::memcpy(encoded + sizeof(header), columns.data(), columns.size() * sizeof(ColumnEntry));
+  }
+
+  for (size_t i = 0; i < columns.size(); ++i) {
+    uint8_t* dst = encoded + columns[i].offset;
+    const uint8_t* src = block.data() + rawColumns[i].offset;
+    if (columns[i].encoding == kQuantized) {
+      std::memcpy(dst, &quantized, sizeof(quantized));
+      std::memcpy(dst + sizeof(quantized), chunkOffsets.data(),
+                  chunkOffsets.size() * sizeof(uint64_t));
+      parallelFor(kZeroSize, _encodedChunks.size(), [&](size_t chunk) {
+        if (!_encodedChunks[chunk].empty()) {
+          std::memcpy(dst + chunkOffsets[chunk], _encodedChunks[chunk].data(),
+                      _encodedChunks[chunk].size());
+        }
+      });
+    } else if (columns[i].encoding == kFloat) {
+      const double* values = reinterpret_cast<const double*>(src);
+      float* out = reinterpret_cast<float*>(dst);
+      parallelFor(kZeroSize, n, [&](size_t j) { out[j] = static_cast<float>(values[j]); });
+    } else {
+      const double* values = reinterpret_cast<const double*>(src);
+      uint16_t* out = reinterpret_cast<uint16_t*>(dst);
+      parallelFor(kZeroSize, 3 * n,
+                  [&](size_t j) { out[j] = floatToHalf(static_cast<float>(values[j])); });
+    }
+  }
+}
+
+// MARK: ParticleCacheFrame3
+
+ParticleCacheFrame3::ParticleCacheFrame3(const uint8_t* block) : _block(block) {}
+
+int ParticleCacheFrame3::index() const { return static_cast<int>(header().frameIndex); }
+
+double ParticleCacheFrame3::timeInSeconds() const { return header().timeInSeconds; }
+
+size_t ParticleCacheFrame3::numberOfParticles() const {
+  return static_cast<size_t>(header().numberOfParticles);
+}
+
+double ParticleCacheFrame3::radius() const { return header().radius; }
+
+double ParticleCacheFrame3::mass() const { return header().mass; }
+
+bool ParticleCacheFrame3::isCompressed() const {
+  for (size_t i = 0; i < header().numberOfColumns; ++i) {
+    if (columnEntry(i).encoding != kRaw) {
+      return true;
+    }
+  }
+  return false;
+}
+
+ConstArrayAccessor1<Vector3D> ParticleCacheFrame3::positions() const {
+  JET_ASSERT(columnEncoding(header().positionColumn) == kRaw);
+  return ConstArrayAccessor1<Vector3D>(
+      numberOfParticles(), reinterpret_cast<const Vector3D*>(column(header().positionColumn)));
+}
+
+ConstArrayAccessor1<Vector3D> ParticleCacheFrame3::velocities() const {
+  JET_ASSERT(columnEncoding(header().velocityColumn) == kRaw);
+  return ConstArrayAccessor1<Vector3D>(
+      numberOfParticles(), reinterpret_cast<const Vector3D*>(column(header().velocityColumn)));
+}
+
+ConstArrayAccessor1<Vector3D> ParticleCacheFrame3::forces() const {
+  JET_ASSERT(columnEncoding(header().forceColumn) == kRaw);
+  return ConstArrayAccessor1<Vector3D>(
+      numberOfParticles(), reinterpret_cast<const Vector3D*>(column(header().forceColumn)));
+}
+
+size_t ParticleCacheFrame3::numberOfScalarData() const { return header().numberOfScalarColumns; }
+
+size_t ParticleCacheFrame3::numberOfVectorData() const {
+  return header().numberOfColumns - header().numberOfScalarColumns;
+}
+
+ConstArrayAccessor1<double> ParticleCacheFrame3::scalarDataAt(size_t idx) const {
+  JET_ASSERT(idx < numberOfScalarData());
+  JET_ASSERT(columnEncoding(idx) == kRaw);
+  return ConstArrayAccessor1<double>(numberOfParticles(),
+                                     reinterpret_cast<const double*>(column(idx)));
+}
+
+ConstArrayAccessor1<Vector3D> ParticleCacheFrame3::vectorDataAt(size_t idx) const {
+  JET_ASSERT(idx < numberOfVectorData());
+  JET_ASSERT(columnEncoding(numberOfScalarData() + idx) == kRaw);
+  return ConstArrayAccessor1<Vector3D>(
+      numberOfParticles(),
+      reinterpret_cast<const Vector3D*>(column(numberOfScalarData() + idx)));
+}
+
+ColumnEncoding ParticleCacheFrame3::columnEncoding(size_t column) const {
+  return static_cast<ColumnEncoding>(columnEntry(column).encoding);
+}
+
+void ParticleCacheFrame3::copyTo(ParticleSystemData3* particles) const {
+  JET_ASSERT(!isCompressed());
+  particles->resize(numberOfParticles());
+  particles->setRadius(radius());
+  particles->setMass(mass());
+
+  const size_t numberOfScalars = std::min(numberOfScalarData(), particles->numberOfScalarData());
+  for (size_t i = 0; i < numberOfScalars; ++i) {
+    std::copy(scalarDataAt(i).begin(), scalarDataAt(i).end(), particles->scalarDataAt(i).begin());
+  }
+  const size_t numberOfVectors = std::min(numberOfVectorData(), particles->numberOfVectorData());
+  for (size_t i = 0; i < numberOfVectors; ++i) {
+    std::copy(vectorDataAt(i).begin(), vectorDataAt(i).end(), particles->vectorDataAt(i).begin());
+  }
+
+  // The built-in layers may sit at other indices in the destination
+  std::copy(positions().begin(), positions().end(), particles->positions().begin());
+  std::copy(velocities().begin(), velocities().end(), particles->velocities().begin());
+  std::copy(forces().begin(), forces().end(), particles->forces().begin());
+}
+
+const FrameHeader& ParticleCacheFrame3::header() const {
+  JET_ASSERT(_block != nullptr);
+  return *reinterpret_cast<const FrameHeader*>(_block);
+}
+
+const ColumnEntry& ParticleCacheFrame3::columnEntry(size_t idx) const {
+  JET_ASSERT(idx < header().numberOfColumns);
+  return reinterpret_cast<const ColumnEntry*>(_block + sizeof(FrameHeader))[idx];
+}
+
+const uint8_t* ParticleCacheFrame3::column(size_t idx) const {
+  return _block + columnEntry(idx).offset;
+}
+
+// MARK: ParticleCacheReader3
+
+ParticleCacheReader3::ParticleCacheReader3() {}
+
+ParticleCacheReader3::~ParticleCacheReader3() { close(); }
+
+bool ParticleCacheReader3::open(const std::string& filename) {
+  close();
+
+#ifdef JET_WINDOWS
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    JET_ERROR << "Cannot open particle cache " << filename;
+    return false;
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < 1) {
+    CloseHandle(file);
+    JET_ERROR << "Invalid particle cache " << filename;
+    return false;
+  }
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  const void* data =
+      (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (data == nullptr) {
+    if (mapping != nullptr) {
+      CloseHandle(mapping);
+    }
+    CloseHandle(file);
+    JET_ERROR << "Cannot map particle cache " << filename;
+    return false;
+  }
+  _fileHandle = file;
+  _mappingHandle = mapping;
+  _size = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    JET_ERROR << "Cannot open particle cache " << filename;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < 1) {
+    ::close(fd);
+    JET_ERROR << "Invalid particle cache " << filename;
+    return false;
+  }
+  void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping keeps the file alive
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    JET_ERROR << "Cannot map particle cache " << filename;
+    return false;
+  }
+  _size = static_cast<uint64_t>(st.st_size);
+#endif
+  _data = static_cast<const uint8_t*>(data);
+
+  if (!readIndex()) {
+    JET_ERROR << "Invalid particle cache " << filename;
+    close();
+    return false;
+  }
+  return true;
+}
+
+void ParticleCacheReader3::close() {
+  if (_data != nullptr) {
+#ifdef JET_WINDOWS
+    UnmapViewOfFile(_data);
+    CloseHandle(_mappingHandle);
+    CloseHandle(_fileHandle);
+    _mappingHandle = nullptr;
+    _fileHandle = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(_data), static_cast<size_t>(_size));
+#endif
+  }
+  _data = nullptr;
+  _size = 0;
+  _index.clear();
+  _decodedCoordinates.clear();
+  _decodedFrame = kMaxSize;
+}
+
+bool ParticleCacheReader3::isOpen() const { return _data != nullptr; }
+
+size_t ParticleCacheReader3::numberOfFrames() const { return _index.size(); }
+
+ParticleCacheFrame3 ParticleCacheReader3::frame(size_t i) const {
+  JET_ASSERT(i < _index.size());
+  return ParticleCacheFrame3(_data + _index[i].offset);
+}
+
+bool ParticleCacheReader3::findFrame(int frameIndex, ParticleCacheFrame3* frame) const {
+  auto iter = std::find_if(_index.begin(), _index.end(), [frameIndex](const FrameIndexEntry& e) {
+    return e.frameIndex == frameIndex;
+  });
+  if (iter == _index.end()) {
+    return false;
+  }
+  *frame = ParticleCacheFrame3(_data + iter->offset);
+  return true;
+}
+
+void ParticleCacheReader3::prefetch(size_t i) const {
+  if (i >= _index.size()) {
+    return;
+  }
+#if defined(JET_WINDOWS) && _WIN32_WINNT >= 0x0602
+  WIN32_MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = const_cast<uint8_t*>(_data + _index[i].offset);
+  range.NumberOfBytes = static_cast<SIZE_T>(_index[i].blockSize);
+  PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#elif !defined(JET_WINDOWS)
+  // madvise needs a page-aligned address
+  const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(_data + _index[i].offset);
+  const uintptr_t alignedBegin = begin / pageSize * pageSize;
+  madvise(reinterpret_cast<void*>(alignedBegin),
+          static_cast<size_t>(begin - alignedBegin + _index[i].blockSize), MADV_WILLNEED);
+#endif
+}
+
+void ParticleCacheReader3::readPositions(size_t i, Array1<Vector3D>* positions) const {
+  const ParticleCacheFrame3 f = frame(i);
+  positions->resize(f.numberOfParticles());
+  readVectorColumn(i, f.header().positionColumn, positions->data());
+}
+
+void ParticleCacheReader3::readScalarDataAt(size_t i, size_t idx, Array1<double>* data) const {
+  const ParticleCacheFrame3 f = frame(i);
+  JET_ASSERT(idx < f.numberOfScalarData());
+  data->resize(f.numberOfParticles());
+  readScalarColumn(i, idx, data->data());
+}
+
+void ParticleCacheReader3::readVectorDataAt(size_t i, size_t idx, Array1<Vector3D>* data) const {
+  const ParticleCacheFrame3 f = frame(i);
+  JET_ASSERT(idx < f.numberOfVectorData());
+  data->resize(f.numberOfParticles());
+  readVectorColumn(i, f.numberOfScalarData() + idx, data->data());
+}
+
+void ParticleCacheReader3::readFrame(size_t i, ParticleSystemData3* particles) const {
+  const ParticleCacheFrame3 f = frame(i);
+  particles->resize(f.numberOfParticles());
+  particles->setRadius(f.radius());
+  particles->setMass(f.mass());
+
+  const size_t numberOfScalars = std::min(f.numberOfScalarData(), particles->numberOfScalarData());
+  for (size_t j = 0; j < numberOfScalars; ++j) {
+    readScalarColumn(i, j, particles->scalarDataAt(j).data());
+  }
+  const size_t numberOfVectors = std::min(f.numberOfVectorData(), particles->numberOfVectorData());
+  for (size_t j = 0; j < numberOfVectors; ++j) {
+    readVectorColumn(i, f.numberOfScalarData() + j, particles->vectorDataAt(j).data());
+  }
+
+  // The built-in layers may sit at other indices in the destination
+  readVectorColumn(i, f.header().positionColumn, particles->positions().data());
+  readVectorColumn(i, f.header().velocityColumn, particles->velocities().data());
+  readVectorColumn(i, f.header().forceColumn, particles->forces().data());
+}
+
+void ParticleCacheReader3::decodeCoordinates(size_t i) const {
+  if (_decodedFrame == i) {
+    return;
+  }
+
+  auto quantizedHeader = [this](size_t j) {
+    const ParticleCacheFrame3 f = frame(j);
+    QuantizedColumnHeader quantized;
+    std::memcpy(&quantized, f.column(f.header().positionColumn), sizeof(quantized));
+    return quantized;
+  };
+
+  // Start from the last key frame, or continue from the last decoded frame
+  size_t first = i;
+  while (first > 0 && quantizedHeader(first).isDelta) {
+    --first;
+  }
+  if (_decodedFrame != kMaxSize && _decodedFrame >= first && _decodedFrame < i) {
+    first = _decodedFrame + 1;
+  }
+
+  for (size_t j = first; j <= i; ++j) {
+    const ParticleCacheFrame3 f = frame(j);
+    const QuantizedColumnHeader quantized = quantizedHeader(j);
+    const uint8_t* column = f.column(f.header().positionColumn);
+    const uint64_t* chunkOffsets =
+        reinterpret_cast<const uint64_t*>(column + sizeof(QuantizedColumnHeader));
+    const size_t n = f.numberOfParticles();
+    if (!quantized.isDelta || _decodedCoordinates.size() != 3 * n) {
+      _decodedCoordinates.assign(3 * n, 0);
+    }
+
+    parallelFor(kZeroSize, static_cast<size_t>(quantized.numberOfChunks), [&](size_t chunk) {
+      const uint8_t* cursor = column + chunkOffsets[chunk];
+      const uint8_t* end = column + chunkOffsets[chunk + 1];
+      const size_t begin = static_cast<size_t>(chunk * quantized.particlesPerChunk);
+      const size_t last = std::min(n, begin + static_cast<size_t>(quantized.particlesPerChunk));
+      for (size_t k = 3 * begin; k < 3 * last; ++k) {
+        _decodedCoordinates[k] += readVarint(&cursor, end);
+      }
+    });
+    _decodedFrame = j;
+  }
+}
+
+void ParticleCacheReader3::readScalarColumn(size_t i, size_t column, double* data) const {
+  const ParticleCacheFrame3 f = frame(i);
+  const size_t n = f.numberOfParticles();
+  const uint8_t* src = f.column(column);
+  if (f.columnEncoding(column) == kFloat) {
+    const float* values = reinterpret_cast<const float*>(src);
+    parallelFor(kZeroSize, n, [&](size_t j) { data[j] = values[j]; });
+  } else {
+    std::memcpy(data, src, n * sizeof(double));
+  }
+}
+
+void ParticleCacheReader3::readVectorColumn(size_t i, size_t column, Vector3D* data) const {
+  const ParticleCacheFrame3 f = frame(i);
+  const size_t n = f.numberOfParticles();
+  const uint8_t* src = f.column(column);
+
+  switch (f.columnEncoding(column)) {
+    case kQuantized: {
+      JET_PROFILE_SCOPE("ParticleCache::decodePositions");
+      decodeCoordinates(i);
+      QuantizedColumnHeader quantized;
+      std::memcpy(&quantized, src, sizeof(quantized));
+      const Vector3D origin(quantized.origin[0], quantized.origin[1], quantized.origin[2]);
+      const double h = quantized.gridSpacing;
+      const int64_t* coordinates = _decodedCoordinates.data();
+      parallelFor(kZeroSize, n, [&](size_t j) {
+        data[j] = origin + h * Vector3D(static_cast<double>(coordinates[3 * j]),
+                                        static_cast<double>(coordinates[3 * j + 1]),
+                                        static_cast<double>(coordinates[3 * j + 2]));
+      });
+      break;
+    }
+    case kHalf: {
+      const uint16_t* values = reinterpret_cast<const uint16_t*>(src);
+      parallelFor(kZeroSize, n, [&](size_t j) {
+        data[j] = Vector3D(halfToFloat(values[3 * j]), halfToFloat(values[3 * j + 1]),
+                           halfToFloat(values[3 * j + 2]));
+      });
+      break;
+    }
+    default:
+      const Vector3D* values = reinterpret_cast<const Vector3D*>(src);
+      std::copy(values, values + n, data);
+      break;
+  }
+}
+
+bool ParticleCacheReader3::readIndex() {
+  FileHeader header;
+  if (_size < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, _data, sizeof(header));
+  if (std::memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+      header.version != kVersion || header.byteOrderMark != kByteOrderMark) {
+    return false;
+  }
+
+  if (header.indexOffset != 0) {
+    if (header.indexOffset > _size ||
+        header.numberOfFrames > (_size - header.indexOffset) / sizeof(FrameIndexEntry)) {
+      return false;
+    }
+    _index.resize(static_cast<size_t>(header.numberOfFrames));
+    if (!_index.empty()) {
+      std::memcpy(_index.data(), _data + header.indexOffset,
+                  _index.size() * sizeof(FrameIndexEntry));
+    }
+    return std::all_of(_index.begin(), _index.end(), [this](const FrameIndexEntry& e) {
+      return isValidBlock(e.offset, e.blockSize);
+    });
+  }
+
+  // The writer was not closed: recover every complete block
+  uint64_t offset = sizeof(header);
+  while (offset + sizeof(FrameHeader) <= _size) {
+    FrameHeader frameHeader;
+    std::memcpy(&frameHeader, _data + offset, sizeof(frameHeader));
+    if (!isValidBlock(offset, frameHeader.blockSize)) {
+      break;
+    }
+    FrameIndexEntry entry;
+    entry.offset = offset;
+    entry.blockSize = frameHeader.blockSize;
+    entry.frameIndex = frameHeader.frameIndex;
+    entry.timeInSeconds = frameHeader.timeInSeconds;
+    _index.push_back(entry);
+    offset += frameHeader.blockSize;
+  }
+  return true;
+}
+
+bool ParticleCacheReader3::isValidBlock(uint64_t offset, uint64_t blockSize) const {
+  if (offset % kAlignment != 0 || offset > _size || blockSize > _size - offset ||
+      blockSize < sizeof(FrameHeader)) {
+    return false;
+  }
+
+  FrameHeader header;
+  std::memcpy(&header, _data + offset, sizeof(header));
+  if (std::memcmp(header.magic, kFrameMagic, sizeof(kFrameMagic)) != 0 ||
+      header.blockSize != blockSize || header.numberOfScalarColumns > header.numberOfColumns ||
+      header.positionColumn >= header.numberOfColumns ||
+      header.velocityColumn >= header.numberOfColumns ||
+      header.forceColumn >= header.numberOfColumns ||
+      header.positionColumn < header.numberOfScalarColumns ||
+      header.velocityColumn < header.numberOfScalarColumns ||
+      header.forceColumn < header.numberOfScalarColumns || header.numberOfParticles > blockSize ||
+      sizeof(FrameHeader) + header.numberOfColumns * sizeof(ColumnEntry) > blockSize) {
+    return false;
+  }
+
+  // Every column must lie inside the block and fit its encoding
+  const ColumnEntry* columns =
+      reinterpret_cast<const ColumnEntry*>(_data + offset + sizeof(header));
+  for (uint32_t i = 0; i < header.numberOfColumns; ++i) {
+    if (columns[i].offset % kAlignment != 0 || columns[i].offset > blockSize ||
+        columns[i].size > blockSize - columns[i].offset ||
+        !isValidColumn(columns[i], _data + offset + columns[i].offset, header.numberOfParticles,
+                       i == header.positionColumn, i < header.numberOfScalarColumns)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ParticleCacheReader3::isValidColumn(const ColumnEntry& column, const uint8_t* data,
+                                         uint64_t numberOfParticles, bool isPosition,
+                                         bool isScalar) const {
+  switch (column.encoding) {
+    case kRaw:
+      return column.size == numberOfParticles * (isScalar ? sizeof(double) : sizeof(Vector3D));
+    case kFloat:
+      return isScalar && column.size == numberOfParticles * sizeof(float);
+    case kHalf:
+      return !isScalar && column.size == numberOfParticles * 3 * sizeof(uint16_t);
+    case kQuantized:
+      break;
+    default:
+      return false;
+  }
+
+  QuantizedColumnHeader quantized;
+  if (!isPosition || column.size < sizeof(quantized)) {
+    return false;
+  }
+  std::memcpy(&quantized, data, sizeof(quantized));
+  if (quantized.particlesPerChunk == 0 || !(quantized.gridSpacing > 0.0) ||
+      quantized.numberOfChunks != numberOfChunks(numberOfParticles, quantized.particlesPerChunk) ||
+      quantized.numberOfChunks >= (column.size - sizeof(quantized)) / sizeof(uint64_t)) {
+    return false;
+  }
+
+  // Chunk offsets must be increasing and end inside the column
+  const size_t numberOfOffsets = quantized.numberOfChunks + 1;
+  std::vector<uint64_t> chunkOffsets(numberOfOffsets);
+  std::memcpy(chunkOffsets.data(), data + sizeof(quantized), numberOfOffsets * sizeof(uint64_t));
+  if (chunkOffsets.front() != sizeof(quantized) + numberOfOffsets * sizeof(uint64_t) ||
+      chunkOffsets.back() > column.size) {
+    return false;
+  }
+  return std::is_sorted(chunkOffsets.begin(), chunkOffsets.end());
+}
@@ -50,4 +50,22 @@ void ParticleEmitter3::setOnBeginUpdateCallback(
     _onBeginUpdateCallback = callback;
 }
 
+void ParticleEmitter3::saveState(StateArchive* archive) const {
+    archive->write(_isEnabled);
+    onSaveState(archive);
+}
+
+void ParticleEmitter3::loadState(StateArchive* archive) {
+    archive->read(&_isEnabled);
+    onLoadState(archive);
+}
+
+void ParticleEmitter3::onSaveState(StateArchive* archive) const {
+    UNUSED_VARIABLE(archive);
+}
+
+void ParticleEmitter3::onLoadState(StateArchive* archive) {
+    UNUSED_VARIABLE(archive);
+}
+
 }  // namespace jet
@@ -41,6 +41,26 @@ void ParticleEmitterSet3::onUpdate(double currentTimeInSeconds,
     }
 }
 
+void ParticleEmitterSet3::onSaveState(StateArchive* archive) const {
+    archive->write(static_cast<uint64_t>(_emitters.size()));
+    for (const auto& emitter : _emitters) {
+        emitter->saveState(archive);
+    }
+}
+
+void ParticleEmitterSet3::onLoadState(StateArchive* archive) {
+    uint64_t numberOfEmitters = 0;
+    archive->read(&numberOfEmitters);
+    if (numberOfEmitters != _emitters.size()) {
+        archive->invalidate();
+        return;
+    }
+
+    for (const auto& emitter : _emitters) {
+        emitter->loadState(archive);
+    }
+}
+
 ParticleEmitterSet3::Builder ParticleEmitterSet3::builder() {
     return Builder();
 }
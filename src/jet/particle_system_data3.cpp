@@ -17,6 +17,7 @@
 #include <jet/parallel.h>
 #include <jet/particle_system_data3.h>
 #include <jet/point_parallel_hash_grid_searcher3.h>
+#include <jet/profiler.h>
 #include <jet/timer.h>
 
 #include <algorithm>
@@ -26,6 +27,24 @@ using namespace jet;
 
 static const size_t kDefaultHashGridResolution = 8;
 
+static_assert(sizeof(fbs::Vector3D) == sizeof(Vector3D),
+              "fbs::Vector3D must have the same layout as Vector3D for zero-copy views");
+
+namespace {
+
+// Returns true if the flatbuffer vector can be viewed in place as an array of T
+template <typename T, typename FbsVector>
+bool canViewInPlace(const FbsVector* data) {
+#if FLATBUFFERS_LITTLEENDIAN
+  return reinterpret_cast<uintptr_t>(data->Data()) % alignof(T) == 0;
+#else
+  (void)data;
+  return false;
+#endif
+}
+
+}  // namespace
+
 ParticleSystemData3::ParticleSystemData3() : ParticleSystemData3(0) {}
 
 ParticleSystemData3::ParticleSystemData3(size_t numberOfParticles) {
@@ -46,6 +65,8 @@ ParticleSystemData3::ParticleSystemData3(const ParticleSystemData3& other) { set
 ParticleSystemData3::~ParticleSystemData3() {}
 
 void ParticleSystemData3::resize(size_t newNumberOfParticles) {
+  promoteAllData();
+
   _numberOfParticles = newNumberOfParticles;
 
   for (auto& attr : _scalarDataList) {
@@ -62,12 +83,18 @@ size_t ParticleSystemData3::numberOfParticles() const { return _numberOfParticle
 size_t ParticleSystemData3::addScalarData(double initialVal) {
   size_t attrIdx = _scalarDataList.size();
   _scalarDataList.emplace_back(numberOfParticles(), initialVal);
+  if (!_scalarDataViews.empty()) {
+    _scalarDataViews.emplace_back();
+  }
   return attrIdx;
 }
 
 size_t ParticleSystemData3::addVectorData(const Vector3D& initialVal) {
   size_t attrIdx = _vectorDataList.size();
   _vectorDataList.emplace_back(numberOfParticles(), initialVal);
+  if (!_vectorDataViews.empty()) {
+    _vectorDataViews.emplace_back();
+  }
   return attrIdx;
 }
 
@@ -98,18 +125,30 @@ ConstArrayAccessor1<Vector3D> ParticleSystemData3::forces() const {
 ArrayAccessor1<Vector3D> ParticleSystemData3::forces() { return vectorDataAt(_forceIdx); }
 
 ConstArrayAccessor1<double> ParticleSystemData3::scalarDataAt(size_t idx) const {
+  if (isScalarDataView(idx)) {
+    return _scalarDataViews[idx];
+  }
   return _scalarDataList[idx].constAccessor();
 }
 
 ArrayAccessor1<double> ParticleSystemData3::scalarDataAt(size_t idx) {
+  promoteScalarData(idx);
   return _scalarDataList[idx].accessor();
 }
 
+size_t ParticleSystemData3::numberOfScalarData() const { return _scalarDataList.size(); }
+
+size_t ParticleSystemData3::numberOfVectorData() const { return _vectorDataList.size(); }
+
 ConstArrayAccessor1<Vector3D> ParticleSystemData3::vectorDataAt(size_t idx) const {
+  if (isVectorDataView(idx)) {
+    return _vectorDataViews[idx];
+  }
   return _vectorDataList[idx].constAccessor();
 }
 
 ArrayAccessor1<Vector3D> ParticleSystemData3::vectorDataAt(size_t idx) {
+  promoteVectorData(idx);
   return _vectorDataList[idx].accessor();
 }
 
@@ -166,6 +205,7 @@ const std::vector<std::vector<size_t>>& ParticleSystemData3::neighborLists() con
 }
 
 void ParticleSystemData3::buildNeighborSearcher(double maxSearchRadius) {
+  JET_PROFILE_SCOPE("buildNeighborSearcher");
   Timer timer;
 
   // Use PointParallelHashGridSearcher3 by default
@@ -179,6 +219,7 @@ void ParticleSystemData3::buildNeighborSearcher(double maxSearchRadius) {
 }
 
 void ParticleSystemData3::buildNeighborLists(double maxSearchRadius) {
+  JET_PROFILE_SCOPE("buildNeighborLists");
   Timer timer;
 
   _neighborLists.resize(numberOfParticles());
@@ -218,7 +259,69 @@ void ParticleSystemData3::deserialize(const std::vector<uint8_t>& buffer) {
   deserializeParticleSystemData(fbsParticleSystemData);
 }
 
+void ParticleSystemData3::deserializeView(const std::shared_ptr<const uint8_t>& buffer) {
+  auto fbsParticleSystemData = fbs::GetParticleSystemData3(buffer.get());
+  deserializeParticleSystemData(fbsParticleSystemData, buffer);
+}
+
+bool ParticleSystemData3::isView() const { return _viewBuffer != nullptr; }
+
+void ParticleSystemData3::saveState(StateArchive* archive) const {
+  archive->write(_radius);
+  archive->write(_mass);
+  archive->write(static_cast<uint64_t>(_scalarDataList.size()));
+  archive->write(static_cast<uint64_t>(_vectorDataList.size()));
+
+  for (size_t i = 0; i < _scalarDataList.size(); ++i) {
+    archive->writeArray(scalarDataAt(i));
+  }
+
+  for (size_t i = 0; i < _vectorDataList.size(); ++i) {
+    archive->writeArray(vectorDataAt(i));
+  }
+}
+
+void ParticleSystemData3::loadState(StateArchive* archive) {
+  uint64_t numberOfScalarLayers = 0;
+  uint64_t numberOfVectorLayers = 0;
+  archive->read(&_radius);
+  archive->read(&_mass);
+  archive->read(&numberOfScalarLayers);
+  archive->read(&numberOfVectorLayers);
+  if (numberOfScalarLayers != _scalarDataList.size() ||
+      numberOfVectorLayers != _vectorDataList.size()) {
+    archive->invalidate();
+    return;
+  }
+
+  _scalarDataViews.clear();
+  _vectorDataViews.clear();
+  _viewBuffer.reset();
+
+  for (auto& attr : _scalarDataList) {
+    archive->readArray(&attr);
+  }
+
+  for (auto& attr : _vectorDataList) {
+    archive->readArray(&attr);
+  }
+
+  _numberOfParticles = _vectorDataList[_positionIdx].size();
+  for (const auto& attr : _scalarDataList) {
+    if (attr.size() != _numberOfParticles) {
+      archive->invalidate();
+    }
+  }
+  for (const auto& attr : _vectorDataList) {
+    if (attr.size() != _numberOfParticles) {
+      archive->invalidate();
+    }
+  }
+}
+
 void ParticleSystemData3::set(const ParticleSystemData3& other) {
+  promoteAllData();
+
   _radius = other._radius;
   _mass = other._mass;
   _positionIdx = other._positionIdx;
@@ -226,12 +329,21 @@ void ParticleSystemData3::set(const ParticleSystemData3& other) {
   _forceIdx = other._forceIdx;
   _numberOfParticles = other._numberOfParticles;
 
-  for (auto& attr : other._scalarDataList) {
-    _scalarDataList.emplace_back(attr);
+  // Borrowed layers of the other data are copied from their views
+  _scalarDataList.clear();
+  _vectorDataList.clear();
+  for (size_t i = 0; i < other._scalarDataList.size(); ++i) {
+    _scalarDataList.emplace_back();
+    _scalarDataList.back().resize(other._numberOfParticles);
+    other.scalarDataAt(i).parallelForEachIndex(
+        [&](size_t j) { _scalarDataList.back()[j] = other.scalarDataAt(i)[j]; });
   }
 
-  for (auto& attr : other._vectorDataList) {
-    _vectorDataList.emplace_back(attr);
+  for (size_t i = 0; i < other._vectorDataList.size(); ++i) {
+    _vectorDataList.emplace_back();
+    _vectorDataList.back().resize(other._numberOfParticles);
+    other.vectorDataAt(i).parallelForEachIndex(
+        [&](size_t j) { _vectorDataList.back()[j] = other.vectorDataAt(i)[j]; });
   }
 
   _neighborSearcher = other._neighborSearcher->clone();
@@ -248,7 +360,8 @@ void ParticleSystemData3::serializeParticleSystemData(
     flatbuffers::Offset<fbs::ParticleSystemData3>* fbsParticleSystemData) const {
   // Copy data
   std::vector<flatbuffers::Offset<fbs::ScalarParticleData3>> scalarDataList;
-  for (const auto& scalarData : _scalarDataList) {
+  for (size_t idx = 0; idx < _scalarDataList.size(); ++idx) {
+    const auto scalarData = scalarDataAt(idx);
     auto fbsScalarData = fbs::CreateScalarParticleData3(
         *builder, builder->CreateVector(scalarData.data(), scalarData.size()));
     scalarDataList.push_back(fbsScalarData);
@@ -256,7 +369,8 @@ void ParticleSystemData3::serializeParticleSystemData(
   auto fbsScalarDataList = builder->CreateVector(scalarDataList);
 
   std::vector<flatbuffers::Offset<fbs::VectorParticleData3>> vectorDataList;
-  for (const auto& vectorData : _vectorDataList) {
+  for (size_t idx = 0; idx < _vectorDataList.size(); ++idx) {
+    const auto vectorData = vectorDataAt(idx);
     std::vector<fbs::Vector3D> newVectorData;
     for (const auto& v : vectorData) {
       newVectorData.push_back(jetToFbs(v));
@@ -295,9 +409,13 @@ void ParticleSystemData3::serializeParticleSystemData(
 }
 
 void ParticleSystemData3::deserializeParticleSystemData(
-    const fbs::ParticleSystemData3* fbsParticleSystemData) {
+    const fbs::ParticleSystemData3* fbsParticleSystemData,
+    const std::shared_ptr<const uint8_t>& viewBuffer) {
   _scalarDataList.clear();
   _vectorDataList.clear();
+  _scalarDataViews.clear();
+  _vectorDataViews.clear();
+  _viewBuffer.reset();
 
   // Copy scalars
   _radius = fbsParticleSystemData->radius();
@@ -306,11 +424,25 @@ void ParticleSystemData3::deserializeParticleSystemData(
   _velocityIdx = static_cast<size_t>(fbsParticleSystemData->velocityIdx());
   _forceIdx = static_cast<size_t>(fbsParticleSystemData->forceIdx());
 
-  // Copy data
+  // Copy data, or borrow it from the buffer in view mode. A borrowed layer
+  // keeps an empty owned array until it gets promoted.
   auto fbsScalarDataList = fbsParticleSystemData->scalarDataList();
+  auto fbsVectorDataList = fbsParticleSystemData->vectorDataList();
+  if (viewBuffer != nullptr) {
+    _scalarDataViews.resize(fbsScalarDataList->size());
+    _vectorDataViews.resize(fbsVectorDataList->size());
+  }
+
   for (const auto& fbsScalarData : (*fbsScalarDataList)) {
     auto data = fbsScalarData->data();
 
+    if (viewBuffer != nullptr && canViewInPlace<double>(data)) {
+      _scalarDataViews[_scalarDataList.size()] = ConstArrayAccessor1<double>(
+          data->size(), reinterpret_cast<const double*>(data->Data()));
+      _scalarDataList.push_back(ScalarData());
+      continue;
+    }
+
     _scalarDataList.push_back(ScalarData(data->size()));
 
     auto& newData = *(_scalarDataList.rbegin());
@@ -320,10 +452,16 @@ void ParticleSystemData3::deserializeParticleSystemData(
     }
   }
 
-  auto fbsVectorDataList = fbsParticleSystemData->vectorDataList();
   for (const auto& fbsVectorData : (*fbsVectorDataList)) {
     auto data = fbsVectorData->data();
 
+    if (viewBuffer != nullptr && canViewInPlace<Vector3D>(data)) {
+      _vectorDataViews[_vectorDataList.size()] = ConstArrayAccessor1<Vector3D>(
+          data->size(), reinterpret_cast<const Vector3D*>(data->Data()));
+      _vectorDataList.push_back(VectorData());
+      continue;
+    }
+
     _vectorDataList.push_back(VectorData(data->size()));
     auto& newData = *(_vectorDataList.rbegin());
     for (uint32_t i = 0; i < data->size(); ++i) {
@@ -331,7 +469,14 @@ void ParticleSystemData3::deserializeParticleSystemData(
     }
   }
 
-  _numberOfParticles = _vectorDataList[0].size();
+  // Read the size through the const overload, which does not promote views
+  const ParticleSystemData3& self = *this;
+  _numberOfParticles = self.vectorDataAt(_positionIdx).size();
+
+  if (viewBuffer != nullptr) {
+    _viewBuffer = viewBuffer;
+    releaseViewBufferIfUnused();
+  }
 
   // Copy neighbor searcher
   auto fbsNeighborSearcher = fbsParticleSystemData->neighborSearcher();
@@ -351,3 +496,67 @@ void ParticleSystemData3::deserializeParticleSystemData(
                    [](uint64_t val) { return static_cast<size_t>(val); });
   }
 }
+
+bool ParticleSystemData3::isScalarDataView(size_t idx) const {
+  return idx < _scalarDataViews.size() && _scalarDataViews[idx].data() != nullptr;
+}
+
+bool ParticleSystemData3::isVectorDataView(size_t idx) const {
+  return idx < _vectorDataViews.size() && _vectorDataViews[idx].data() != nullptr;
+}
+
+void ParticleSystemData3::promoteScalarData(size_t idx) {
+  if (!isScalarDataView(idx)) {
+    return;
+  }
+
+  const auto view = _scalarDataViews[idx];
+  auto& data = _scalarDataList[idx];
+  data.resize(view.size());
+  view.parallelForEachIndex([&](size_t i) { data[i] = view[i]; });
+
+  _scalarDataViews[idx] = ConstArrayAccessor1<double>();
+  releaseViewBufferIfUnused();
+}
+
+void ParticleSystemData3::promoteVectorData(size_t idx) {
+  if (!isVectorDataView(idx)) {
+    return;
+  }
+
+  const auto view = _vectorDataViews[idx];
+  auto& data = _vectorDataList[idx];
+  data.resize(view.size());
+  view.parallelForEachIndex([&](size_t i) { data[i] = view[i]; });
+
+  _vectorDataViews[idx] = ConstArrayAccessor1<Vector3D>();
+  releaseViewBufferIfUnused();
+}
+
+void ParticleSystemData3::promoteAllData() {
+  for (size_t i = 0; i < _scalarDataViews.size(); ++i) {
+    promoteScalarData(i);
+  }
+
+  for (size_t i = 0; i < _vectorDataViews.size(); ++i) {
+    promoteVectorData(i);
+  }
+}
+
+void ParticleSystemData3::releaseViewBufferIfUnused() {
+  for (size_t i = 0; i < _scalarDataViews.size(); ++i) {
+    if (isScalarDataView(i)) {
+      return;
+    }
+  }
+
+  for (size_t i = 0; i < _vectorDataViews.size(); ++i) {
+    if (isVectorDataView(i)) {
+      return;
+    }
+  }
+
+  _viewBuffer.reset();
+  _scalarDataViews.clear();
+  _vectorDataViews.clear();
+}
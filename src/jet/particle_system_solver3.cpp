@@ -10,6 +10,7 @@
 #include <jet/constant_vector_field3.h>
 #include <jet/parallel.h>
 #include <jet/particle_system_solver3.h>
+#include <jet/profiler.h>
 #include <jet/timer.h>
 
 #include <algorithm>
@@ -104,24 +105,44 @@ void ParticleSystemSolver3::onInitialize() {
 }
 
 void ParticleSystemSolver3::onAdvanceTimeStep(double timeStepInSeconds) {
+    JET_PROFILE_SCOPE("ParticleSystemSolver3::onAdvanceTimeStep");
+
     beginAdvanceTimeStep(timeStepInSeconds);
 
     Timer timer;
-    accumulateForces(timeStepInSeconds);
+    {
+        JET_PROFILE_SCOPE("accumulateForces");
+        accumulateForces(timeStepInSeconds);
+    }
+    recordPhaseTime(SubTimeStepPhase::kAccumulateForces,
+                    timer.durationInSeconds());
     JET_INFO << "Accumulating forces took "
              << timer.durationInSeconds() << " seconds";
 
     timer.reset();
-    timeIntegration(timeStepInSeconds);
+    {
+        JET_PROFILE_SCOPE("timeIntegration");
+        timeIntegration(timeStepInSeconds);
+    }
+    recordPhaseTime(SubTimeStepPhase::kTimeIntegration,
+                    timer.durationInSeconds());
     JET_INFO << "Time integration took "
              << timer.durationInSeconds() << " seconds";
 
     timer.reset();
-    resolveCollision();
+    {
+        JET_PROFILE_SCOPE("resolveCollision");
+        resolveCollision();
+    }
+    recordPhaseTime(SubTimeStepPhase::kResolveCollision,
+                    timer.durationInSeconds());
     JET_INFO << "Resolving collision took "
              << timer.durationInSeconds() << " seconds";
 
     endAdvanceTimeStep(timeStepInSeconds);
+
+    currentSubTimeStepMetrics().numberOfParticles =
+        _particleSystemData->numberOfParticles();
 }
 
 void ParticleSystemSolver3::accumulateForces(double timeStepInSeconds) {
@@ -138,12 +159,22 @@ void ParticleSystemSolver3::beginAdvanceTimeStep(double timeStepInSeconds) {
 
     // Update collider and emitter
     Timer timer;
-    updateCollider(timeStepInSeconds);
+    {
+        JET_PROFILE_SCOPE("updateCollider");
+        updateCollider(timeStepInSeconds);
+    }
+    recordPhaseTime(SubTimeStepPhase::kUpdateCollider,
+                    timer.durationInSeconds());
     JET_INFO << "Update collider took "
              << timer.durationInSeconds() << " seconds";
 
     timer.reset();
-    updateEmitter(timeStepInSeconds);
+    {
+        JET_PROFILE_SCOPE("updateEmitter");
+        updateEmitter(timeStepInSeconds);
+    }
+    recordPhaseTime(SubTimeStepPhase::kUpdateEmitter,
+                    timer.durationInSeconds());
     JET_INFO << "Update emitter took "
              << timer.durationInSeconds() << " seconds";
 
@@ -151,6 +182,7 @@ void ParticleSystemSolver3::beginAdvanceTimeStep(double timeStepInSeconds) {
     size_t n = _particleSystemData->numberOfParticles();
     _newPositions.resize(n);
     _newVelocities.resize(n);
+    JET_PROFILE_COUNTER("Number of particles", n);
 
     onBeginAdvanceTimeStep(timeStepInSeconds);
 }
@@ -210,6 +242,52 @@ void ParticleSystemSolver3::setParticleSystemData(
     _particleSystemData = newParticles;
 }
 
+void ParticleSystemSolver3::onSaveState(StateArchive* archive) const {
+    archive->write(_dragCoefficient);
+    archive->write(_restitutionCoefficient);
+    archive->write(_gravity);
+
+    _particleSystemData->saveState(archive);
+
+    archive->write(_emitter != nullptr);
+    if (_emitter != nullptr) {
+        _emitter->saveState(archive);
+    }
+
+    archive->write(_collider != nullptr);
+    if (_collider != nullptr) {
+        _collider->saveState(archive);
+    }
+}
+
+void ParticleSystemSolver3::onLoadState(StateArchive* archive) {
+    archive->read(&_dragCoefficient);
+    archive->read(&_restitutionCoefficient);
+    archive->read(&_gravity);
+
+    _particleSystemData->loadState(archive);
+
+    bool hasEmitter = false;
+    archive->read(&hasEmitter);
+    if (hasEmitter != (_emitter != nullptr)) {
+        archive->invalidate();
+        return;
+    }
+    if (_emitter != nullptr) {
+        _emitter->loadState(archive);
+    }
+
+    bool hasCollider = false;
+    archive->read(&hasCollider);
+    if (hasCollider != (_collider != nullptr)) {
+        archive->invalidate();
+        return;
+    }
+    if (_collider != nullptr) {
+        _collider->loadState(archive);
+    }
+}
+
 void ParticleSystemSolver3::accumulateExternalForces() {
     size_t n = _particleSystemData->numberOfParticles();
     auto forces = _particleSystemData->forces();
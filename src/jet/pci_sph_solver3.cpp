@@ -8,6 +8,7 @@
 #include <jet/bcc_lattice_point_generator.h>
 #include <jet/parallel.h>
 #include <jet/pci_sph_solver3.h>
+#include <jet/profiler.h>
 #include <jet/sph_kernels3.h>
 
 #include <algorithm>
@@ -17,6 +18,9 @@ using namespace jet;
 // Heuristically chosen
 const double kDefaultTimeStepLimitScale = 5.0;
 
+// Minimum number of particles per task for loops with trivial bodies
+const size_t kLightLoopGrainSize = 1024;
+
 PciSphSolver3::PciSphSolver3() { setTimeStepLimitScale(kDefaultTimeStepLimitScale); }
 
 PciSphSolver3::PciSphSolver3(double targetDensity, double targetSpacing,
@@ -37,7 +41,11 @@ unsigned int PciSphSolver3::maxNumberOfIterations() const { return _maxNumberOfI
 
 void PciSphSolver3::setMaxNumberOfIterations(unsigned int n) { _maxNumberOfIterations = n; }
 
+unsigned int PciSphSolver3::lastNumberOfIterations() const { return _lastNumberOfIterations; }
+
 void PciSphSolver3::accumulatePressureForce(double timeIntervalInSeconds) {
+  JET_PROFILE_SCOPE("PciSphSolver3::accumulatePressureForce");
+
   auto particles = sphSystemData();
   const size_t numberOfParticles = particles->numberOfParticles();
   const double delta = computeDelta(timeIntervalInSeconds);
@@ -55,62 +63,80 @@ void PciSphSolver3::accumulatePressureForce(double timeIntervalInSeconds) {
 
   SphStdKernel3 kernel(particles->kernelRadius());
 
+  const ExecutionPolicy lightPolicy = ExecutionPolicy::kParallel.withGrainSize(kLightLoopGrainSize);
+
   // Initialize buffers
-  parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
-    p[i] = 0.0;
-    _pressureForces[i] = Vector3D();
-    _densityErrors[i] = 0.0;
-    ds[i] = d[i];
-  });
+  parallelFor(
+      kZeroSize, numberOfParticles,
+      [&](size_t i) {
+        p[i] = 0.0;
+        _pressureForces[i] = Vector3D();
+        _densityErrors[i] = 0.0;
+        ds[i] = d[i];
+      },
+      lightPolicy.withAffinity(_initializationAffinity));
 
   unsigned int maxNumIter = 0;
   double maxDensityError;
   double densityErrorRatio = 0.0;
 
   for (unsigned int k = 0; k < _maxNumberOfIterations; ++k) {
+    JET_PROFILE_SCOPE("PCI iteration");
+
     // Predict velocity and position
-    parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
-      _tempVelocities[i] = v[i] + timeIntervalInSeconds / mass * (f[i] + _pressureForces[i]);
-      _tempPositions[i] = x[i] + timeIntervalInSeconds * _tempVelocities[i];
-    });
+    parallelFor(
+        kZeroSize, numberOfParticles,
+        [&](size_t i) {
+          _tempVelocities[i] = v[i] + timeIntervalInSeconds / mass * (f[i] + _pressureForces[i]);
+          _tempPositions[i] = x[i] + timeIntervalInSeconds * _tempVelocities[i];
+        },
+        lightPolicy.withAffinity(_predictionAffinity));
 
     // Resolve collisions
     resolveCollision(_tempPositions, _tempVelocities);
 
     // Compute pressure from density error
-    parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
-      double weightSum = 0.0;
-      const auto& neighbors = particles->neighborLists()[i];
-
-      for (size_t j : neighbors) {
-        double dist = _tempPositions[j].distanceTo(_tempPositions[i]);
-        weightSum += kernel(dist);
-      }
-      weightSum += kernel(0);
-
-      double density = mass * weightSum;
-      double densityError = (density - targetDensity);
-      double pressure = delta * densityError;
-
-      if (pressure < 0.0) {
-        pressure *= negativePressureScale();
-        densityError *= negativePressureScale();
-      }
-
-      p[i] += pressure;
-      ds[i] = density;
-      _densityErrors[i] = densityError;
-    });
+    parallelFor(
+        kZeroSize, numberOfParticles,
+        [&](size_t i) {
+          double weightSum = 0.0;
+          const auto& neighbors = particles->neighborLists()[i];
+
+          for (size_t j : neighbors) {
+            double dist = _tempPositions[j].distanceTo(_tempPositions[i]);
+            weightSum += kernel(dist);
+          }
+          weightSum += kernel(0);
+
+          double density = mass * weightSum;
+          double densityError = (density - targetDensity);
+          double pressure = delta * densityError;
+
+          if (pressure < 0.0) {
+            pressure *= negativePressureScale();
+            densityError *= negativePressureScale();
+          }
+
+          p[i] += pressure;
+          ds[i] = density;
+          _densityErrors[i] = densityError;
+        },
+        ExecutionPolicy::kParallel.withAffinity(_densityAffinity));
 
     // Compute pressure gradient force
     _pressureForces.set(Vector3D());
     SphSolver3::accumulatePressureForce(x, ds.constAccessor(), p, _pressureForces.accessor());
 
     // Compute max density error
-    maxDensityError = 0.0;
-    for (size_t i = 0; i < numberOfParticles; ++i) {
-      maxDensityError = absmax(maxDensityError, _densityErrors[i]);
-    }
+    maxDensityError = parallelDeterministicReduce(
+        kZeroSize, numberOfParticles, 0.0,
+        [this](size_t k1, size_t k2, double result) {
+          for (size_t i = k1; i < k2; ++i) {
+            result = absmax(result, _densityErrors[i]);
+          }
+          return result;
+        },
+        [](double a, double b) { return absmax(a, b); });
 
     densityErrorRatio = maxDensityError / targetDensity;
     maxNumIter = k + 1;
@@ -120,7 +146,12 @@ void PciSphSolver3::accumulatePressureForce(double timeIntervalInSeconds) {
     }
   }
 
+  _lastNumberOfIterations = maxNumIter;
+  currentSubTimeStepMetrics().numberOfPressureIterations = maxNumIter;
+  currentSubTimeStepMetrics().maxDensityErrorRatio = std::fabs(densityErrorRatio);
   JET_INFO << "Number of PCI iterations: " << maxNumIter;
+  JET_PROFILE_COUNTER("Number of PCI iterations", maxNumIter);
+  JET_PROFILE_COUNTER("Max density error", maxDensityError);
   JET_INFO << "Max density error after PCI iteration: " << maxDensityError;
   if (std::fabs(densityErrorRatio) > _maxDensityErrorRatio) {
     JET_WARN << "Max density error ratio is greater than the threshold!";
@@ -128,7 +159,9 @@ void PciSphSolver3::accumulatePressureForce(double timeIntervalInSeconds) {
   }
 
   // Accumulate pressure force
-  parallelFor(kZeroSize, numberOfParticles, [this, &f](size_t i) { f[i] += _pressureForces[i]; });
+  parallelFor(
+      kZeroSize, numberOfParticles, [this, &f](size_t i) { f[i] += _pressureForces[i]; },
+      lightPolicy.withAffinity(_forceAccumulationAffinity));
 }
 
 void PciSphSolver3::onBeginAdvanceTimeStep(double timeStepInSeconds) {
@@ -185,6 +218,22 @@ double PciSphSolver3::computeBeta(double timeStepInSeconds) {
   return 2.0 * square(particles->mass() * timeStepInSeconds / particles->targetDensity());
 }
 
+void PciSphSolver3::onSaveState(StateArchive* archive) const {
+  archive->write(_maxDensityErrorRatio);
+  archive->write(_maxNumberOfIterations);
+  archive->write(_lastNumberOfIterations);
+
+  SphSolver3::onSaveState(archive);
+}
+
+void PciSphSolver3::onLoadState(StateArchive* archive) {
+  archive->read(&_maxDensityErrorRatio);
+  archive->read(&_maxNumberOfIterations);
+  archive->read(&_lastNumberOfIterations);
+
+  SphSolver3::onLoadState(archive);
+}
+
 PciSphSolver3::Builder PciSphSolver3::builder() { return Builder(); }
 
 PciSphSolver3 PciSphSolver3::Builder::build() const {
@@ -8,12 +8,36 @@
 
 #include <jet/constants.h>
 #include <jet/physics_animation.h>
+#include <jet/profiler.h>
 #include <jet/timer.h>
 
 #include <limits>
 
 using namespace jet;
 
+const char* jet::subTimeStepPhaseName(SubTimeStepPhase phase) {
+    switch (phase) {
+        case SubTimeStepPhase::kUpdateCollider:
+            return "update_collider";
+        case SubTimeStepPhase::kUpdateEmitter:
+            return "update_emitter";
+        case SubTimeStepPhase::kNeighborSearch:
+            return "neighbor_search";
+        case SubTimeStepPhase::kDensity:
+            return "density";
+        case SubTimeStepPhase::kAccumulateForces:
+            return "accumulate_forces";
+        case SubTimeStepPhase::kPressure:
+            return "pressure";
+        case SubTimeStepPhase::kTimeIntegration:
+            return "time_integration";
+        case SubTimeStepPhase::kResolveCollision:
+            return "resolve_collision";
+        default:
+            return "";
+    }
+}
+
 PhysicsAnimation::PhysicsAnimation() { _currentFrame.index = -1; }
 
 PhysicsAnimation::~PhysicsAnimation() {}
@@ -48,6 +72,63 @@ void PhysicsAnimation::setCurrentFrame(const Frame& frame) {
 
 double PhysicsAnimation::currentTimeInSeconds() const { return _currentTime; }
 
+unsigned int PhysicsAnimation::lastNumberOfSubTimeSteps() const {
+    return _lastNumberOfSubTimeSteps;
+}
+
+void PhysicsAnimation::setSubTimeStepCallback(
+    const SubTimeStepCallback& callback) {
+    _subTimeStepCallback = callback;
+}
+
+std::vector<SubTimeStepMetrics> PhysicsAnimation::metricsHistory() const {
+    return std::vector<SubTimeStepMetrics>(_metricsHistory.begin(),
+                                           _metricsHistory.end());
+}
+
+size_t PhysicsAnimation::metricsHistorySize() const {
+    return _metricsHistorySize;
+}
+
+void PhysicsAnimation::setMetricsHistorySize(size_t size) {
+    _metricsHistorySize = size;
+    while (_metricsHistory.size() > _metricsHistorySize) {
+        _metricsHistory.pop_front();
+    }
+}
+
+void PhysicsAnimation::saveState(StateArchive* archive) const {
+    archive->write(_currentFrame.index);
+    archive->write(_currentFrame.timeIntervalInSeconds);
+    archive->write(_isUsingFixedSubTimeSteps);
+    archive->write(_numberOfFixedSubTimeSteps);
+    archive->write(_currentTime);
+    archive->write(_lastNumberOfSubTimeSteps);
+
+    onSaveState(archive);
+}
+
+void PhysicsAnimation::loadState(StateArchive* archive) {
+    archive->read(&_currentFrame.index);
+    archive->read(&_currentFrame.timeIntervalInSeconds);
+    archive->read(&_isUsingFixedSubTimeSteps);
+    archive->read(&_numberOfFixedSubTimeSteps);
+    archive->read(&_currentTime);
+    archive->read(&_lastNumberOfSubTimeSteps);
+
+    onLoadState(archive);
+}
+
+SubTimeStepMetrics& PhysicsAnimation::currentSubTimeStepMetrics() {
+    return _currentSubTimeStepMetrics;
+}
+
+void PhysicsAnimation::recordPhaseTime(SubTimeStepPhase phase,
+                                       double seconds) {
+    _currentSubTimeStepMetrics
+        .phaseTimesInSeconds[static_cast<size_t>(phase)] += seconds;
+}
+
 unsigned int PhysicsAnimation::numberOfSubTimeSteps(
     double timeIntervalInSeconds) const {
     UNUSED_VARIABLE(timeIntervalInSeconds);
@@ -65,6 +146,7 @@ void PhysicsAnimation::onUpdate(const Frame& frame) {
         int32_t numberOfFrames = frame.index - _currentFrame.index;
 
         for (int32_t i = 0; i < numberOfFrames; ++i) {
+            _frameIndexInProgress = _currentFrame.index + i + 1;
             advanceTimeStep(frame.timeIntervalInSeconds);
         }
 
@@ -73,7 +155,10 @@ void PhysicsAnimation::onUpdate(const Frame& frame) {
 }
 
 void PhysicsAnimation::advanceTimeStep(double timeIntervalInSeconds) {
+    JET_PROFILE_SCOPE("PhysicsAnimation::advanceTimeStep");
+
     _currentTime = _currentFrame.timeInSeconds();
+    _lastNumberOfSubTimeSteps = 0;
 
     if (_isUsingFixedSubTimeSteps) {
         JET_INFO << "Using fixed sub-timesteps: " << _numberOfFixedSubTimeSteps;
@@ -84,16 +169,7 @@ void PhysicsAnimation::advanceTimeStep(double timeIntervalInSeconds) {
             static_cast<double>(_numberOfFixedSubTimeSteps);
 
         for (unsigned int i = 0; i < _numberOfFixedSubTimeSteps; ++i) {
-            JET_INFO << "Begin onAdvanceTimeStep: " << actualTimeInterval
-                     << " (1/" << 1.0 / actualTimeInterval << ") seconds";
-
-            Timer timer;
-            onAdvanceTimeStep(actualTimeInterval);
-
-            JET_INFO << "End onAdvanceTimeStep (took "
-                     << timer.durationInSeconds() << " seconds)";
-
-            _currentTime += actualTimeInterval;
+            advanceSubTimeStep(actualTimeInterval);
         }
     } else {
         JET_INFO << "Using adaptive sub-timesteps";
@@ -107,19 +183,46 @@ void PhysicsAnimation::advanceTimeStep(double timeIntervalInSeconds) {
 
             JET_INFO << "Number of remaining sub-timesteps: " << numSteps;
 
-            JET_INFO << "Begin onAdvanceTimeStep: " << actualTimeInterval
-                     << " (1/" << 1.0 / actualTimeInterval << ") seconds";
+            advanceSubTimeStep(actualTimeInterval);
 
-            Timer timer;
-            onAdvanceTimeStep(actualTimeInterval);
+            remainingTime -= actualTimeInterval;
+        }
+    }
+}
 
-            JET_INFO << "End onAdvanceTimeStep (took "
-                     << timer.durationInSeconds() << " seconds)";
+void PhysicsAnimation::advanceSubTimeStep(double timeIntervalInSeconds) {
+    _currentSubTimeStepMetrics = SubTimeStepMetrics();
+    _currentSubTimeStepMetrics.frameIndex = _frameIndexInProgress;
+    _currentSubTimeStepMetrics.subTimeStepIndex = _lastNumberOfSubTimeSteps;
+    _currentSubTimeStepMetrics.timeInSeconds = _currentTime;
+    _currentSubTimeStepMetrics.timeIntervalInSeconds = timeIntervalInSeconds;
 
-            remainingTime -= actualTimeInterval;
-            _currentTime += actualTimeInterval;
+    JET_INFO << "Begin onAdvanceTimeStep: " << timeIntervalInSeconds
+             << " (1/" << 1.0 / timeIntervalInSeconds << ") seconds";
+
+    Timer timer;
+    {
+        JET_PROFILE_SCOPE("Substep");
+        onAdvanceTimeStep(timeIntervalInSeconds);
+    }
+    _currentSubTimeStepMetrics.wallTimeInSeconds = timer.durationInSeconds();
+
+    JET_INFO << "End onAdvanceTimeStep (took "
+             << _currentSubTimeStepMetrics.wallTimeInSeconds << " seconds)";
+
+    _currentTime += timeIntervalInSeconds;
+    ++_lastNumberOfSubTimeSteps;
+
+    if (_metricsHistorySize > 0) {
+        _metricsHistory.push_back(_currentSubTimeStepMetrics);
+        while (_metricsHistory.size() > _metricsHistorySize) {
+            _metricsHistory.pop_front();
         }
     }
+
+    if (_subTimeStepCallback) {
+        _subTimeStepCallback(_currentSubTimeStepMetrics);
+    }
 }
 
 void PhysicsAnimation::initialize() { onInitialize(); }
@@ -127,3 +230,11 @@ void PhysicsAnimation::initialize() { onInitialize(); }
 void PhysicsAnimation::onInitialize() {
     // Do nothing
 }
+
+void PhysicsAnimation::onSaveState(StateArchive* archive) const {
+    UNUSED_VARIABLE(archive);
+}
+
+void PhysicsAnimation::onLoadState(StateArchive* archive) {
+    UNUSED_VARIABLE(archive);
+}
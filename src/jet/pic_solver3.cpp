@@ -11,12 +11,23 @@
 #include <pch.h>
 #include <jet/array_utils.h>
 #include <jet/level_set_utils.h>
+#include <jet/parallel.h>
 #include <jet/pic_solver3.h>
 #include <jet/timer.h>
 #include <algorithm>
+#include <numeric>
 
 using namespace jet;
 
+namespace {
+
+// Edge length of the particle blocks in cells. A particle scatters to the
+// grid points within one cell of its own, so blocks of the same color are
+// independent for any size of two or more.
+const size_t kParticleBlockSize = 4;
+
+}  // namespace
+
 PicSolver3::PicSolver3() : PicSolver3({1, 1, 1}, {1, 1, 1}, {0, 0, 0}) {
 }
 
@@ -119,7 +130,6 @@ void PicSolver3::transferFromParticlesToGrids() {
     auto flow = gridSystemData()->velocity();
     auto positions = _particles->positions();
     auto velocities = _particles->velocities();
-    size_t numberOfParticles = _particles->numberOfParticles();
 
     // Clear velocity to zero
     flow->fill(Vector3D());
@@ -149,7 +159,7 @@ void PicSolver3::transferFromParticlesToGrids() {
         flow->wConstAccessor(),
         flow->gridSpacing(),
         flow->wOrigin());
-    for (size_t i = 0; i < numberOfParticles; ++i) {
+    forEachParticleInColoredBlocks([&](size_t i) {
         std::array<Point3UI, 8> indices;
         std::array<double, 8> weights;
 
@@ -173,7 +183,7 @@ void PicSolver3::transferFromParticlesToGrids() {
             wWeight(indices[j]) += weights[j];
             _wMarkers(indices[j]) = 1;
         }
-    }
+    });
 
     uWeight.parallelForEachIndex([&](size_t i, size_t j, size_t k) {
         if (uWeight(i, j, k) > 0.0) {
@@ -192,6 +202,58 @@ void PicSolver3::transferFromParticlesToGrids() {
     });
 }
 
+void PicSolver3::bucketParticlesByBlock() {
+    auto grids = gridSystemData();
+    const Size3 resolution = grids->resolution();
+    const Vector3D gridSpacing = grids->gridSpacing();
+    const Vector3D origin = grids->origin();
+    auto positions = _particles->positions();
+    const size_t numberOfParticles = _particles->numberOfParticles();
+
+    _numberOfParticleBlocks = Size3(
+        (resolution.x + kParticleBlockSize - 1) / kParticleBlockSize,
+        (resolution.y + kParticleBlockSize - 1) / kParticleBlockSize,
+        (resolution.z + kParticleBlockSize - 1) / kParticleBlockSize);
+    const size_t totalNumberOfBlocks = _numberOfParticleBlocks.x *
+                                       _numberOfParticleBlocks.y *
+                                       _numberOfParticleBlocks.z;
+
+    // Particles outside the grid belong to the nearest boundary cell, which
+    // is also where the samplers clamp them to
+    auto blockCoordinate = [](double x, double h, size_t n) {
+        const double cell = clamp(std::floor(x / h), 0.0, n - 1.0);
+        return static_cast<size_t>(cell) / kParticleBlockSize;
+    };
+
+    // Bucket the particles by block with a stable counting sort
+    _particleBlocks.resize(numberOfParticles);
+    parallelFor(kZeroSize, numberOfParticles, [&](size_t i) {
+        const Vector3D x = positions[i] - origin;
+        const size_t bi = blockCoordinate(x.x, gridSpacing.x, resolution.x);
+        const size_t bj = blockCoordinate(x.y, gridSpacing.y, resolution.y);
+        const size_t bk = blockCoordinate(x.z, gridSpacing.z, resolution.z);
+        _particleBlocks[i] =
+            bi + _numberOfParticleBlocks.x *
+                     (bj + _numberOfParticleBlocks.y * bk);
+    });
+
+    _blockPointers.assign(totalNumberOfBlocks + 1, 0);
+    for (size_t i = 0; i < numberOfParticles; ++i) {
+        ++_blockPointers[_particleBlocks[i] + 1];
+    }
+    std::partial_sum(_blockPointers.begin(), _blockPointers.end(),
+                     _blockPointers.begin());
+
+    _particlesByBlock.resize(numberOfParticles);
+    for (size_t i = 0; i < numberOfParticles; ++i) {
+        // Advance the block's begin pointer and restore it below
+        _particlesByBlock[_blockPointers[_particleBlocks[i]]++] = i;
+    }
+    std::copy_backward(_blockPointers.begin(), _blockPointers.end() - 1,
+                       _blockPointers.end());
+    _blockPointers[0] = 0;
+}
+
 void PicSolver3::transferFromGridsToParticles() {
     auto flow = gridSystemData()->velocity();
     auto positions = _particles->positions();
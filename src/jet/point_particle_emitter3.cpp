@@ -89,6 +89,20 @@ void PointParticleEmitter3::onUpdate(
     }
 }
 
+void PointParticleEmitter3::onSaveState(StateArchive* archive) const {
+    archive->write(_rng);
+    archive->write(_firstFrameTimeInSeconds);
+    archive->write(static_cast<uint64_t>(_numberOfEmittedParticles));
+}
+
+void PointParticleEmitter3::onLoadState(StateArchive* archive) {
+    uint64_t numberOfEmittedParticles = 0;
+    archive->read(&_rng);
+    archive->read(&_firstFrameTimeInSeconds);
+    archive->read(&numberOfEmittedParticles);
+    _numberOfEmittedParticles = static_cast<size_t>(numberOfEmittedParticles);
+}
+
 void PointParticleEmitter3::emit(
     Array1<Vector3D>* newPositions,
     Array1<Vector3D>* newVelocities,
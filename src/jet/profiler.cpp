@@ -0,0 +1,167 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#include <pch.h>
+
+#include <jet/logging.h>
+#include <jet/profiler.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace jet {
+
+namespace internal {
+
+std::atomic<bool> sIsProfilingEnabled{false};
+
+}  // namespace internal
+
+namespace {
+
+const auto kProfilerEpoch = std::chrono::steady_clock::now();
+
+struct ProfileEvent {
+  // 'X' for a zone, 'C' for a counter, 'i' for a frame marker
+  char phase;
+  const char* name;
+  int64_t timestamp;
+  int64_t duration;
+  double value;
+};
+
+// Events of one thread. The mutex is only contended while a trace is written.
+struct ThreadEvents {
+  unsigned int threadId = 0;
+  std::mutex mutex;
+  std::vector<ProfileEvent> events;
+};
+
+std::mutex sThreadsMutex;
+std::vector<std::shared_ptr<ThreadEvents>> sThreads;
+
+ThreadEvents& localEvents() {
+  static thread_local std::shared_ptr<ThreadEvents> local;
+  if (!local) {
+    local = std::make_shared<ThreadEvents>();
+    std::lock_guard<std::mutex> lock(sThreadsMutex);
+    local->threadId = static_cast<unsigned int>(sThreads.size());
+    sThreads.push_back(local);
+  }
+  return *local;
+}
+
+void record(const ProfileEvent& event) {
+  ThreadEvents& local = localEvents();
+  std::lock_guard<std::mutex> lock(local.mutex);
+  local.events.push_back(event);
+}
+
+void writeEscaped(std::ostream& strm, const char* str) {
+  for (; *str != '\0'; ++str) {
+    if (*str == '"' || *str == '\\') {
+      strm << '\\';
+    }
+    strm << *str;
+  }
+}
+
+}  // namespace
+
+void Profiler::setEnabled(bool isEnabled) {
+  internal::sIsProfilingEnabled = isEnabled;
+}
+
+void Profiler::beginFrame(unsigned int frameIndex) {
+  if (isEnabled()) {
+    record({'i', "Frame", now(), 0, static_cast<double>(frameIndex)});
+  }
+}
+
+void Profiler::writeChromeTrace(const std::string& filename) {
+  std::vector<std::pair<unsigned int, std::vector<ProfileEvent>>> threads;
+  {
+    std::lock_guard<std::mutex> lock(sThreadsMutex);
+    for (const auto& thread : sThreads) {
+      std::lock_guard<std::mutex> threadLock(thread->mutex);
+      threads.emplace_back(thread->threadId, std::move(thread->events));
+      thread->events.clear();
+    }
+  }
+
+  std::ofstream file(filename.c_str());
+  if (!file) {
+    JET_ERROR << "Cannot write trace to " << filename;
+    return;
+  }
+
+  char timestamp[64];
+  auto toMicroseconds = [&timestamp](int64_t nanoseconds) {
+    snprintf(timestamp, sizeof(timestamp), "%.3f", nanoseconds / 1000.0);
+    return timestamp;
+  };
+
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool isFirst = true;
+  for (const auto& thread : threads) {
+    if (thread.second.empty()) {
+      continue;
+    }
+
+    file << (isFirst ? "" : ",") << "\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,"
+         << "\"tid\":" << thread.first << ",\"args\":{\"name\":\"Thread "
+         << thread.first << "\"}}";
+    isFirst = false;
+
+    for (const ProfileEvent& event : thread.second) {
+      file << ",\n{\"ph\":\"" << event.phase << "\",\"name\":\"";
+      writeEscaped(file, event.name);
+      file << "\",\"pid\":0,\"tid\":" << thread.first
+           << ",\"ts\":" << toMicroseconds(event.timestamp);
+      switch (event.phase) {
+        case 'X':
+          file << ",\"dur\":" << toMicroseconds(event.duration);
+          break;
+        case 'C':
+          file << ",\"args\":{\"value\":" << event.value << "}";
+          break;
+        default:
+          file << ",\"s\":\"g\",\"args\":{\"index\":" << event.value << "}";
+          break;
+      }
+      file << "}";
+    }
+  }
+  file << "\n]}\n";
+}
+
+void Profiler::clear() {
+  std::lock_guard<std::mutex> lock(sThreadsMutex);
+  for (const auto& thread : sThreads) {
+    std::lock_guard<std::mutex> threadLock(thread->mutex);
+    thread->events.clear();
+  }
+}
+
+int64_t Profiler::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - kProfilerEpoch)
+      .count();
+}
+
+void Profiler::recordZone(const char* name, int64_t begin, int64_t end) {
+  record({'X', name, begin, end - begin, 0.0});
+}
+
+void Profiler::recordCounter(const char* name, double value) {
+  record({'C', name, now(), 0, value});
+}
+
+}  // namespace jet
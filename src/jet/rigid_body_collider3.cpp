@@ -27,6 +27,16 @@ Vector3D RigidBodyCollider3::velocityAt(const Vector3D& point) const {
     return linearVelocity + angularVelocity.cross(r);
 }
 
+void RigidBodyCollider3::onSaveState(StateArchive* archive) const {
+    archive->write(linearVelocity);
+    archive->write(angularVelocity);
+}
+
+void RigidBodyCollider3::onLoadState(StateArchive* archive) {
+    archive->read(&linearVelocity);
+    archive->read(&angularVelocity);
+}
+
 RigidBodyCollider3::Builder RigidBodyCollider3::builder() {
     return Builder();
 }
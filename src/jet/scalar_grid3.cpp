@@ -47,6 +47,7 @@ void ScalarGrid3::resize(size_t resolutionX, size_t resolutionY,
 
 void ScalarGrid3::resize(const Size3& resolution, const Vector3D& gridSpacing,
                          const Vector3D& origin, double initialValue) {
+    promoteData();
     setSizeParameters(resolution, gridSpacing, origin);
 
     _data.resize(dataSize(), initialValue);
@@ -65,19 +66,26 @@ void ScalarGrid3::resize(const Vector3D& gridSpacing, const Vector3D& origin) {
 }
 
 const double& ScalarGrid3::operator()(size_t i, size_t j, size_t k) const {
+    if (_viewBuffer != nullptr) {
+        return _view(i, j, k);
+    }
     return _data(i, j, k);
 }
 
 double& ScalarGrid3::operator()(size_t i, size_t j, size_t k) {
+    // Returns right away unless the grid is still a view. The parallel
+    // entry points promote before their loops, so this only copies on the
+    // first serial access.
+    promoteData();
     return _data(i, j, k);
 }
 
 Vector3D ScalarGrid3::gradientAtDataPoint(size_t i, size_t j, size_t k) const {
-    return gradient3(_data.constAccessor(), gridSpacing(), i, j, k);
+    return gradient3(dataView(), gridSpacing(), i, j, k);
 }
 
 double ScalarGrid3::laplacianAtDataPoint(size_t i, size_t j, size_t k) const {
-    return laplacian3(_data.constAccessor(), gridSpacing(), i, j, k);
+    return laplacian3(dataView(), gridSpacing(), i, j, k);
 }
 
 double ScalarGrid3::sample(const Vector3D& x) const { return _sampler(x); }
@@ -117,11 +125,12 @@ double ScalarGrid3::laplacian(const Vector3D& x) const {
 }
 
 ScalarGrid3::ScalarDataAccessor ScalarGrid3::dataAccessor() {
+    promoteData();
     return _data.accessor();
 }
 
 ScalarGrid3::ConstScalarDataAccessor ScalarGrid3::constDataAccessor() const {
-    return _data.constAccessor();
+    return dataView();
 }
 
 ScalarGrid3::DataPositionFunc ScalarGrid3::dataPosition() const {
@@ -132,6 +141,14 @@ ScalarGrid3::DataPositionFunc ScalarGrid3::dataPosition() const {
 }
 
 void ScalarGrid3::fill(double value, ExecutionPolicy policy) {
+    // Every value gets overwritten, so the view does not need to be copied
+    if (_viewBuffer != nullptr) {
+        _data.resize(_view.size());
+        _view = ConstArrayAccessor3<double>();
+        _viewBuffer.reset();
+        resetSampler();
+    }
+
     parallelFor(
         kZeroSize, _data.width(), kZeroSize, _data.height(), kZeroSize,
         _data.depth(),
@@ -141,6 +158,7 @@ void ScalarGrid3::fill(double value, ExecutionPolicy policy) {
 
 void ScalarGrid3::fill(const std::function<double(const Vector3D&)>& func,
                        ExecutionPolicy policy) {
+    promoteData();
     DataPositionFunc pos = dataPosition();
     parallelFor(kZeroSize, _data.width(), kZeroSize, _data.height(), kZeroSize,
                 _data.depth(),
@@ -152,11 +170,24 @@ void ScalarGrid3::fill(const std::function<double(const Vector3D&)>& func,
 
 void ScalarGrid3::forEachDataPointIndex(
     const std::function<void(size_t, size_t, size_t)>& func) const {
-    _data.forEachIndex(func);
+    dataView().forEachIndex(func);
 }
 
 void ScalarGrid3::parallelForEachDataPointIndex(
     const std::function<void(size_t, size_t, size_t)>& func) const {
+    dataView().parallelForEachIndex(func);
+}
+
+void ScalarGrid3::forEachDataPointIndex(
+    const std::function<void(size_t, size_t, size_t)>& func) {
+    // Promote before the loop since func may write through operator()
+    promoteData();
+    _data.forEachIndex(func);
+}
+
+void ScalarGrid3::parallelForEachDataPointIndex(
+    const std::function<void(size_t, size_t, size_t)>& func) {
+    promoteData();
     _data.parallelForEachIndex(func);
 }
 
@@ -189,17 +220,51 @@ void ScalarGrid3::deserialize(const std::vector<uint8_t>& buffer) {
     resize(fbsToJet(*fbsGrid->resolution()), fbsToJet(*fbsGrid->gridSpacing()),
            fbsToJet(*fbsGrid->origin()));
 
+    // Copy straight into the grid without a temporary linear array
     auto data = fbsGrid->data();
-    std::vector<double> gridData(data->size());
-    std::copy(data->begin(), data->end(), gridData.begin());
+    JET_ASSERT(_data.width() * _data.height() * _data.depth() == data->size());
+    std::copy(data->begin(), data->end(), _data.begin());
+}
+
+void ScalarGrid3::deserializeView(
+    const std::shared_ptr<const uint8_t>& buffer) {
+    auto fbsGrid = fbs::GetScalarGrid3(buffer.get());
+    auto data = fbsGrid->data();
+
+#if FLATBUFFERS_LITTLEENDIAN
+    const bool canView =
+        reinterpret_cast<uintptr_t>(data->Data()) % alignof(double) == 0;
+#else
+    const bool canView = false;
+#endif
+    if (!canView) {
+        resize(fbsToJet(*fbsGrid->resolution()),
+               fbsToJet(*fbsGrid->gridSpacing()), fbsToJet(*fbsGrid->origin()));
+        std::copy(data->begin(), data->end(), _data.begin());
+        return;
+    }
 
-    setData(gridData);
+    promoteData();
+    setSizeParameters(fbsToJet(*fbsGrid->resolution()),
+                      fbsToJet(*fbsGrid->gridSpacing()),
+                      fbsToJet(*fbsGrid->origin()));
+    JET_ASSERT(dataSize().x * dataSize().y * dataSize().z == data->size());
+
+    _data.clear();
+    _view = ConstArrayAccessor3<double>(
+        dataSize(), reinterpret_cast<const double*>(data->Data()));
+    _viewBuffer = buffer;
+    resetSampler();
 }
 
+bool ScalarGrid3::isView() const { return _viewBuffer != nullptr; }
+
 void ScalarGrid3::swapScalarGrid(ScalarGrid3* other) {
     swapGrid(other);
 
     _data.swap(other->_data);
+    std::swap(_view, other->_view);
+    std::swap(_viewBuffer, other->_viewBuffer);
     std::swap(_linearSampler, other->_linearSampler);
     std::swap(_sampler, other->_sampler);
 }
@@ -207,28 +272,56 @@ void ScalarGrid3::swapScalarGrid(ScalarGrid3* other) {
 void ScalarGrid3::setScalarGrid(const ScalarGrid3& other) {
     setGrid(other);
 
+    // A borrowed grid is shared rather than copied since both are read-only
     _data.set(other._data);
+    _view = other._view;
+    _viewBuffer = other._viewBuffer;
     resetSampler();
 }
 
 void ScalarGrid3::resetSampler() {
     _linearSampler = LinearArraySampler3<double, double>(
-        _data.constAccessor(), gridSpacing(), dataOrigin());
+        dataView(), gridSpacing(), dataOrigin());
     _sampler = _linearSampler.functor();
 }
 
 void ScalarGrid3::getData(std::vector<double>* data) const {
     size_t size = dataSize().x * dataSize().y * dataSize().z;
     data->resize(size);
-    std::copy(_data.begin(), _data.end(), data->begin());
+    const auto view = dataView();
+    std::copy(view.data(), view.data() + size, data->begin());
 }
 
 void ScalarGrid3::setData(const std::vector<double>& data) {
     JET_ASSERT(dataSize().x * dataSize().y * dataSize().z == data.size());
 
+    promoteData();
+
     std::copy(data.begin(), data.end(), _data.begin());
 }
 
+ConstArrayAccessor3<double> ScalarGrid3::dataView() const {
+    if (_viewBuffer != nullptr) {
+        return _view;
+    }
+    return _data.constAccessor();
+}
+
+void ScalarGrid3::promoteData() {
+    if (_viewBuffer == nullptr) {
+        return;
+    }
+
+    const auto view = _view;
+    _data.resize(view.size());
+    view.parallelForEachIndex(
+        [&](size_t i, size_t j, size_t k) { _data(i, j, k) = view(i, j, k); });
+
+    _view = ConstArrayAccessor3<double>();
+    _viewBuffer.reset();
+    resetSampler();
+}
+
 ScalarGridBuilder3::ScalarGridBuilder3() {}
 
 ScalarGridBuilder3::~ScalarGridBuilder3() {}
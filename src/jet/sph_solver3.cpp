@@ -7,6 +7,7 @@
 #include <pch.h>
 #include <physics_helpers.h>
 #include <jet/parallel.h>
+#include <jet/profiler.h>
 #include <jet/sph_kernels3.h>
 #include <jet/sph_solver3.h>
 #include <jet/timer.h>
@@ -82,11 +83,8 @@ unsigned int SphSolver3::numberOfSubTimeSteps(double timeIntervalInSeconds) cons
   const double kernelRadius = particles->kernelRadius();
   const double mass = particles->mass();
 
-  double maxForceMagnitude = 0.0;
-
-  for (size_t i = 0; i < numberOfParticles; ++i) {
-    maxForceMagnitude = std::max(maxForceMagnitude, f[i].length());
-  }
+  double maxForceMagnitude =
+      parallelMax(kZeroSize, numberOfParticles, 0.0, [&](size_t i) { return f[i].length(); });
 
   double timeStepLimitBySpeed = kTimeStepLimitBySpeedFactor * kernelRadius / _speedOfSound;
   double timeStepLimitByForce =
@@ -100,7 +98,10 @@ unsigned int SphSolver3::numberOfSubTimeSteps(double timeIntervalInSeconds) cons
 
 void SphSolver3::accumulateForces(double timeStepInSeconds) {
   accumulateNonPressureForces(timeStepInSeconds);
+
+  Timer timer;
   accumulatePressureForce(timeStepInSeconds);
+  recordPhaseTime(SubTimeStepPhase::kPressure, timer.durationInSeconds());
 }
 
 void SphSolver3::onBeginAdvanceTimeStep(double timeStepInSeconds) {
@@ -111,10 +112,19 @@ void SphSolver3::onBeginAdvanceTimeStep(double timeStepInSeconds) {
   Timer timer;
   particles->buildNeighborSearcher();
   particles->buildNeighborLists();
-  particles->updateDensities();
+  const double neighborSearchSeconds = timer.durationInSeconds();
+  recordPhaseTime(SubTimeStepPhase::kNeighborSearch, neighborSearchSeconds);
 
-  JET_INFO << "Building neighbor lists and updating densities took " << timer.durationInSeconds()
-           << " seconds";
+  timer.reset();
+  {
+    JET_PROFILE_SCOPE("updateDensities");
+    particles->updateDensities();
+  }
+  const double densitySeconds = timer.durationInSeconds();
+  recordPhaseTime(SubTimeStepPhase::kDensity, densitySeconds);
+
+  JET_INFO << "Building neighbor lists took " << neighborSearchSeconds
+           << " seconds, updating densities took " << densitySeconds << " seconds";
 }
 
 void SphSolver3::onEndAdvanceTimeStep(double timeStepInSeconds) {
@@ -124,10 +134,8 @@ void SphSolver3::onEndAdvanceTimeStep(double timeStepInSeconds) {
   size_t numberOfParticles = particles->numberOfParticles();
   auto densities = particles->densities();
 
-  double maxDensity = 0.0;
-  for (size_t i = 0; i < numberOfParticles; ++i) {
-    maxDensity = std::max(maxDensity, densities[i]);
-  }
+  double maxDensity =
+      parallelMax(kZeroSize, numberOfParticles, 0.0, [&](size_t i) { return densities[i]; });
 
   JET_INFO << "Max density: " << maxDensity << " "
            << "Max density / target density ratio: " << maxDensity / particles->targetDensity();
@@ -258,6 +266,50 @@ void SphSolver3::computePseudoViscosity(double timeStepInSeconds) {
               [&](size_t i) { v[i] = lerp(v[i], smoothedVelocities[i], factor); });
 }
 
+void SphSolver3::onSaveState(StateArchive* archive) const {
+  auto particles = sphSystemData();
+  archive->write(particles->targetDensity());
+  archive->write(particles->targetSpacing());
+  archive->write(particles->relativeKernelRadius());
+
+  archive->write(_eosExponent);
+  archive->write(_negativePressureScale);
+  archive->write(_viscosityCoefficient);
+  archive->write(_pseudoViscosityCoefficient);
+  archive->write(_speedOfSound);
+  archive->write(_timeStepLimitScale);
+
+  // The particles go last so that their radius and mass are restored as saved
+  // rather than recomputed from the target spacing above
+  ParticleSystemSolver3::onSaveState(archive);
+}
+
+void SphSolver3::onLoadState(StateArchive* archive) {
+  double targetDensity = 0.0;
+  double targetSpacing = 0.0;
+  double relativeKernelRadius = 0.0;
+  archive->read(&targetDensity);
+  archive->read(&targetSpacing);
+  archive->read(&relativeKernelRadius);
+  if (!archive->isValid()) {
+    return;
+  }
+
+  auto particles = sphSystemData();
+  particles->setTargetDensity(targetDensity);
+  particles->setTargetSpacing(targetSpacing);
+  particles->setRelativeKernelRadius(relativeKernelRadius);
+
+  archive->read(&_eosExponent);
+  archive->read(&_negativePressureScale);
+  archive->read(&_viscosityCoefficient);
+  archive->read(&_pseudoViscosityCoefficient);
+  archive->read(&_speedOfSound);
+  archive->read(&_timeStepLimitScale);
+
+  ParticleSystemSolver3::onLoadState(archive);
+}
+
 SphSolver3::Builder SphSolver3::builder() { return Builder(); }
 
 SphSolver3 SphSolver3::Builder::build() const {
@@ -286,10 +286,20 @@ void SphSystemData3::serialize(std::vector<uint8_t>* buffer) const {
 }
 
 void SphSystemData3::deserialize(const std::vector<uint8_t>& buffer) {
-    auto fbsSphSystemData = fbs::GetSphSystemData3(buffer.data());
+    deserializeSphSystemData(buffer.data(), nullptr);
+}
+
+void SphSystemData3::deserializeView(
+    const std::shared_ptr<const uint8_t>& buffer) {
+    deserializeSphSystemData(buffer.get(), buffer);
+}
+
+void SphSystemData3::deserializeSphSystemData(
+    const uint8_t* buffer, const std::shared_ptr<const uint8_t>& viewBuffer) {
+    auto fbsSphSystemData = fbs::GetSphSystemData3(buffer);
 
     auto base = fbsSphSystemData->base();
-    deserializeParticleSystemData(base);
+    deserializeParticleSystemData(base, viewBuffer);
 
     // SPH specific
     _targetDensity = fbsSphSystemData->targetDensity();
@@ -0,0 +1,114 @@
+// Copyright (c) 2018 Doyub Kim
+//
+// I am making my contributions/submissions to this project solely in my
+// personal capacity and am not conveying any rights to any intellectual
+// property of any third parties.
+
+#include <pch.h>
+
+#include <jet/state_archive.h>
+
+#include <cstring>
+#include <sstream>
+#include <utility>
+
+using namespace jet;
+
+StateArchive::StateArchive() {}
+
+StateArchive::StateArchive(std::vector<uint8_t> buffer) : _buffer(std::move(buffer)) {}
+
+void StateArchive::clear() {
+  _buffer.clear();
+  _readPosition = 0;
+  _isValid = true;
+}
+
+const std::vector<uint8_t>& StateArchive::buffer() const { return _buffer; }
+
+void StateArchive::setBuffer(std::vector<uint8_t> buffer) {
+  _buffer = std::move(buffer);
+  _readPosition = 0;
+  _isValid = true;
+}
+
+size_t StateArchive::size() const { return _buffer.size(); }
+
+bool StateArchive::isValid() const { return _isValid; }
+
+void StateArchive::invalidate() { _isValid = false; }
+
+bool StateArchive::isAtEnd() const { return _readPosition == _buffer.size(); }
+
+void StateArchive::write(const void* data, size_t size) {
+  const size_t offset = _buffer.size();
+  _buffer.resize(offset + size);
+  if (size > 0) {
+    std::memcpy(_buffer.data() + offset, data, size);
+  }
+}
+
+void StateArchive::read(void* data, size_t size) {
+  if (!_isValid || size > _buffer.size() - _readPosition) {
+    _isValid = false;
+    std::memset(data, 0, size);
+    return;
+  }
+
+  if (size > 0) {
+    std::memcpy(data, _buffer.data() + _readPosition, size);
+  }
+  _readPosition += size;
+}
+
+void StateArchive::write(const Vector3D& value) {
+  write(value.x);
+  write(value.y);
+  write(value.z);
+}
+
+void StateArchive::read(Vector3D* value) {
+  read(&value->x);
+  read(&value->y);
+  read(&value->z);
+}
+
+void StateArchive::write(const std::string& value) {
+  write(static_cast<uint64_t>(value.size()));
+  write(value.data(), value.size());
+}
+
+void StateArchive::read(std::string* value) {
+  uint64_t size = 0;
+  read(&size);
+  if (!_isValid || size > _buffer.size() - _readPosition) {
+    _isValid = false;
+    value->clear();
+    return;
+  }
+
+  value->assign(reinterpret_cast<const char*>(_buffer.data() + _readPosition),
+                static_cast<size_t>(size));
+  _readPosition += static_cast<size_t>(size);
+}
+
+void StateArchive::write(const std::mt19937& rng) {
+  // The textual form is the only portable way to get the full engine state
+  std::ostringstream stream;
+  stream << rng;
+  write(stream.str());
+}
+
+void StateArchive::read(std::mt19937* rng) {
+  std::string state;
+  read(&state);
+  if (!_isValid) {
+    return;
+  }
+
+  std::istringstream stream(state);
+  stream >> *rng;
+  if (stream.fail()) {
+    _isValid = false;
+  }
+}
@@ -13,6 +13,9 @@
 #define TINYOBJLOADER_USE_DOUBLE
 #include <tiny_obj_loader.h>
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <fstream>
 
 using namespace jet;
@@ -55,14 +58,83 @@ WindingNumberGatherData postOrderTraversal(const Bvh3<size_t>& bvh, size_t nodeI
   return data;
 }
 
-inline std::ostream& operator<<(std::ostream& strm, const Vector2D& v) {
-  strm << v.x << ' ' << v.y;
-  return strm;
-}
+// Size of the formatting buffers of the mesh writers
+constexpr size_t kWriteBufferSize = 1 << 20;
+
+// Longest text std::to_chars produces for a double or an integer
+constexpr size_t kMaxNumberLength = 32;
+
+// Collects the output in a large buffer and hands it to the stream in big
+// writes. Text is formatted with std::to_chars, which is locale-independent
+// and much faster than formatted stream output.
+class BufferedWriter {
+ public:
+  explicit BufferedWriter(std::ostream* strm) : _strm(strm), _buffer(kWriteBufferSize) {}
+
+  ~BufferedWriter() { flush(); }
 
-inline std::ostream& operator<<(std::ostream& strm, const Vector3D& v) {
-  strm << v.x << ' ' << v.y << ' ' << v.z;
-  return strm;
+  void put(char c) {
+    reserve(1);
+    _buffer[_size++] = c;
+  }
+
+  void put(const char* str) {
+    const size_t length = std::strlen(str);
+    reserve(length);
+    std::memcpy(_buffer.data() + _size, str, length);
+    _size += length;
+  }
+
+  template <typename T>
+  void putNumber(T value) {
+    reserve(kMaxNumberLength);
+    char* begin = _buffer.data() + _size;
+    _size = std::to_chars(begin, begin + kMaxNumberLength, value).ptr - _buffer.data();
+  }
+
+  void putVector(const Vector2D& v) {
+    putNumber(v.x);
+    put(' ');
+    putNumber(v.y);
+  }
+
+  void putVector(const Vector3D& v) {
+    putNumber(v.x);
+    put(' ');
+    putNumber(v.y);
+    put(' ');
+    putNumber(v.z);
+  }
+
+  template <typename T>
+  void putBinary(T value) {
+    reserve(sizeof(T));
+    std::memcpy(_buffer.data() + _size, &value, sizeof(T));
+    _size += sizeof(T);
+  }
+
+  void flush() {
+    _strm->write(_buffer.data(), static_cast<std::streamsize>(_size));
+    _size = 0;
+  }
+
+ private:
+  std::ostream* _strm;
+  std::vector<char> _buffer;
+  size_t _size = 0;
+
+  void reserve(size_t length) {
+    if (_size + length > _buffer.size()) {
+      flush();
+    }
+  }
+};
+
+bool isLittleEndian() {
+  const uint16_t value = 1;
+  uint8_t firstByte;
+  std::memcpy(&firstByte, &value, 1);
+  return firstByte == 1;
 }
 
 }  // namespace
@@ -457,50 +529,129 @@ void TriangleMesh3::rotate(const Quaternion<double>& q) {
 }
 
 void TriangleMesh3::writeObj(std::ostream* strm) const {
+  BufferedWriter writer(strm);
+
   // vertex
   for (const auto& pt : _points) {
-    (*strm) << "v " << pt << std::endl;
+    writer.put("v ");
+    writer.putVector(pt);
+    writer.put('\n');
   }
 
   // uv coords
   for (const auto& uv : _uvs) {
-    (*strm) << "vt " << uv << std::endl;
+    writer.put("vt ");
+    writer.putVector(uv);
+    writer.put('\n');
   }
 
   // normals
   for (const auto& n : _normals) {
-    (*strm) << "vn " << n << std::endl;
+    writer.put("vn ");
+    writer.putVector(n);
+    writer.put('\n');
   }
 
   // faces
   bool hasUvs_ = hasUvs();
   bool hasNormals_ = hasNormals();
   for (size_t i = 0; i < numberOfTriangles(); ++i) {
-    (*strm) << "f ";
+    writer.put("f ");
     for (int j = 0; j < 3; ++j) {
-      (*strm) << _pointIndices[i][j] + 1;
+      writer.putNumber(_pointIndices[i][j] + 1);
       if (hasNormals_ || hasUvs_) {
-        (*strm) << '/';
+        writer.put('/');
       }
       if (hasUvs_) {
-        (*strm) << _uvIndices[i][j] + 1;
+        writer.putNumber(_uvIndices[i][j] + 1);
       }
       if (hasNormals_) {
-        (*strm) << '/' << _normalIndices[i][j] + 1;
+        writer.put('/');
+        writer.putNumber(_normalIndices[i][j] + 1);
       }
-      (*strm) << ' ';
+      writer.put(' ');
     }
-    (*strm) << std::endl;
+    writer.put('\n');
   }
 }
 
 bool TriangleMesh3::writeObj(const std::string& filename) const {
-  std::ofstream file(filename.c_str());
+  std::ofstream file(filename.c_str(), std::ios::binary);
   if (file) {
     writeObj(&file);
     file.close();
 
+    return !file.fail();
+  } else {
+    return false;
+  }
+}
+
+void TriangleMesh3::writePly(std::ostream* strm) const {
+  const size_t numTris = numberOfTriangles();
+
+  // Per-vertex attributes are only possible with the same indexing as points
+  auto isIndexedLikePoints = [&](const IndexArray& indices, size_t count) {
+    if (count != _points.size() || indices.size() != numTris) {
+      return false;
+    }
+    for (size_t i = 0; i < numTris; ++i) {
+      if (indices[i] != _pointIndices[i]) {
+        return false;
+      }
+    }
     return true;
+  };
+  const bool hasVertexNormals = hasNormals() && isIndexedLikePoints(_normalIndices, _normals.size());
+  const bool hasVertexUvs = hasUvs() && isIndexedLikePoints(_uvIndices, _uvs.size());
+
+  BufferedWriter writer(strm);
+
+  writer.put("ply\nformat ");
+  writer.put(isLittleEndian() ? "binary_little_endian" : "binary_big_endian");
+  writer.put(" 1.0\nelement vertex ");
+  writer.putNumber(_points.size());
+  writer.put("\nproperty float x\nproperty float y\nproperty float z\n");
+  if (hasVertexNormals) {
+    writer.put("property float nx\nproperty float ny\nproperty float nz\n");
+  }
+  if (hasVertexUvs) {
+    writer.put("property float s\nproperty float t\n");
+  }
+  writer.put("element face ");
+  writer.putNumber(numTris);
+  writer.put("\nproperty list uchar uint vertex_indices\nend_header\n");
+
+  for (size_t i = 0; i < _points.size(); ++i) {
+    writer.putBinary(static_cast<float>(_points[i].x));
+    writer.putBinary(static_cast<float>(_points[i].y));
+    writer.putBinary(static_cast<float>(_points[i].z));
+    if (hasVertexNormals) {
+      writer.putBinary(static_cast<float>(_normals[i].x));
+      writer.putBinary(static_cast<float>(_normals[i].y));
+      writer.putBinary(static_cast<float>(_normals[i].z));
+    }
+    if (hasVertexUvs) {
+      writer.putBinary(static_cast<float>(_uvs[i].x));
+      writer.putBinary(static_cast<float>(_uvs[i].y));
+    }
+  }
+
+  for (size_t i = 0; i < numTris; ++i) {
+    writer.putBinary(static_cast<uint8_t>(3));
+    for (int j = 0; j < 3; ++j) {
+      writer.putBinary(static_cast<uint32_t>(_pointIndices[i][j]));
+    }
+  }
+}
+
+bool TriangleMesh3::writePly(const std::string& filename) const {
+  std::ofstream file(filename.c_str(), std::ios::binary);
+  if (file) {
+    writePly(&file);
+    file.close();
+
+    return !file.fail();
   } else {
     return false;
   }
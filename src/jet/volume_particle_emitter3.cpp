@@ -62,6 +62,18 @@ void VolumeParticleEmitter3::onUpdate(double currentTimeInSeconds,
     }
 }
 
+void VolumeParticleEmitter3::onSaveState(StateArchive* archive) const {
+    archive->write(_rng);
+    archive->write(static_cast<uint64_t>(_numberOfEmittedParticles));
+}
+
+void VolumeParticleEmitter3::onLoadState(StateArchive* archive) {
+    uint64_t numberOfEmittedParticles = 0;
+    archive->read(&_rng);
+    archive->read(&numberOfEmittedParticles);
+    _numberOfEmittedParticles = static_cast<size_t>(numberOfEmittedParticles);
+}
+
 void VolumeParticleEmitter3::emit(const ParticleSystemData3Ptr& particles,
                                   Array1<Vector3D>* newPositions,
                                   Array1<Vector3D>* newVelocities) {